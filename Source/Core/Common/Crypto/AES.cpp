@@ -0,0 +1,106 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Built with -maes on GCC and Clang; see Common/CMakeLists.txt.
+
+#include <wmmintrin.h>
+
+#include "Common/Crypto/AES.h"
+
+namespace AES
+{
+
+static __m128i ExpandKeyStep(__m128i key, __m128i assist)
+{
+	assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, assist);
+}
+
+void ExpandDecryptionKey(const u8* key, u8* round_keys)
+{
+	// The round constant has to be an immediate.
+	__m128i enc[NUM_ROUND_KEYS];
+	enc[0] = _mm_loadu_si128((const __m128i*)key);
+#define EXPAND(i, rcon) enc[i] = ExpandKeyStep(enc[i - 1], _mm_aeskeygenassist_si128(enc[i - 1], rcon))
+	EXPAND(1, 0x01);
+	EXPAND(2, 0x02);
+	EXPAND(3, 0x04);
+	EXPAND(4, 0x08);
+	EXPAND(5, 0x10);
+	EXPAND(6, 0x20);
+	EXPAND(7, 0x40);
+	EXPAND(8, 0x80);
+	EXPAND(9, 0x1B);
+	EXPAND(10, 0x36);
+#undef EXPAND
+
+	// The equivalent inverse cipher uses the encryption keys in reverse, with
+	// InvMixColumns applied to all but the first and last.
+	__m128i* dec = (__m128i*)round_keys;
+	_mm_storeu_si128(&dec[0], enc[10]);
+	for (int i = 1; i < 10; i++)
+		_mm_storeu_si128(&dec[i], _mm_aesimc_si128(enc[10 - i]));
+	_mm_storeu_si128(&dec[10], enc[0]);
+}
+
+void DecryptCBC(const u8* round_keys, u8* iv, const u8* in, u8* out, size_t size)
+{
+	__m128i keys[NUM_ROUND_KEYS];
+	for (int i = 0; i < NUM_ROUND_KEYS; i++)
+		keys[i] = _mm_loadu_si128((const __m128i*)round_keys + i);
+
+	__m128i prev = _mm_loadu_si128((const __m128i*)iv);
+	const __m128i* src = (const __m128i*)in;
+	__m128i* dst = (__m128i*)out;
+	size_t blocks = size / BLOCK_SIZE;
+	size_t i = 0;
+
+	// Unlike encryption, CBC decryption of each block is independent, so do
+	// four at a time to hide the latency of AESDEC.
+	for (; i + 4 <= blocks; i += 4)
+	{
+		__m128i c0 = _mm_loadu_si128(src + i);
+		__m128i c1 = _mm_loadu_si128(src + i + 1);
+		__m128i c2 = _mm_loadu_si128(src + i + 2);
+		__m128i c3 = _mm_loadu_si128(src + i + 3);
+		__m128i b0 = _mm_xor_si128(c0, keys[0]);
+		__m128i b1 = _mm_xor_si128(c1, keys[0]);
+		__m128i b2 = _mm_xor_si128(c2, keys[0]);
+		__m128i b3 = _mm_xor_si128(c3, keys[0]);
+		for (int r = 1; r < NUM_ROUND_KEYS - 1; r++)
+		{
+			b0 = _mm_aesdec_si128(b0, keys[r]);
+			b1 = _mm_aesdec_si128(b1, keys[r]);
+			b2 = _mm_aesdec_si128(b2, keys[r]);
+			b3 = _mm_aesdec_si128(b3, keys[r]);
+		}
+		b0 = _mm_aesdeclast_si128(b0, keys[NUM_ROUND_KEYS - 1]);
+		b1 = _mm_aesdeclast_si128(b1, keys[NUM_ROUND_KEYS - 1]);
+		b2 = _mm_aesdeclast_si128(b2, keys[NUM_ROUND_KEYS - 1]);
+		b3 = _mm_aesdeclast_si128(b3, keys[NUM_ROUND_KEYS - 1]);
+		_mm_storeu_si128(dst + i, _mm_xor_si128(b0, prev));
+		_mm_storeu_si128(dst + i + 1, _mm_xor_si128(b1, c0));
+		_mm_storeu_si128(dst + i + 2, _mm_xor_si128(b2, c1));
+		_mm_storeu_si128(dst + i + 3, _mm_xor_si128(b3, c2));
+		prev = c3;
+	}
+
+	for (; i < blocks; i++)
+	{
+		__m128i c = _mm_loadu_si128(src + i);
+		__m128i b = _mm_xor_si128(c, keys[0]);
+		for (int r = 1; r < NUM_ROUND_KEYS - 1; r++)
+			b = _mm_aesdec_si128(b, keys[r]);
+		b = _mm_aesdeclast_si128(b, keys[NUM_ROUND_KEYS - 1]);
+		_mm_storeu_si128(dst + i, _mm_xor_si128(b, prev));
+		prev = c;
+	}
+
+	_mm_storeu_si128((__m128i*)iv, prev);
+}
+
+}
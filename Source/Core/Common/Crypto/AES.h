@@ -0,0 +1,32 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+// AES-128 decryption using the AES-NI instructions. Only available on x86,
+// and only to be called when cpu_info.bAES is set.
+
+namespace AES
+{
+
+enum
+{
+	KEY_SIZE = 16,
+	BLOCK_SIZE = 16,
+	NUM_ROUND_KEYS = 11,
+};
+
+// Expands key into the NUM_ROUND_KEYS * BLOCK_SIZE bytes of round keys used
+// by DecryptCBC.
+void ExpandDecryptionKey(const u8* key, u8* round_keys);
+
+// Decrypts size bytes (a multiple of BLOCK_SIZE) in CBC mode. Like polarssl's
+// aes_crypt_cbc, iv is updated so that consecutive calls chain.
+void DecryptCBC(const u8* round_keys, u8* iv, const u8* in, u8* out, size_t size);
+
+}
@@ -436,6 +436,21 @@ u64 GetSize(FILE *f)
 	return size;
 }
 
+u64 GetModificationTime(const std::string &filename)
+{
+	struct stat64 buf;
+#ifdef _WIN32
+	if (_tstat64(UTF8ToTStr(filename).c_str(), &buf) == 0)
+#else
+	if (stat64(filename.c_str(), &buf) == 0)
+#endif
+		return (u64)buf.st_mtime;
+
+	ERROR_LOG(COMMON, "GetModificationTime: Stat failed %s: %s",
+			filename.c_str(), GetLastErrorMsg());
+	return 0;
+}
+
 // creates an empty file filename, returns true on success
 bool CreateEmptyFile(const std::string &filename)
 {
@@ -82,6 +82,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE *f);
 
+// Returns the last modification time of filename in seconds since the epoch, or 0 on failure
+u64 GetModificationTime(const std::string &filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string &filename);
 
@@ -0,0 +1,95 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// A bounded lock-free queue with any number of writers and a single reader.
+//
+// Push() may be called from any thread and returns false instead of blocking
+// when the queue is full. Pop() and Empty() must only be called from the
+// reader thread. Empty() is a single atomic load, so it is cheap to poll.
+//
+// Each slot carries a sequence number which tells writers whether the slot is
+// free and the reader whether it has been published (D. Vyukov's bounded
+// queue, restricted to one consumer).
+
+#include <atomic>
+#include <cstddef>
+
+namespace Common
+{
+
+template <typename T, size_t N>
+class MPSCQueue
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "MPSCQueue size must be a power of two");
+
+public:
+	MPSCQueue() : m_write_pos(0), m_read_pos(0)
+	{
+		for (size_t i = 0; i < N; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool Push(const T& t)
+	{
+		size_t pos = m_write_pos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = m_cells[pos & (N - 1)];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+			if (diff == 0)
+			{
+				if (m_write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.data = t;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// The reader hasn't freed this slot yet: the queue is full.
+				return false;
+			}
+			else
+			{
+				pos = m_write_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool Empty() const
+	{
+		const Cell& cell = m_cells[m_read_pos & (N - 1)];
+		return cell.sequence.load(std::memory_order_acquire) != m_read_pos + 1;
+	}
+
+	bool Pop(T& t)
+	{
+		if (Empty())
+			return false;
+
+		Cell& cell = m_cells[m_read_pos & (N - 1)];
+		t = cell.data;
+		cell.sequence.store(m_read_pos + N, std::memory_order_release);
+		++m_read_pos;
+		return true;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	Cell m_cells[N];
+	std::atomic<size_t> m_write_pos;
+	// Only touched by the reader.
+	size_t m_read_pos;
+};
+
+}
@@ -0,0 +1,100 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "Common/Thread.h"
+#include "Common/WorkerPool.h"
+
+namespace Common
+{
+
+WorkerPool::WorkerPool(unsigned int num_threads)
+	: m_quit(false), m_generation(0), m_busy_workers(0), m_func(nullptr), m_count(0), m_next(0)
+{
+	if (num_threads == 0)
+		num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned int i = 1; i < num_threads; ++i)
+		m_threads.emplace_back(&WorkerPool::WorkerThread, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_quit = true;
+	}
+	m_work_available.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+void WorkerPool::RunJobs()
+{
+	size_t i;
+	while ((i = m_next.fetch_add(1)) < m_count)
+		(*m_func)(i);
+}
+
+void WorkerPool::ParallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+	if (count == 0)
+		return;
+
+	if (m_threads.empty() || count == 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_func = &func;
+		m_count = count;
+		m_next = 0;
+		m_busy_workers = m_threads.size();
+		++m_generation;
+	}
+	m_work_available.notify_all();
+
+	RunJobs();
+
+	// The workers may still be running their last iteration, and func has
+	// to stay alive until they're done with it.
+	std::unique_lock<std::mutex> lk(m_mutex);
+	m_work_done.wait(lk, [this] { return m_busy_workers == 0; });
+	m_func = nullptr;
+}
+
+void WorkerPool::WorkerThread()
+{
+	SetCurrentThreadName("Worker thread");
+
+	size_t generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			m_work_available.wait(lk, [&] { return m_quit || m_generation != generation; });
+			if (m_quit)
+				return;
+			generation = m_generation;
+		}
+
+		RunJobs();
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lk(m_mutex);
+			last = --m_busy_workers == 0;
+		}
+		if (last)
+			m_work_done.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,56 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// A fixed set of threads that run the iterations of a loop in parallel.
+//
+// ParallelFor() hands out func(0) .. func(count - 1) to the workers and the
+// calling thread, and returns once all of them have finished. The threads
+// stay around between calls, so this is cheap enough to use for work that
+// only takes a fraction of a millisecond. Only one thread may call
+// ParallelFor() at a time.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common
+{
+
+class WorkerPool
+{
+public:
+	// num_threads counts the calling thread, 0 means one per hardware thread.
+	explicit WorkerPool(unsigned int num_threads = 0);
+	~WorkerPool();
+
+	void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+	unsigned int GetNumThreads() const { return (unsigned int)m_threads.size() + 1; }
+
+private:
+	void WorkerThread();
+	void RunJobs();
+
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_work_available;
+	std::condition_variable m_work_done;
+	bool m_quit;
+	// Bumped for every ParallelFor so that workers can tell a new job from the old one.
+	size_t m_generation;
+	size_t m_busy_workers;
+
+	const std::function<void(size_t)>* m_func;
+	size_t m_count;
+	std::atomic<size_t> m_next;
+};
+
+}
@@ -20,6 +20,7 @@
 
 // Includes
 // ----------------
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -36,6 +37,7 @@
 #include "Core/HW/EXI.h"
 #include "Core/HW/SI.h"
 #include "Core/HW/WiimoteReal/WiimoteReal.h"
+#include "DiscIO/CompressedBlob.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeCreator.h"
 #include "VideoCommon/VideoBackendBase.h"
@@ -91,6 +93,8 @@ bool BootCore(const std::string& _rFilename)
 	// This is saved separately from everything because it can be changed in SConfig::AutoSetup()
 	config_cache.bHLE_BS2 = StartUp.bHLE_BS2;
 
+	DiscIO::CompressedBlobReader::SetCacheSize(std::max(StartUp.iGCZCacheSize, 1), std::max(StartUp.iGCZReadAhead, 0));
+
 	// If for example the ISO file is bad we return here
 	if (!StartUp.AutoSetup(SCoreStartupParameter::BOOT_DEFAULT))
 		return false;
@@ -538,6 +538,9 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("CPUCore",      &m_LocalCoreStartupParameter.iCPUCore, SCoreStartupParameter::CORE_INTERPRETER);
 #endif
 	core->Get("Fastmem",           &m_LocalCoreStartupParameter.bFastmem,      true);
+	core->Get("JITBlockProfileCache", &m_LocalCoreStartupParameter.bJITBlockProfileCache, false);
+	core->Get("JITHotBlockThreshold", &m_LocalCoreStartupParameter.iJITHotBlockThreshold, 1000);
+	core->Get("SamplingProfilerRate", &m_LocalCoreStartupParameter.iSamplingProfilerRate, 0);
 	core->Get("DSPHLE",            &m_LocalCoreStartupParameter.bDSPHLE,       true);
 	core->Get("CPUThread",         &m_LocalCoreStartupParameter.bCPUThread,    true);
 	core->Get("SkipIdle",          &m_LocalCoreStartupParameter.bSkipIdle,     true);
@@ -572,6 +575,12 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("VBeam",                     &m_LocalCoreStartupParameter.bVBeamSpeedHack,   false);
 	core->Get("SyncGPU",                   &m_LocalCoreStartupParameter.bSyncGPU,          false);
 	core->Get("FastDiscSpeed",             &m_LocalCoreStartupParameter.bFastDiscSpeed,    false);
+	core->Get("GPUWakeupThreshold",        &m_LocalCoreStartupParameter.iGPUWakeupThreshold, 32);
+	core->Get("GPUSpinIterations",         &m_LocalCoreStartupParameter.iGPUSpinIterations,  1000);
+	core->Get("GCZCacheSize",              &m_LocalCoreStartupParameter.iGCZCacheSize,     16);
+	core->Get("GCZReadAhead",              &m_LocalCoreStartupParameter.iGCZReadAhead,     8);
+	core->Get("StateCompression",          &m_LocalCoreStartupParameter.iStateCompression, 0);
+	core->Get("StateCompressionLevel",     &m_LocalCoreStartupParameter.iStateCompressionLevel, 1);
 	core->Get("DCBZ",                      &m_LocalCoreStartupParameter.bDCBZOFF,          false);
 	core->Get("FrameLimit",                &m_Framelimit,                                  1); // auto frame limit by default
 	core->Get("FrameSkip",                 &m_FrameSkip,                                   0);
@@ -14,6 +14,7 @@
 #include "Common/CommonPaths.h"
 #include "Common/CommonTypes.h"
 #include "Common/CPUDetect.h"
+#include "Common/FileUtil.h"
 #include "Common/MathUtil.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
@@ -51,6 +52,7 @@
 #include "Core/IPC_HLE/WII_Socket.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SamplingProfiler.h"
 
 #ifdef USE_GDBSTUB
 #include "Core/PowerPC/GDBStub.h"
@@ -256,13 +258,29 @@ static void CpuThread()
 	}
 
 	if (_CoreParameter.bFastmem)
+	{
 		EMM::InstallExceptionHandler(); // Let's run under memory watch
 
+		// Only the x86-64 JITs store to constant addresses through the mirrors.
+		if (_CoreParameter.iCPUCore == SCoreStartupParameter::CORE_JIT64 ||
+		    _CoreParameter.iCPUCore == SCoreStartupParameter::CORE_JITIL64)
+		{
+			Memory::EnableWriteTracking();
+		}
+	}
+
 	if (!s_state_filename.empty())
 		State::LoadAs(s_state_filename);
 
 	s_is_started = true;
 
+	// Before any block is compiled, so that all of them can be attributed.
+	if (_CoreParameter.iSamplingProfilerRate > 0)
+	{
+		SamplingProfiler::Start(StringFromFormat("%sprofile-%s.folded",
+			File::GetUserPath(D_DUMP_IDX).c_str(), _CoreParameter.m_strUniqueID.c_str()),
+			_CoreParameter.iSamplingProfilerRate);
+	}
 
 	#ifdef USE_GDBSTUB
 	if (_CoreParameter.iGDBPort > 0)
@@ -273,14 +291,22 @@ static void CpuThread()
 	}
 	#endif
 
+	// Compile the blocks this game needed last time before it starts running.
+	if (PowerPC::GetMode() == PowerPC::MODE_JIT)
+		JitInterface::PrecompileFromBlockProfile();
+
 	// Enter CPU run loop. When we leave it - we are done.
 	CCPU::Run();
 
+	JitInterface::SaveBlockProfile();
+	SamplingProfiler::Stop();
+
 	s_is_started = false;
 
 	if (!_CoreParameter.bCPUThread)
 		g_video_backend->Video_Cleanup();
 
+	Memory::DisableWriteTracking();
 	EMM::UninstallExceptionHandler();
 
 	return;
@@ -32,6 +32,8 @@ SCoreStartupParameter::SCoreStartupParameter()
   bJITPairedOff(false), bJITSystemRegistersOff(false),
   bJITBranchOff(false),
   bJITILTimeProfiling(false), bJITILOutputIR(false),
+  bJITBlockProfileCache(false), iJITHotBlockThreshold(1000),
+  iSamplingProfilerRate(0),
   bFPRF(false),
   bCPUThread(true), bDSPThread(false), bDSPHLE(true),
   bSkipIdle(true), bSyncGPUOnSkipIdleHack(true), bNTSC(false), bForceNTSCJ(false),
@@ -42,6 +44,9 @@ SCoreStartupParameter::SCoreStartupParameter()
   bBAT(false), bMMU(false), bDCBZOFF(false),
   iBBDumpPort(0), bVBeamSpeedHack(false),
   bSyncGPU(false), bFastDiscSpeed(false),
+  iGPUWakeupThreshold(32), iGPUSpinIterations(1000),
+  iGCZCacheSize(16), iGCZReadAhead(8),
+  iStateCompression(0), iStateCompressionLevel(1),
   SelectedLanguage(0), bWii(false),
   bConfirmStop(false), bHideCursor(false),
   bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
@@ -81,6 +86,12 @@ void SCoreStartupParameter::LoadDefaults()
 	bVBeamSpeedHack = false;
 	bSyncGPU = false;
 	bFastDiscSpeed = false;
+	iGPUWakeupThreshold = 32;
+	iGPUSpinIterations = 1000;
+	iGCZCacheSize = 16;
+	iGCZReadAhead = 8;
+	iStateCompression = 0;
+	iStateCompressionLevel = 1;
 	bMergeBlocks = false;
 	bEnableMemcardSaving = true;
 	SelectedLanguage = 0;
@@ -103,6 +114,9 @@ void SCoreStartupParameter::LoadDefaults()
 	bJITIntegerOff = false;
 	bJITPairedOff = false;
 	bJITSystemRegistersOff = false;
+	bJITBlockProfileCache = false;
+	iJITHotBlockThreshold = 1000;
+	iSamplingProfilerRate = 0;
 
 	m_strName = "NONE";
 	m_strUniqueID = "00000000";
@@ -138,7 +138,8 @@ struct SCoreStartupParameter
 		CORE_JIT64,
 		CORE_JITIL64,
 		CORE_JITARM,
-		CORE_JITARM64
+		CORE_JITARM64,
+		CORE_CACHEDINTERPRETER
 	};
 	int iCPUCore;
 
@@ -155,6 +156,14 @@ struct SCoreStartupParameter
 	bool bJITBranchOff;
 	bool bJITILTimeProfiling;
 	bool bJITILOutputIR;
+	// Save the blocks compiled for a game to disk and precompile them on the next boot
+	bool bJITBlockProfileCache;
+	// Jit64 recompiles a block with every optimization once it has run this
+	// many times. 0 compiles every block that way from the start.
+	int iJITHotBlockThreshold;
+	// Samples per second of the sampling profiler, 0 disables it. The folded
+	// stacks are written to the Dump directory when emulation stops.
+	int iSamplingProfilerRate;
 
 	bool bFastmem;
 	bool bFPRF;
@@ -185,6 +194,21 @@ struct SCoreStartupParameter
 	bool bSyncGPU;
 	bool bFastDiscSpeed;
 
+	// Dual core GPU thread idling: how many bytes must be queued in the FIFO
+	// before the CPU wakes a sleeping GPU thread, and how many times the GPU
+	// thread may poll for work before it goes to sleep.
+	int iGPUWakeupThreshold;
+	int iGPUSpinIterations;
+
+	// Compressed (GCZ) images: size of the decompressed block cache in MB, and
+	// how many blocks to decompress ahead of sequential reads.
+	int iGCZCacheSize;
+	int iGCZReadAhead;
+
+	// Savestate codec (a State::StateCompression) and zlib level.
+	int iStateCompression;
+	int iStateCompressionLevel;
+
 	int SelectedLanguage;
 
 	bool bWii;
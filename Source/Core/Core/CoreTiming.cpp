@@ -2,12 +2,19 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cinttypes>
+#include <functional>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include "Common/ChunkFile.h"
 #include "Common/FifoQueue.h"
+#include "Common/MPSCQueue.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 
@@ -27,26 +34,55 @@ struct EventType
 {
 	TimedCallback callback;
 	std::string name;
+	// Number of events of this type currently in event_queue.
+	u32 pending;
 };
 
 static std::vector<EventType> event_types;
 
-struct BaseEvent
+struct Event
 {
 	s64 time;
+	u64 fifo_order;
 	u64 userdata;
 	int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+// Events are ordered by time first, then by the order they were scheduled in,
+// so that events firing on the same cycle keep their FIFO order.
+static bool operator>(const Event& left, const Event& right)
+{
+	return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
+}
 
 // STATE_TO_SAVE
-static Event *first;
+// Binary min-heap of pending events, maintained with std::push_heap/std::pop_heap.
+static std::vector<Event> event_queue;
+static u64 event_fifo_id;
 static std::mutex tsWriteLock;
-static Common::FifoQueue<BaseEvent, false> tsQueue;
 
-// event pools
-static Event *eventPool = nullptr;
+// Events scheduled from other threads. Producers push into tsQueue without
+// locking; only when it is full do they take tsWriteLock and spill into
+// tsOverflowQueue. tsOverflowing stays set until the CPU thread has drained the
+// overflow, and sends every event pushed in the meantime there too, so that
+// each thread's events keep their order. tsPending counts events pushed but not
+// yet moved, so the CPU thread can see that there is nothing to do with a
+// single atomic load.
+static Common::MPSCQueue<Event, 1024> tsQueue;
+static Common::FifoQueue<Event, false> tsOverflowQueue;
+static std::atomic<bool> tsOverflowing;
+static std::atomic<u32> tsPending;
+
+// Per-thread counters of threadsafe event injections, for diagnostics.
+struct ThreadsafeEventSource
+{
+	std::atomic<size_t> thread_hash; // 0 if the slot is free
+	std::atomic<const char*> role;
+	std::atomic<u64> events;
+	std::atomic<u64> overflowed;
+};
+
+static std::array<ThreadsafeEventSource, 16> tsSources;
 
 int slicelength;
 static int maxSliceLength = MAX_SLICE_LENGTH;
@@ -64,22 +100,6 @@ static int ev_lost;
 
 static void (*advanceCallback)(int cyclesExecuted) = nullptr;
 
-static Event* GetNewEvent()
-{
-	if (!eventPool)
-		return new Event;
-
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
-}
-
-static void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
-}
-
 static void EmptyTimedCallback(u64 userdata, int cyclesLate) {}
 
 int RegisterEvent(const std::string& name, TimedCallback callback)
@@ -87,6 +107,7 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 	EventType type;
 	type.name = name;
 	type.callback = callback;
+	type.pending = 0;
 
 	// check for existing type with same name.
 	// we want event type names to remain unique so that we can use them for serialization.
@@ -108,7 +129,7 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 
 void UnregisterAllEvents()
 {
-	if (first)
+	if (!event_queue.empty())
 		PanicAlertT("Cannot unregister events with events pending");
 	event_types.clear();
 }
@@ -120,25 +141,53 @@ void Init()
 	globalTimer = 0;
 	idledCycles = 0;
 
+	for (auto& source : tsSources)
+	{
+		source.thread_hash.store(0);
+		source.events.store(0);
+		source.overflowed.store(0);
+	}
+
 	ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
 }
 
 void Shutdown()
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
 
-	while (eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	INFO_LOG(POWERPC, "%s", GetThreadsafeEventsSummary().c_str());
 }
 
-static void EventDoState(PointerWrap &p, BaseEvent* ev)
+static void AddEventToQueue(Event ne)
+{
+	ne.fifo_order = event_fifo_id++;
+	event_types[ne.type].pending++;
+	event_queue.push_back(ne);
+	std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+}
+
+// Removes the earliest event from the queue and returns it.
+static Event PopEventFromQueue()
+{
+	std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+	Event evt = event_queue.back();
+	event_queue.pop_back();
+	event_types[evt.type].pending--;
+	return evt;
+}
+
+// Returns a copy of the pending events, earliest first.
+static std::vector<Event> GetSortedEvents()
+{
+	std::vector<Event> sorted_events(event_queue);
+	std::sort(sorted_events.begin(), sorted_events.end(),
+		[](const Event& left, const Event& right) { return right > left; });
+	return sorted_events;
+}
+
+static void EventDoState(PointerWrap &p, Event* ev)
 {
 	p.Do(ev->time);
 
@@ -174,7 +223,6 @@ static void EventDoState(PointerWrap &p, BaseEvent* ev)
 
 void DoState(PointerWrap &p)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	p.Do(slicelength);
 	p.Do(globalTimer);
 	p.Do(idledCycles);
@@ -186,7 +234,35 @@ void DoState(PointerWrap &p)
 
 	MoveEvents();
 
-	p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+	// Events are stored in firing order, each preceded by a 1 byte and the list
+	// terminated by a 0 byte. This is the layout the event queue had when it was
+	// a linked list, so older states still load.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		ClearPendingEvents();
+		while (true)
+		{
+			u8 exists = 0;
+			p.Do(exists);
+			if (!exists)
+				break;
+
+			Event ev;
+			EventDoState(p, &ev);
+			AddEventToQueue(ev);
+		}
+	}
+	else
+	{
+		for (Event& ev : GetSortedEvents())
+		{
+			u8 exists = 1;
+			p.Do(exists);
+			EventDoState(p, &ev);
+		}
+		u8 exists = 0;
+		p.Do(exists);
+	}
 	p.DoMarker("CoreTimingEvents");
 }
 
@@ -200,16 +276,48 @@ u64 GetIdleTicks()
 	return (u64)idledCycles;
 }
 
+static ThreadsafeEventSource& GetThreadsafeEventSource()
+{
+	// Never 0, which marks a free slot.
+	size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+	for (auto& source : tsSources)
+	{
+		size_t owner = source.thread_hash.load(std::memory_order_relaxed);
+		if (owner == 0 && source.thread_hash.compare_exchange_strong(owner, hash))
+		{
+			source.role.store(Core::IsGPUThread() ? "GPU" : Core::IsCPUThread() ? "CPU" : "other");
+			return source;
+		}
+		if (owner == hash)
+			return source;
+	}
+	// Out of slots, lump the remaining threads together.
+	return tsSources.back();
+}
+
 // This is to be called when outside threads, such as the graphics thread, wants to
 // schedule things to be executed on the main thread.
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	Event ne;
 	ne.time = globalTimer + cyclesIntoFuture;
+	ne.fifo_order = 0;
 	ne.type = event_type;
 	ne.userdata = userdata;
-	tsQueue.Push(ne);
+
+	ThreadsafeEventSource& source = GetThreadsafeEventSource();
+	source.events.fetch_add(1, std::memory_order_relaxed);
+
+	// Counted before the push, so that MoveEvents never sees fewer pending
+	// events than it can pop.
+	tsPending.fetch_add(1, std::memory_order_release);
+	if (tsOverflowing.load(std::memory_order_acquire) || !tsQueue.Push(ne))
+	{
+		source.overflowed.fetch_add(1, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lk(tsWriteLock);
+		tsOverflowing.store(true, std::memory_order_relaxed);
+		tsOverflowQueue.Push(ne);
+	}
 }
 
 // Same as ScheduleEvent_Threadsafe(0, ...) EXCEPT if we are already on the CPU thread
@@ -228,41 +336,21 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
+	event_queue.clear();
+	for (auto& event_type : event_types)
+		event_type.pending = 0;
 }
 
-static void AddEventToQueue(Event* ne)
-{
-	Event* prev = nullptr;
-	Event** pNext = &first;
-	for (;;)
-	{
-		Event*& next = *pNext;
-		if (!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
-}
 
 // This must be run ONLY from within the CPU thread
 // cyclesIntoFuture may be VERY inaccurate if called from anything else
 // than Advance
 void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = globalTimer + cyclesIntoFuture;
+	Event ne;
+	ne.userdata = userdata;
+	ne.type = event_type;
+	ne.time = globalTimer + cyclesIntoFuture;
 	AddEventToQueue(ne);
 }
 
@@ -273,56 +361,19 @@ void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e)
-	{
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return event_types[event_type].pending != 0;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-
-	while (first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-
-	if (!first)
+	if (!event_types[event_type].pending)
 		return;
 
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	auto it = std::remove_if(event_queue.begin(), event_queue.end(),
+		[event_type](const Event& e) { return e.type == event_type; });
+	event_queue.erase(it, event_queue.end());
+	std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+	event_types[event_type].pending = 0;
 }
 
 void RemoveAllEvents(int event_type)
@@ -356,36 +407,40 @@ void ProcessFifoWaitEvents()
 {
 	MoveEvents();
 
-	if (!first)
-		return;
-
-	while (first)
+	while (!event_queue.empty() && event_queue.front().time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		Event evt = PopEventFromQueue();
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 	}
 }
 
 void MoveEvents()
 {
-	BaseEvent sevt;
-	while (tsQueue.Pop(sevt))
+	if (!tsPending.load(std::memory_order_acquire))
+		return;
+
+	u32 moved = 0;
+	Event evt;
+	while (tsQueue.Pop(evt))
 	{
-		Event *evt = GetNewEvent();
-		evt->time = sevt.time;
-		evt->userdata = sevt.userdata;
-		evt->type = sevt.type;
 		AddEventToQueue(evt);
+		moved++;
 	}
+
+	// Everything in tsQueue was pushed before the overflow started, or
+	// concurrently with it.
+	if (tsOverflowing.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lk(tsWriteLock);
+		while (tsOverflowQueue.Pop(evt))
+		{
+			AddEventToQueue(evt);
+			moved++;
+		}
+		tsOverflowing.store(false, std::memory_order_release);
+	}
+
+	tsPending.fetch_sub(moved, std::memory_order_relaxed);
 }
 
 void Advance()
@@ -396,31 +451,20 @@ void Advance()
 	globalTimer += cyclesExecuted;
 	PowerPC::ppcState.downcount = slicelength;
 
-	while (first)
+	while (!event_queue.empty() && event_queue.front().time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-			//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-			//             event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		Event evt = PopEventFromQueue();
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 	}
 
-	if (!first)
+	if (event_queue.empty())
 	{
 		WARN_LOG(POWERPC, "WARNING - no events in queue. Setting downcount to 10000");
 		PowerPC::ppcState.downcount += 10000;
 	}
 	else
 	{
-		slicelength = (int)(first->time - globalTimer);
+		slicelength = (int)(event_queue.front().time - globalTimer);
 		if (slicelength > maxSliceLength)
 			slicelength = maxSliceLength;
 		PowerPC::ppcState.downcount = slicelength;
@@ -432,12 +476,8 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
-	{
-		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
-	}
+	for (const Event& ev : GetSortedEvents())
+		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ev.time, ev.type);
 }
 
 void Idle()
@@ -464,19 +504,32 @@ void Idle()
 
 std::string GetScheduledEventsSummary()
 {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr)
+	for (const Event& ev : GetSortedEvents())
 	{
-		unsigned int t = ptr->type;
+		unsigned int t = ev.type;
 		if (t >= event_types.size())
 			PanicAlertT("Invalid event type %i", t);
 
-		const std::string& name = event_types[ptr->type].name;
+		const std::string& name = event_types[ev.type].name;
+
+		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ev.time, ev.userdata);
+	}
+	return text;
+}
+
+std::string GetThreadsafeEventsSummary()
+{
+	std::string text = "Threadsafe events by thread\n";
+	for (const auto& source : tsSources)
+	{
+		size_t hash = source.thread_hash.load();
+		if (!hash)
+			continue;
 
-		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ptr->time, ptr->userdata);
-		ptr = ptr->next;
+		text += StringFromFormat("%016" PRIx64 " (%s): %" PRIu64 " events, %" PRIu64 " overflowed\n",
+			(u64)hash, source.role.load(), source.events.load(), source.overflowed.load());
 	}
 	return text;
 }
@@ -70,6 +70,8 @@ void ResetSliceLength();
 void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted));
 
 std::string GetScheduledEventsSummary();
+// How many events each thread has passed to ScheduleEvent_Threadsafe.
+std::string GetThreadsafeEventsSummary();
 
 u32 GetFakeDecStartValue();
 void SetFakeDecStartValue(u32 val);
@@ -17,6 +17,7 @@ namespace DSPHost
 {
 u8 ReadHostMemory(u32 addr);
 void WriteHostMemory(u8 value, u32 addr);
+void CPUMemoryWritten(u32 addr, u32 size);
 void OSD_AddMessage(const std::string& str, u32 ms);
 bool OnThread();
 bool IsWiiHost();
@@ -610,6 +610,9 @@ static void Do_ARAM_DMA()
 
 		if (g_arDMA.ARAddr < g_ARAM.size)
 		{
+			const u32 ar_start = g_arDMA.ARAddr;
+			const u32 count = g_arDMA.Cnt.count;
+
 			while (g_arDMA.Cnt.count)
 			{
 				if ((g_ARAM_Info.Hex & 0xf) == 3)
@@ -633,6 +636,10 @@ static void Do_ARAM_DMA()
 				g_arDMA.ARAddr += 8;
 				g_arDMA.Cnt.count -= 8;
 			}
+
+			// On the Wii, ARAM is EXRAM.
+			if (g_ARAM.wii_mode)
+				Memory::MarkWritten(0x10000000 | ar_start, count);
 		}
 		else
 		{
@@ -668,6 +675,8 @@ void WriteARAM(u8 value, u32 _uAddress)
 	//NOTICE_LOG(DSPINTERFACE, "WriteARAM 0x%08x", _uAddress);
 	//TODO: verify this on WII
 	g_ARAM.ptr[_uAddress & g_ARAM.mask] = value;
+	if (g_ARAM.wii_mode)
+		Memory::MarkWritten(0x10000000 | (_uAddress & g_ARAM.mask), 1);
 }
 
 u8 *GetARAMPtr()
@@ -101,6 +101,7 @@ bool WritePB(u32 addr, const PB_TYPE& pb)
 
 	for (u32 i = 0; i < sizeof (pb) / sizeof (u16); ++i)
 		dst[i] = Common::swap16(src[i]);
+	Memory::MarkWritten(addr, sizeof (pb));
 
 	return true;
 }
@@ -528,6 +528,7 @@ void AXWiiUCode::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr, u16 vo
 		for (auto& buffer : buffers)
 			for (u32 j = 0; j < 3 * 32; ++j)
 				*ptr++ = Common::swap32(buffer[j]);
+		HLEMemory_Written(write_addr, 3 * 3 * 32 * sizeof(int));
 	}
 
 	// Then read the buffers from the CPU and add to our main buffers.
@@ -555,10 +556,12 @@ void AXWiiUCode::UploadAUXMixLRSC(int aux_id, u32* addresses, u16 volume)
 		*upload_ptr++ = Common::swap32(aux_right[i]);
 	for (u32 i = 0; i < 96; ++i)
 		*upload_ptr++ = Common::swap32(aux_surround[i]);
+	HLEMemory_Written(addresses[0], 3 * 96 * sizeof(int));
 
 	upload_ptr = (int*)HLEMemory_Get_Pointer(addresses[1]);
 	for (u32 i = 0; i < 96; ++i)
 		*upload_ptr++ = Common::swap32(auxc_buffer[i]);
+	HLEMemory_Written(addresses[1], 96 * sizeof(int));
 
 	u16 volume_ramp[96];
 	GenerateVolumeRamp(volume_ramp, m_last_aux_volumes[aux_id], volume, 96);
@@ -597,6 +600,7 @@ void AXWiiUCode::OutputSamples(u32 lr_addr, u32 surround_addr, u16 volume,
 	for (u32 i = 0; i < 3 * 32; ++i)
 		upload_buffer[i] = Common::swap32(m_samples_surround[i]);
 	memcpy(HLEMemory_Get_Pointer(surround_addr), upload_buffer, sizeof (upload_buffer));
+	HLEMemory_Written(surround_addr, sizeof (upload_buffer));
 
 	if (upload_auxc)
 	{
@@ -604,6 +608,7 @@ void AXWiiUCode::OutputSamples(u32 lr_addr, u32 surround_addr, u16 volume,
 		for (u32 i = 0; i < 3 * 32; ++i)
 			upload_buffer[i] = Common::swap32(m_samples_auxC_left[i]);
 		memcpy(HLEMemory_Get_Pointer(surround_addr), upload_buffer, sizeof (upload_buffer));
+		HLEMemory_Written(surround_addr, sizeof (upload_buffer));
 	}
 
 	short buffer[3 * 32 * 2];
@@ -632,6 +637,7 @@ void AXWiiUCode::OutputSamples(u32 lr_addr, u32 surround_addr, u16 volume,
 	}
 
 	memcpy(HLEMemory_Get_Pointer(lr_addr), buffer, sizeof (buffer));
+	HLEMemory_Written(lr_addr, sizeof (buffer));
 
 	// There should be a DSP_SYNC message sent here. However, it looks like not
 	// sending it does not cause any issue, and sending it actually causes some
@@ -657,6 +663,7 @@ void AXWiiUCode::OutputWMSamples(u32* addresses)
 			MathUtil::Clamp(&sample, -32767, 32767);
 			out[j] = Common::swap16((u16)sample);
 		}
+		HLEMemory_Written(addresses[i], 3 * 6 * sizeof(u16));
 	}
 }
 
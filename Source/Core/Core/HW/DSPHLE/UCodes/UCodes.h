@@ -57,6 +57,15 @@ inline void* HLEMemory_Get_Pointer(u32 address)
 		return &Memory::m_pRAM[address & Memory::RAM_MASK];
 }
 
+// Writes through HLEMemory_Get_Pointer bypass Memory::, so tell it about them.
+inline void HLEMemory_Written(u32 address, u32 size)
+{
+	if (ExramRead(address))
+		Memory::MarkWritten(0x10000000 | (address & Memory::EXRAM_MASK), size);
+	else
+		Memory::MarkWritten(address & Memory::RAM_MASK, size);
+}
+
 class UCodeInterface
 {
 public:
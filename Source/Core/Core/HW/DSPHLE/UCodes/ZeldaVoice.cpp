@@ -44,6 +44,7 @@ void ZeldaUCode::WritebackVoicePB(u32 _Addr, ZeldaVoicePB& PB)
 	// Only the first 0x100 bytes are written back
 	for (int i = 0; i < (0x100 / 2); i++)
 		memory[i] = Common::swap16(((u16*)&PB)[i]);
+	Memory::MarkWritten(_Addr, 0x100);
 }
 
 int ZeldaUCode::ConvertRatio(int pb_ratio)
@@ -787,4 +788,6 @@ void ZeldaUCode::MixAudio()
 		MathUtil::Clamp(&right, -32768, 32767);
 		right_buffer[i] = Common::swap16((short)right);
 	}
+	HLEMemory_Written(m_left_buffers_addr + m_current_buffer * BufferSamples * sizeof(s16), BufferSamples * sizeof(s16));
+	HLEMemory_Written(m_right_buffers_addr + m_current_buffer * BufferSamples * sizeof(s16), BufferSamples * sizeof(s16));
 }
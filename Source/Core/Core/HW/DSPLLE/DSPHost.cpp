@@ -11,6 +11,7 @@
 #include "Core/DSP/DSPCore.h"
 #include "Core/DSP/DSPHost.h"
 #include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
 #include "Core/HW/DSPLLE/DSPLLETools.h"
 #include "Core/HW/DSPLLE/DSPSymbols.h"
 #include "Core/PowerPC/PowerPC.h"
@@ -34,6 +35,11 @@ void WriteHostMemory(u8 value, u32 addr)
 	DSP::WriteARAM(value, addr);
 }
 
+void CPUMemoryWritten(u32 addr, u32 size)
+{
+	Memory::MarkWritten(addr, size);
+}
+
 void OSD_AddMessage(const std::string& str, u32 ms)
 {
 	OSD::AddMessage(str, ms);
@@ -532,6 +532,7 @@ IEXIDevice* CEXIMemoryCard::FindDevice(TEXIDevices device_type, int customIndex)
 void CEXIMemoryCard::DMARead(u32 _uAddr, u32 _uSize)
 {
 	memorycard->Read(address, _uSize, Memory::GetPointer(_uAddr));
+	Memory::MarkWritten(_uAddr, _uSize);
 
 	if ((address + _uSize) % BLOCK_SIZE == 0)
 	{
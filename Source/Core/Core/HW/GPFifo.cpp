@@ -65,6 +65,7 @@ void CheckGatherPipe()
 		{
 			// copy the GatherPipe
 			memcpy(curMem, m_gatherPipe + cnt, GATHER_PIPE_SIZE);
+			Memory::MarkWritten(ProcessorInterface::Fifo_CPUWritePointer, GATHER_PIPE_SIZE);
 			m_gatherPipeCount -= GATHER_PIPE_SIZE;
 
 			// increase the CPUWritePointer
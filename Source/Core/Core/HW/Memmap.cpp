@@ -8,6 +8,10 @@
 // However, if a JITed instruction (for example lwz) wants to access a bad memory area that call
 // may be redirected here (for example to Read_U32()).
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Common/MemArena.h"
@@ -36,6 +40,12 @@
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/VideoBackendBase.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
 namespace Memory
 {
 
@@ -130,6 +140,8 @@ void Init()
 	if (wii) flags |= MV_WII_ONLY;
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
 	base = MemoryMap_Setup(views, num_views, flags, &g_arena);
+	m_pRAMWriteView = m_pRAM;
+	m_pEXRAMWriteView = m_pEXRAM;
 
 	mmio_mapping = new MMIO::Mapping();
 
@@ -154,6 +166,8 @@ void DoState(PointerWrap &p)
 	if (wii)
 		p.DoArray(m_pEXRAM, EXRAM_SIZE);
 	p.DoMarker("Memory EXRAM");
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		MarkAllWritten();
 }
 
 void Shutdown()
@@ -165,6 +179,8 @@ void Shutdown()
 	MemoryMap_Shutdown(views, num_views, flags, &g_arena);
 	g_arena.ReleaseSHMSegment();
 	base = nullptr;
+	m_pRAMWriteView = nullptr;
+	m_pEXRAMWriteView = nullptr;
 	delete mmio_mapping;
 	INFO_LOG(MEMMAP, "Memory system shut down.");
 }
@@ -177,6 +193,7 @@ void Clear()
 		memset(m_pL1Cache, 0, L1_CACHE_SIZE);
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii && m_pEXRAM)
 		memset(m_pEXRAM, 0, EXRAM_SIZE);
+	MarkAllWritten();
 }
 
 bool AreMemoryBreakpointsActivated()
@@ -219,6 +236,7 @@ void CopyToEmu(u32 address, const void* data, size_t size)
 		return;
 	}
 	memcpy(GetPointer(address), data, size);
+	MarkWritten(address, u32(size));
 }
 
 void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
@@ -227,6 +245,7 @@ void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
 	if (ptr != nullptr)
 	{
 		memset(ptr,_iValue,_iLength);
+		MarkWritten(_Address, _iLength);
 	}
 	else
 	{
@@ -251,6 +270,7 @@ void DMA_LCToMemory(const u32 _MemAddr, const u32 _CacheAddr, const u32 _iNumBlo
 	if ((dst != nullptr) && (src != nullptr) && (_MemAddr & 3) == 0 && (_CacheAddr & 3) == 0)
 	{
 		memcpy(dst, src, 32 * _iNumBlocks);
+		MarkWritten(_MemAddr, 32 * _iNumBlocks);
 	}
 	else
 	{
@@ -351,6 +371,227 @@ u8* GetPointer(const u32 _Address)
 	return nullptr;
 }
 
+// =================================
+// Write tracking
+// ----------------
+enum
+{
+	TRACKED_PAGE_SHIFT = 12,
+	TRACKED_PAGE_SIZE = 1 << TRACKED_PAGE_SHIFT,
+	RAM_PAGES = RAM_SIZE >> TRACKED_PAGE_SHIFT,
+	EXRAM_PAGES = EXRAM_SIZE >> TRACKED_PAGE_SHIFT,
+	NUM_TRACKED_PAGES = RAM_PAGES + EXRAM_PAGES,
+};
+
+// Write faults are handled on whatever thread took them, in a signal handler
+// on POSIX, so everything the handler touches is a lock-free atomic.
+static std::atomic<bool> s_write_tracking(false);
+// Incremented by every WatchRange, pages get the current value when they are written.
+static std::atomic<u64> s_write_stamp(1);
+static std::atomic<u64> s_all_written_stamp(0);
+static std::atomic<u64> s_page_stamps[NUM_TRACKED_PAGES];
+// Serializes WatchRange against DisableWriteTracking, never taken by the fault handler.
+static std::mutex s_protection_lock;
+
+// What Write_* stores RAM and EXRAM through. These are the write protected
+// mirrors while tracking is enabled, so that the CPU thread's stores are
+// caught the same way JIT stores are, without a check on every store.
+u8* m_pRAMWriteView;
+u8* m_pEXRAMWriteView;
+
+static int GetTrackedPage(u32 address)
+{
+	switch (address >> 28)
+	{
+	case 0x0:
+	case 0x8:
+	case 0xC:
+		if ((address & 0x0FFFFFFF) < RAM_SIZE)
+			return (address & RAM_MASK) >> TRACKED_PAGE_SHIFT;
+		break;
+	case 0x1:
+	case 0x9:
+	case 0xD:
+		if (m_pEXRAM && (address & 0x0FFFFFFF) < EXRAM_SIZE)
+			return RAM_PAGES + ((address & EXRAM_MASK) >> TRACKED_PAGE_SHIFT);
+		break;
+	}
+	return -1;
+}
+
+// Only the 0x8/0xC and 0x9/0xD mirrors are protected. The physical views at
+// 0x0 and 0x1 are the ones behind m_pRAM/GetPointer, writes through them are
+// marked by hand, including the JIT's fastmem stores in real mode.
+static void SetRangeProtection(int first_page, int num_pages, bool protect)
+{
+	u64 offset;
+	u8* mirrors[2];
+	if (first_page < RAM_PAGES)
+	{
+		offset = (u64)first_page << TRACKED_PAGE_SHIFT;
+		mirrors[0] = base + 0x80000000;
+		mirrors[1] = base + 0xC0000000;
+	}
+	else
+	{
+		offset = (u64)(first_page - RAM_PAGES) << TRACKED_PAGE_SHIFT;
+		mirrors[0] = base + 0x90000000;
+		mirrors[1] = base + 0xD0000000;
+	}
+
+	for (u8* mirror : mirrors)
+	{
+		if (protect)
+			WriteProtectMemory(mirror + offset, (size_t)num_pages << TRACKED_PAGE_SHIFT);
+		else
+			UnWriteProtectMemory(mirror + offset, (size_t)num_pages << TRACKED_PAGE_SHIFT);
+	}
+}
+
+// Page stamps only move forward, even when two threads mark the same page.
+static void StampPage(int page, u64 stamp)
+{
+	u64 old = s_page_stamps[page].load(std::memory_order_relaxed);
+	while (old < stamp && !s_page_stamps[page].compare_exchange_weak(old, stamp, std::memory_order_release))
+	{
+	}
+}
+
+void EnableWriteTracking()
+{
+	// Needs the mirrors of the 64-bit memory map. The Mach exception handler
+	// only sees faults on the CPU thread, while Write_* is also used elsewhere.
+#if _ARCH_64 && !defined(__APPLE__)
+	std::lock_guard<std::mutex> lk(s_protection_lock);
+	for (std::atomic<u64>& stamp : s_page_stamps)
+		stamp.store(0, std::memory_order_relaxed);
+	s_all_written_stamp = s_write_stamp++;
+	m_pRAMWriteView = base + 0x80000000;
+	if (m_pEXRAM)
+		m_pEXRAMWriteView = base + 0x90000000;
+	s_write_tracking = true;
+#endif
+}
+
+void DisableWriteTracking()
+{
+	std::lock_guard<std::mutex> lk(s_protection_lock);
+	if (!s_write_tracking)
+		return;
+
+	// Unprotect everything before the fault handler stops claiming faults.
+	SetRangeProtection(0, RAM_PAGES, false);
+	if (m_pEXRAM)
+		SetRangeProtection(RAM_PAGES, EXRAM_PAGES, false);
+	m_pRAMWriteView = m_pRAM;
+	m_pEXRAMWriteView = m_pEXRAM;
+	s_write_tracking = false;
+}
+
+bool IsWriteTrackingEnabled()
+{
+	return s_write_tracking.load(std::memory_order_relaxed);
+}
+
+u64 WatchRange(u32 address, u32 size)
+{
+	if (!s_write_tracking || !size)
+		return 0;
+
+	int first = GetTrackedPage(address);
+	int last = GetTrackedPage(address + size - 1);
+	if (first < 0 || last < first || (first < RAM_PAGES) != (last < RAM_PAGES))
+		return 0;
+
+	std::lock_guard<std::mutex> lk(s_protection_lock);
+	if (!s_write_tracking)
+		return 0;
+
+	// Take the stamp before protecting. A write that unprotects a page again
+	// after this stamps the page with at least this value, so the caller
+	// sees it as a change and watches the range again.
+	u64 stamp = ++s_write_stamp;
+
+	// Protecting pages that already are is cheaper than keeping track of
+	// them, and heals pages a fault unprotected behind our back.
+	SetRangeProtection(first, last - first + 1, true);
+	return stamp;
+}
+
+bool WrittenSince(u32 address, u32 size, u64 stamp)
+{
+	if (!s_write_tracking || !stamp || stamp <= s_all_written_stamp.load(std::memory_order_acquire))
+		return true;
+
+	int first = GetTrackedPage(address);
+	int last = GetTrackedPage(address + size - 1);
+	if (first < 0 || last < first)
+		return true;
+
+	for (int page = first; page <= last; page++)
+	{
+		if (s_page_stamps[page].load(std::memory_order_acquire) >= stamp)
+			return true;
+	}
+	return false;
+}
+
+void MarkWritten(u32 address, u32 size)
+{
+	if (!s_write_tracking || !size)
+		return;
+
+	int first = GetTrackedPage(address);
+	int last = GetTrackedPage(address + size - 1);
+	if (first < 0)
+		return;
+	if (last < first)
+		last = first < RAM_PAGES ? RAM_PAGES - 1 : NUM_TRACKED_PAGES - 1;
+
+	const u64 stamp = s_write_stamp;
+	for (int page = first; page <= last; page++)
+		StampPage(page, stamp);
+}
+
+void MarkAllWritten()
+{
+	s_all_written_stamp.store(s_write_stamp, std::memory_order_release);
+}
+
+bool HandleWriteFault(uintptr_t access_address)
+{
+	if (!s_write_tracking.load(std::memory_order_acquire) || access_address < (uintptr_t)base ||
+	    access_address - (uintptr_t)base >= 0x100000000ULL)
+	{
+		return false;
+	}
+
+	// Only the mirrors are ever protected, and they are always mapped, so any
+	// fault in them is ours.
+	const u32 address = (u32)(access_address - (uintptr_t)base);
+	const u32 segment = address >> 28;
+	if (segment != 0x8 && segment != 0x9 && segment != 0xC && segment != 0xD)
+		return false;
+	int page = GetTrackedPage(address);
+	if (page < 0)
+		return false;
+
+	// Unprotect only the page that faulted, in one call, then stamp it. The
+	// stamp has to come after the unprotect: if WatchRange protects the page
+	// again in between, its stamp is older than ours and it sees the write.
+	u8* page_address = base + (address & ~(u32)(TRACKED_PAGE_SIZE - 1));
+#ifdef _WIN32
+	DWORD old_protect;
+	if (!VirtualProtect(page_address, TRACKED_PAGE_SIZE, PAGE_READWRITE, &old_protect))
+		return false;
+#else
+	if (mprotect(page_address, TRACKED_PAGE_SIZE, PROT_READ | PROT_WRITE) != 0)
+		return false;
+#endif
+	StampPage(page, s_write_stamp.load(std::memory_order_acquire));
+	return true;
+}
+
 bool IsRAMAddress(const u32 addr, bool allow_locked_cache, bool allow_fake_vmem)
 {
 	switch ((addr >> 24) & 0xFC)
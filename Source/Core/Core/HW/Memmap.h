@@ -36,6 +36,10 @@ extern u8* m_pL1Cache;
 extern u8* m_pFakeVMEM;
 extern bool bFakeVMEM;
 
+// Where Write_* stores to RAM and EXRAM, see the write tracking functions.
+extern u8* m_pRAMWriteView;
+extern u8* m_pEXRAMWriteView;
+
 enum
 {
 	// RAM_SIZE is the amount allocated by the emulator, whereas REALRAM_SIZE is
@@ -133,6 +137,32 @@ void CopyToEmu(u32 address, const void* data, size_t size);
 void Memset(const u32 _Address, const u8 _Data, const u32 _iLength);
 void ClearCacheLine(const u32 _Address); // Zeroes 32 bytes; address should be 32-byte-aligned
 
+// Write tracking, so that the texture cache can tell whether guest memory has
+// changed without hashing it again. While a range is watched, its pages are
+// write protected in the 0x8/0xC and 0x9/0xD mirrors and the faults are caught
+// by the fastmem exception handler. That covers:
+// - JIT fastmem stores to effective addresses in the mirrors,
+// - JIT stores to constant addresses, which always go through a mirror,
+// - Write_*, which stores through m_pRAMWriteView/m_pEXRAMWriteView.
+// The physical views at 0x0 and 0x1 aren't protected, so these call
+// MarkWritten instead:
+// - JIT fastmem stores, dcbz and paired stores to physical addresses, which
+//   is what the guest uses with MSR.DR clear (see MarkPhysicalWrite),
+// - everything that writes through m_pRAM, m_pEXRAM or GetPointer (DMA, HLE,
+//   the GPU thread), once the data is in place and before the guest is told
+//   about it. CopyToEmu, Memset and the locked cache DMA already do.
+// A new writer of guest RAM that does neither makes the texture cache miss
+// changes. Only enabled for the x86-64 JITs.
+void EnableWriteTracking();
+void DisableWriteTracking();
+bool IsWriteTrackingEnabled();
+// Returns a stamp for WrittenSince, or 0 if the range can't be tracked.
+u64 WatchRange(u32 address, u32 size);
+bool WrittenSince(u32 address, u32 size, u64 stamp);
+void MarkWritten(u32 address, u32 size);
+void MarkAllWritten();
+bool HandleWriteFault(uintptr_t access_address);
+
 // TLB functions
 void SDRUpdated();
 enum XCheckTLBFlag
@@ -243,14 +243,14 @@ inline void WriteToHardware(u32 em_address, const T data, Memory::XCheckTLBFlag
 		((em_address & 0xF0000000) == 0xC0000000) ||
 		((em_address & 0xF0000000) == 0x00000000))
 	{
-		*(T*)&m_pRAM[em_address & RAM_MASK] = bswap(data);
+		*(T*)&m_pRAMWriteView[em_address & RAM_MASK] = bswap(data);
 		return;
 	}
 	else if (m_pEXRAM && (((em_address & 0xF0000000) == 0x90000000) ||
 		((em_address & 0xF0000000) == 0xD0000000) ||
 		((em_address & 0xF0000000) == 0x10000000)))
 	{
-		*(T*)&m_pEXRAM[em_address & EXRAM_MASK] = bswap(data);
+		*(T*)&m_pEXRAMWriteView[em_address & EXRAM_MASK] = bswap(data);
 		return;
 	}
 	else if ((em_address >= 0xE0000000) && (em_address < (0xE0000000+L1_CACHE_SIZE)))
@@ -583,6 +583,30 @@ void EnqueueCommandAcknowledgement(u32 address, int cycles_in_future)
 	                          address | ENQUEUE_ACKNOWLEDGEMENT_FLAG);
 }
 
+// Devices fill output buffers through whatever path is convenient (including
+// raw pointers), so flag them as written once the reply goes out.
+static void MarkReplyBuffersWritten(u32 address)
+{
+	switch (Memory::Read_U32(address + 8))
+	{
+	case IPC_CMD_READ:
+		Memory::MarkWritten(Memory::Read_U32(address + 0xC), Memory::Read_U32(address + 0x10));
+		break;
+	case IPC_CMD_IOCTL:
+		Memory::MarkWritten(Memory::Read_U32(address + 0x18), Memory::Read_U32(address + 0x1C));
+		break;
+	case IPC_CMD_IOCTLV:
+	{
+		SIOCtlVBuffer buffer(address);
+		for (const auto& payload : buffer.PayloadBuffer)
+			Memory::MarkWritten(payload.m_Address, payload.m_Size);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
 // This is called every IPC_HLE_PERIOD from SystemTimers.cpp
 // Takes care of routing ipc <-> ipc HLE
 void Update()
@@ -602,6 +626,8 @@ void Update()
 
 	if (reply_queue.size())
 	{
+		if (Memory::IsWriteTrackingEnabled())
+			MarkReplyBuffersWritten(reply_queue.front());
 		WII_IPCInterface::GenerateReply(reply_queue.front());
 		INFO_LOG(WII_IPC_HLE, "<<-- Reply to IPC Request @ 0x%08x", reply_queue.front());
 		reply_queue.pop_front();
@@ -0,0 +1,208 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "Common/Atomic.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/HLE/HLE.h"
+#include "Core/PowerPC/CachedInterpreter.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/Profiler.h"
+
+void CachedInterpreter::Init()
+{
+	m_code.reserve(CODE_SIZE);
+
+	jo.enableBlocklink = false;
+
+	m_block_cache.Init();
+}
+
+void CachedInterpreter::Shutdown()
+{
+	m_block_cache.Shutdown();
+}
+
+void CachedInterpreter::ClearCache()
+{
+	m_block_cache.Clear();
+	m_code.clear();
+}
+
+void CachedInterpreter::Run()
+{
+	while (!PowerPC::GetState())
+	{
+		while (PowerPC::ppcState.downcount > 0)
+		{
+			if (!ExecuteBlock())
+				return;
+		}
+
+		CoreTiming::Advance();
+
+		if (PowerPC::ppcState.Exceptions)
+		{
+			PowerPC::CheckExceptions();
+			PC = NPC;
+		}
+	}
+}
+
+void CachedInterpreter::SingleStep()
+{
+	// Stepping runs exactly one instruction, which is what the interpreter does
+	// anyway; going through a block would run all of it.
+	Interpreter::getInstance()->SingleStep();
+}
+
+// Runs the block at PC, compiling it first if needed. Returns false if it hit
+// a breakpoint.
+bool CachedInterpreter::ExecuteBlock()
+{
+	int block_num = m_block_cache.GetBlockNumberFromStartAddress(PC);
+	if (block_num < 0)
+	{
+		Jit(PC);
+		block_num = m_block_cache.GetBlockNumberFromStartAddress(PC);
+		if (block_num < 0)
+		{
+			// The first instruction couldn't be fetched. Let the interpreter
+			// raise the exception.
+			PowerPC::ppcState.downcount -= Interpreter::getInstance()->SingleStepInner();
+			return true;
+		}
+	}
+
+	if (Profiler::g_ProfileBlocks)
+		m_block_cache.GetBlock(block_num)->runCount++;
+
+	const Instruction* op = reinterpret_cast<const Instruction*>(m_block_cache.GetCodePointers()[block_num]);
+	for (;; op++)
+	{
+		if (op->flags & (FLAG_BREAKPOINT | FLAG_END_BLOCK | FLAG_CHECK_FPU))
+		{
+			if (op->flags & FLAG_END_BLOCK)
+			{
+				PC = NPC;
+				PowerPC::ppcState.downcount -= op->cycles;
+				return true;
+			}
+
+			if (op->flags & FLAG_BREAKPOINT)
+			{
+				PC = op->address;
+				PowerPC::CheckBreakPoints();
+				if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+				{
+					PowerPC::ppcState.downcount -= op->cycles;
+					return false;
+				}
+				continue;
+			}
+
+			if (!((UReg_MSR&)MSR).FP)
+			{
+				PC = op->address;
+				NPC = op->address + 4;
+				Common::AtomicOr(PowerPC::ppcState.Exceptions, EXCEPTION_FPU_UNAVAILABLE);
+				PowerPC::CheckExceptions();
+				PC = NPC;
+				PowerPC::ppcState.downcount -= op->cycles;
+				return true;
+			}
+		}
+
+		PC = op->address;
+		NPC = op->address + 4;
+		op->handler(op->inst);
+
+		if ((op->flags & FLAG_CHECK_DSI) && (PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+		{
+			PowerPC::CheckExceptions();
+			PC = NPC;
+			PowerPC::ppcState.downcount -= op->cycles;
+			return true;
+		}
+	}
+}
+
+void CachedInterpreter::Jit(u32 address)
+{
+	// Every instruction takes at most three records: a breakpoint check, an HLE
+	// call and the instruction itself.
+	if (m_code.size() > CODE_SIZE - MAX_BLOCK_SIZE * 3 - 1 || m_block_cache.IsFull() ||
+	    SConfig::GetInstance().m_LocalCoreStartupParameter.bJITNoBlockCache)
+	{
+		ClearCache();
+	}
+
+	const bool debugging = SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging;
+	const size_t start = m_code.size();
+	u32 num_instructions = 0;
+	u32 cycles = 0;
+	bool fpu_checked = false;
+
+	for (u32 pc = address; num_instructions < MAX_BLOCK_SIZE; pc += 4)
+	{
+		UGeckoInstruction inst = JitInterface::ReadOpcodeJIT(pc);
+		// The fetch failed. If this is the first instruction, ExecuteBlock hands
+		// it to the interpreter; otherwise the block just ends before it.
+		if (inst.hex == 0)
+			break;
+
+		const GekkoOPInfo* opinfo = GetOpInfo(inst);
+		num_instructions++;
+
+		if (debugging && PowerPC::breakpoints.IsAddressBreakPoint(pc))
+			m_code.push_back({ nullptr, inst, pc, (u16)cycles, FLAG_BREAKPOINT });
+
+		cycles += opinfo->numCycles;
+
+		u32 function = HLE::GetFunctionIndex(pc);
+		if (function != 0)
+		{
+			int type = HLE::GetFunctionTypeByIndex(function);
+			if ((type == HLE::HLE_HOOK_START || type == HLE::HLE_HOOK_REPLACE) &&
+			    HLE::IsEnabled(HLE::GetFunctionFlagsByIndex(function)))
+			{
+				m_code.push_back({ Interpreter::HLEFunction, function, pc, (u16)cycles, 0 });
+				// The replacement sets NPC to where the function would have returned.
+				if (type == HLE::HLE_HOOK_REPLACE)
+					break;
+			}
+		}
+
+		u16 flags = 0;
+		if (!fpu_checked && PPCTables::UsesFPU(inst))
+		{
+			// MSR.FP can only change in instructions which end the block.
+			flags |= FLAG_CHECK_FPU;
+			fpu_checked = true;
+		}
+		if (opinfo->flags & FL_LOADSTORE)
+			flags |= FLAG_CHECK_DSI;
+
+		m_code.push_back({ GetInterpreterOp(inst), inst, pc, (u16)cycles, flags });
+
+		if (opinfo->flags & FL_ENDBLOCK)
+			break;
+	}
+
+	if (num_instructions == 0)
+		return;
+
+	m_code.push_back({ nullptr, 0, 0, (u16)cycles, FLAG_END_BLOCK });
+
+	int block_num = m_block_cache.AllocateBlock(address);
+	JitBlock* b = m_block_cache.GetBlock(block_num);
+	b->checkedEntry = reinterpret_cast<const u8*>(&m_code[start]);
+	b->normalEntry = b->checkedEntry;
+	b->codeSize = (u32)((m_code.size() - start) * sizeof(Instruction));
+	b->originalSize = num_instructions;
+	b->runCount = 0;
+	m_block_cache.FinalizeBlock(block_num, jo.enableBlocklink, b->checkedEntry);
+}
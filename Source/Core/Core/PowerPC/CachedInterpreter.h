@@ -0,0 +1,90 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/Gekko.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+// An interpreter which decodes each block of guest code once, into a list of
+// interpreter handlers, and walks that list on later visits instead of
+// fetching and decoding every instruction again. Blocks live in the same
+// block cache as the JITs' code, so they get invalidated the same way.
+class CachedInterpreter : public JitBase
+{
+public:
+	CachedInterpreter() {}
+	~CachedInterpreter() {}
+
+	void Init() override;
+	void Shutdown() override;
+
+	JitBaseBlockCache *GetBlockCache() override { return &m_block_cache; }
+
+	bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+
+	void ClearCache() override;
+
+	const CommonAsmRoutinesBase *GetAsmRoutines() override { return nullptr; }
+
+	void Run() override;
+	void SingleStep() override;
+
+	void Jit(u32 address) override;
+
+	const char *GetName() override
+	{
+		return "Cached Interpreter";
+	}
+
+private:
+	struct Instruction
+	{
+		Interpreter::_interpreterInstruction handler;
+		UGeckoInstruction inst;
+		u32 address;
+		// Cycles of the block up to and including this instruction.
+		u16 cycles;
+		u16 flags;
+	};
+
+	enum
+	{
+		// Not an instruction: check for a breakpoint at address.
+		FLAG_BREAKPOINT = 1 << 0,
+		// Not an instruction: the end of the block.
+		FLAG_END_BLOCK = 1 << 1,
+		// Raise an FPU unavailable exception instead if MSR.FP is clear.
+		FLAG_CHECK_FPU = 1 << 2,
+		// Leave the block if the instruction raised a DSI.
+		FLAG_CHECK_DSI = 1 << 3,
+	};
+
+	enum
+	{
+		// In instructions. Blocks normally end at a branch well before this.
+		MAX_BLOCK_SIZE = 1000,
+		// In Instruction records, reserved up front so that block pointers stay
+		// valid until the cache is cleared.
+		CODE_SIZE = 1024 * 1024,
+	};
+
+	class BlockCache : public JitBaseBlockCache
+	{
+	private:
+		// Blocks are never linked, and there is no code to patch.
+		void WriteLinkBlock(u8* location, const u8* address) override {}
+		void WriteDestroyBlock(const u8* location, u32 address) override {}
+	};
+
+	bool ExecuteBlock();
+
+	BlockCache m_block_cache;
+	std::vector<Instruction> m_code;
+};
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -205,6 +206,16 @@ void Jit64::Init()
 	code_block.m_gpa = &js.gpa;
 	code_block.m_fpa = &js.fpa;
 	EnableOptimization();
+
+	m_hot_threshold = std::max(SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold, 0);
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging)
+		m_hot_threshold = 0;
+	m_compiling_hot = true;
+	m_hot_addresses.clear();
+	m_num_cold_blocks = 0;
+	m_num_hot_blocks = 0;
+	m_num_elided_flags = 0;
+	m_num_constant_addresses = 0;
 }
 
 void Jit64::ClearCache()
@@ -218,6 +229,14 @@ void Jit64::ClearCache()
 
 void Jit64::Shutdown()
 {
+	if (m_hot_threshold)
+	{
+		NOTICE_LOG(DYNA_REC, "Compiled %u cold and %u hot blocks, %u addresses promoted at %u runs",
+		           m_num_cold_blocks, m_num_hot_blocks, (u32)m_hot_addresses.size(), m_hot_threshold);
+	}
+	NOTICE_LOG(DYNA_REC, "Elided %u flag updates, %u loads/stores used constant addresses",
+	           m_num_elided_flags, m_num_constant_addresses);
+
 	FreeStack();
 	FreeCodeSpace();
 
@@ -365,7 +384,7 @@ void Jit64::JustWriteExit(u32 destination, bool bl, u32 after)
 			JMP(asm_routines.dispatcher, true);
 	}
 
-	b->linkData.push_back(linkData);
+	blocks.AddLinkData(b, linkData);
 
 	if (bl)
 	{
@@ -430,6 +449,39 @@ void Jit64::WriteRfiExitDestInRSCRATCH()
 	JMP(asm_routines.dispatcher, true);
 }
 
+// Whether a branch can jump straight back to the loop header. Not if it calls,
+// or if Cleanup() has to call out, which would clobber the loop registers.
+bool Jit64::CanLoopBack(u32 destination, bool bl)
+{
+	return m_loop_header && destination == js.blockStart && !bl &&
+	       !(jo.optimizeGatherPipe && js.fifoBytesThisBlock > 0) && !MMCR0.Hex && !MMCR1.Hex;
+}
+
+void Jit64::WriteLoopBack()
+{
+	gpr.FlushToLoopHeader(m_loop_regs);
+	fpr.Flush(FLUSH_MAINTAIN_STATE);
+	SUB(32, PPCSTATE(downcount), Imm32(js.downcountAmount));
+	FixupBranch out_of_time = J_CC(CC_BE);
+
+	// The loop body can destroy this block (an icache flush through HID0, a DMA
+	// over it), and the header is past the checked entry which would notice.
+	MOV(64, R(RSCRATCH), ImmPtr(&js.curBlock->invalid));
+	CMP(8, MatR(RSCRATCH), Imm8(0));
+	J_CC(CC_Z, m_loop_header);
+
+	// Out of time or destroyed. Leave like the checked entry would, with the
+	// loop registers written back.
+	SetJumpTarget(out_of_time);
+	for (size_t i = 0; i < m_loop_regs.size(); i++)
+	{
+		if (m_loop_regs[i] != INVALID_REG)
+			MOV(32, PPCSTATE(gpr[i]), R(m_loop_regs[i]));
+	}
+	MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+	JMP(asm_routines.doTiming, true);
+}
+
 void Jit64::WriteExceptionExit()
 {
 	Cleanup();
@@ -500,11 +552,99 @@ void Jit64::Jit(u32 em_address)
 		ClearCache();
 	}
 
+	// Block profiling counts runs in runCount as well, so it gets hot blocks only.
+	m_compiling_hot = !m_hot_threshold || Profiler::g_ProfileBlocks || m_hot_addresses.count(em_address);
+	// Breakpoints and single stepping go by the instructions as they are laid out.
+	if (m_compiling_hot && !SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging)
+		analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_FORWARD_JUMP);
+	else
+		analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_FORWARD_JUMP);
+	if (m_compiling_hot)
+		m_num_hot_blocks++;
+	else
+		m_num_cold_blocks++;
+
 	int block_num = blocks.AllocateBlock(em_address);
 	JitBlock *b = blocks.GetBlock(block_num);
 	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b));
 }
 
+// Called from the entry of a cold block which has reached the threshold. The
+// dispatcher compiles it again right after, and LinkBlock relinks the exits
+// which pointed at the old one.
+void Jit64::PromoteBlock(u32 address)
+{
+	Jit64* jit64 = static_cast<Jit64*>(jit);
+	jit64->m_hot_addresses.insert(address);
+	int block_num = jit64->blocks.GetBlockNumberFromStartAddress(address);
+	if (block_num >= 0)
+		jit64->blocks.RetireBlock(block_num);
+}
+
+// If the block branches back to its own start, binds the GPRs it uses most
+// and marks the loop header after them. Branches back to the start then go
+// to the header instead of through the block entry, see WriteLoopBack().
+void Jit64::PreloadLoopRegisters(const PPCAnalyst::CodeOp* ops, u32 num_instructions)
+{
+	// Leave some registers for everything else.
+	const size_t MAX_LOOP_REGS = 6;
+
+	m_loop_header = nullptr;
+	m_loop_regs.fill(INVALID_REG);
+
+	// Each iteration has to go through the block entry for these. Cold blocks
+	// count iterations there too.
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging ||
+	    Profiler::g_ProfileBlocks || !jo.enableBlocklink || !m_compiling_hot)
+	{
+		return;
+	}
+
+	u32 loop_end = num_instructions;
+	for (u32 i = 0; i < num_instructions; i++)
+	{
+		UGeckoInstruction inst = ops[i].inst;
+		// dcbst, dcbf and dcbi may invalidate this very block.
+		if (inst.OPCD == 31 && (inst.SUBOP10 == 54 || inst.SUBOP10 == 86 || inst.SUBOP10 == 470))
+			return;
+
+		u32 destination;
+		// Unconditional branches only leave the block when they're the last instruction.
+		if (inst.OPCD == 18 && !inst.LK && i == num_instructions - 1)
+			destination = (inst.AA ? 0 : ops[i].address) + SignExt26(inst.LI << 2);
+		else if (inst.OPCD == 16 && !inst.LK)
+			destination = (inst.AA ? 0 : ops[i].address) + SignExt16(inst.BD << 2);
+		else
+			continue;
+
+		// A branch to itself is an idle loop, which bx handles on its own.
+		if (destination == js.blockStart && ops[i].address != js.blockStart)
+			loop_end = i;
+	}
+	if (loop_end == num_instructions)
+		return;
+
+	std::array<int, 32> uses{};
+	for (u32 i = 0; i <= loop_end; i++)
+	{
+		for (int reg : ops[i].regsIn | ops[i].regsOut)
+			uses[reg]++;
+	}
+	std::array<int, 32> order;
+	for (int i = 0; i < 32; i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return uses[a] > uses[b]; });
+
+	// They are dirty at the header, since the back edge doesn't store them.
+	for (size_t i = 0; i < MAX_LOOP_REGS && uses[order[i]]; i++)
+	{
+		gpr.BindToRegister(order[i], true, true);
+		m_loop_regs[order[i]] = gpr.RX(order[i]);
+	}
+
+	m_loop_header = GetCodePtr();
+}
+
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBlock *b)
 {
 	int blockSize = code_buf->GetSize();
@@ -559,6 +699,23 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	const u8 *normalEntry = GetCodePtr();
 	b->normalEntry = normalEntry;
 
+	if (!m_compiling_hot)
+	{
+		MOV(64, R(RSCRATCH), ImmPtr(&b->runCount));
+		ADD(32, MatR(RSCRATCH), Imm8(1));
+		CMP(32, MatR(RSCRATCH), Imm32(m_hot_threshold));
+		FixupBranch hot = J_CC(CC_AE, true);
+		SwitchToFarCode();
+		SetJumpTarget(hot);
+		ABI_PushRegistersAndAdjustStack({}, 0);
+		ABI_CallFunctionC((void *)&PromoteBlock, js.blockStart);
+		ABI_PopRegistersAndAdjustStack({}, 0);
+		// The downcount was already checked on the way in.
+		MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+		JMP(asm_routines.dispatcherNoCheck, true);
+		SwitchToNearCode();
+	}
+
 	if (ImHereDebug)
 	{
 		ABI_PushRegistersAndAdjustStack({}, 0);
@@ -586,6 +743,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	// They use the information in gpa/fpa to preload commonly used registers.
 	gpr.Start();
 	fpr.Start();
+	PreloadLoopRegisters(ops, code_block.m_num_instructions);
 
 	js.downcountAmount = 0;
 	if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging)
@@ -729,6 +887,22 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 				SetJumpTarget(noBreakpoint);
 			}
 
+			// The register cache forgets immediates when it flushes, e.g. around instructions
+			// that fall back to the interpreter. Give loads and stores back the constant
+			// addresses the analyzer found, so that they can access them directly.
+			for (int reg : ops[i].addressIsConstant)
+			{
+				u32 value = reg == ops[i].inst.RA ? ops[i].constantRA : ops[i].constantRB;
+				if (gpr.R(reg).IsImm())
+				{
+					_assert_msg_(DYNA_REC, (u32)gpr.R(reg).offset == value,
+					             "Analyzer and register cache disagree on r%d", reg);
+					continue;
+				}
+				gpr.SetImmediate32(reg, value);
+				m_num_constant_addresses++;
+			}
+
 			// If we have an input register that is going to be used again, load it pre-emptively,
 			// even if the instruction doesn't strictly need it in a register, to avoid redundant
 			// loads later. Of course, don't do this if we're already out of registers.
@@ -753,9 +927,13 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 
 			Jit64Tables::CompileInstruction(ops[i]);
 
-			// If we have a register that will never be used again, flush it.
+			// If we have a register that will never be used again, flush it. Loop
+			// registers are used again on the next iteration.
 			for (int j : ~ops[i].gprInUse)
-				gpr.StoreFromRegister(j);
+			{
+				if (m_loop_regs[j] == INVALID_REG)
+					gpr.StoreFromRegister(j);
+			}
 			for (int j : ~ops[i].fprInUse)
 				fpr.StoreFromRegister(j);
 
@@ -836,6 +1014,10 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 
 	b->codeSize = (u32)(GetCodePtr() - normalEntry);
 	b->originalSize = code_block.m_num_instructions;
+	// Forward jumps skip code, which has to invalidate the block all the same.
+	// Branches aren't reordered, so the last instruction is the furthest one.
+	if (code_block.m_num_instructions)
+		b->originalSize = (ops[code_block.m_num_instructions - 1].address - em_address) / 4 + 1;
 
 #ifdef JIT_LOG_X86
 	LogGeneratedX86(code_block.m_num_instructions, code_buf, normalEntry, b);
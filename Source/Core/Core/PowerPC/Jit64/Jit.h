@@ -54,6 +54,33 @@ private:
 	bool m_clear_cache_asap;
 	u8* m_stack;
 
+	// Set while compiling a block which branches back to its own start: where the
+	// loop body begins, and the host register each GPR is kept in there
+	// (INVALID_REG for the ones left in ppcState).
+	const u8* m_loop_header;
+	std::array<Gen::X64Reg, 32> m_loop_regs;
+
+	void PreloadLoopRegisters(const PPCAnalyst::CodeOp* ops, u32 num_instructions);
+
+	// Blocks are first compiled with the usual options, and count their runs in
+	// runCount. Once that reaches m_hot_threshold, the block is retired and its
+	// address compiled again with loop registers, and with forward jumps followed
+	// so that it covers more code. A threshold of 0 compiles every block that way
+	// from the start.
+	u32 m_hot_threshold;
+	bool m_compiling_hot;
+	std::unordered_set<u32> m_hot_addresses;
+	u32 m_num_cold_blocks;
+	u32 m_num_hot_blocks;
+
+	static void PromoteBlock(u32 address);
+
+	// CR, XER[CA] and FPRF updates left out because the analyzer found them
+	// overwritten before being read, and loads/stores whose address register the
+	// register cache had lost but the analyzer knew to be constant.
+	u32 m_num_elided_flags;
+	u32 m_num_constant_addresses;
+
 public:
 	Jit64() : code_buffer(32000) {}
 	~Jit64() {}
@@ -111,6 +138,8 @@ public:
 	void WriteRfiExitDestInRSCRATCH();
 	void WriteCallInterpreter(UGeckoInstruction _inst);
 	bool Cleanup();
+	bool CanLoopBack(u32 destination, bool bl);
+	void WriteLoopBack();
 
 	void GenerateConstantOverflow(bool overflow);
 	void GenerateConstantOverflow(s64 val);
@@ -124,6 +153,7 @@ public:
 	Gen::OpArg ExtractFromReg(int reg, int offset);
 	void AndWithMask(Gen::X64Reg reg, u32 mask);
 	bool CheckMergedBranch(int crf);
+	u32 MergedBranchDestination();
 	void DoMergedBranch();
 	void DoMergedBranchCondition();
 	void DoMergedBranchImmediate(s64 val);
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 
 #include "Core/PowerPC/Jit64/Jit.h"
@@ -261,6 +262,73 @@ void GPRRegCache::SetImmediate32(size_t preg, u32 immValue)
 	regs[preg].location = Imm32(immValue);
 }
 
+void GPRRegCache::FlushToLoopHeader(const std::array<X64Reg, 32>& bindings)
+{
+	for (size_t i = 0; i < regs.size(); i++)
+	{
+		if (bindings[i] == INVALID_REG)
+			StoreFromRegister(i, FLUSH_MAINTAIN_STATE);
+	}
+
+	// Registers which are bound, but to the wrong host register. A move can be
+	// done once no other move still has to read its destination.
+	std::array<X64Reg, 32> sources;
+	sources.fill(INVALID_REG);
+	size_t pending = 0;
+	for (size_t i = 0; i < regs.size(); i++)
+	{
+		if (bindings[i] != INVALID_REG && IsBound(i) && RX(i) != bindings[i])
+		{
+			sources[i] = RX(i);
+			pending++;
+		}
+	}
+	while (pending)
+	{
+		bool progress = false;
+		for (size_t i = 0; i < regs.size(); i++)
+		{
+			if (sources[i] == INVALID_REG)
+				continue;
+			if (std::find(sources.begin(), sources.end(), bindings[i]) != sources.end())
+				continue;
+			emit->MOV(32, ::Gen::R(bindings[i]), ::Gen::R(sources[i]));
+			sources[i] = INVALID_REG;
+			pending--;
+			progress = true;
+		}
+		if (progress)
+			continue;
+
+		// Only cycles are left. A swap finishes one move, and leaves the old value
+		// of its destination, which some other move reads, in its source.
+		size_t i = std::find_if(sources.begin(), sources.end(), [](X64Reg x) { return x != INVALID_REG; }) - sources.begin();
+		X64Reg dest = bindings[i];
+		emit->XCHG(32, ::Gen::R(dest), ::Gen::R(sources[i]));
+		for (size_t j = 0; j < regs.size(); j++)
+		{
+			if (sources[j] == dest)
+			{
+				sources[j] = sources[i];
+				if (sources[j] == bindings[j])
+				{
+					sources[j] = INVALID_REG;
+					pending--;
+				}
+			}
+		}
+		sources[i] = INVALID_REG;
+		pending--;
+	}
+
+	// Registers which are in ppcState or immediates now.
+	for (size_t i = 0; i < regs.size(); i++)
+	{
+		if (bindings[i] != INVALID_REG && !IsBound(i))
+			emit->MOV(32, ::Gen::R(bindings[i]), regs[i].location);
+	}
+}
+
 const int* GPRRegCache::GetAllocationOrder(size_t& count)
 {
 	static const int allocationOrder[] =
@@ -137,6 +137,10 @@ public:
 	Gen::OpArg GetDefaultLocation(size_t reg) const override;
 	const int* GetAllocationOrder(size_t& count) override;
 	void SetImmediate32(size_t preg, u32 immValue);
+	// Emits code which puts every register where a loop header expects it: in
+	// the given host register, or in ppcState where that is INVALID_REG. Like
+	// FLUSH_MAINTAIN_STATE, the cache state itself is left alone.
+	void FlushToLoopHeader(const std::array<Gen::X64Reg, 32>& bindings);
 	BitSet32 GetRegUtilization() override;
 	BitSet32 CountRegsIn(size_t preg, u32 lookahead) override;
 };
@@ -61,8 +61,12 @@ void Jit64::SetFPRFIfNeeded(UGeckoInstruction inst, X64Reg xmm)
 	// As far as we know, the games that use this flag only need FPRF for fmul and fmadd, but
 	// FPRF is fast enough in JIT that we might as well just enable it for every float instruction
 	// if the FPRF flag is set.
-	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bFPRF && js.op->wantsFPRF)
+	if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bFPRF)
+		return;
+	if (js.op->wantsFPRF)
 		SetFPRF(xmm);
+	else
+		m_num_elided_flags++;
 }
 
 void Jit64::fp_arith(UGeckoInstruction inst)
@@ -345,6 +349,13 @@ void Jit64::FloatCompare(UGeckoInstruction inst, bool upper)
 	int crf = inst.CRFD;
 	int output[4] = { CR_SO, CR_EQ, CR_GT, CR_LT };
 
+	// fcmp only has flag outputs, and neither is read before being set again.
+	if (!js.op->wantsCR[crf] && !fprf)
+	{
+		m_num_elided_flags++;
+		return;
+	}
+
 	// Merge neighboring fcmp and cror (the primary use of cror).
 	UGeckoInstruction next = js.next_inst;
 	if (next.OPCD == 19 && next.SUBOP10 == 449 && (next.CRBA >> 2) == crf && (next.CRBB >> 2) == crf && (next.CRBD >> 2) == crf)
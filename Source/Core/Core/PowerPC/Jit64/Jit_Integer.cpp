@@ -77,6 +77,10 @@ void Jit64::FinalizeCarry(CCFlags cond)
 			JitSetCAIf(cond);
 		}
 	}
+	else
+	{
+		m_num_elided_flags++;
+	}
 }
 
 // Unconditional version
@@ -104,6 +108,10 @@ void Jit64::FinalizeCarry(bool ca)
 			JitClearCA();
 		}
 	}
+	else
+	{
+		m_num_elided_flags++;
+	}
 }
 
 void Jit64::FinalizeCarryOverflow(bool oe, bool inv)
@@ -131,6 +139,13 @@ void Jit64::FinalizeCarryOverflow(bool oe, bool inv)
 void Jit64::ComputeRC(const Gen::OpArg & arg, bool needs_test, bool needs_sext)
 {
 	_assert_msg_(DYNA_REC, arg.IsSimpleReg() || arg.IsImm(), "Invalid ComputeRC operand");
+	// Nothing reads CR0 before it is set again. A branch merged with this
+	// instruction would be one, so there is nothing else to do either.
+	if (!js.op->wantsCR[0])
+	{
+		m_num_elided_flags++;
+		return;
+	}
 	if (arg.IsImm())
 	{
 		MOV(64, PPCSTATE(cr_val[0]), Imm32((s32)arg.offset));
@@ -222,6 +237,8 @@ void Jit64::regimmop(int d, int a, bool binary, u32 value, Operation doop, void
 	// Be careful; addic treats r0 as r0, but addi treats r0 as zero.
 	if (a || binary || carry)
 	{
+		if (carry && !js.op->wantsCA)
+			m_num_elided_flags++;
 		carry &= js.op->wantsCA;
 		if (gpr.R(a).IsImm() && !carry)
 		{
@@ -340,6 +357,14 @@ bool Jit64::CheckMergedBranch(int crf)
 	         (next.BI >> 2) == crf);
 }
 
+// The destination of a merged bcx.
+u32 Jit64::MergedBranchDestination()
+{
+	if (js.next_inst.AA)
+		return SignExt16(js.next_inst.BD << 2);
+	return js.next_compilerPC + SignExt16(js.next_inst.BD << 2);
+}
+
 void Jit64::DoMergedBranch()
 {
 	// Code that handles successful PPC branching.
@@ -348,12 +373,7 @@ void Jit64::DoMergedBranch()
 		if (js.next_inst.LK)
 			MOV(32, M(&LR), Imm32(js.next_compilerPC + 4));
 
-		u32 destination;
-		if (js.next_inst.AA)
-			destination = SignExt16(js.next_inst.BD << 2);
-		else
-			destination = js.next_compilerPC + SignExt16(js.next_inst.BD << 2);
-		WriteExit(destination, js.next_inst.LK, js.next_compilerPC + 4);
+		WriteExit(MergedBranchDestination(), js.next_inst.LK, js.next_compilerPC + 4);
 	}
 	else if ((js.next_inst.OPCD == 19) && (js.next_inst.SUBOP10 == 528)) // bcctrx
 	{
@@ -397,10 +417,17 @@ void Jit64::DoMergedBranchCondition()
 	else  // SO bit, do not branch (we don't emulate SO for cmp).
 		pDontBranch = J(true);
 
-	gpr.Flush(FLUSH_MAINTAIN_STATE);
-	fpr.Flush(FLUSH_MAINTAIN_STATE);
+	if (js.next_inst.OPCD == 16 && CanLoopBack(MergedBranchDestination(), js.next_inst.LK))
+	{
+		WriteLoopBack();
+	}
+	else
+	{
+		gpr.Flush(FLUSH_MAINTAIN_STATE);
+		fpr.Flush(FLUSH_MAINTAIN_STATE);
 
-	DoMergedBranch();
+		DoMergedBranch();
+	}
 
 	SetJumpTarget(pDontBranch);
 
@@ -431,7 +458,11 @@ void Jit64::DoMergedBranchImmediate(s64 val)
 	else  // SO bit, do not branch (we don't emulate SO for cmp).
 		branch = false;
 
-	if (branch)
+	if (branch && js.next_inst.OPCD == 16 && CanLoopBack(MergedBranchDestination(), js.next_inst.LK))
+	{
+		WriteLoopBack();
+	}
+	else if (branch)
 	{
 		gpr.Flush();
 		fpr.Flush();
@@ -455,6 +486,12 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 	int crf = inst.CRFD;
 	bool merge_branch = CheckMergedBranch(crf);
 
+	if (!js.op->wantsCR[crf])
+	{
+		m_num_elided_flags++;
+		return;
+	}
+
 	OpArg comparand;
 	bool signedCompare;
 	if (inst.OPCD == 31)
@@ -1756,6 +1793,7 @@ void Jit64::srawix(UGeckoInstruction inst)
 		gpr.BindToRegister(a, a == s, true);
 		if (!js.op->wantsCA)
 		{
+			m_num_elided_flags++;
 			if (a != s)
 				MOV(32, gpr.R(a), gpr.R(s));
 			SAR(32, gpr.R(a), Imm8(amount));
@@ -325,6 +325,8 @@ void Jit64::dcbz(UGeckoInstruction inst)
 	PXOR(XMM0, R(XMM0));
 	MOVAPS(MComplex(RMEM, RSCRATCH, SCALE_1, 0), XMM0);
 	MOVAPS(MComplex(RMEM, RSCRATCH, SCALE_1, 16), XMM0);
+	if (Memory::IsWriteTrackingEnabled())
+		MarkPhysicalWrite(RSCRATCH, 0, 32, registersInUse);
 	SetJumpTarget(exit);
 }
 
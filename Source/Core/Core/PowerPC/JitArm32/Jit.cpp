@@ -230,7 +230,7 @@ void JitArm::WriteExit(u32 destination)
 		B(A);
 	}
 
-	b->linkData.push_back(linkData);
+	blocks.AddLinkData(b, linkData);
 }
 
 void JitArm::Run()
@@ -134,7 +134,7 @@ void JitArm64::WriteExit(u32 destination)
 		gpr.Unlock(WA);
 	}
 
-	b->linkData.push_back(linkData);
+	blocks.AddLinkData(b, linkData);
 }
 void JitArm64::WriteExceptionExit(ARM64Reg dest)
 {
@@ -251,6 +251,8 @@ void CommonAsmRoutines::GenQuantizedStores()
 		too_complex = J_CC(CC_NZ, true);
 		MOV(64, R(RSCRATCH), M(&psTemp[0]));
 		SwapAndStore(64, MComplex(RMEM, RSCRATCH_EXTRA, SCALE_1, 0), RSCRATCH);
+		// RSP alignment here is 8 due to the call.
+		MarkPhysicalWrite(RSCRATCH_EXTRA, 0, 8, QUANTIZED_REGS_TO_SAVE, 8);
 		skip_complex = J(true);
 		SetJumpTarget(too_complex);
 	}
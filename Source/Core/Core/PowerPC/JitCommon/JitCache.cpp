@@ -9,12 +9,22 @@
 // performance hit, it's not enabled by default, but it's useful for
 // locating performance issues.
 
+#include <algorithm>
+#include <map>
+
 #include "disasm.h"
 
 #include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
 #include "Common/JitRegister.h"
+#include "Common/LinearDiskCache.h"
 #include "Common/MemoryUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/SamplingProfiler.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 
 #ifdef _WIN32
@@ -41,6 +51,7 @@ using namespace Gen;
 		iCache.fill(JIT_ICACHE_INVALID_BYTE);
 		iCacheEx.fill(JIT_ICACHE_INVALID_BYTE);
 		iCacheVMEM.fill(JIT_ICACHE_INVALID_BYTE);
+		pages.resize(NUM_PAGES);
 		Clear();
 
 		m_initialized = true;
@@ -69,10 +80,16 @@ using namespace Gen;
 		{
 			DestroyBlock(i, false);
 		}
-		links_to.clear();
-		block_map.clear();
+		for (u32 page : touched_pages)
+		{
+			pages[page].blocks.clear();
+			pages[page].links_to.clear();
+		}
+		touched_pages.clear();
+		link_data.clear();
 
 		valid_block.ClearAll();
+		SamplingProfiler::ClearBlocks();
 
 		num_blocks = 0;
 		blockCodePointers.fill(nullptr);
@@ -106,17 +123,34 @@ using namespace Gen;
 			return false;
 	}
 
+	JitBaseBlockCache::PageIndex& JitBaseBlockCache::GetPage(u32 address)
+	{
+		u32 page = (address & 0x1FFFFFFF) >> PAGE_SHIFT;
+		PageIndex& index = pages[page];
+		if (index.blocks.empty() && index.links_to.empty())
+			touched_pages.push_back(page);
+		return index;
+	}
+
 	int JitBaseBlockCache::AllocateBlock(u32 em_address)
 	{
 		JitBlock &b = blocks[num_blocks];
 		b.invalid = false;
 		b.memoryException = false;
 		b.originalAddress = em_address;
-		b.linkData.clear();
+		b.linkDataStart = (u32)link_data.size();
+		b.linkDataCount = 0;
 		num_blocks++; //commit the current block
 		return num_blocks - 1;
 	}
 
+	void JitBaseBlockCache::AddLinkData(JitBlock* b, const JitBlock::LinkData& data)
+	{
+		_assert_msg_(DYNA_REC, b == &blocks[num_blocks - 1], "Adding an exit to a block that isn't being compiled");
+		link_data.push_back(data);
+		b->linkDataCount++;
+	}
+
 	void JitBaseBlockCache::FinalizeBlock(int block_num, bool block_link, const u8 *code_ptr)
 	{
 		blockCodePointers[block_num] = code_ptr;
@@ -130,7 +164,8 @@ using namespace Gen;
 		for (u32 block = pAddr / 32; block <= (pAddr + (b.originalSize - 1) * 4) / 32; ++block)
 			valid_block.Set(block);
 
-		block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
+		for (u32 addr = pAddr & ~((1 << PAGE_SHIFT) - 1); addr <= pAddr + (b.originalSize - 1) * 4; addr += 1 << PAGE_SHIFT)
+			GetPage(addr).blocks.push_back(block_num);
 
 		// Blocks where a memory exception (ISI) occurred in the instruction fetch have to
 		// execute the ISI handler as the next instruction. These blocks cannot be
@@ -138,17 +173,28 @@ using namespace Gen;
 		// and so we do not link other blocks to it either.
 		if (block_link && !b.memoryException)
 		{
-			for (const auto& e : b.linkData)
+			for (u32 j = 0; j < b.linkDataCount; j++)
 			{
-				links_to.insert(std::pair<u32, int>(e.exitAddress, block_num));
+				u32 exit_address = link_data[b.linkDataStart + j].exitAddress;
+				GetPage(exit_address).links_to.emplace_back(exit_address, block_num);
 			}
 
 			LinkBlock(block_num);
 			LinkBlockExits(block_num);
 		}
 
+		// Looking up a symbol which doesn't start at the block scans all of them,
+		// so only name the block after its function when there is a perf map.
+		std::string name = "JIT_PPC";
+		if (!SConfig::GetInstance().m_LocalCoreStartupParameter.m_perfDir.empty())
+		{
+			if (Symbol* symbol = g_symbolDB.GetSymbolFromAddr(b.originalAddress))
+				name += "_" + symbol->name;
+		}
 		JitRegister::Register(blockCodePointers[block_num], b.codeSize,
-			"JIT_PPC", b.originalAddress);
+			name.c_str(), b.originalAddress);
+		SamplingProfiler::RegisterBlock(b.checkedEntry,
+			(u32)(b.normalEntry + b.codeSize - b.checkedEntry), b.originalAddress);
 	}
 
 	const u8 **JitBaseBlockCache::GetCodePointers()
@@ -200,8 +246,9 @@ using namespace Gen;
 			// This block is dead. Don't relink it.
 			return;
 		}
-		for (auto& e : b.linkData)
+		for (u32 j = 0; j < b.linkDataCount; j++)
 		{
+			JitBlock::LinkData& e = link_data[b.linkDataStart + j];
 			if (!e.linkStatus)
 			{
 				int destinationBlock = GetBlockNumberFromStartAddress(e.exitAddress);
@@ -218,38 +265,31 @@ using namespace Gen;
 	{
 		LinkBlockExits(i);
 		JitBlock &b = blocks[i];
-		// equal_range(b) returns pair<iterator,iterator> representing the range
-		// of element with key b
-		auto ppp = links_to.equal_range(b.originalAddress);
-
-		if (ppp.first == ppp.second)
-			return;
-
-		for (auto iter = ppp.first; iter != ppp.second; ++iter)
+		for (const auto& link : pages[(b.originalAddress & 0x1FFFFFFF) >> PAGE_SHIFT].links_to)
 		{
-			// PanicAlert("Linking block %i to block %i", iter->second, i);
-			LinkBlockExits(iter->second);
+			if (link.first == b.originalAddress)
+				LinkBlockExits(link.second);
 		}
 	}
 
-	void JitBaseBlockCache::UnlinkBlock(int i)
+	void JitBaseBlockCache::UnlinkBlock(int i, bool keep_links)
 	{
 		JitBlock &b = blocks[i];
-		auto ppp = links_to.equal_range(b.originalAddress);
+		auto& links_to = pages[(b.originalAddress & 0x1FFFFFFF) >> PAGE_SHIFT].links_to;
+		auto it = std::remove_if(links_to.begin(), links_to.end(), [&](const std::pair<u32, int>& link) {
+			if (link.first != b.originalAddress)
+				return false;
 
-		if (ppp.first == ppp.second)
-			return;
-
-		for (auto iter = ppp.first; iter != ppp.second; ++iter)
-		{
-			JitBlock &sourceBlock = blocks[iter->second];
-			for (auto& e : sourceBlock.linkData)
+			JitBlock &sourceBlock = blocks[link.second];
+			for (u32 j = 0; j < sourceBlock.linkDataCount; j++)
 			{
+				JitBlock::LinkData& e = link_data[sourceBlock.linkDataStart + j];
 				if (e.exitAddress == b.originalAddress)
 					e.linkStatus = false;
 			}
-		}
-		links_to.erase(b.originalAddress);
+			return !keep_links;
+		});
+		links_to.erase(it, links_to.end());
 	}
 
 	void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
@@ -269,7 +309,7 @@ using namespace Gen;
 		b.invalid = true;
 		*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
 
-		UnlinkBlock(block_num);
+		UnlinkBlock(block_num, false);
 
 		// Send anyone who tries to run this block back to the dispatcher.
 		// Not entirely ideal, but .. pretty good.
@@ -277,6 +317,19 @@ using namespace Gen;
 		WriteDestroyBlock(b.checkedEntry, b.originalAddress);
 	}
 
+	void JitBaseBlockCache::RetireBlock(int block_num)
+	{
+		JitBlock &b = blocks[block_num];
+		if (b.invalid)
+			return;
+		b.invalid = true;
+		*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
+
+		UnlinkBlock(block_num, true);
+
+		WriteDestroyBlock(b.checkedEntry, b.originalAddress);
+	}
+
 	void JitBaseBlockCache::InvalidateICache(u32 address, const u32 length, bool forced)
 	{
 		// Convert the logical address to a physical address for the block map
@@ -293,20 +346,26 @@ using namespace Gen;
 		}
 
 		// destroy JIT blocks
-		// !! this works correctly under assumption that any two overlapping blocks end at the same address
-		if (destroy_block)
+		if (destroy_block && length)
 		{
-			std::map<std::pair<u32,u32>, u32>::iterator it1 = block_map.lower_bound(std::make_pair(pAddr, 0)), it2 = it1;
-			while (it2 != block_map.end() && it2->first.second < pAddr + length)
-			{
-				JitBlock &b = blocks[it2->second];
-				*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
-				DestroyBlock(it2->second, true);
-				++it2;
-			}
-			if (it1 != it2)
+			u64 pEnd = (u64)pAddr + length;
+			u32 last_page = (u32)std::min<u64>((pEnd - 1) >> PAGE_SHIFT, NUM_PAGES - 1);
+			for (u32 page = pAddr >> PAGE_SHIFT; page <= last_page; ++page)
 			{
-				block_map.erase(it1, it2);
+				std::vector<int>& page_blocks = pages[page].blocks;
+				auto it = std::remove_if(page_blocks.begin(), page_blocks.end(), [&](int block_num) {
+					JitBlock &b = blocks[block_num];
+					if (b.invalid)
+						return true;
+
+					u32 start = b.originalAddress & 0x1FFFFFFF;
+					if (start >= pEnd || start + 4 * b.originalSize <= pAddr)
+						return false;
+
+					DestroyBlock(block_num, true);
+					return true;
+				});
+				page_blocks.erase(it, page_blocks.end());
 			}
 
 			// If the code was actually modified, we need to clear the relevant entries from the
@@ -321,6 +380,94 @@ using namespace Gen;
 		}
 	}
 
+	// Returns 0 if the code isn't in RAM, which Adler-32 never produces otherwise.
+	static u32 HashGuestCode(u32 address, u32 size)
+	{
+		if (size == 0 || !Memory::IsRAMAddress(address) || !Memory::IsRAMAddress(address + (size - 1) * 4))
+			return 0;
+		return HashAdler32(Memory::GetPointer(address), size * 4);
+	}
+
+	class JitBlockProfileReader : public LinearDiskCacheReader<u32, JitBlockProfile>
+	{
+	public:
+		void Read(const u32& key, const JitBlockProfile* value, u32 value_size) override
+		{
+			if (value_size == 1)
+				entries[key] = *value;
+		}
+
+		std::map<u32, JitBlockProfile> entries;
+	};
+
+	void JitBaseBlockCache::SaveProfile(const std::string& filename)
+	{
+		JitBlockProfileReader reader;
+		LinearDiskCache<u32, JitBlockProfile> cache;
+		cache.OpenAndRead(filename, reader);
+		cache.Close();
+
+		for (int i = 0; i < num_blocks; i++)
+		{
+			const JitBlock& b = blocks[i];
+			if (b.invalid)
+				continue;
+
+			JitBlockProfile profile = { HashGuestCode(b.originalAddress, b.originalSize), b.originalSize, (u32)b.runCount };
+			if (!profile.hash)
+				continue;
+
+			// Keep the highest count seen, so that blocks from previous sessions
+			// (or dropped by a cache clear) don't all sink to the bottom.
+			auto it = reader.entries.find(b.originalAddress);
+			if (it != reader.entries.end() && it->second.hash == profile.hash)
+				profile.runCount = std::max(profile.runCount, it->second.runCount);
+			reader.entries[b.originalAddress] = profile;
+		}
+
+		std::vector<std::pair<u32, JitBlockProfile>> entries(reader.entries.begin(), reader.entries.end());
+		std::stable_sort(entries.begin(), entries.end(), [](const std::pair<u32, JitBlockProfile>& a, const std::pair<u32, JitBlockProfile>& b) {
+			return a.second.runCount > b.second.runCount;
+		});
+		if (entries.size() > MAX_NUM_BLOCKS / 2)
+			entries.resize(MAX_NUM_BLOCKS / 2);
+
+		// Rewrite the file from scratch rather than appending duplicates.
+		File::Delete(filename);
+		cache.OpenAndRead(filename, reader);
+		for (const auto& entry : entries)
+			cache.Append(entry.first, &entry.second, 1);
+		cache.Close();
+
+		INFO_LOG(DYNA_REC, "Saved %u blocks to JIT profile %s", (u32)entries.size(), filename.c_str());
+	}
+
+	std::vector<u32> JitBaseBlockCache::LoadProfile(const std::string& filename)
+	{
+		std::vector<u32> addresses;
+		if (!File::Exists(filename))
+			return addresses;
+
+		JitBlockProfileReader reader;
+		LinearDiskCache<u32, JitBlockProfile> cache;
+		cache.OpenAndRead(filename, reader);
+		cache.Close();
+
+		std::vector<std::pair<u32, JitBlockProfile>> entries(reader.entries.begin(), reader.entries.end());
+		std::stable_sort(entries.begin(), entries.end(), [](const std::pair<u32, JitBlockProfile>& a, const std::pair<u32, JitBlockProfile>& b) {
+			return a.second.runCount > b.second.runCount;
+		});
+
+		for (const auto& entry : entries)
+		{
+			if (HashGuestCode(entry.first, entry.second.size) == entry.second.hash)
+				addresses.push_back(entry.first);
+		}
+
+		INFO_LOG(DYNA_REC, "JIT profile %s: %u of %u blocks still match", filename.c_str(), (u32)addresses.size(), (u32)entries.size());
+		return addresses;
+	}
+
 	void JitBlockCache::WriteLinkBlock(u8* location, const u8* address)
 	{
 		XEmitter emit(location);
@@ -6,8 +6,9 @@
 
 #include <array>
 #include <bitset>
-#include <map>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "Core/PowerPC/Gekko.h"
@@ -50,7 +51,10 @@ struct JitBlock
 		u32 exitAddress;
 		bool linkStatus; // is it already linked?
 	};
-	std::vector<LinkData> linkData;
+	// This block's exits, stored contiguously in the block cache's link data
+	// pool (see JitBaseBlockCache::AddLinkData).
+	u32 linkDataStart;
+	u32 linkDataCount;
 
 	// we don't really need to save start and stop
 	// TODO (mb2): ticStart and ticStop -> "local var" mean "in block" ... low priority ;)
@@ -61,6 +65,14 @@ struct JitBlock
 
 typedef void (*CompiledCode)();
 
+// One entry of the on-disk block profile, keyed by the block's start address.
+struct JitBlockProfile
+{
+	u32 hash;      // HashAdler32 of the guest code the block was compiled from
+	u32 size;      // in instructions
+	u32 runCount;
+};
+
 // This is essentially just an std::bitset, but Visual Studia 2013's
 // implementation of std::bitset is slow.
 class ValidBlockBitSet final
@@ -105,21 +117,39 @@ class JitBaseBlockCache
 	enum
 	{
 		MAX_NUM_BLOCKS = 65536 * 2,
+		// Blocks and links are indexed by 4 KiB pages of physical memory.
+		PAGE_SHIFT = 12,
+		NUM_PAGES = 0x20000000 >> PAGE_SHIFT,
+	};
+
+	struct PageIndex
+	{
+		// Blocks whose code overlaps this page. May contain blocks that have
+		// since been destroyed; those are dropped when the page is scanned.
+		std::vector<int> blocks;
+		// (exit address, source block) for every linkable exit into this page.
+		std::vector<std::pair<u32, int>> links_to;
 	};
 
 	std::array<const u8*, MAX_NUM_BLOCKS> blockCodePointers;
 	std::array<JitBlock, MAX_NUM_BLOCKS> blocks;
 	int num_blocks;
-	std::multimap<u32, int> links_to;
-	std::map<std::pair<u32,u32>, u32> block_map; // (end_addr, start_addr) -> number
+	// Exits of all blocks, see JitBlock::linkDataStart. Only ever grows until
+	// Clear(), like num_blocks, and keeps its capacity across clears.
+	std::vector<JitBlock::LinkData> link_data;
+	// Flat page table, so that range invalidation and linking touch only the
+	// pages involved. touched_pages lists the pages Clear() has to reset.
+	std::vector<PageIndex> pages;
+	std::vector<u32> touched_pages;
 	ValidBlockBitSet valid_block;
 
 	bool m_initialized;
 
 	bool RangeIntersect(int s1, int e1, int s2, int e2) const;
+	PageIndex& GetPage(u32 address);
 	void LinkBlockExits(int i);
 	void LinkBlock(int i);
-	void UnlinkBlock(int i);
+	void UnlinkBlock(int i, bool keep_links);
 
 	// Virtual for overloaded
 	virtual void WriteLinkBlock(u8* location, const u8* address) = 0;
@@ -131,6 +161,8 @@ public:
 	}
 
 	int AllocateBlock(u32 em_address);
+	// Records an exit of the block being compiled, which must be the last one allocated.
+	void AddLinkData(JitBlock* b, const JitBlock::LinkData& data);
 	void FinalizeBlock(int block_num, bool block_link, const u8 *code_ptr);
 
 	void Clear();
@@ -159,6 +191,17 @@ public:
 	// DOES NOT WORK CORRECTLY WITH INLINING
 	void InvalidateICache(u32 address, const u32 length, bool forced);
 	void DestroyBlock(int block_num, bool invalidate);
+	// Destroys a block which is about to be compiled again from the same code.
+	// Unlike DestroyBlock, the exits linked to it are remembered, so that
+	// LinkBlock points them at the new block once it is finalized.
+	void RetireBlock(int block_num);
+
+	// Block profile: the start addresses of the blocks compiled for a game, so
+	// that the next boot can compile them before the game starts running.
+	// SaveProfile merges the current blocks into the file. LoadProfile returns
+	// the addresses whose guest code is unchanged, most executed first.
+	void SaveProfile(const std::string& filename);
+	std::vector<u32> LoadProfile(const std::string& filename);
 };
 
 // x86 BlockCache
@@ -7,6 +7,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
 
+#include "Core/HW/Memmap.h"
 #include "Core/HW/MMIO.h"
 #include "Core/PowerPC/JitCommon/Jit_Util.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
@@ -566,6 +567,10 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
 
 		registersInUseAtLoc[mov] = registersInUse;
 		pcAtLoc[mov] = jit->js.compilerPC;
+
+		// After the backpatch region, so that a backpatched store skips to here.
+		if (Memory::IsWriteTrackingEnabled())
+			MarkPhysicalWrite(reg_addr, offset, accessSize >> 3, registersInUse);
 		return;
 	}
 
@@ -640,13 +645,57 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
 	SetJumpTarget(exit);
 }
 
+void EmuCodeBlock::MarkPhysicalWrite(X64Reg reg_addr, s32 offset, int size, BitSet32 registersInUse, size_t rsp_alignment)
+{
+	// Only segments 0x0 and 0x1 hold physical RAM. Marking a range that isn't
+	// RAM is a no-op, and so is marking while tracking is disabled, which the
+	// asm routines can't know about when they are generated.
+	TEST(32, R(reg_addr), Imm32(0xE0000000));
+	FixupBranch physical, exit;
+	if (farcode.Enabled())
+	{
+		physical = J_CC(CC_Z, true);
+		SwitchToFarCode();
+		SetJumpTarget(physical);
+	}
+	else
+	{
+		exit = J_CC(CC_NZ, true);
+	}
+
+	ABI_PushRegistersAndAdjustStack(registersInUse, rsp_alignment);
+	LEA(32, ABI_PARAM1, MDisp(reg_addr, offset));
+	MOV(32, R(ABI_PARAM2), Imm32(size));
+	ABI_CallFunction((void *)&Memory::MarkWritten);
+	ABI_PopRegistersAndAdjustStack(registersInUse, rsp_alignment);
+
+	if (farcode.Enabled())
+	{
+		exit = J(true);
+		SwitchToNearCode();
+	}
+	SetJumpTarget(exit);
+}
+
 void EmuCodeBlock::WriteToConstRamAddress(int accessSize, OpArg arg, u32 address, bool swap)
 {
+	OpArg dest = MDisp(RMEM, address & 0x3FFFFFFF);
+	// The physical view isn't write protected, so store through the mirror
+	// when write tracking needs to see it, also for physical addresses, whose
+	// mirror is at 0x8/0x9. RSCRATCH2 is free here.
+	const u32 segment = address >> 28;
+	if (Memory::IsWriteTrackingEnabled() &&
+	    (segment == 0x0 || segment == 0x1 || segment == 0x8 || segment == 0x9 || segment == 0xC || segment == 0xD))
+	{
+		MOV(64, R(RSCRATCH2), ImmPtr(Memory::base + (address | 0x80000000)));
+		dest = MatR(RSCRATCH2);
+	}
+
 	X64Reg reg;
 	if (arg.IsImm())
 	{
 		arg = SwapImmediate(accessSize, arg);
-		MOV(accessSize, MDisp(RMEM, address & 0x3FFFFFFF), arg);
+		MOV(accessSize, dest, arg);
 		return;
 	}
 
@@ -661,9 +710,9 @@ void EmuCodeBlock::WriteToConstRamAddress(int accessSize, OpArg arg, u32 address
 	}
 
 	if (swap)
-		SwapAndStore(accessSize, MDisp(RMEM, address & 0x3FFFFFFF), reg);
+		SwapAndStore(accessSize, dest, reg);
 	else
-		MOV(accessSize, MDisp(RMEM, address & 0x3FFFFFFF), R(reg));
+		MOV(accessSize, dest, R(reg));
 }
 
 void EmuCodeBlock::ForceSinglePrecisionS(X64Reg output, X64Reg input)
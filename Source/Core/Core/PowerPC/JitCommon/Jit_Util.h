@@ -117,6 +117,11 @@ public:
 		return swap && !cpu_info.bMOVBE && accessSize > 8;
 	}
 
+	// Fastmem stores to the physical view at 0x0/0x1 (real mode) aren't seen by
+	// Memory's write tracking, which only protects the mirrors. This marks the
+	// written range when reg_addr + offset is in that view.
+	void MarkPhysicalWrite(Gen::X64Reg reg_addr, s32 offset, int size, BitSet32 registersInUse, size_t rsp_alignment = 0);
+
 	void WriteToConstRamAddress(int accessSize, Gen::OpArg arg, u32 address, bool swap = true);
 	// returns true if an exception could have been caused
 	bool WriteToConstAddress(int accessSize, Gen::OpArg arg, u32 address, BitSet32 registersInUse);
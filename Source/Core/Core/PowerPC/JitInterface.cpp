@@ -12,8 +12,11 @@
 #include "Common/PerformanceCounter.h"
 #endif
 
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
+#include "Core/PowerPC/CachedInterpreter.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PPCSymbolDB.h"
 #include "Core/PowerPC/Profiler.h"
@@ -80,6 +83,11 @@ namespace JitInterface
 				break;
 			}
 			#endif
+			case 5:
+			{
+				ptr = new CachedInterpreter();
+				break;
+			}
 			default:
 			{
 				PanicAlert("Unrecognizable cpu_core: %d", core);
@@ -121,6 +129,11 @@ namespace JitInterface
 				break;
 			}
 			#endif
+			case 5:
+			{
+				// Uses the interpreter's tables, which are always initialized.
+				break;
+			}
 			default:
 			{
 				PanicAlert("Unrecognizable cpu_core: %d", core);
@@ -181,8 +194,54 @@ namespace JitInterface
 			}
 		}
 	}
+
+	static std::string GetBlockProfileFilename()
+	{
+		const SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+		if (!params.bJITBlockProfileCache || params.m_strUniqueID.empty())
+			return "";
+		return StringFromFormat("%sjit-%s.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(), params.m_strUniqueID.c_str());
+	}
+
+	void PrecompileFromBlockProfile()
+	{
+		std::string filename = GetBlockProfileFilename();
+		if (!jit || filename.empty())
+			return;
+
+		JitBaseBlockCache* block_cache = jit->GetBlockCache();
+		int compiled = 0;
+		for (u32 address : block_cache->LoadProfile(filename))
+		{
+			// Jit() clears the whole cache when it is full, which would throw
+			// away what we just compiled.
+			if (block_cache->IsFull())
+				break;
+			if (block_cache->GetBlockNumberFromStartAddress(address) >= 0)
+				continue;
+			jit->Jit(address);
+			compiled++;
+		}
+		NOTICE_LOG(DYNA_REC, "Precompiled %d blocks from %s", compiled, filename.c_str());
+	}
+
+	void SaveBlockProfile()
+	{
+		std::string filename = GetBlockProfileFilename();
+		if (!jit || filename.empty())
+			return;
+
+		if (!File::Exists(File::GetUserPath(D_SHADERCACHE_IDX)))
+			File::CreateDir(File::GetUserPath(D_SHADERCACHE_IDX));
+		jit->GetBlockCache()->SaveProfile(filename);
+	}
+
 	bool HandleFault(uintptr_t access_address, SContext* ctx)
 	{
+		// Stores to write-protected pages that are being watched for the texture cache.
+		if (Memory::HandleWriteFault(access_address))
+			return true;
+
 		return jit->HandleFault(access_address, ctx);
 	}
 
@@ -25,6 +25,11 @@ namespace JitInterface
 	// Debugging
 	void WriteProfileResults(const std::string& filename);
 
+	// Per-game block profile, stored next to the shader caches. Must be called
+	// on the CPU thread while no JIT code is running.
+	void PrecompileFromBlockProfile();
+	void SaveBlockProfile();
+
 	// Memory Utilities
 	bool HandleFault(uintptr_t access_address, SContext* ctx);
 
@@ -10,6 +10,7 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/GeckoCode.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PPCAnalyst.h"
@@ -431,7 +432,7 @@ void PPCAnalyzer::ReorderInstructionsCore(u32 instructions, CodeOp* code, bool r
 			CodeOp &b = code[i + increment];
 			// Reorder integer compares, rlwinm., and carry-affecting ops
 			// (if we add more merged branch instructions, add them here!)
-			if ((type == REORDER_CROR && isCror(a)) || (type == REORDER_CARRY && isCarryOp(a)) || (type == REORDER_CMP && (isCmp(a) || a.outputCR0)))
+			if ((type == REORDER_CROR && isCror(a)) || (type == REORDER_CARRY && isCarryOp(a)) || (type == REORDER_CMP && (isCmp(a) || a.outputCR[0])))
 			{
 				// once we're next to a carry instruction, don't move away!
 				if (type == REORDER_CARRY && i != start)
@@ -474,32 +475,119 @@ void PPCAnalyzer::ReorderInstructions(u32 instructions, CodeOp *code)
 		ReorderInstructionsCore(instructions, code, false, REORDER_CMP);
 }
 
-void PPCAnalyzer::SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInfo *opinfo, u32 index)
+// If the instruction sets a GPR to a value which follows from the constant GPRs before it,
+// returns that register and stores the value in result. Otherwise returns -1.
+static int EvaluateConstant(const CodeOp& op, BitSet32 is_constant, const u32* constants, u32* result)
 {
-	code->wantsCR0 = false;
-	code->wantsCR1 = false;
+	const UGeckoInstruction inst = op.inst;
+	switch (inst.OPCD)
+	{
+	case 14: // addi
+	case 15: // addis
+	{
+		u32 imm = inst.OPCD == 14 ? (u32)(s32)inst.SIMM_16 : (u32)inst.SIMM_16 << 16;
+		if (inst.RA == 0)
+			*result = imm;
+		else if (is_constant[inst.RA])
+			*result = constants[inst.RA] + imm;
+		else
+			return -1;
+		return inst.RD;
+	}
+	case 24: // ori
+	case 25: // oris
+	case 26: // xori
+	case 27: // xoris
+	{
+		if (!is_constant[inst.RS])
+			return -1;
+		u32 imm = (inst.OPCD & 1) ? inst.UIMM << 16 : inst.UIMM;
+		*result = inst.OPCD < 26 ? constants[inst.RS] | imm : constants[inst.RS] ^ imm;
+		return inst.RA;
+	}
+	case 31:
+		if (inst.SUBOP10 == 444 && is_constant[inst.RS] && is_constant[inst.RB]) // or, mr
+		{
+			*result = constants[inst.RS] | constants[inst.RB];
+			return inst.RA;
+		}
+		if (inst.SUBOP10 == 266 && is_constant[inst.RA] && is_constant[inst.RB]) // add
+		{
+			*result = constants[inst.RA] + constants[inst.RB];
+			return inst.RD;
+		}
+		return -1;
+	default:
+		return -1;
+	}
+}
 
+void PPCAnalyzer::SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInfo *opinfo, u32 index)
+{
 	if (opinfo->flags & FL_USE_FPU)
 		block->m_fpa->any = true;
 
 	if (opinfo->flags & FL_TIMER)
 		block->m_gpa->anyTimer = true;
 
-	// Does the instruction output CR0?
-	if (opinfo->flags & FL_RC_BIT)
-		code->outputCR0 = code->inst.hex & 1; //todo fix
-	else if ((opinfo->flags & FL_SET_CRn) && code->inst.CRFD == 0)
-		code->outputCR0 = true;
-	else
-		code->outputCR0 = (opinfo->flags & FL_SET_CR0) ? true : false;
+	// Which CR fields does the instruction overwrite?
+	code->outputCR = BitSet32(0);
+	if (((opinfo->flags & FL_RC_BIT) && code->inst.Rc) || (opinfo->flags & FL_SET_CR0))
+		code->outputCR[0] = true;
+	if (((opinfo->flags & FL_RC_BIT_F) && code->inst.Rc) || (opinfo->flags & FL_SET_CR1))
+		code->outputCR[1] = true;
+	if (opinfo->flags & FL_SET_CRn)
+		code->outputCR[code->inst.CRFD] = true;
+	if (code->inst.OPCD == 31 && code->inst.SUBOP10 == 20) // lwarx
+	{
+		// Only stwcx. sets CR0, despite the flag.
+		code->outputCR = BitSet32(0);
+	}
+	else if (code->inst.OPCD == 31 && code->inst.SUBOP10 == 144) // mtcrf
+	{
+		code->outputCR = BitSet32(0);
+		for (int i = 0; i < 8; i++)
+			code->outputCR[i] = (code->inst.CRM & (0x80 >> i)) != 0;
+	}
 
-	// Does the instruction output CR1?
-	if (opinfo->flags & FL_RC_BIT_F)
-		code->outputCR1 = code->inst.hex & 1; //todo fix
-	else if ((opinfo->flags & FL_SET_CRn) && code->inst.CRFD == 1)
-		code->outputCR1 = true;
-	else
-		code->outputCR1 = (opinfo->flags & FL_SET_CR1) ? true : false;
+	// Which CR fields does the instruction read?
+	code->wantsCR = BitSet32(0);
+	if (code->inst.OPCD == 16) // bcx
+	{
+		if (!(code->inst.BO & BO_DONT_CHECK_CONDITION))
+			code->wantsCR[code->inst.BI >> 2] = true;
+	}
+	else if (code->inst.OPCD == 19)
+	{
+		switch (code->inst.SUBOP10)
+		{
+		case 0: // mcrf
+			code->wantsCR[code->inst.CRFS] = true;
+			break;
+		case 16:  // bclrx
+		case 528: // bcctrx
+			if (!(code->inst.BO_2 & BO_DONT_CHECK_CONDITION))
+				code->wantsCR[code->inst.BI_2 >> 2] = true;
+			break;
+		case 33:  // crnor
+		case 129: // crandc
+		case 193: // crxor
+		case 225: // crnand
+		case 257: // crand
+		case 289: // creqv
+		case 417: // crorc
+		case 449: // cror
+			// These only write one bit of the destination field.
+			code->wantsCR[code->inst.CRBA >> 2] = true;
+			code->wantsCR[code->inst.CRBB >> 2] = true;
+			code->wantsCR[code->inst.CRBD >> 2] = true;
+			break;
+		}
+	}
+	else if (code->inst.OPCD == 31 && code->inst.SUBOP10 == 19) // mfcr
+	{
+		code->wantsCR = BitSet32(0xFF);
+	}
 
 	code->wantsFPRF = (opinfo->flags & FL_READ_FPRF) ? true : false;
 	code->outputFPRF = (opinfo->flags & FL_SET_FPRF) ? true : false;
@@ -606,12 +694,6 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInf
 	case OPTYPE_DOUBLEFP:
 		break;
 	case OPTYPE_BRANCH:
-		if (code->inst.hex == 0x4e800020)
-		{
-			// For analysis purposes, we can assume that blr eats opinfo->flags.
-			code->outputCR0 = true;
-			code->outputCR1 = true;
-		}
 		break;
 	case OPTYPE_SYSTEM:
 	case OPTYPE_SYSTEMFP:
@@ -684,6 +766,12 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 
 			SetInstructionStats(block, &code[i], opinfo, i);
 
+			// HLE functions run before the instruction they are hooked to, and may
+			// leave the block there.
+			code[i].isHLEHooked = HLE::GetFunctionIndex(address) != 0;
+			if (code[i].isHLEHooked)
+				code[i].canEndBlock = true;
+
 			bool follow = false;
 			u32 destination = 0;
 
@@ -765,6 +853,21 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 				}
 			}
 
+			// Do we follow forward jumps?
+			if (HasOption(OPTION_FORWARD_JUMP) && inst.OPCD == 18 && !inst.AA && !inst.LK)
+			{
+				u32 target = address + SignExt26(inst.LI << 2);
+				// Staying in the page keeps a single address translation for the
+				// whole block.
+				if (target > address && (target >> 12) == (block->m_address >> 12))
+				{
+					// The JIT only branches at the last instruction of the block.
+					code[i].canEndBlock = false;
+					address = target;
+					continue;
+				}
+			}
+
 			if (!follow)
 			{
 				address += 4;
@@ -810,24 +913,26 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 
 	// Scan for flag dependencies; assume the next block (or any branch that can leave the block)
 	// wants flags, to be safe.
-	bool wantsCR0 = true, wantsCR1 = true, wantsFPRF = true, wantsCA = true;
+	// Exceptions taken in the middle of a block return to the instruction they were taken at,
+	// so only the exits need to count as reads.
+	const BitSet32 ALL_CR_FIELDS(0xFF);
+	BitSet32 wantsCR = ALL_CR_FIELDS;
+	bool wantsFPRF = true, wantsCA = true;
 	BitSet32 fprInUse, gprInUse, gprInReg, fprInXmm;
 	for (int i = block->m_num_instructions - 1; i >= 0; i--)
 	{
-		bool opWantsCR0 = code[i].wantsCR0;
-		bool opWantsCR1 = code[i].wantsCR1;
+		BitSet32 opWantsCR = code[i].wantsCR;
 		bool opWantsFPRF = code[i].wantsFPRF;
 		bool opWantsCA = code[i].wantsCA;
-		code[i].wantsCR0 = wantsCR0 || code[i].canEndBlock;
-		code[i].wantsCR1 = wantsCR1 || code[i].canEndBlock;
+		if (code[i].canEndBlock)
+			wantsCR = ALL_CR_FIELDS;
+		code[i].wantsCR = wantsCR;
 		code[i].wantsFPRF = wantsFPRF || code[i].canEndBlock;
 		code[i].wantsCA = wantsCA || code[i].canEndBlock;
-		wantsCR0 |= opWantsCR0 || code[i].canEndBlock;
-		wantsCR1 |= opWantsCR1 || code[i].canEndBlock;
+		wantsCR |= opWantsCR;
 		wantsFPRF |= opWantsFPRF || code[i].canEndBlock;
 		wantsCA |= opWantsCA || code[i].canEndBlock;
-		wantsCR0 &= !code[i].outputCR0 || opWantsCR0;
-		wantsCR1 &= !code[i].outputCR1 || opWantsCR1;
+		wantsCR &= ~code[i].outputCR | opWantsCR;
 		wantsFPRF &= !code[i].outputFPRF || opWantsFPRF;
 		wantsCA &= !code[i].outputCA || opWantsCA;
 		code[i].gprInUse = gprInUse;
@@ -890,6 +995,39 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 				fprIsStoreSafe = BitSet32(0);
 		}
 	}
+
+	// Forward scan for GPRs with values known at compile time, mostly addresses built with
+	// lis/addi/ori for the loads and stores after them.
+	BitSet32 gprIsConstant;
+	u32 gprConstant[32] = {};
+	for (u32 i = 0; i < block->m_num_instructions; i++)
+	{
+		// HLE functions may write any register.
+		if (code[i].isHLEHooked)
+			gprIsConstant = BitSet32(0);
+		if (code[i].opinfo->flags & FL_LOADSTORE)
+		{
+			BitSet32 address_regs;
+			address_regs[code[i].inst.RA] = true;
+			if (code[i].inst.OPCD == 31)
+				address_regs[code[i].inst.RB] = true;
+			code[i].addressIsConstant = address_regs & code[i].regsIn & gprIsConstant;
+			code[i].constantRA = gprConstant[code[i].inst.RA];
+			code[i].constantRB = gprConstant[code[i].inst.RB];
+		}
+
+		u32 value;
+		int reg = EvaluateConstant(code[i], gprIsConstant, gprConstant, &value);
+		gprIsConstant &= ~code[i].regsOut;
+		if (reg >= 0)
+		{
+			gprIsConstant[reg] = true;
+			gprConstant[reg] = value;
+		}
+		// lswx/lswi write more registers than they list.
+		if (code[i].inst.OPCD == 31 && (code[i].inst.SUBOP10 == 533 || code[i].inst.SUBOP10 == 597))
+			gprIsConstant = BitSet32(0);
+	}
 	return address;
 }
 
@@ -20,7 +20,7 @@ struct Symbol;
 namespace PPCAnalyst
 {
 
-struct CodeOp //16B
+struct CodeOp // 104B on x86-64
 {
 	UGeckoInstruction inst;
 	GekkoOPInfo * opinfo;
@@ -32,16 +32,18 @@ struct CodeOp //16B
 	BitSet32 fregsIn;
 	s8 fregOut;
 	bool isBranchTarget;
-	bool wantsCR0;
-	bool wantsCR1;
+	// CR fields (bit n = crn) read by this instruction; after the analysis, the CR fields
+	// whose value after this instruction may still be read, in this block or after it.
+	BitSet32 wantsCR;
 	bool wantsFPRF;
 	bool wantsCA;
 	bool wantsCAInFlags;
-	bool outputCR0;
-	bool outputCR1;
+	// CR fields completely overwritten by this instruction.
+	BitSet32 outputCR;
 	bool outputFPRF;
 	bool outputCA;
 	bool canEndBlock;
+	bool isHLEHooked;
 	bool skip;  // followed BL-s for example
 	// which registers are still needed after this instruction in this block
 	BitSet32 fprInUse;
@@ -58,6 +60,12 @@ struct CodeOp //16B
 	// whether an fpr is the output of a single-precision arithmetic instruction, i.e. whether we can safely
 	// skip PPC_FP.
 	BitSet32 fprIsStoreSafe;
+	// for loads and stores, which of RA and RB hold a value known at compile time before this
+	// instruction, because they were formed by li/lis/addi/ori and the like earlier in the block,
+	// and those values.
+	BitSet32 addressIsConstant;
+	u32 constantRA;
+	u32 constantRB;
 };
 
 struct BlockStats
@@ -197,8 +205,9 @@ public:
 
 		// Similar to complex blocks.
 		// Instead of jumping backwards, this jumps forwards within the block.
+		// Only unconditional branches without LK are followed, to a target in
+		// the same page. The block then also covers the code jumped over.
 		// Requires JIT support to work.
-		// XXX: NOT COMPLETE
 		OPTION_FORWARD_JUMP = (1 << 3),
 
 		// Reorder compare/Rc instructions next to their associated branches and
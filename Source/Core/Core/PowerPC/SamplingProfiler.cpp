@@ -0,0 +1,409 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Logging/Log.h"
+#include "Core/PowerPC/SamplingProfiler.h"
+
+#ifdef __linux__
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "Common/Event.h"
+#include "Common/FileUtil.h"
+#include "Common/Flag.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Core/ConfigManager.h"
+#include "Core/MachineContext.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+
+namespace SamplingProfiler
+{
+
+// A seqlock: the handler zeroes sequence, writes the fields, then stores the
+// index + 1 of the sample. The fields are atomics only so that a reader
+// racing with the handler reads some value instead of undefined behaviour; it
+// throws the sample away when sequence changed under it.
+struct Sample
+{
+	std::atomic<u32> sequence;
+	std::atomic<u32> thread_id;
+	std::atomic<u32> guest_pc;
+	std::atomic<u64> host_pc;
+};
+
+// A sample taken off the ring, with the block it hit already looked up since
+// blocks are only known until the code space is cleared.
+struct PendingSample
+{
+	u32 thread_id;
+	u32 guest_pc;
+	u64 host_pc;
+	// guest_pc is the block's address then.
+	bool in_block;
+};
+
+// Filled by the signal handler, drained by the writer thread every 100ms, so
+// this holds a few seconds of samples at any sensible rate.
+static const u32 RING_SIZE = 8192;
+static Sample s_ring[RING_SIZE];
+static std::atomic<u32> s_write_index;
+
+static bool s_running;
+static std::string s_filename;
+static u32 s_cpu_thread_id;
+static bool s_interpreted;
+static std::thread s_writer_thread;
+static Common::Event s_writer_wakeup;
+static Common::Flag s_writer_quit;
+
+// Only touched with s_mutex held. The signal handler never takes it, so it
+// does not matter which thread it interrupts. The CPU thread takes it to
+// register blocks, so nothing slow happens under it.
+static std::mutex s_mutex;
+static u32 s_read_index;
+static u64 s_num_dropped;
+// Host code start -> (host code end, guest address) of every block compiled
+// since the code space was last cleared.
+static std::map<const u8*, std::pair<const u8*, u32>> s_blocks;
+static std::vector<PendingSample> s_pending;
+
+// Only touched by the writer thread, and by Stop() once it has exited.
+static u64 s_num_samples;
+static std::unordered_map<u32, std::string> s_thread_names;
+// (host part of the stack, guest address or -1) -> number of samples.
+static std::map<std::pair<std::string, s64>, u64> s_stacks;
+
+static void SampleHandler(int sig, siginfo_t* info, void* raw_context)
+{
+	int saved_errno = errno;
+	u32 index = s_write_index.fetch_add(1, std::memory_order_relaxed);
+	Sample& sample = s_ring[index % RING_SIZE];
+	sample.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	sample.host_pc.store((u64)((ucontext_t*)raw_context)->uc_mcontext.CTX_PC, std::memory_order_relaxed);
+	sample.thread_id.store((u32)syscall(SYS_gettid), std::memory_order_relaxed);
+	sample.guest_pc.store(PowerPC::ppcState.pc, std::memory_order_relaxed);
+	sample.sequence.store(index + 1, std::memory_order_release);
+	errno = saved_errno;
+}
+
+// ';' separates frames in the folded format.
+static std::string Frame(std::string name)
+{
+	std::replace(name.begin(), name.end(), ';', ':');
+	return name;
+}
+
+static const std::string& ThreadName(u32 thread_id)
+{
+	auto it = s_thread_names.find(thread_id);
+	if (it != s_thread_names.end())
+		return it->second;
+
+	// procfs files have no size, so ReadFileToString can't be used here.
+	std::string name;
+	std::ifstream comm(StringFromFormat("/proc/self/task/%u/comm", thread_id));
+	std::getline(comm, name);
+	if (name.empty())
+		name = StringFromFormat("thread %u", thread_id);
+	return s_thread_names[thread_id] = Frame(name);
+}
+
+// Only exported symbols are known to dladdr, anything else is attributed to
+// its module. Code outside of any module is generated code.
+static std::string HostFunction(u64 address)
+{
+	Dl_info info;
+	if (!dladdr((void*)address, &info) || !info.dli_fname)
+		return "";
+
+	if (info.dli_sname)
+	{
+		int status;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+		std::string name = status == 0 ? demangled : info.dli_sname;
+		free(demangled);
+		return Frame(name);
+	}
+
+	const char* module = strrchr(info.dli_fname, '/');
+	return Frame(StringFromFormat("[%s]", module ? module + 1 : info.dli_fname));
+}
+
+static void Attribute(const PendingSample& sample)
+{
+	std::string stack = ThreadName(sample.thread_id);
+	s64 guest_address = -1;
+
+	if (sample.in_block)
+	{
+		stack += ";JIT";
+		guest_address = sample.guest_pc;
+	}
+	else if (sample.thread_id == s_cpu_thread_id && s_interpreted)
+	{
+		stack += ";Interpreter";
+		guest_address = sample.guest_pc;
+	}
+	else
+	{
+		std::string function = HostFunction(sample.host_pc);
+		if (!function.empty())
+			stack += ";" + function;
+		else if (sample.thread_id == s_cpu_thread_id)
+			stack += ";JIT;[dispatcher and far code]";
+		else
+			stack += ";[unknown]";
+	}
+
+	s_stacks[std::make_pair(stack, guest_address)]++;
+	s_num_samples++;
+}
+
+// Moves the complete samples from the ring to s_pending. Called with s_mutex
+// held.
+static void Drain()
+{
+	u32 write_index = s_write_index.load(std::memory_order_acquire);
+	if (write_index - s_read_index > RING_SIZE)
+	{
+		s_num_dropped += write_index - RING_SIZE - s_read_index;
+		s_read_index = write_index - RING_SIZE;
+	}
+
+	while (s_read_index != write_index)
+	{
+		Sample& slot = s_ring[s_read_index % RING_SIZE];
+		u32 sequence = slot.sequence.load(std::memory_order_acquire);
+		PendingSample sample;
+		sample.thread_id = slot.thread_id.load(std::memory_order_relaxed);
+		sample.guest_pc = slot.guest_pc.load(std::memory_order_relaxed);
+		sample.host_pc = slot.host_pc.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+			sequence = 0;
+
+		if (sequence == s_read_index + 1)
+		{
+			const u8* host_pc = (const u8*)sample.host_pc;
+			auto block = s_blocks.upper_bound(host_pc);
+			sample.in_block = block != s_blocks.begin() && host_pc < (--block)->second.first;
+			if (sample.in_block)
+				sample.guest_pc = block->second.second;
+			s_pending.push_back(sample);
+		}
+		else if ((s32)(sequence - s_read_index - 1) > 0)
+		{
+			// Overwritten by a later sample while we were catching up.
+			s_num_dropped++;
+		}
+		else
+		{
+			// The handler is still writing this one, or started overwriting
+			// it while we read it. Look again next time.
+			break;
+		}
+		s_read_index++;
+	}
+}
+
+// Looks up the thread names and host symbols of the drained samples, which
+// reads /proc and can take a while, without holding s_mutex.
+static void AttributePending()
+{
+	std::vector<PendingSample> samples;
+	{
+		std::lock_guard<std::mutex> lk(s_mutex);
+		Drain();
+		samples.swap(s_pending);
+	}
+	for (const PendingSample& sample : samples)
+		Attribute(sample);
+}
+
+static void WriterThread()
+{
+	Common::SetCurrentThreadName("Sampling profiler");
+
+	while (!s_writer_quit.IsSet())
+	{
+		s_writer_wakeup.WaitFor(std::chrono::milliseconds(100));
+		AttributePending();
+	}
+}
+
+static void WriteReport()
+{
+	File::CreateFullPath(s_filename);
+	File::IOFile f(s_filename, "w");
+	if (!f)
+	{
+		ERROR_LOG(POWERPC, "Could not write the sampling profile to %s", s_filename.c_str());
+		return;
+	}
+
+	for (const auto& stack : s_stacks)
+	{
+		std::string line = stack.first.first;
+		if (stack.first.second >= 0)
+		{
+			u32 address = (u32)stack.first.second;
+			Symbol* symbol = g_symbolDB.GetSymbolFromAddr(address);
+			line += ";" + (symbol ? Frame(symbol->name) : "[no symbol]");
+			line += StringFromFormat(";%08x", address);
+		}
+		line += StringFromFormat(" %" PRIu64 "\n", stack.second);
+		f.WriteBytes(line.data(), line.size());
+	}
+
+	u64 num_dropped;
+	{
+		std::lock_guard<std::mutex> lk(s_mutex);
+		num_dropped = s_num_dropped;
+	}
+	NOTICE_LOG(POWERPC, "Wrote %" PRIu64 " samples (%" PRIu64 " dropped) to %s",
+	           s_num_samples, num_dropped, s_filename.c_str());
+}
+
+void Start(const std::string& filename, int samples_per_second)
+{
+	if (s_running || samples_per_second <= 0)
+		return;
+
+	const SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	s_filename = filename;
+	s_cpu_thread_id = (u32)syscall(SYS_gettid);
+	s_interpreted = params.iCPUCore == SCoreStartupParameter::CORE_INTERPRETER ||
+	                params.iCPUCore == SCoreStartupParameter::CORE_CACHEDINTERPRETER;
+
+	for (Sample& sample : s_ring)
+		sample.sequence.store(0, std::memory_order_relaxed);
+	s_write_index.store(0, std::memory_order_release);
+	s_read_index = 0;
+	s_num_samples = 0;
+	s_num_dropped = 0;
+	s_blocks.clear();
+	s_pending.clear();
+	s_thread_names.clear();
+	s_stacks.clear();
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = &SampleHandler;
+	// Samples land on whatever the thread is doing, don't fail its syscalls.
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGPROF, &action, nullptr))
+	{
+		ERROR_LOG(POWERPC, "Could not install the sampling profiler's signal handler");
+		return;
+	}
+
+	s_running = true;
+	s_writer_quit.Clear();
+	s_writer_thread = std::thread(WriterThread);
+
+	// ITIMER_PROF counts the CPU time of the whole process, and the kernel
+	// delivers the signal to the thread which was running when it expired.
+	int interval = std::max(1000000 / samples_per_second, 1);
+	struct itimerval timer;
+	timer.it_interval.tv_sec = interval / 1000000;
+	timer.it_interval.tv_usec = interval % 1000000;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, nullptr);
+
+	NOTICE_LOG(POWERPC, "Sampling profiler started at %d samples per second", samples_per_second);
+}
+
+void Stop()
+{
+	if (!s_running)
+		return;
+
+	struct itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	// A signal may still be pending, and SIGPROF terminates by default.
+	signal(SIGPROF, SIG_IGN);
+
+	s_writer_quit.Set();
+	s_writer_wakeup.Set();
+	s_writer_thread.join();
+
+	AttributePending();
+	WriteReport();
+	std::lock_guard<std::mutex> lk(s_mutex);
+	s_blocks.clear();
+	s_running = false;
+}
+
+bool IsRunning()
+{
+	return s_running;
+}
+
+void RegisterBlock(const u8* code, u32 code_size, u32 guest_address)
+{
+	if (!s_running)
+		return;
+
+	std::lock_guard<std::mutex> lk(s_mutex);
+	s_blocks[code] = std::make_pair(code + code_size, guest_address);
+}
+
+void ClearBlocks()
+{
+	if (!s_running)
+		return;
+
+	std::lock_guard<std::mutex> lk(s_mutex);
+	Drain();
+	s_blocks.clear();
+}
+
+}
+
+#else
+
+namespace SamplingProfiler
+{
+
+void Start(const std::string& filename, int samples_per_second)
+{
+	if (samples_per_second > 0)
+		WARN_LOG(POWERPC, "The sampling profiler is not supported on this platform");
+}
+
+void Stop() {}
+bool IsRunning() { return false; }
+void RegisterBlock(const u8* code, u32 code_size, u32 guest_address) {}
+void ClearBlocks() {}
+
+}
+
+#endif
@@ -0,0 +1,34 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Statistical profiler for the whole emulator. A SIGPROF timer samples the
+// host program counter of whichever thread is consuming CPU time; samples in
+// JIT code are attributed to the guest block and function they were compiled
+// from, everything else to the host thread and function. The result is
+// written as folded stacks, which flamegraph.pl and similar tools accept.
+//
+// Only implemented on Linux, elsewhere Start() does nothing.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+namespace SamplingProfiler
+{
+
+// Must be called on the CPU thread, which is what guest samples are taken on.
+void Start(const std::string& filename, int samples_per_second);
+// Stops sampling and writes the report.
+void Stop();
+bool IsRunning();
+
+// Called by the block cache, so that samples can be mapped back to guest code.
+void RegisterBlock(const u8* code, u32 code_size, u32 guest_address);
+// Looks up the blocks of the samples taken so far, the code space is about to
+// be reused.
+void ClearBlocks();
+
+}
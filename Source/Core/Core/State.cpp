@@ -2,14 +2,19 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <lzo/lzo1x.h>
+#include <zlib.h>
 
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
 #include "Common/StringUtil.h"
 #include "Common/Timer.h"
+#include "Common/WorkerPool.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
@@ -39,14 +44,9 @@ static const u32 IN_LEN = 60 * 1024u;
 static const u32 IN_LEN = 128 * 1024u;
 #endif
 
-static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
+const u32 COMPRESSED_CHUNK_SIZE = IN_LEN;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
-
-#define HEAP_ALLOC(var, size) \
-	lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+static const u32 LZO_OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
 static std::string g_last_filename;
 
@@ -80,6 +80,150 @@ void EnableCompression(bool compression)
 	g_use_compression = compression;
 }
 
+// Compresses and decompresses the chunks of a state. Created by Init, so that
+// saving and loading don't pay for starting threads every time.
+static std::unique_ptr<Common::WorkerPool> g_workers;
+static std::mutex g_cs_workers;
+
+// Runs func(0) .. func(count - 1) on the worker pool and the calling thread.
+template <typename Func>
+static void ParallelForChunks(size_t count, const Func& func)
+{
+	std::lock_guard<std::mutex> lk(g_cs_workers);
+	if (g_workers)
+	{
+		g_workers->ParallelFor(count, func);
+	}
+	else
+	{
+		for (size_t k = 0; k < count; ++k)
+			func(k);
+	}
+}
+
+static bool CompressChunk(u8 compression, int level, const u8* src, size_t src_len, std::vector<u8>* dst)
+{
+	if (compression == COMPRESSION_ZLIB)
+	{
+		uLongf out_len = compressBound((uLong)src_len);
+		dst->resize(out_len);
+		if (compress2(dst->data(), &out_len, src, (uLong)src_len, level) != Z_OK)
+			return false;
+		dst->resize(out_len);
+		return true;
+	}
+
+	std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+	lzo_uint out_len = 0;
+	dst->resize(LZO_OUT_LEN);
+	if (lzo1x_1_compress(src, (lzo_uint)src_len, dst->data(), &out_len, wrkmem.data()) != LZO_E_OK)
+		return false;
+	dst->resize(out_len);
+	return true;
+}
+
+// On entry *dst_len is the capacity of dst, on success it is the decompressed size.
+static bool DecompressChunk(u8 compression, const u8* src, size_t src_len, u8* dst, size_t* dst_len)
+{
+	if (compression == COMPRESSION_ZLIB)
+	{
+		uLongf new_len = (uLongf)*dst_len;
+		if (uncompress(dst, &new_len, src, (uLong)src_len) != Z_OK)
+			return false;
+		*dst_len = new_len;
+		return true;
+	}
+
+	lzo_uint new_len = (lzo_uint)*dst_len;
+	if (lzo1x_decompress_safe(src, (lzo_uint)src_len, dst, &new_len, nullptr) != LZO_E_OK)
+		return false;
+	*dst_len = new_len;
+	return true;
+}
+
+bool CompressStateData(u8 compression, int level, const u8* data, size_t size, std::vector<u8>& out)
+{
+	// The stream always ends with a chunk shorter than IN_LEN, which may be empty.
+	const size_t num_chunks = size / IN_LEN + 1;
+	std::vector<std::vector<u8>> chunks(num_chunks);
+
+	std::atomic<bool> failed(false);
+	ParallelForChunks(num_chunks, [&](size_t k) {
+		const size_t offset = k * IN_LEN;
+		const size_t cur_len = std::min<size_t>(IN_LEN, size - offset);
+		if (!CompressChunk(compression, level, data + offset, cur_len, &chunks[k]))
+			failed = true;
+	});
+
+	out.clear();
+	for (const std::vector<u8>& chunk : chunks)
+	{
+		// Each chunk is prefixed with its compressed size
+		lzo_uint32 out_len = (lzo_uint32)chunk.size();
+		const u8* len_bytes = reinterpret_cast<const u8*>(&out_len);
+		out.insert(out.end(), len_bytes, len_bytes + sizeof(out_len));
+		out.insert(out.end(), chunk.begin(), chunk.end());
+	}
+
+	return !failed;
+}
+
+bool DecompressStateData(u8 compression, const u8* data, size_t data_size, size_t size, std::vector<u8>& out)
+{
+	// Every chunk but the last one expands to exactly IN_LEN bytes, so the
+	// chunks can be located up front and decompressed independently.
+	std::vector<std::pair<size_t, size_t>> chunks;
+	size_t pos = 0;
+	while (pos + sizeof(lzo_uint32) <= data_size)
+	{
+		lzo_uint32 cur_len;
+		memcpy(&cur_len, data + pos, sizeof(cur_len));
+		pos += sizeof(cur_len);
+		if (cur_len > data_size - pos)
+		{
+			PanicAlertT("Savestate is truncated or corrupt");
+			return false;
+		}
+		chunks.emplace_back(pos, cur_len);
+		pos += cur_len;
+	}
+
+	if (chunks.empty() || (chunks.size() - 1) * IN_LEN > size)
+	{
+		PanicAlertT("Savestate is truncated or corrupt");
+		return false;
+	}
+
+	std::vector<u8> buffer(size);
+
+	// A state whose size is a multiple of IN_LEN ends with an empty chunk, whose
+	// source and destination are both one past the end, so don't index there.
+	std::atomic<bool> failed(false);
+	std::atomic<size_t> total_len(0);
+	ParallelForChunks(chunks.size(), [&](size_t k) {
+		const size_t offset = k * IN_LEN;
+		const size_t capacity = std::min<size_t>(IN_LEN, size - offset);
+		size_t new_len = capacity;
+		if (!DecompressChunk(compression, data + chunks[k].first, chunks[k].second,
+		                     buffer.data() + offset, &new_len) ||
+		    (k + 1 < chunks.size() && new_len != IN_LEN))
+		{
+			failed = true;
+		}
+		total_len += new_len;
+	});
+
+	if (failed || total_len != size)
+	{
+		PanicAlertT("Internal Error - savestate decompression failed\n"
+			"Try loading the state again");
+		return false;
+	}
+
+	out.swap(buffer);
+	return true;
+}
+
 static void DoState(PointerWrap &p)
 {
 	u32 version = STATE_VERSION;
@@ -253,43 +397,28 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 		return;
 	}
 
+	const SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+
 	// Setting up the header
-	StateHeader header;
-	memcpy(header.gameID, SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), 6);
+	StateHeader header = {};
+	memcpy(header.gameID, params.GetUniqueID().c_str(), 6);
+	header.compression = params.iStateCompression == COMPRESSION_ZLIB ? COMPRESSION_ZLIB : COMPRESSION_LZO;
+	header.compression_level = (u8)std::min(std::max(params.iStateCompressionLevel, 1), 9);
 	header.size = g_use_compression ? (u32)buffer_size : 0;
+	header.compression_magic = COMPRESSION_MAGIC;
 	header.time = Common::Timer::GetDoubleTime();
 
 	f.WriteArray(&header, 1);
 
 	if (header.size != 0) // non-zero header size means the state is compressed
 	{
-		lzo_uint i = 0;
-		while (true)
+		std::vector<u8> compressed;
+		if (!CompressStateData(header.compression, header.compression_level,
+		                       buffer_data, buffer_size, compressed))
 		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
-
-			if (cur_len != IN_LEN)
-				break;
-
-			i += cur_len;
+			PanicAlertT("Internal Error - savestate compression failed");
 		}
+		f.WriteBytes(compressed.data(), compressed.size());
 	}
 	else // uncompressed
 	{
@@ -386,28 +515,27 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
 	{
 		Core::DisplayMessage("Decompressing State...", 500);
 
-		buffer.resize(header.size);
-
-		lzo_uint i = 0;
-		while (true)
+		// States written before the codec was recorded leave garbage here.
+		const u8 compression = header.compression_magic == COMPRESSION_MAGIC ?
+			header.compression : (u8)COMPRESSION_LZO;
+		if (compression != COMPRESSION_LZO && compression != COMPRESSION_ZLIB)
 		{
-			lzo_uint32 cur_len = 0;  // number of bytes to read
-			lzo_uint new_len = 0;  // number of bytes to write
-
-			if (!f.ReadArray(&cur_len, 1))
-				break;
+			PanicAlertT("Unknown savestate compression type %d", compression);
+			return;
+		}
 
-			f.ReadBytes(out, cur_len);
-			const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-			if (res != LZO_E_OK)
-			{
-				// This doesn't seem to happen anymore.
-				PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-					"Try loading the state again", res, i, new_len);
-				return;
-			}
+		const size_t file_size = (size_t)(f.GetSize() - sizeof(StateHeader));
+		std::vector<u8> compressed(file_size);
+		if (!f.ReadBytes(compressed.data(), file_size))
+		{
+			PanicAlertT("Failed to read savestate data");
+			return;
+		}
 
-			i += new_len;
+		if (!DecompressStateData(compression, compressed.data(), compressed.size(),
+		                         header.size, buffer))
+		{
+			return;
 		}
 	}
 	else // uncompressed
@@ -527,12 +655,20 @@ void Init()
 {
 	if (lzo_init() != LZO_E_OK)
 		PanicAlertT("Internal LZO Error - lzo_init() failed");
+
+	std::lock_guard<std::mutex> lk(g_cs_workers);
+	g_workers.reset(new Common::WorkerPool());
 }
 
 void Shutdown()
 {
 	Flush();
 
+	{
+		std::lock_guard<std::mutex> lk(g_cs_workers);
+		g_workers.reset();
+	}
+
 	// swapping with an empty vector, rather than clear()ing
 	// this gives a better guarantee to free the allocated memory right NOW (as opposed to, actually, never)
 	{
@@ -18,12 +18,36 @@ namespace State
 // number of states
 static const u32 NUM_STATES = 10;
 
+enum StateCompression : u8
+{
+	COMPRESSION_LZO = 0,
+	COMPRESSION_ZLIB = 1,
+};
+
+// Marks states that say which codec they use. Older states leave the
+// compression fields uninitialized and are always LZO.
+static const u32 COMPRESSION_MAGIC = 0x43535444; // 'DTSC'
+
 struct StateHeader
 {
 	u8 gameID[6];
-	u32 size;
+	// These two and compression_magic used to be padding.
+	u8 compression;       // StateCompression
+	u8 compression_level;
+	u32 size;             // uncompressed size, 0 if the state isn't compressed
+	u32 compression_magic;
 	double time;
 };
+static_assert(sizeof(StateHeader) == 24, "StateHeader layout must not change");
+
+// Compressed states are a sequence of independently compressed chunks of this
+// many bytes, each prefixed with its compressed size. The last chunk is always
+// shorter, possibly empty.
+extern const u32 COMPRESSED_CHUNK_SIZE;
+
+// Used by saving and loading, exposed for the unit tests.
+bool CompressStateData(u8 compression, int level, const u8* data, size_t size, std::vector<u8>& out);
+bool DecompressStateData(u8 compression, const u8* data, size_t data_size, size_t size, std::vector<u8>& out);
 
 void Init();
 
@@ -29,7 +29,9 @@ void SectorReader::SetSectorSize(int blocksize)
 	{
 		m_cache[i] = new u8[blocksize];
 		m_cache_tags[i] = (u64)(s64) - 1;
+		m_cache_age[i] = 0;
 	}
+	m_access_counter = 0;
 	m_blocksize = blocksize;
 }
 
@@ -43,17 +45,22 @@ SectorReader::~SectorReader()
 
 const u8 *SectorReader::GetBlockData(u64 block_num)
 {
-	// TODO : Expand usage of the cache to more than one block :P
-	if (m_cache_tags[0] == block_num)
-	{
-		return m_cache[0];
-	}
-	else
+	int oldest = 0;
+	for (int i = 0; i < CACHE_SIZE; i++)
 	{
-		GetBlock(block_num, m_cache[0]);
-		m_cache_tags[0] = block_num;
-		return m_cache[0];
+		if (m_cache_tags[i] == block_num)
+		{
+			m_cache_age[i] = ++m_access_counter;
+			return m_cache[i];
+		}
+		if (m_cache_age[i] < m_cache_age[oldest])
+			oldest = i;
 	}
+
+	GetBlock(block_num, m_cache[oldest]);
+	m_cache_tags[oldest] = block_num;
+	m_cache_age[oldest] = ++m_access_counter;
+	return m_cache[oldest];
 }
 
 bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
@@ -37,7 +37,7 @@ protected:
 
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
-// Currently only uses a single entry cache.
+// Keeps the CACHE_SIZE most recently used blocks.
 // Multi-block reads are not cached.
 class SectorReader : public IBlobReader
 {
@@ -60,7 +60,8 @@ private:
 	int m_blocksize;
 	u8* m_cache[CACHE_SIZE];
 	u64 m_cache_tags[CACHE_SIZE];
-	int m_cache_age[CACHE_SIZE];
+	u32 m_cache_age[CACHE_SIZE];
+	u32 m_access_counter;
 };
 
 // Factory function - examines the path to choose the right type of IBlobReader, and returns one.
@@ -68,9 +69,12 @@ IBlobReader* CreateBlobReader(const std::string& filename);
 
 typedef bool (*CompressCB)(const std::string& text, float percent, void* arg);
 
+// The callback is called on the calling thread; returning false cancels.
+// Blocks are (de)compressed on num_threads worker threads, 0 meaning one per
+// hardware thread. The output doesn't depend on the number of threads.
 bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u32 sub_type = 0, int sector_size = 16384,
-		CompressCB callback = nullptr, void *arg = nullptr);
+		CompressCB callback = nullptr, void *arg = nullptr, int num_threads = 0);
 bool DecompressBlobToFile(const std::string& infile, const std::string& outfile,
-		CompressCB callback = nullptr, void *arg = nullptr);
+		CompressCB callback = nullptr, void *arg = nullptr, int num_threads = 0);
 
 }  // namespace
@@ -11,6 +11,7 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,6 +21,7 @@
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
@@ -28,7 +30,21 @@
 namespace DiscIO
 {
 
-CompressedBlobReader::CompressedBlobReader(const std::string& filename) : m_file_name(filename)
+static u32 s_cache_size_mb = 16;
+static u32 s_read_ahead_blocks = 8;
+
+// Reads in a row before we start reading ahead.
+static const int SEQUENTIAL_THRESHOLD = 2;
+static const u32 MAX_WORKERS = 4;
+
+void CompressedBlobReader::SetCacheSize(u32 megabytes, u32 read_ahead_blocks)
+{
+	s_cache_size_mb = megabytes;
+	s_read_ahead_blocks = read_ahead_blocks;
+}
+
+CompressedBlobReader::CompressedBlobReader(const std::string& filename)
+	: m_file_name(filename), m_shutdown(false), m_next_block(0), m_sequential_reads(0)
 {
 	m_file.Open(filename, "rb");
 	m_file_size = File::GetSize(filename);
@@ -46,11 +62,10 @@ CompressedBlobReader::CompressedBlobReader(const std::string& filename) : m_file
 	              + (sizeof(u64)) * m_header.num_blocks  // skip block pointers
 	              + (sizeof(u32)) * m_header.num_blocks; // skip hashes
 
-	// A compressed block is never ever longer than a decompressed block, so just header.block_size should be fine.
-	// I still add some safety margin.
-	m_zlib_buffer_size = m_header.block_size + 64;
-	m_zlib_buffer = new u8[m_zlib_buffer_size];
-	memset(m_zlib_buffer, 0, m_zlib_buffer_size);
+	// Always keep at least two blocks of read-ahead worth of room, so that
+	// prefetched blocks aren't evicted before they are read.
+	m_max_cached_blocks = std::max<size_t>(1, (size_t)s_cache_size_mb * 1024 * 1024 / std::max<u32>(1, m_header.block_size));
+	m_read_ahead = (u32)std::min<size_t>(s_read_ahead_blocks, m_max_cached_blocks / 2);
 }
 
 CompressedBlobReader* CompressedBlobReader::Create(const std::string& filename)
@@ -63,7 +78,15 @@ CompressedBlobReader* CompressedBlobReader::Create(const std::string& filename)
 
 CompressedBlobReader::~CompressedBlobReader()
 {
-	delete [] m_zlib_buffer;
+	{
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		m_shutdown = true;
+		m_jobs.clear();
+	}
+	m_work_available.notify_all();
+	for (std::thread& worker : m_workers)
+		worker.join();
+
 	delete [] m_block_pointers;
 	delete [] m_hashes;
 }
@@ -81,7 +104,7 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
 	return 0;
 }
 
-void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
+void CompressedBlobReader::DecodeBlock(u64 block_num, u8 *out_ptr)
 {
 	bool uncompressed = false;
 	u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
@@ -95,13 +118,17 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 		offset &= ~(1ULL << 63);
 	}
 
-	// clear unused part of zlib buffer. maybe this can be deleted when it works fully.
-	memset(m_zlib_buffer + comp_block_size, 0, m_zlib_buffer_size - comp_block_size);
+	// A compressed block is never ever longer than a decompressed block, so just header.block_size should be fine.
+	// I still add some safety margin.
+	std::vector<u8> zlib_buffer(std::max(comp_block_size, m_header.block_size) + 64);
 
-	m_file.Seek(offset, SEEK_SET);
-	m_file.ReadBytes(m_zlib_buffer, comp_block_size);
+	{
+		std::lock_guard<std::mutex> lk(m_file_lock);
+		m_file.Seek(offset, SEEK_SET);
+		m_file.ReadBytes(zlib_buffer.data(), comp_block_size);
+	}
 
-	u8* source = m_zlib_buffer;
+	u8* source = zlib_buffer.data();
 	u8* dest = out_ptr;
 
 	// First, check hash.
@@ -143,8 +170,306 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	}
 }
 
+void CompressedBlobReader::DecodeIntoCache(u64 block_num, CachedBlock& entry, std::unique_lock<std::mutex>& lock)
+{
+	// Pending entries are never evicted, so entry stays valid while unlocked.
+	lock.unlock();
+	entry.data.resize(m_header.block_size);
+	DecodeBlock(block_num, entry.data.data());
+	lock.lock();
+
+	entry.ready = true;
+	m_lru.push_front(block_num);
+	entry.lru = m_lru.begin();
+	while (m_lru.size() > m_max_cached_blocks)
+	{
+		m_cache.erase(m_lru.back());
+		m_lru.pop_back();
+	}
+	m_block_ready.notify_all();
+}
+
+const std::vector<u8>& CompressedBlobReader::GetCachedBlock(u64 block_num, std::unique_lock<std::mutex>& lock)
+{
+	while (true)
+	{
+		auto it = m_cache.find(block_num);
+		if (it == m_cache.end())
+		{
+			it = m_cache.emplace(block_num, CachedBlock()).first;
+			DecodeIntoCache(block_num, it->second, lock);
+			return it->second.data;
+		}
+
+		CachedBlock& entry = it->second;
+		if (entry.ready)
+		{
+			m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+			return entry.data;
+		}
+
+		// Being read ahead. Do it ourselves if no worker has picked it up yet.
+		auto job = std::find_if(m_jobs.begin(), m_jobs.end(), [block_num](const Job& j) {
+			return !j.dest && j.block_num == block_num;
+		});
+		if (job != m_jobs.end())
+		{
+			m_jobs.erase(job);
+			DecodeIntoCache(block_num, entry, lock);
+			return entry.data;
+		}
+
+		// The entry may be evicted again before we wake up, so look it up anew.
+		m_block_ready.wait(lock);
+	}
+}
+
+void CompressedBlobReader::RunJob(const Job& job, std::unique_lock<std::mutex>& lock)
+{
+	if (job.dest)
+	{
+		lock.unlock();
+		DecodeBlock(job.block_num, job.dest);
+		lock.lock();
+		if (--*job.remaining == 0)
+			m_block_ready.notify_all();
+	}
+	else
+	{
+		DecodeIntoCache(job.block_num, m_cache[job.block_num], lock);
+	}
+}
+
+void CompressedBlobReader::StartWorkers()
+{
+	if (!m_workers.empty())
+		return;
+
+	u32 num_workers = std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, MAX_WORKERS);
+	for (u32 i = 0; i < num_workers; i++)
+		m_workers.emplace_back(&CompressedBlobReader::WorkerThread, this);
+}
+
+void CompressedBlobReader::WorkerThread()
+{
+	Common::SetCurrentThreadName("GCZ reader");
+
+	std::unique_lock<std::mutex> lock(m_cache_lock);
+	while (true)
+	{
+		m_work_available.wait(lock, [this] { return m_shutdown || !m_jobs.empty(); });
+		if (m_shutdown)
+			return;
+
+		Job job = m_jobs.front();
+		m_jobs.pop_front();
+		RunJob(job, lock);
+	}
+}
+
+void CompressedBlobReader::UpdateReadAhead(u64 first_block, u64 last_block)
+{
+	if (first_block == m_next_block)
+		m_sequential_reads++;
+	else
+		m_sequential_reads = 0;
+	m_next_block = last_block + 1;
+
+	if (m_sequential_reads < SEQUENTIAL_THRESHOLD || m_read_ahead == 0)
+		return;
+
+	bool queued = false;
+	u64 end = std::min<u64>(m_next_block + m_read_ahead, m_header.num_blocks);
+	for (u64 block = m_next_block; block < end; block++)
+	{
+		if (m_cache.count(block))
+			continue;
+		m_cache.emplace(block, CachedBlock());
+		m_jobs.push_back({block, nullptr, nullptr});
+		queued = true;
+	}
+
+	if (queued)
+	{
+		StartWorkers();
+		m_work_available.notify_all();
+	}
+}
+
+void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
+{
+	std::unique_lock<std::mutex> lock(m_cache_lock);
+	const std::vector<u8>& data = GetCachedBlock(block_num, lock);
+	memcpy(out_ptr, data.data(), m_header.block_size);
+	UpdateReadAhead(block_num, block_num);
+}
+
+bool CompressedBlobReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8 *out_ptr)
+{
+	std::unique_lock<std::mutex> lock(m_cache_lock);
+
+	// Copy what is cached, and hand the blocks that aren't cached or being
+	// read ahead to the workers, in front of any read-ahead.
+	std::vector<u64> read_ahead_blocks;
+	int remaining = 0;
+	for (u64 i = num_blocks; i-- > 0;)
+	{
+		u8* dest = out_ptr + i * m_header.block_size;
+		auto it = m_cache.find(block_num + i);
+		if (it == m_cache.end())
+		{
+			m_jobs.push_front({block_num + i, dest, &remaining});
+			remaining++;
+		}
+		else if (it->second.ready)
+		{
+			m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+			memcpy(dest, it->second.data.data(), m_header.block_size);
+		}
+		else
+		{
+			read_ahead_blocks.push_back(block_num + i);
+		}
+	}
+
+	if (remaining > 1)
+	{
+		StartWorkers();
+		m_work_available.notify_all();
+	}
+
+	// Help out until our blocks are done.
+	while (remaining)
+	{
+		if (!m_jobs.empty())
+		{
+			Job job = m_jobs.front();
+			m_jobs.pop_front();
+			RunJob(job, lock);
+		}
+		else
+		{
+			m_block_ready.wait(lock);
+		}
+	}
+
+	for (u64 block : read_ahead_blocks)
+	{
+		const std::vector<u8>& data = GetCachedBlock(block, lock);
+		memcpy(out_ptr + (block - block_num) * m_header.block_size, data.data(), m_header.block_size);
+	}
+
+	UpdateReadAhead(block_num, block_num + num_blocks - 1);
+	return true;
+}
+
+// Runs a function on numbered items on worker threads, and hands the results
+// back in submission order. The calling thread fills the slots and consumes
+// the results, so all file I/O and progress callbacks stay on that thread.
+template <typename Slot>
+class OrderedWorkQueue
+{
+public:
+	typedef std::function<void(Slot& slot, int worker)> WorkFunction;
+
+	OrderedWorkQueue(int num_workers, WorkFunction work)
+		: m_work(work), m_slots(num_workers * 4), m_done(num_workers * 4),
+		  m_first(0), m_count(0), m_shutdown(false)
+	{
+		for (int i = 0; i < num_workers; i++)
+			m_workers.emplace_back(&OrderedWorkQueue::WorkerThread, this, i);
+	}
+
+	~OrderedWorkQueue()
+	{
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			m_shutdown = true;
+			m_queue.clear();
+		}
+		m_work_available.notify_all();
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+
+	bool IsFull() const { return m_count == m_slots.size(); }
+	bool IsEmpty() const { return m_count == 0; }
+
+	// The slot to fill before the next Submit. Only valid if !IsFull().
+	Slot& GetFreeSlot() { return m_slots[(m_first + m_count) % m_slots.size()]; }
+
+	void Submit()
+	{
+		size_t index = (m_first + m_count) % m_slots.size();
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			m_done[index] = false;
+			m_queue.push_back(index);
+		}
+		m_count++;
+		m_work_available.notify_one();
+	}
+
+	// Waits for the oldest submitted item, which stays valid until PopOldest.
+	Slot& WaitForOldest()
+	{
+		std::unique_lock<std::mutex> lk(m_lock);
+		m_item_done.wait(lk, [this] { return m_done[m_first]; });
+		return m_slots[m_first];
+	}
+
+	void PopOldest()
+	{
+		m_first = (m_first + 1) % m_slots.size();
+		m_count--;
+	}
+
+private:
+	void WorkerThread(int worker)
+	{
+		std::unique_lock<std::mutex> lk(m_lock);
+		while (true)
+		{
+			m_work_available.wait(lk, [this] { return m_shutdown || !m_queue.empty(); });
+			if (m_shutdown)
+				return;
+
+			size_t index = m_queue.front();
+			m_queue.pop_front();
+			lk.unlock();
+			m_work(m_slots[index], worker);
+			lk.lock();
+			m_done[index] = true;
+			m_item_done.notify_one();
+		}
+	}
+
+	WorkFunction m_work;
+	std::vector<Slot> m_slots;
+	std::vector<std::thread> m_workers;
+
+	// Only touched by the calling thread.
+	size_t m_first;
+	size_t m_count;
+
+	// Guards everything below.
+	std::mutex m_lock;
+	std::vector<bool> m_done;
+	std::deque<size_t> m_queue;
+	bool m_shutdown;
+	std::condition_variable m_work_available;
+	std::condition_variable m_item_done;
+};
+
+static int GetNumWorkers(int num_threads)
+{
+	if (num_threads > 0)
+		return num_threads;
+	return std::max<int>(1, std::thread::hardware_concurrency());
+}
+
 bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u32 sub_type,
-						int block_size, CompressCB callback, void* arg)
+						int block_size, CompressCB callback, void* arg, int num_threads)
 {
 	bool scrubbing = false;
 
@@ -165,139 +490,186 @@ bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u
 		scrubbing = true;
 	}
 
-	z_stream z = {};
-	if (deflateInit(&z, 9) != Z_OK)
-		return false;
+	// One stream per worker, set up exactly like the old single stream, so
+	// that the output doesn't depend on the number of threads.
+	int num_workers = GetNumWorkers(num_threads);
+	std::vector<z_stream> streams(num_workers);
+	for (int i = 0; i < num_workers; i++)
+	{
+		if (deflateInit(&streams[i], 9) != Z_OK)
+		{
+			while (i--)
+				deflateEnd(&streams[i]);
+			return false;
+		}
+	}
+
+	auto report_progress = [&](const std::string& text, float percent) {
+		return !callback || callback(text, percent, arg);
+	};
 
 	File::IOFile inf(infile, "rb");
 	File::IOFile f(outfile, "wb");
 
 	if (!f || !inf)
 	{
-		deflateEnd(&z);
+		for (z_stream& z : streams)
+			deflateEnd(&z);
 		return false;
 	}
 
-	callback("Files opened, ready to compress.", 0, arg);
+	bool success = true;
 
-	CompressedBlobHeader header;
-	header.magic_cookie = kBlobCookie;
-	header.sub_type   = sub_type;
-	header.block_size = block_size;
-	header.data_size  = File::GetSize(infile);
-
-	// round upwards!
-	header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
-
-	u64* offsets = new u64[header.num_blocks];
-	u32* hashes = new u32[header.num_blocks];
-	u8* out_buf = new u8[block_size];
-	u8* in_buf = new u8[block_size];
-
-	// seek past the header (we will write it at the end)
-	f.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
-	// seek past the offset and hash tables (we will write them at the end)
-	f.Seek((sizeof(u64) + sizeof(u32)) * header.num_blocks, SEEK_CUR);
-
-	// Now we are ready to write compressed data!
-	u64 position = 0;
-	int num_compressed = 0;
-	int num_stored = 0;
-	int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
-	bool was_cancelled = false;
-
-	for (u32 i = 0; i < header.num_blocks; i++)
+	// Scoped so that the workers are gone before the streams are freed.
 	{
-		if (i % progress_monitor == 0)
-		{
-			const u64 inpos = inf.Tell();
-			int ratio = 0;
-			if (inpos != 0)
-				ratio = (int)(100 * position / inpos);
+		report_progress("Files opened, ready to compress.", 0);
 
-			std::string temp = StringFromFormat("%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
-			was_cancelled = !callback(temp, (float)i / (float)header.num_blocks, arg);
-			if (was_cancelled)
-				break;
-		}
+		CompressedBlobHeader header;
+		header.magic_cookie = kBlobCookie;
+		header.sub_type   = sub_type;
+		header.block_size = block_size;
+		header.data_size  = File::GetSize(infile);
 
-		offsets[i] = position;
+		// round upwards!
+		header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
 
-		size_t read_bytes;
-		if (scrubbing)
-			read_bytes = DiscScrubber::GetNextBlock(inf, in_buf);
-		else
-			inf.ReadArray(in_buf, header.block_size, &read_bytes);
-		if (read_bytes < header.block_size)
-			std::fill(in_buf + read_bytes, in_buf + header.block_size, 0);
+		std::vector<u64> offsets(header.num_blocks);
+		std::vector<u32> hashes(header.num_blocks);
 
-		int retval = deflateReset(&z);
-		z.next_in   = in_buf;
-		z.avail_in  = header.block_size;
-		z.next_out  = out_buf;
-		z.avail_out = block_size;
+		// seek past the header (we will write it at the end)
+		f.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
+		// seek past the offset and hash tables (we will write them at the end)
+		f.Seek((sizeof(u64) + sizeof(u32)) * header.num_blocks, SEEK_CUR);
 
-		if (retval != Z_OK)
+		struct CompressSlot
 		{
-			ERROR_LOG(DISCIO, "Deflate failed");
-			goto cleanup;
+			std::vector<u8> in_buf;
+			std::vector<u8> out_buf;
+			int comp_size;
+			bool stored;
+			bool failed;
+			u32 hash;
+		};
+
+		OrderedWorkQueue<CompressSlot> queue(num_workers, [&](CompressSlot& slot, int worker) {
+			z_stream& z = streams[worker];
+			slot.failed = deflateReset(&z) != Z_OK;
+			if (slot.failed)
+				return;
+
+			z.next_in   = slot.in_buf.data();
+			z.avail_in  = header.block_size;
+			z.next_out  = slot.out_buf.data();
+			z.avail_out = block_size;
+
+			int status = deflate(&z, Z_FINISH);
+			slot.comp_size = block_size - z.avail_out;
+			// Blocks that don't compress well are stored uncompressed.
+			slot.stored = (status != Z_STREAM_END) || (z.avail_out < 10);
+			if (slot.stored)
+				slot.hash = HashAdler32(slot.in_buf.data(), block_size);
+			else
+				slot.hash = HashAdler32(slot.out_buf.data(), slot.comp_size);
+		});
+
+		// Now we are ready to write compressed data!
+		u64 position = 0;
+		int num_compressed = 0;
+		int num_stored = 0;
+		int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
+		bool was_cancelled = false;
+		u32 next_read = 0;
+
+		for (u32 i = 0; i < header.num_blocks; i++)
+		{
+			if (i % progress_monitor == 0)
+			{
+				const u64 inpos = (u64)i * block_size;
+				int ratio = 0;
+				if (inpos != 0)
+					ratio = (int)(100 * position / inpos);
+
+				std::string temp = StringFromFormat("%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
+				was_cancelled = !report_progress(temp, (float)i / (float)header.num_blocks);
+				if (was_cancelled)
+					break;
+			}
+
+			// Keep the workers busy.
+			for (; next_read < header.num_blocks && !queue.IsFull(); next_read++)
+			{
+				CompressSlot& slot = queue.GetFreeSlot();
+				slot.in_buf.resize(block_size);
+				slot.out_buf.resize(block_size);
+
+				size_t read_bytes;
+				if (scrubbing)
+					read_bytes = DiscScrubber::GetNextBlock(inf, slot.in_buf.data());
+				else
+					inf.ReadArray(slot.in_buf.data(), header.block_size, &read_bytes);
+				if (read_bytes < header.block_size)
+					std::fill(slot.in_buf.begin() + read_bytes, slot.in_buf.end(), 0);
+
+				queue.Submit();
+			}
+
+			CompressSlot& slot = queue.WaitForOldest();
+			if (slot.failed)
+			{
+				ERROR_LOG(DISCIO, "Deflate failed");
+				success = false;
+				break;
+			}
+
+			offsets[i] = position;
+			hashes[i] = slot.hash;
+			if (slot.stored)
+			{
+				// let's store uncompressed
+				offsets[i] |= 0x8000000000000000ULL;
+				f.WriteBytes(slot.in_buf.data(), block_size);
+				position += block_size;
+				num_stored++;
+			}
+			else
+			{
+				// let's store compressed
+				f.WriteBytes(slot.out_buf.data(), slot.comp_size);
+				position += slot.comp_size;
+				num_compressed++;
+			}
+			queue.PopOldest();
 		}
 
-		int status = deflate(&z, Z_FINISH);
-		int comp_size = block_size - z.avail_out;
-		if ((status != Z_STREAM_END) || (z.avail_out < 10))
+		header.compressed_data_size = position;
+
+		if (was_cancelled)
 		{
-			//PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-			// let's store uncompressed
-			offsets[i] |= 0x8000000000000000ULL;
-			f.WriteBytes(in_buf, block_size);
-			hashes[i] = HashAdler32(in_buf, block_size);
-			position += block_size;
-			num_stored++;
+			// Remove the incomplete output file.
+			f.Close();
+			File::Delete(outfile);
 		}
-		else
+		else if (success)
 		{
-			// let's store compressed
-			//PanicAlert("Comp %i to %i", block_size, comp_size);
-			f.WriteBytes(out_buf, comp_size);
-			hashes[i] = HashAdler32(out_buf, comp_size);
-			position += comp_size;
-			num_compressed++;
+			// Okay, go back and fill in headers
+			f.Seek(0, SEEK_SET);
+			f.WriteArray(&header, 1);
+			f.WriteArray(offsets.data(), header.num_blocks);
+			f.WriteArray(hashes.data(), header.num_blocks);
 		}
 	}
 
-	header.compressed_data_size = position;
-
-	if (was_cancelled)
-	{
-		// Remove the incomplete output file.
-		f.Close();
-		File::Delete(outfile);
-	}
-	else
-	{
-		// Okay, go back and fill in headers
-		f.Seek(0, SEEK_SET);
-		f.WriteArray(&header, 1);
-		f.WriteArray(offsets, header.num_blocks);
-		f.WriteArray(hashes, header.num_blocks);
-	}
-
-cleanup:
-	// Cleanup
-	delete[] in_buf;
-	delete[] out_buf;
-	delete[] offsets;
-	delete[] hashes;
+	DiscScrubber::Cleanup();
+	report_progress("Done compressing disc image.", 1.0f);
 
-	deflateEnd(&z);
+	for (z_stream& z : streams)
+		deflateEnd(&z);
 
-	DiscScrubber::Cleanup();
-	callback("Done compressing disc image.", 1.0f, arg);
-	return true;
+	return success;
 }
 
-bool DecompressBlobToFile(const std::string& infile, const std::string& outfile, CompressCB callback, void* arg)
+bool DecompressBlobToFile(const std::string& infile, const std::string& outfile, CompressCB callback, void* arg,
+		int num_threads)
 {
 	if (!IsCompressedBlob(infile))
 	{
@@ -314,23 +686,42 @@ bool DecompressBlobToFile(const std::string& infile, const std::string& outfile,
 		return false;
 
 	const CompressedBlobHeader &header = reader->GetHeader();
-	static const size_t BUFFER_BLOCKS = 32;
-	size_t buffer_size = header.block_size * BUFFER_BLOCKS;
-	std::vector<u8> buffer(buffer_size);
-	u32 num_buffers = header.num_blocks / BUFFER_BLOCKS;
-	int progress_monitor = std::max<int>(1, num_buffers / 100);
+	int progress_monitor = std::max<int>(1, header.num_blocks / 100);
 	bool was_cancelled = false;
 
-	for (u64 i = 0; i < num_buffers; i++)
+	struct DecompressSlot
+	{
+		u64 block_num;
+		std::vector<u8> data;
+	};
+
+	OrderedWorkQueue<DecompressSlot> queue(GetNumWorkers(num_threads), [&](DecompressSlot& slot, int worker) {
+		reader->DecodeBlock(slot.block_num, slot.data.data());
+	});
+
+	u32 next_read = 0;
+	for (u32 i = 0; i < header.num_blocks; i++)
 	{
 		if (i % progress_monitor == 0)
 		{
-			was_cancelled = !callback("Unpacking", (float)i / (float)num_buffers, arg);
+			was_cancelled = callback && !callback("Unpacking", (float)i / (float)header.num_blocks, arg);
 			if (was_cancelled)
 				break;
 		}
-		reader->Read(i * buffer_size, buffer_size, buffer.data());
-		f.WriteBytes(buffer.data(), buffer_size);
+
+		for (; next_read < header.num_blocks && !queue.IsFull(); next_read++)
+		{
+			DecompressSlot& slot = queue.GetFreeSlot();
+			slot.block_num = next_read;
+			slot.data.resize(header.block_size);
+			queue.Submit();
+		}
+
+		// The last block is padded; don't write past the end of the data.
+		const DecompressSlot& slot = queue.WaitForOldest();
+		u64 offset = (u64)i * header.block_size;
+		f.WriteBytes(slot.data.data(), (size_t)std::min<u64>(header.block_size, header.data_size - offset));
+		queue.PopOldest();
 	}
 
 	if (was_cancelled)
@@ -339,10 +730,6 @@ bool DecompressBlobToFile(const std::string& infile, const std::string& outfile,
 		f.Close();
 		File::Delete(outfile);
 	}
-	else
-	{
-		f.Resize(header.data_size);
-	}
 
 	return true;
 }
@@ -14,7 +14,14 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
@@ -43,6 +50,11 @@ struct CompressedBlobHeader // 32 bytes
 	u32 num_blocks;
 };
 
+// Decompressed blocks are kept in an LRU cache. When reads look sequential,
+// the next few blocks are decompressed ahead of time on worker threads, and
+// multi-block reads decompress their blocks in parallel. The workers are only
+// started once one of those happens, so short-lived readers (game list
+// scanning) stay single threaded.
 class CompressedBlobReader : public SectorReader
 {
 public:
@@ -53,18 +65,69 @@ public:
 	u64 GetRawSize() const override { return m_file_size; }
 	u64 GetBlockCompressedSize(u64 block_num) const;
 	void GetBlock(u64 block_num, u8* out_ptr) override;
+	bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override;
+
+	// Reads, verifies and decompresses a block, bypassing the cache. Safe to
+	// call from any thread.
+	void DecodeBlock(u64 block_num, u8* out_ptr);
+
+	// Applies to readers created afterwards.
+	static void SetCacheSize(u32 megabytes, u32 read_ahead_blocks);
+
 private:
 	CompressedBlobReader(const std::string& filename);
 
+	struct CachedBlock
+	{
+		std::vector<u8> data;
+		bool ready = false;
+		std::list<u64>::iterator lru;
+	};
+
+	// A block to decompress on a worker thread: into dest if set (counting down
+	// *remaining when done), otherwise into its cache entry.
+	struct Job
+	{
+		u64 block_num;
+		u8* dest;
+		int* remaining;
+	};
+
+	// These must be called with m_cache_lock held, which they may drop while
+	// decompressing.
+	const std::vector<u8>& GetCachedBlock(u64 block_num, std::unique_lock<std::mutex>& lock);
+	void DecodeIntoCache(u64 block_num, CachedBlock& entry, std::unique_lock<std::mutex>& lock);
+	void RunJob(const Job& job, std::unique_lock<std::mutex>& lock);
+	void UpdateReadAhead(u64 first_block, u64 last_block);
+	void StartWorkers();
+
+	void WorkerThread();
+
 	CompressedBlobHeader m_header;
 	u64* m_block_pointers;
 	u32* m_hashes;
 	int m_data_offset;
 	File::IOFile m_file;
+	std::mutex m_file_lock;
 	u64 m_file_size;
-	u8* m_zlib_buffer;
-	int m_zlib_buffer_size;
 	std::string m_file_name;
+
+	// Guards everything below.
+	std::mutex m_cache_lock;
+	std::unordered_map<u64, CachedBlock> m_cache;
+	std::list<u64> m_lru; // Ready blocks, most recently used first.
+	size_t m_max_cached_blocks;
+	std::condition_variable m_block_ready;
+
+	std::deque<Job> m_jobs;
+	std::condition_variable m_work_available;
+	std::vector<std::thread> m_workers;
+	bool m_shutdown;
+
+	// Sequential access predictor.
+	u64 m_next_block;
+	int m_sequential_reads;
+	u32 m_read_ahead;
 };
 
 }  // namespace
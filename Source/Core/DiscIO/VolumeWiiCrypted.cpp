@@ -2,8 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <polarssl/aes.h>
@@ -11,7 +14,9 @@
 
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
 #include "Common/MsgHandler.h"
+#include "Common/WorkerPool.h"
 #include "Common/Logging/Log.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/FileMonitor.h"
@@ -23,35 +28,51 @@
 namespace DiscIO
 {
 
+// Reads of at least this many whole clusters are decrypted on several threads.
+static const u64 PARALLEL_CLUSTERS = 16;
+
 CVolumeWiiCrypted::CVolumeWiiCrypted(IBlobReader* _pReader, u64 _VolumeOffset,
 									 const unsigned char* _pVolumeKey)
 	: m_pReader(_pReader),
 	m_AES_ctx(new aes_context),
-	m_pBuffer(nullptr),
 	m_VolumeOffset(_VolumeOffset),
 	m_dataOffset(0x20000),
-	m_LastDecryptedBlockOffset(-1)
+	m_access_counter(0)
 {
-	aes_setkey_dec(m_AES_ctx.get(), _pVolumeKey, 128);
-	m_pBuffer = new u8[0x8000];
+	for (CachedCluster& entry : m_cache)
+	{
+		entry.cluster = (u64)-1;
+		entry.age = 0;
+		entry.data.reset(new u8[CLUSTER_DATA_SIZE]);
+	}
+	SetKey(_pVolumeKey);
+}
+
+void CVolumeWiiCrypted::SetKey(const u8* key)
+{
+	aes_setkey_dec(m_AES_ctx.get(), key, 128);
+#if _M_X86
+	if (cpu_info.bAES)
+		AES::ExpandDecryptionKey(key, m_round_keys);
+#endif
+
+	for (CachedCluster& entry : m_cache)
+		entry.cluster = (u64)-1;
 }
 
 bool CVolumeWiiCrypted::ChangePartition(u64 offset)
 {
 	m_VolumeOffset = offset;
-	m_LastDecryptedBlockOffset = -1;
 
 	u8 volume_key[16];
 	DiscIO::VolumeKeyForParition(*m_pReader, offset, volume_key);
-	aes_setkey_dec(m_AES_ctx.get(), volume_key, 128);
+	SetKey(volume_key);
 	return true;
 }
 
 
 CVolumeWiiCrypted::~CVolumeWiiCrypted()
 {
-	delete[] m_pBuffer;
-	m_pBuffer = nullptr;
 }
 
 bool CVolumeWiiCrypted::RAWRead( u64 _Offset, u64 _Length, u8* _pBuffer ) const
@@ -65,6 +86,79 @@ bool CVolumeWiiCrypted::RAWRead( u64 _Offset, u64 _Length, u8* _pBuffer ) const
 		return true;
 }
 
+void CVolumeWiiCrypted::DecryptCluster(const u8* raw, u8* out) const
+{
+	u8 iv[16];
+	memcpy(iv, raw + 0x3d0, 16);
+#if _M_X86
+	if (cpu_info.bAES)
+	{
+		AES::DecryptCBC(m_round_keys, iv, raw + CLUSTER_DATA_OFFSET, out, CLUSTER_DATA_SIZE);
+		return;
+	}
+#endif
+	aes_crypt_cbc(m_AES_ctx.get(), AES_DECRYPT, CLUSTER_DATA_SIZE, iv, raw + CLUSTER_DATA_OFFSET, out);
+}
+
+const u8* CVolumeWiiCrypted::GetDecryptedCluster(u64 cluster) const
+{
+	int oldest = 0;
+	for (int i = 0; i < CACHE_SIZE; i++)
+	{
+		if (m_cache[i].cluster == cluster)
+		{
+			m_cache[i].age = ++m_access_counter;
+			return m_cache[i].data.get();
+		}
+		if (m_cache[i].age < m_cache[oldest].age)
+			oldest = i;
+	}
+
+	m_raw_buffer.resize(CLUSTER_SIZE);
+	if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + cluster * CLUSTER_SIZE, CLUSTER_SIZE, m_raw_buffer.data()))
+		return nullptr;
+
+	CachedCluster& entry = m_cache[oldest];
+	DecryptCluster(m_raw_buffer.data(), entry.data.get());
+	entry.cluster = cluster;
+	entry.age = ++m_access_counter;
+	return entry.data.get();
+}
+
+bool CVolumeWiiCrypted::ReadClusters(u64 first_cluster, u64 num_clusters, u8* out) const
+{
+	m_raw_buffer.resize((size_t)(num_clusters * CLUSTER_SIZE));
+	if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + first_cluster * CLUSTER_SIZE, num_clusters * CLUSTER_SIZE, m_raw_buffer.data()))
+		return false;
+
+	auto decrypt_range = [&](u64 begin, u64 end) {
+		for (u64 i = begin; i < end; i++)
+			DecryptCluster(&m_raw_buffer[(size_t)(i * CLUSTER_SIZE)], out + i * CLUSTER_DATA_SIZE);
+	};
+
+	// Shared by all volumes. Only one read can use it at a time, any other
+	// decrypts on its own thread rather than waiting.
+	static std::mutex s_pool_lock;
+	static std::unique_ptr<Common::WorkerPool> s_pool;
+
+	std::unique_lock<std::mutex> lk(s_pool_lock, std::defer_lock);
+	if (num_clusters < PARALLEL_CLUSTERS || !lk.try_lock())
+	{
+		decrypt_range(0, num_clusters);
+		return true;
+	}
+
+	if (!s_pool)
+		s_pool.reset(new Common::WorkerPool());
+
+	u64 num_chunks = std::min<u64>(s_pool->GetNumThreads(), num_clusters / (PARALLEL_CLUSTERS / 2));
+	s_pool->ParallelFor((size_t)num_chunks, [&](size_t chunk) {
+		decrypt_range(num_clusters * chunk / num_chunks, num_clusters * (chunk + 1) / num_chunks);
+	});
+
+	return true;
+}
+
 bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 {
 	if (m_pReader == nullptr)
@@ -74,28 +168,31 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 
 	while (_Length > 0)
 	{
-		static unsigned char IV[16];
-
 		// math block offset
-		u64 Block  = _ReadOffset / 0x7C00;
-		u64 Offset = _ReadOffset % 0x7C00;
+		u64 Block  = _ReadOffset / CLUSTER_DATA_SIZE;
+		u64 Offset = _ReadOffset % CLUSTER_DATA_SIZE;
 
-		// read current block
-		if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + Block * 0x8000, 0x8000, m_pBuffer))
-			return(false);
-
-		if (m_LastDecryptedBlockOffset != Block)
+		// Whole clusters bypass the cache.
+		if (Offset == 0 && _Length >= 2 * CLUSTER_DATA_SIZE)
 		{
-			memcpy(IV, m_pBuffer + 0x3d0, 16);
-			aes_crypt_cbc(m_AES_ctx.get(), AES_DECRYPT, 0x7C00, IV, m_pBuffer + 0x400, m_LastDecryptedBlock);
+			u64 num_clusters = _Length / CLUSTER_DATA_SIZE;
+			if (!ReadClusters(Block, num_clusters, _pBuffer))
+				return(false);
 
-			m_LastDecryptedBlockOffset = Block;
+			_Length -= num_clusters * CLUSTER_DATA_SIZE;
+			_pBuffer += num_clusters * CLUSTER_DATA_SIZE;
+			_ReadOffset += num_clusters * CLUSTER_DATA_SIZE;
+			continue;
 		}
 
+		const u8* data = GetDecryptedCluster(Block);
+		if (!data)
+			return(false);
+
 		// copy the encrypted data
-		u64 MaxSizeToCopy = 0x7C00 - Offset;
+		u64 MaxSizeToCopy = CLUSTER_DATA_SIZE - Offset;
 		u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-		memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+		memcpy(_pBuffer, &data[Offset], (size_t)CopySize);
 
 		// increase buffers
 		_Length -= CopySize;
@@ -10,6 +10,7 @@
 #include <polarssl/aes.h>
 
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
 #include "DiscIO/Volume.h"
 
 // --- this volume type is used for encrypted Wii images ---
@@ -44,16 +45,42 @@ public:
 	bool ChangePartition(u64 offset) override;
 
 private:
+	enum
+	{
+		CLUSTER_SIZE = 0x8000,
+		CLUSTER_DATA_OFFSET = 0x400,
+		CLUSTER_DATA_SIZE = 0x7C00,
+		// Number of decrypted clusters kept around for small reads.
+		CACHE_SIZE = 16,
+	};
+
+	void SetKey(const u8* key);
+	// Decrypts the data of a raw cluster. Safe to call from several threads.
+	void DecryptCluster(const u8* raw, u8* out) const;
+	// Decrypts num_clusters whole clusters straight into out, in parallel if
+	// there are enough of them.
+	bool ReadClusters(u64 first_cluster, u64 num_clusters, u8* out) const;
+	const u8* GetDecryptedCluster(u64 cluster) const;
+
 	std::unique_ptr<IBlobReader> m_pReader;
 	std::unique_ptr<aes_context> m_AES_ctx;
-
-	u8* m_pBuffer;
+	// For the AES-NI path.
+	u8 m_round_keys[AES::NUM_ROUND_KEYS * AES::BLOCK_SIZE];
 
 	u64 m_VolumeOffset;
 	u64 m_dataOffset;
 
-	mutable u64 m_LastDecryptedBlockOffset;
-	mutable unsigned char m_LastDecryptedBlock[0x8000];
+	mutable std::vector<u8> m_raw_buffer;
+
+	// LRU cache of decrypted clusters.
+	struct CachedCluster
+	{
+		u64 cluster;
+		u32 age;
+		std::unique_ptr<u8[]> data;
+	};
+	mutable CachedCluster m_cache[CACHE_SIZE];
+	mutable u32 m_access_counter;
 };
 
 } // namespace
@@ -28,6 +28,7 @@ namespace DX11
 GeometryShaderCache::GSCache GeometryShaderCache::GeometryShaders;
 const GeometryShaderCache::GSCacheEntry* GeometryShaderCache::last_entry;
 GeometryShaderUid GeometryShaderCache::last_uid;
+ShaderUidInputs GeometryShaderCache::last_uid_inputs;
 UidChecker<GeometryShaderUid,ShaderCode> GeometryShaderCache::geometry_uid_checker;
 const GeometryShaderCache::GSCacheEntry GeometryShaderCache::pass_entry;
 
@@ -163,6 +164,7 @@ void GeometryShaderCache::Init()
 		Clear();
 
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 // ONLY to be used during shutdown.
@@ -174,6 +176,7 @@ void GeometryShaderCache::Clear()
 	geometry_uid_checker.Invalidate();
 
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 void GeometryShaderCache::Shutdown()
@@ -190,6 +193,13 @@ void GeometryShaderCache::Shutdown()
 
 bool GeometryShaderCache::SetShader(u32 primitive_type)
 {
+	// Nothing the UID depends on has changed since the last draw.
+	if (!last_uid_inputs.Changed(primitive_type) && last_entry)
+	{
+		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE,true);
+		return true;
+	}
+
 	GeometryShaderUid uid;
 	GetGeometryShaderUid(uid, primitive_type, API_D3D);
 	if (g_ActiveConfig.bEnableShaderDebugging)
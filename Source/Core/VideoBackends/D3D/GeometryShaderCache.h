@@ -5,7 +5,7 @@
 #pragma once
 
 #include <d3d11.h>
-#include <map>
+#include <unordered_map>
 
 #include "VideoCommon/GeometryShaderGen.h"
 
@@ -38,11 +38,12 @@ private:
 		void Destroy() { SAFE_RELEASE(shader); }
 	};
 
-	typedef std::map<GeometryShaderUid, GSCacheEntry> GSCache;
+	typedef std::unordered_map<GeometryShaderUid, GSCacheEntry, GeometryShaderUid::Hasher> GSCache;
 
 	static GSCache GeometryShaders;
 	static const GSCacheEntry* last_entry;
 	static GeometryShaderUid last_uid;
+	static ShaderUidInputs last_uid_inputs;
 	static const GSCacheEntry pass_entry;
 
 	static UidChecker<GeometryShaderUid, ShaderCode> geometry_uid_checker;
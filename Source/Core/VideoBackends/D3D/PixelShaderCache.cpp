@@ -27,6 +27,7 @@ namespace DX11
 PixelShaderCache::PSCache PixelShaderCache::PixelShaders;
 const PixelShaderCache::PSCacheEntry* PixelShaderCache::last_entry;
 PixelShaderUid PixelShaderCache::last_uid;
+ShaderUidInputs PixelShaderCache::last_uid_inputs;
 UidChecker<PixelShaderUid,PixelShaderCode> PixelShaderCache::pixel_uid_checker;
 
 LinearDiskCache<PixelShaderUid, u8> g_ps_disk_cache;
@@ -485,6 +486,7 @@ void PixelShaderCache::Init()
 		Clear();
 
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 // ONLY to be used during shutdown.
@@ -496,6 +498,7 @@ void PixelShaderCache::Clear()
 	pixel_uid_checker.Invalidate();
 
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 // Used in Swap() when AA mode has changed
@@ -530,6 +533,13 @@ void PixelShaderCache::Shutdown()
 
 bool PixelShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components)
 {
+	// Nothing the UID depends on has changed since the last draw.
+	if (!last_uid_inputs.Changed(dstAlphaMode, components) && last_entry)
+	{
+		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE,true);
+		return (last_entry->shader != nullptr);
+	}
+
 	PixelShaderUid uid;
 	GetPixelShaderUid(uid, dstAlphaMode, API_D3D, components);
 	if (g_ActiveConfig.bEnableShaderDebugging)
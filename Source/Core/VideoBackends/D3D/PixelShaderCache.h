@@ -5,7 +5,7 @@
 #pragma once
 
 #include <d3d11.h>
-#include <map>
+#include <unordered_map>
 
 #include "VideoCommon/PixelShaderGen.h"
 
@@ -47,11 +47,12 @@ private:
 		void Destroy() { SAFE_RELEASE(shader); }
 	};
 
-	typedef std::map<PixelShaderUid, PSCacheEntry> PSCache;
+	typedef std::unordered_map<PixelShaderUid, PSCacheEntry, PixelShaderUid::Hasher> PSCache;
 
 	static PSCache PixelShaders;
 	static const PSCacheEntry* last_entry;
 	static PixelShaderUid last_uid;
+	static ShaderUidInputs last_uid_inputs;
 
 	static UidChecker<PixelShaderUid,PixelShaderCode> pixel_uid_checker;
 };
@@ -75,14 +75,14 @@ bool TextureCache::TCacheEntry::Save(const std::string& filename, unsigned int l
 	return saved_png;
 }
 
-void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
+void TextureCache::TCacheEntry::Load(const u8* buffer, unsigned int width, unsigned int height,
 	unsigned int expanded_width, unsigned int level)
 {
-	D3D::ReplaceRGBATexture2D(texture->GetTex(), TextureCache::temp, width, height, expanded_width, level, usage);
+	D3D::ReplaceRGBATexture2D(texture->GetTex(), buffer, width, height, expanded_width, level, usage);
 }
 
-TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
-	unsigned int height, unsigned int expanded_width,
+TextureCache::TCacheEntryBase* TextureCache::CreateTexture(const u8* buffer,
+	unsigned int width, unsigned int height, unsigned int expanded_width,
 	unsigned int tex_levels, PC_TexFormat pcfmt)
 {
 	D3D11_USAGE usage = D3D11_USAGE_DEFAULT;
@@ -94,7 +94,7 @@ TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
 		usage = D3D11_USAGE_DYNAMIC;
 		cpu_access = D3D11_CPU_ACCESS_WRITE;
 
-		srdata.pSysMem = TextureCache::temp;
+		srdata.pSysMem = buffer;
 		srdata.SysMemPitch = 4 * expanded_width;
 
 		data = &srdata;
@@ -117,7 +117,7 @@ TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
 	SAFE_RELEASE(pTexture);
 
 	if (tex_levels != 1)
-		entry->Load(width, height, expanded_width, 0);
+		entry->Load(buffer, width, height, expanded_width, 0);
 
 	return entry;
 }
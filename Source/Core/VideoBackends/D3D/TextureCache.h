@@ -26,7 +26,7 @@ private:
 		TCacheEntry(D3DTexture2D *_tex) : texture(_tex) {}
 		~TCacheEntry();
 
-		void Load(unsigned int width, unsigned int height,
+		void Load(const u8* buffer, unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int levels) override;
 
 		void FromRenderTarget(u32 dstAddr, unsigned int dstFormat,
@@ -38,7 +38,7 @@ private:
 		bool Save(const std::string& filename, unsigned int level) override;
 	};
 
-	TCacheEntryBase* CreateTexture(unsigned int width, unsigned int height,
+	TCacheEntryBase* CreateTexture(const u8* buffer, unsigned int width, unsigned int height,
 		unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt) override;
 
 	TCacheEntryBase* CreateRenderTargetTexture(unsigned int scaled_tex_w, unsigned int scaled_tex_h) override;
@@ -24,6 +24,7 @@ namespace DX11 {
 VertexShaderCache::VSCache VertexShaderCache::vshaders;
 const VertexShaderCache::VSCacheEntry *VertexShaderCache::last_entry;
 VertexShaderUid VertexShaderCache::last_uid;
+ShaderUidInputs VertexShaderCache::last_uid_inputs;
 UidChecker<VertexShaderUid,VertexShaderCode> VertexShaderCache::vertex_uid_checker;
 
 static ID3D11VertexShader* SimpleVertexShader = nullptr;
@@ -157,6 +158,7 @@ void VertexShaderCache::Init()
 		Clear();
 
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 void VertexShaderCache::Clear()
@@ -167,6 +169,7 @@ void VertexShaderCache::Clear()
 	vertex_uid_checker.Invalidate();
 
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 void VertexShaderCache::Shutdown()
@@ -186,6 +189,13 @@ void VertexShaderCache::Shutdown()
 
 bool VertexShaderCache::SetShader(u32 components)
 {
+	// Nothing the UID depends on has changed since the last draw.
+	if (!last_uid_inputs.Changed(components) && last_entry)
+	{
+		GFX_DEBUGGER_PAUSE_AT(NEXT_VERTEX_SHADER_CHANGE, true);
+		return (last_entry->shader != nullptr);
+	}
+
 	VertexShaderUid uid;
 	GetVertexShaderUid(uid, components, API_D3D);
 	if (g_ActiveConfig.bEnableShaderDebugging)
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <map>
+#include <unordered_map>
 
 #include "VideoBackends/D3D/D3DBase.h"
 #include "VideoBackends/D3D/D3DBlob.h"
@@ -53,11 +53,12 @@ private:
 			SAFE_RELEASE(bytecode);
 		}
 	};
-	typedef std::map<VertexShaderUid, VSCacheEntry> VSCache;
+	typedef std::unordered_map<VertexShaderUid, VSCacheEntry, VertexShaderUid::Hasher> VSCache;
 
 	static VSCache vshaders;
 	static const VSCacheEntry* last_entry;
 	static VertexShaderUid last_uid;
+	static ShaderUidInputs last_uid_inputs;
 
 	static UidChecker<VertexShaderUid,VertexShaderCode> vertex_uid_checker;
 };
@@ -108,6 +108,7 @@ bool cInterfaceGLX::Create(void *window_handle)
 	XErrorHandler oldHandler = XSetErrorHandler(&ctxErrorHandler);
 	ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs);
 	XSync(dpy, False);
+	core_profile = ctx && !s_glxError;
 	if (!ctx || s_glxError)
 	{
 		int context_attribs_legacy[] =
@@ -145,8 +146,75 @@ bool cInterfaceGLX::Create(void *window_handle)
 	return true;
 }
 
+cInterfaceBase* cInterfaceGLX::CreateSharedContext()
+{
+	// A context needs a drawable to be made current, so give the shared one a
+	// tiny pbuffer.
+	int visual_attribs[] =
+	{
+		GLX_DRAWABLE_TYPE   , GLX_PBUFFER_BIT,
+		GLX_RED_SIZE        , 8,
+		GLX_GREEN_SIZE      , 8,
+		GLX_BLUE_SIZE       , 8,
+		None
+	};
+	int fbcount = 0;
+	GLXFBConfig* fbc = glXChooseFBConfig(dpy, DefaultScreen(dpy), visual_attribs, &fbcount);
+	if (!fbc || !fbcount)
+		return nullptr;
+	GLXFBConfig pbuffer_config = *fbc;
+	XFree(fbc);
+
+	int pbuffer_attribs[] =
+	{
+		GLX_PBUFFER_WIDTH   , 1,
+		GLX_PBUFFER_HEIGHT  , 1,
+		None
+	};
+
+	int context_attribs[] =
+	{
+		GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+		GLX_CONTEXT_MINOR_VERSION_ARB, 3,
+		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+		GLX_CONTEXT_FLAGS_ARB,         GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
+		None
+	};
+	int context_attribs_legacy[] =
+	{
+		GLX_CONTEXT_MAJOR_VERSION_ARB, 1,
+		GLX_CONTEXT_MINOR_VERSION_ARB, 0,
+		None
+	};
+
+	cInterfaceGLX* shared = new cInterfaceGLX;
+	shared->dpy = dpy;
+	shared->is_shared = true;
+	shared->core_profile = core_profile;
+
+	s_glxError = false;
+	XErrorHandler oldHandler = XSetErrorHandler(&ctxErrorHandler);
+	shared->ctx = glXCreateContextAttribs(dpy, pbuffer_config, ctx, True,
+	                                      core_profile ? context_attribs : context_attribs_legacy);
+	shared->pbuffer = glXCreatePbuffer(dpy, pbuffer_config, pbuffer_attribs);
+	XSync(dpy, False);
+	XSetErrorHandler(oldHandler);
+
+	if (!shared->ctx || !shared->pbuffer || s_glxError)
+	{
+		ERROR_LOG(VIDEO, "Unable to create a shared GL context.");
+		shared->Shutdown();
+		delete shared;
+		return nullptr;
+	}
+	return shared;
+}
+
 bool cInterfaceGLX::MakeCurrent()
 {
+	if (is_shared)
+		return glXMakeContextCurrent(dpy, pbuffer, pbuffer, ctx);
+
 	bool success = glXMakeCurrent(dpy, win, ctx);
 	if (success)
 	{
@@ -165,6 +233,18 @@ bool cInterfaceGLX::ClearCurrent()
 // Close backend
 void cInterfaceGLX::Shutdown()
 {
+	if (is_shared)
+	{
+		// The display belongs to the context this one was created from.
+		if (ctx)
+			glXDestroyContext(dpy, ctx);
+		if (pbuffer)
+			glXDestroyPbuffer(dpy, pbuffer);
+		ctx = nullptr;
+		pbuffer = 0;
+		return;
+	}
+
 	XWindow.DestroyXWindow();
 	if (ctx)
 	{
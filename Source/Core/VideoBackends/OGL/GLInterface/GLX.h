@@ -19,8 +19,14 @@ private:
 	GLXContext ctx;
 	XVisualInfo *vi;
 	GLXFBConfig fbconfig;
+	bool core_profile;
+
+	// Only used by shared contexts, which render to a pbuffer instead of win.
+	bool is_shared;
+	GLXPbuffer pbuffer;
 public:
 	friend class cX11Window;
+	cInterfaceGLX() : core_profile(false), is_shared(false), pbuffer(0) {}
 	void SwapInterval(int Interval) override;
 	void Swap() override;
 	void* GetFuncAddress(const std::string& name) override;
@@ -28,4 +34,5 @@ public:
 	bool MakeCurrent() override;
 	bool ClearCurrent() override;
 	void Shutdown() override;
+	cInterfaceBase* CreateSharedContext() override;
 };
@@ -33,6 +33,11 @@ public:
 	virtual bool ClearCurrent() { return true; }
 	virtual void Shutdown() {}
 
+	// Creates an offscreen context which shares objects with this one, so that
+	// another thread can create GL objects for it. Must be called with this
+	// context current. Returns nullptr if the platform can't do it.
+	virtual cInterfaceBase* CreateSharedContext() { return nullptr; }
+
 	virtual void SwapInterval(int Interval) { }
 	virtual u32 GetBackBufferWidth() { return s_backbuffer_width; }
 	virtual u32 GetBackBufferHeight() { return s_backbuffer_height; }
@@ -2,11 +2,21 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "Common/MathUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 
+#include "VideoBackends/OGL/GLInterfaceBase.h"
 #include "VideoBackends/OGL/ProgramShaderCache.h"
 #include "VideoBackends/OGL/Render.h"
 #include "VideoBackends/OGL/StreamBuffer.h"
@@ -28,19 +38,50 @@ u32 ProgramShaderCache::s_ubo_buffer_size;
 s32 ProgramShaderCache::s_ubo_align;
 
 static StreamBuffer *s_buffer;
-static int num_failures = 0;
+static std::atomic<int> num_failures(0);
 
 static LinearDiskCache<SHADERUID, u8> g_program_disk_cache;
 static GLuint CurrentProgram = 0;
 ProgramShaderCache::PCache ProgramShaderCache::pshaders;
 ProgramShaderCache::PCacheEntry* ProgramShaderCache::last_entry;
 SHADERUID ProgramShaderCache::last_uid;
+ShaderUidInputs ProgramShaderCache::last_uid_inputs;
 UidChecker<PixelShaderUid,PixelShaderCode> ProgramShaderCache::pixel_uid_checker;
 UidChecker<VertexShaderUid,VertexShaderCode> ProgramShaderCache::vertex_uid_checker;
 UidChecker<GeometryShaderUid,ShaderCode> ProgramShaderCache::geometry_uid_checker;
 
 static char s_glsl_header[1024] = "";
 
+// With bBackgroundShaderCompiling, programs are linked by worker threads on
+// shared contexts, and the source of every program is recorded so that the
+// next run of the same game can start compiling them right away. The UIDs
+// alone aren't enough for that, the generators build the code from the
+// current xf/bp state rather than from a UID.
+struct ShaderCompileJob
+{
+	std::string vcode, pcode, gcode;
+
+	// Guarded by s_compile_mutex.
+	GLuint program;
+	bool done;
+	// Already moved to the front of the queue because a draw needs it.
+	bool urgent;
+};
+
+static LinearDiskCache<SHADERUID, char> s_source_disk_cache;
+// Sources of programs which didn't make it into the binary cache are kept up to this size.
+static const size_t MAX_SOURCE_CACHE_SIZE = 32 * 1024 * 1024;
+
+static std::vector<cInterfaceBase*> s_compile_contexts;
+static std::vector<std::thread> s_compile_threads;
+static std::mutex s_compile_mutex;
+// Signalled when a job is queued, and when the threads have to quit.
+static std::condition_variable s_compile_queue_cond;
+// Signalled when a job is done.
+static std::condition_variable s_compile_done_cond;
+static std::deque<std::shared_ptr<ShaderCompileJob>> s_compile_queue;
+static bool s_compile_threads_quit;
+
 static std::string GetGLSLVersionString()
 {
 	GLSL_VERSION v = g_ogl_config.eSupportedGLSLVersion;
@@ -95,7 +136,7 @@ void SHADER::SetProgramVariables()
 	}
 }
 
-void SHADER::SetProgramBindings()
+void SHADER::SetProgramBindings(GLuint glprogid)
 {
 	if (g_ActiveConfig.backend_info.bSupportsDualSourceBlend)
 	{
@@ -173,6 +214,13 @@ GLuint ProgramShaderCache::GetCurrentProgram()
 
 SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components, u32 primitive_type)
 {
+	// Nothing the UID depends on has changed since the last draw.
+	if (!last_uid_inputs.Changed(dstAlphaMode, components, primitive_type) && last_entry)
+	{
+		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
+		return BindEntry(last_entry);
+	}
+
 	SHADERUID uid;
 	GetShaderId(&uid, dstAlphaMode, components, primitive_type);
 
@@ -182,8 +230,7 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 		if (uid == last_uid)
 		{
 			GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-			last_entry->shader.Bind();
-			return &last_entry->shader;
+			return BindEntry(last_entry);
 		}
 	}
 
@@ -197,8 +244,7 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 		last_entry = entry;
 
 		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-		last_entry->shader.Bind();
-		return &last_entry->shader;
+		return BindEntry(last_entry);
 	}
 
 	// Make an entry in the table
@@ -239,6 +285,23 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 	}
 #endif
 
+	if (!s_compile_threads.empty())
+	{
+		// Record the source for the next run, see ShaderSourceInserter.
+		std::string sources = vcode.GetBuffer();
+		sources += '\0';
+		sources += pcode.GetBuffer();
+		sources += '\0';
+		if (gcode.GetBuffer())
+			sources += gcode.GetBuffer();
+		s_source_disk_cache.Append(uid, sources.data(), (u32)sources.size());
+
+		QueueCompile(&newentry, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer(), true);
+		SETSTAT(stats.numPixelShadersAlive, pshaders.size());
+		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
+		return BindEntry(&newentry);
+	}
+
 	if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer()))
 	{
 		GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
@@ -253,7 +316,68 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 	return &last_entry->shader;
 }
 
+// Binds the program of a cache entry, first waiting for it if it's still
+// being compiled in the background. Returns nullptr if there's no usable
+// program, or if bSkipDrawsWhileCompiling is set and it isn't ready yet.
+SHADER* ProgramShaderCache::BindEntry(PCacheEntry* entry)
+{
+	if (entry->pending)
+	{
+		const std::shared_ptr<ShaderCompileJob> job = entry->pending;
+		{
+			std::unique_lock<std::mutex> lk(s_compile_mutex);
+			if (!job->done && !job->urgent)
+			{
+				// Prefetched programs sit at the back of the queue.
+				auto queued = std::find(s_compile_queue.begin(), s_compile_queue.end(), job);
+				if (queued != s_compile_queue.end())
+				{
+					s_compile_queue.erase(queued);
+					s_compile_queue.push_front(job);
+				}
+				job->urgent = true;
+			}
+
+			if (!job->done && g_ActiveConfig.bSkipDrawsWhileCompiling)
+				return nullptr;
+
+			s_compile_done_cond.wait(lk, [&] { return job->done; });
+		}
+
+		entry->pending.reset();
+		entry->shader.glprogid = job->program;
+		if (entry->shader.glprogid)
+		{
+			entry->shader.SetProgramVariables();
+			INCSTAT(stats.numPixelShadersCreated);
+		}
+		else
+		{
+			GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+		}
+	}
+
+	if (!entry->shader.glprogid)
+		return nullptr;
+
+	entry->shader.Bind();
+	return &entry->shader;
+}
+
 bool ProgramShaderCache::CompileShader(SHADER& shader, const char* vcode, const char* pcode, const char* gcode)
+{
+	shader.glprogid = LinkProgram(vcode, pcode, gcode);
+	if (!shader.glprogid)
+		return false;
+
+	shader.SetProgramVariables();
+
+	return true;
+}
+
+// Compiles and links a program without touching any state of the current
+// context, so that the compile threads can use it too.
+GLuint ProgramShaderCache::LinkProgram(const char* vcode, const char* pcode, const char* gcode)
 {
 	GLuint vsid = CompileSingleShader(GL_VERTEX_SHADER, vcode);
 	GLuint psid = CompileSingleShader(GL_FRAGMENT_SHADER, pcode);
@@ -268,10 +392,10 @@ bool ProgramShaderCache::CompileShader(SHADER& shader, const char* vcode, const
 		glDeleteShader(vsid);
 		glDeleteShader(psid);
 		glDeleteShader(gsid);
-		return false;
+		return 0;
 	}
 
-	GLuint pid = shader.glprogid = glCreateProgram();
+	GLuint pid = glCreateProgram();
 
 	glAttachShader(pid, vsid);
 	glAttachShader(pid, psid);
@@ -281,7 +405,7 @@ bool ProgramShaderCache::CompileShader(SHADER& shader, const char* vcode, const
 	if (g_ogl_config.bSupportsGLSLCache)
 		glProgramParameteri(pid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
-	shader.SetProgramBindings();
+	SHADER::SetProgramBindings(pid);
 
 	glLinkProgram(pid);
 
@@ -329,12 +453,106 @@ bool ProgramShaderCache::CompileShader(SHADER& shader, const char* vcode, const
 
 		// Don't try to use this shader
 		glDeleteProgram(pid);
-		return false;
+		return 0;
 	}
 
-	shader.SetProgramVariables();
+	return pid;
+}
 
-	return true;
+void ProgramShaderCache::QueueCompile(PCacheEntry* entry, const char* vcode, const char* pcode, const char* gcode, bool urgent)
+{
+	std::shared_ptr<ShaderCompileJob> job = std::make_shared<ShaderCompileJob>();
+	job->vcode = vcode;
+	job->pcode = pcode;
+	if (gcode)
+		job->gcode = gcode;
+	job->program = 0;
+	job->done = false;
+	job->urgent = urgent;
+	entry->pending = job;
+
+	{
+		std::lock_guard<std::mutex> lk(s_compile_mutex);
+		if (urgent)
+			s_compile_queue.push_front(std::move(job));
+		else
+			s_compile_queue.push_back(std::move(job));
+	}
+	s_compile_queue_cond.notify_one();
+}
+
+void ProgramShaderCache::CompileThread(size_t index)
+{
+	Common::SetCurrentThreadName(StringFromFormat("Shader compiler %u", (unsigned int)index).c_str());
+	s_compile_contexts[index]->MakeCurrent();
+
+	std::unique_lock<std::mutex> lk(s_compile_mutex);
+	while (true)
+	{
+		s_compile_queue_cond.wait(lk, [] { return s_compile_threads_quit || !s_compile_queue.empty(); });
+		if (s_compile_threads_quit)
+			break;
+
+		std::shared_ptr<ShaderCompileJob> job = std::move(s_compile_queue.front());
+		s_compile_queue.pop_front();
+		lk.unlock();
+
+		GLuint program = LinkProgram(job->vcode.c_str(), job->pcode.c_str(), job->gcode.empty() ? nullptr : job->gcode.c_str());
+		// Other contexts may only use the program once it's complete.
+		glFinish();
+
+		lk.lock();
+		job->program = program;
+		job->done = true;
+		s_compile_done_cond.notify_all();
+	}
+	lk.unlock();
+
+	s_compile_contexts[index]->ClearCurrent();
+}
+
+void ProgramShaderCache::StartCompileThreads()
+{
+	// Leave some cores to the CPU and GPU threads, and don't go overboard on
+	// drivers which serialize compiles internally anyway.
+	const unsigned int num_threads = std::min(std::max(std::thread::hardware_concurrency() / 2, 1u), 4u);
+	for (unsigned int i = 0; i < num_threads; i++)
+	{
+		cInterfaceBase* context = GLInterface->CreateSharedContext();
+		if (!context)
+			break;
+		s_compile_contexts.push_back(context);
+	}
+
+	if (s_compile_contexts.empty())
+	{
+		WARN_LOG(VIDEO, "Shared contexts aren't supported, compiling shaders on the GPU thread.");
+		return;
+	}
+
+	s_compile_threads_quit = false;
+	for (size_t i = 0; i < s_compile_contexts.size(); i++)
+		s_compile_threads.emplace_back(CompileThread, i);
+}
+
+void ProgramShaderCache::StopCompileThreads()
+{
+	{
+		std::lock_guard<std::mutex> lk(s_compile_mutex);
+		s_compile_threads_quit = true;
+	}
+	s_compile_queue_cond.notify_all();
+	for (std::thread& thread : s_compile_threads)
+		thread.join();
+	s_compile_threads.clear();
+	s_compile_queue.clear();
+
+	for (cInterfaceBase* context : s_compile_contexts)
+	{
+		context->Shutdown();
+		delete context;
+	}
+	s_compile_contexts.clear();
 }
 
 GLuint ProgramShaderCache::CompileSingleShader(GLuint type, const char* code)
@@ -462,18 +680,98 @@ void ProgramShaderCache::Init()
 
 	CreateHeader();
 
+	if (g_Config.bBackgroundShaderCompiling)
+	{
+		StartCompileThreads();
+
+		// Queue everything the last run needed and the binary cache didn't have.
+		if (!s_compile_threads.empty())
+		{
+			if (!File::Exists(File::GetUserPath(D_SHADERCACHE_IDX)))
+				File::CreateDir(File::GetUserPath(D_SHADERCACHE_IDX));
+
+			std::string cache_filename = StringFromFormat("%sogl-%s-sources.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
+				SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
+
+			ShaderSourceInserter inserter;
+			u32 num_entries = s_source_disk_cache.OpenAndRead(cache_filename, inserter);
+
+			// Keep the newest sources up to MAX_SOURCE_CACHE_SIZE.
+			size_t kept_size = 0;
+			auto first_kept = inserter.entries.end();
+			while (first_kept != inserter.entries.begin() &&
+			       kept_size + std::prev(first_kept)->second.size() <= MAX_SOURCE_CACHE_SIZE)
+			{
+				--first_kept;
+				kept_size += first_kept->second.size();
+			}
+			inserter.entries.erase(inserter.entries.begin(), first_kept);
+
+			// The file is only ever appended to, so rewrite it without the
+			// programs the binary cache has by now and the ones over the cap.
+			if (inserter.entries.size() < num_entries)
+			{
+				s_source_disk_cache.Close();
+				File::Delete(cache_filename);
+				ShaderSourceInserter empty;
+				s_source_disk_cache.OpenAndRead(cache_filename, empty);
+				for (const auto& entry : inserter.entries)
+					s_source_disk_cache.Append(entry.first, entry.second.data(), (u32)entry.second.size());
+			}
+
+			for (const auto& entry : inserter.entries)
+			{
+				// vcode\0pcode\0gcode, where gcode is empty without a geometry shader.
+				const std::string& sources = entry.second;
+				const size_t pcode_start = sources.find('\0');
+				const size_t gcode_start = sources.find('\0', pcode_start + 1);
+				if (pcode_start == std::string::npos || gcode_start == std::string::npos || pshaders.count(entry.first))
+					continue;
+
+				const std::string vcode = sources.substr(0, pcode_start);
+				const std::string pcode = sources.substr(pcode_start + 1, gcode_start - pcode_start - 1);
+				const std::string gcode = sources.substr(gcode_start + 1);
+
+				PCacheEntry& newentry = pshaders[entry.first];
+				newentry.in_cache = 0;
+				QueueCompile(&newentry, vcode.c_str(), pcode.c_str(), gcode.empty() ? nullptr : gcode.c_str(), false);
+			}
+			SETSTAT(stats.numPixelShadersAlive, pshaders.size());
+		}
+	}
+
 	CurrentProgram = 0;
 	last_entry = nullptr;
+	last_uid_inputs.Reset();
 }
 
 void ProgramShaderCache::Shutdown()
 {
+	if (!s_compile_threads.empty())
+	{
+		StopCompileThreads();
+		s_source_disk_cache.Sync();
+		s_source_disk_cache.Close();
+
+		// Programs which were prefetched but never drawn with can still go
+		// into the binary cache.
+		for (auto& entry : pshaders)
+		{
+			if (entry.second.pending)
+			{
+				if (entry.second.pending->done)
+					entry.second.shader.glprogid = entry.second.pending->program;
+				entry.second.pending.reset();
+			}
+		}
+	}
+
 	// store all shaders in cache on disk
 	if (g_ogl_config.bSupportsGLSLCache && !g_Config.bEnableShaderDebugging)
 	{
 		for (auto& entry : pshaders)
 		{
-			if (entry.second.in_cache)
+			if (entry.second.in_cache || !entry.second.shader.glprogid)
 			{
 				continue;
 			}
@@ -599,5 +897,14 @@ void ProgramShaderCache::ProgramShaderCacheInserter::Read(const SHADERUID& key,
 	}
 }
 
+void ProgramShaderCache::ShaderSourceInserter::Read(const SHADERUID& key, const char* value, u32 value_size)
+{
+	// Already loaded from the binary cache.
+	if (pshaders.count(key))
+		return;
+
+	entries.emplace_back(key, std::string(value, value_size));
+}
+
 
 } // namespace OGL
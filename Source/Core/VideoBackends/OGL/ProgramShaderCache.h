@@ -4,6 +4,12 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "Common/LinearDiskCache.h"
 #include "Core/ConfigManager.h"
 #include "VideoBackends/OGL/GLUtil.h"
@@ -49,6 +55,14 @@ public:
 	{
 		return puid == r.puid && vuid == r.vuid && guid == r.guid;
 	}
+
+	struct Hasher
+	{
+		size_t operator()(const SHADERUID& uid) const
+		{
+			return (size_t)(uid.puid.GetHash() ^ (uid.vuid.GetHash() * 31) ^ (uid.guid.GetHash() * 961));
+		}
+	};
 };
 
 
@@ -65,10 +79,13 @@ struct SHADER
 	std::string strvprog, strpprog, strgprog;
 
 	void SetProgramVariables();
-	void SetProgramBindings();
+	static void SetProgramBindings(GLuint glprogid);
 	void Bind();
 };
 
+// A program which is being linked on a worker thread.
+struct ShaderCompileJob;
+
 class ProgramShaderCache
 {
 public:
@@ -78,13 +95,17 @@ public:
 		SHADER shader;
 		bool in_cache;
 
+		// Set while the program is queued or being compiled in the background,
+		// shader.glprogid is 0 until it has finished.
+		std::shared_ptr<ShaderCompileJob> pending;
+
 		void Destroy()
 		{
 			shader.Destroy();
 		}
 	};
 
-	typedef std::map<SHADERUID, PCacheEntry> PCache;
+	typedef std::unordered_map<SHADERUID, PCacheEntry, SHADERUID::Hasher> PCache;
 
 	static PCacheEntry GetShaderProgram();
 	static GLuint GetCurrentProgram();
@@ -92,6 +113,7 @@ public:
 	static void GetShaderId(SHADERUID *uid, DSTALPHA_MODE dstAlphaMode, u32 components, u32 primitive_type);
 
 	static bool CompileShader(SHADER &shader, const char* vcode, const char* pcode, const char* gcode = nullptr);
+	static GLuint LinkProgram(const char* vcode, const char* pcode, const char* gcode);
 	static GLuint CompileSingleShader(GLuint type, const char *code);
 	static void UploadConstants();
 
@@ -106,9 +128,25 @@ private:
 		void Read(const SHADERUID &key, const u8 *value, u32 value_size) override;
 	};
 
+	class ShaderSourceInserter : public LinearDiskCacheReader<SHADERUID, char>
+	{
+	public:
+		void Read(const SHADERUID &key, const char *value, u32 value_size) override;
+
+		// Sources of the programs the binary cache doesn't have, oldest first.
+		std::vector<std::pair<SHADERUID, std::string>> entries;
+	};
+
+	static void StartCompileThreads();
+	static void StopCompileThreads();
+	static void CompileThread(size_t index);
+	static void QueueCompile(PCacheEntry* entry, const char* vcode, const char* pcode, const char* gcode, bool urgent);
+	static SHADER* BindEntry(PCacheEntry* entry);
+
 	static PCache pshaders;
 	static PCacheEntry* last_entry;
 	static SHADERUID last_uid;
+	static ShaderUidInputs last_uid_inputs;
 
 	static UidChecker<PixelShaderUid,PixelShaderCode> pixel_uid_checker;
 	static UidChecker<VertexShaderUid,VertexShaderCode> vertex_uid_checker;
@@ -108,8 +108,8 @@ bool TextureCache::TCacheEntry::Save(const std::string& filename, unsigned int l
 	return SaveTexture(filename, GL_TEXTURE_2D_ARRAY, texture, virtual_width, virtual_height, level);
 }
 
-TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
-	unsigned int height, unsigned int expanded_width,
+TextureCache::TCacheEntryBase* TextureCache::CreateTexture(const u8* buffer,
+	unsigned int width, unsigned int height, unsigned int expanded_width,
 	unsigned int tex_levels, PC_TexFormat pcfmt)
 {
 	int gl_format = 0,
@@ -175,7 +175,7 @@ TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
 	glBindTexture(GL_TEXTURE_2D_ARRAY, entry.texture);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, tex_levels - 1);
 
-	entry.Load(width, height, expanded_width, 0);
+	entry.Load(buffer, width, height, expanded_width, 0);
 
 	// This isn't needed as Load() also reset the stage in the end
 	//TextureCache::SetStage();
@@ -183,7 +183,7 @@ TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
 	return &entry;
 }
 
-void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
+void TextureCache::TCacheEntry::Load(const u8* buffer, unsigned int width, unsigned int height,
 	unsigned int expanded_width, unsigned int level)
 {
 	if (pcfmt != PC_TEX_FMT_DXT1)
@@ -194,7 +194,7 @@ void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
 		if (expanded_width != width)
 			glPixelStorei(GL_UNPACK_ROW_LENGTH, expanded_width);
 
-		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, gl_iformat, width, height, 1, 0, gl_format, gl_type, temp);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, gl_iformat, width, height, 1, 0, gl_format, gl_type, buffer);
 
 		if (expanded_width != width)
 			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
@@ -203,7 +203,7 @@ void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
 	{
 		PanicAlert("PC_TEX_FMT_DXT1 support disabled");
 		//glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
-			//width, height, 0, expanded_width * expanded_height/2, temp);
+			//width, height, 0, expanded_width * expanded_height/2, buffer);
 	}
 	TextureCache::SetStage();
 }
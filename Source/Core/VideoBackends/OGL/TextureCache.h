@@ -39,7 +39,7 @@ private:
 		TCacheEntry();
 		~TCacheEntry();
 
-		void Load(unsigned int width, unsigned int height,
+		void Load(const u8* buffer, unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int level) override;
 
 		void FromRenderTarget(u32 dstAddr, unsigned int dstFormat,
@@ -53,7 +53,7 @@ private:
 
 	~TextureCache();
 
-	TCacheEntryBase* CreateTexture(unsigned int width, unsigned int height,
+	TCacheEntryBase* CreateTexture(const u8* buffer, unsigned int width, unsigned int height,
 		unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt) override;
 
 	TCacheEntryBase* CreateRenderTargetTexture(unsigned int scaled_tex_w, unsigned int scaled_tex_h) override;
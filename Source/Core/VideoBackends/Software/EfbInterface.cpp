@@ -20,6 +20,14 @@ static u8 efb[EFB_WIDTH*EFB_HEIGHT*6];
 namespace EfbInterface
 {
 	u32 perf_values[PQ_NUM_MEMBERS];
+	u32 perf_quad_pixels[PQ_NUM_MEMBERS];
+
+	void IncPerfCounterQuadCount(PerfQueryType type, u32 pixels)
+	{
+		pixels += perf_quad_pixels[type];
+		perf_values[type] += pixels / 3;
+		perf_quad_pixels[type] = pixels % 3;
+	}
 
 	static inline u32 GetColorOffset(u16 x, u16 y)
 	{
@@ -61,16 +61,20 @@ namespace EfbInterface
 	void DoState(PointerWrap &p);
 
 	extern u32 perf_values[PQ_NUM_MEMBERS];
+	// Pixels counted towards the next quad, see below.
+	extern u32 perf_quad_pixels[PQ_NUM_MEMBERS];
 	inline void IncPerfCounterQuadCount(PerfQueryType type)
 	{
 		// NOTE: hardware doesn't process individual pixels but quads instead.
 		// Current software renderer architecture works on pixels though, so
 		// we have this "quad" hack here to only increment the registers on
 		// every fourth rendered pixel
-		static u32 quad[PQ_NUM_MEMBERS];
-		if (++quad[type] != 3)
+		if (++perf_quad_pixels[type] != 3)
 			return;
-		quad[type] = 0;
+		perf_quad_pixels[type] = 0;
 		++perf_values[type];
 	}
+
+	// Same as calling the above for each of the given number of pixels.
+	void IncPerfCounterQuadCount(PerfQueryType type, u32 pixels);
 }
@@ -9,6 +9,7 @@
 #include "VideoBackends/Software/CPMemLoader.h"
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/OpcodeDecoder.h"
+#include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/SWCommandProcessor.h"
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
@@ -70,6 +71,8 @@ static void DecodePrimitiveStream(u32 iBufferSize)
 			iBufferSize -= vertexSize;
 			streamSize--;
 		}
+
+		Rasterizer::Flush();
 	}
 
 	if (streamSize == 0)
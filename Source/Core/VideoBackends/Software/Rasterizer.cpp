@@ -3,8 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/WorkerPool.h"
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/HwRasterizer.h"
@@ -19,6 +22,15 @@
 
 #define BLOCK_SIZE 2
 
+// Triangles are drawn in parallel in horizontal bands of the EFB, one thread
+// per band at a time. Must be a multiple of BLOCK_SIZE.
+#define TILE_HEIGHT 16
+#define NUM_TILES ((EFB_HEIGHT + TILE_HEIGHT - 1) / TILE_HEIGHT)
+
+// Batches covering less than this many pixels aren't worth waking up the
+// other threads for.
+#define MIN_PARALLEL_AREA 4096
+
 #define CLAMP(x, a, b) (x>b)?b:(x<a)?a:x
 
 // returns approximation of log2(f) in s28.4
@@ -34,49 +46,107 @@ static inline s32 FixedLog2(float f)
 
 namespace Rasterizer
 {
+// Everything the pixel loops need to know about a triangle.
+struct Triangle
+{
+	Slope ZSlope;
+	Slope WSlope;
+	Slope ColorSlopes[2][4];
+	Slope TexSlopes[8][3];
+
+	s32 vertex0X;
+	s32 vertex0Y;
+	float vertexOffsetX;
+	float vertexOffsetY;
+
+	// Half-edge functions, in 28.4 fixed point
+	s32 DX12, DX23, DX31;
+	s32 DY12, DY23, DY31;
+	s32 C1, C2, C3;
+
+	// Bounding rectangle, clipped to the scissor
+	s32 minx, maxx, miny, maxy;
+};
+
+// A Tev and the block of pixels it's working on. The GPU thread draws with
+// its own one; when triangles are drawn in parallel, every tile gets one.
+struct DrawContext
+{
+	Tev tev;
+	RasterBlock rasterBlock;
+	Tev::Counters counters;
+
+	// Indices into s_pending of the triangles touching this tile.
+	std::vector<u32> triangles;
+	// The triangle being drawn, and the last ones which got a block built
+	// and a pixel through to the Tev, or -1 if none did.
+	s32 current;
+	s32 lastBuilt;
+	s32 lastDrawn;
+};
+
+// The z plane of the last triangle, kept around for zfreeze.
 static Slope ZSlope;
-static Slope WSlope;
-static Slope ColorSlopes[2][4];
-static Slope TexSlopes[8][3];
-
-static s32 vertex0X;
-static s32 vertex0Y;
-static float vertexOffsetX;
-static float vertexOffsetY;
+static Triangle triangle;
 
 static s32 scissorLeft = 0;
 static s32 scissorTop = 0;
 static s32 scissorRight = 0;
 static s32 scissorBottom = 0;
 
-static Tev tev;
-static RasterBlock rasterBlock;
+static DrawContext s_main;
+static DrawContext s_tiles[NUM_TILES];
+static std::unique_ptr<Common::WorkerPool> s_pool;
+
+// Triangles which are drawn in parallel are collected until Flush().
+static std::vector<Triangle> s_pending;
+static u32 s_pending_area;
+// Whether the current state allows drawing in parallel, checked once per batch.
+static bool s_batch_checked;
+static bool s_batch_parallel;
 
 void DoState(PointerWrap &p)
 {
 	ZSlope.DoState(p);
-	WSlope.DoState(p);
-	for (auto& color_slopes_1d : ColorSlopes)
+	triangle.WSlope.DoState(p);
+	for (auto& color_slopes_1d : triangle.ColorSlopes)
 		for (Slope& color_slope : color_slopes_1d)
 			color_slope.DoState(p);
-	for (auto& tex_slopes_1d : TexSlopes)
+	for (auto& tex_slopes_1d : triangle.TexSlopes)
 		for (Slope& tex_slope : tex_slopes_1d)
 			tex_slope.DoState(p);
-	p.Do(vertex0X);
-	p.Do(vertex0Y);
-	p.Do(vertexOffsetX);
-	p.Do(vertexOffsetY);
+	p.Do(triangle.vertex0X);
+	p.Do(triangle.vertex0Y);
+	p.Do(triangle.vertexOffsetX);
+	p.Do(triangle.vertexOffsetY);
 	p.Do(scissorLeft);
 	p.Do(scissorTop);
 	p.Do(scissorRight);
 	p.Do(scissorBottom);
-	tev.DoState(p);
-	p.Do(rasterBlock);
+	s_main.tev.DoState(p);
+	p.Do(s_main.rasterBlock);
 }
 
 void Init()
 {
-	tev.Init();
+	s_main.tev.Init();
+	for (DrawContext& tile : s_tiles)
+	{
+		tile.tev.Init();
+		tile.tev.counters = &tile.counters;
+	}
+
+	s_pending.clear();
+	s_pending_area = 0;
+	s_batch_checked = false;
+
+	s_pool.reset();
+	if (g_SWVideoConfig.iRasterizerThreads != 1)
+	{
+		s_pool.reset(new Common::WorkerPool(std::max(g_SWVideoConfig.iRasterizerThreads, 0)));
+		if (s_pool->GetNumThreads() == 1)
+			s_pool.reset();
+	}
 
 	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
 	// TODO: This is just a guess!
@@ -84,6 +154,13 @@ void Init()
 	ZSlope.f0 = 1.f;
 }
 
+void Shutdown()
+{
+	s_pool.reset();
+	s_pending.clear();
+	s_pending_area = 0;
+}
+
 static inline int iround(float x)
 {
 	int t = (int)x;
@@ -117,33 +194,42 @@ void SetScissor()
 
 void SetTevReg(int reg, int comp, bool konst, s16 color)
 {
-	tev.SetRegColor(reg, comp, konst, color);
+	// Triangles are only ever pending while drawing, the tiles get a copy of
+	// this Tev's registers when they start.
+	s_main.tev.SetRegColor(reg, comp, konst, color);
 }
 
-inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
+static inline void Draw(const Triangle& tri, DrawContext& ctx, s32 x, s32 y, s32 xi, s32 yi)
 {
-	INCSTAT(swstats.thisFrame.rasterizedPixels);
+	Tev& tev = ctx.tev;
+	if (tev.counters)
+		tev.counters->rasterizedPixels++;
+	else
+		INCSTAT(swstats.thisFrame.rasterizedPixels);
 
-	float dx = vertexOffsetX + (float)(x - vertex0X);
-	float dy = vertexOffsetY + (float)(y - vertex0Y);
+	float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+	float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
 
-	s32 z = (s32)ZSlope.GetValue(dx, dy);
+	s32 z = (s32)tri.ZSlope.GetValue(dx, dy);
 	if (z < 0 || z > 0x00ffffff)
 		return;
 
 	if (!BoundingBox::active && bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
 	{
 		// TODO: Test if perf regs are incremented even if test is disabled
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
+		tev.IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
 		if (bpmem.zmode.testenable)
 		{
 			// early z
 			if (!EfbInterface::ZCompare(x, y, z))
 				return;
 		}
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
+		tev.IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
 	}
 
+	ctx.lastDrawn = ctx.current;
+
+	RasterBlock& rasterBlock = ctx.rasterBlock;
 	RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
 	tev.Position[0] = x;
@@ -155,7 +241,7 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	{
 		for (int comp = 0; comp < 4; comp++)
 		{
-			u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+			u16 color = (u16)tri.ColorSlopes[i][comp].GetValue(dx, dy);
 
 			// clamp color value to 0
 			u16 mask = ~(color >> 8);
@@ -189,14 +275,14 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 
 static void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
 {
-	vertex0X = xi;
-	vertex0Y = yi;
+	triangle.vertex0X = xi;
+	triangle.vertex0Y = yi;
 
 	// adjust a little less than 0.5
 	const float adjust = 0.495f;
 
-	vertexOffsetX = ((float)xi - X1) + adjust;
-	vertexOffsetY = ((float)yi - Y1) + adjust;
+	triangle.vertexOffsetX = ((float)xi - X1) + adjust;
+	triangle.vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 static void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX12, float DY12, float DY31)
@@ -211,7 +297,7 @@ static void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, fl
 	slope->f0 = f1;
 }
 
-static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoord)
+static inline void CalculateLOD(const RasterBlock& rasterBlock, s32* lodp, bool* linear, u32 texmap, u32 texcoord)
 {
 	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
 	u8 subTexmap = texmap & 3;
@@ -224,17 +310,17 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
 	float sDelta, tDelta;
 	if (tm0.diag_lod)
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
 		sDelta = fabsf(uv0[0] - uv1[0]);
 		tDelta = fabsf(uv0[1] - uv1[1]);
 	}
 	else
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-		float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+		const float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
 		sDelta = std::max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
 		tDelta = std::max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -258,18 +344,21 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
 	*lodp = lod;
 }
 
-static void BuildBlock(s32 blockX, s32 blockY)
+static void BuildBlock(const Triangle& tri, DrawContext& ctx, s32 blockX, s32 blockY)
 {
+	RasterBlock& rasterBlock = ctx.rasterBlock;
+	ctx.lastBuilt = ctx.current;
+
 	for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
 	{
 		for (s32 xi = 0; xi < BLOCK_SIZE; xi++)
 		{
 			RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-			float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-			float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+			float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+			float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-			float invW = 1.0f / WSlope.GetValue(dx, dy);
+			float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
 			pixel.InvW = invW;
 
 			// tex coords
@@ -278,13 +367,13 @@ static void BuildBlock(s32 blockX, s32 blockY)
 				float projection = invW;
 				if (xfmem.texMtxInfo[i].projection)
 				{
-					float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+					float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
 					if (q != 0.0f)
 						projection = invW / q;
 				}
 
-				pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-				pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+				pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+				pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
 			}
 		}
 	}
@@ -297,7 +386,7 @@ static void BuildBlock(s32 blockX, s32 blockY)
 		u32 texcoord = indref & 3;
 		indref >>= 3;
 
-		CalculateLOD(&rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
+		CalculateLOD(rasterBlock, &rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
 	}
 
 	for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -309,12 +398,12 @@ static void BuildBlock(s32 blockX, s32 blockY)
 			u32 texmap = order.getTexMap(stageOdd);
 			u32 texcoord = order.getTexCoord(stageOdd);
 
-			CalculateLOD(&rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+			CalculateLOD(rasterBlock, &rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
 		}
 	}
 }
 
-static inline void PrepareBlock(s32 blockX, s32 blockY)
+static inline void PrepareBlock(const Triangle& tri, DrawContext& ctx, s32 blockX, s32 blockY)
 {
 	static s32 x = -1;
 	static s32 y = -1;
@@ -326,10 +415,213 @@ static inline void PrepareBlock(s32 blockX, s32 blockY)
 	{
 		x = blockX;
 		y = blockY;
-		BuildBlock(x, y);
+		BuildBlock(tri, ctx, x, y);
 	}
 }
 
+// Draws the part of the triangle between the rows top and bottom, which have
+// to be multiples of BLOCK_SIZE.
+static void DrawTriangle(const Triangle& tri, DrawContext& ctx, s32 top, s32 bottom)
+{
+	const s32 DX12 = tri.DX12;
+	const s32 DX23 = tri.DX23;
+	const s32 DX31 = tri.DX31;
+
+	const s32 DY12 = tri.DY12;
+	const s32 DY23 = tri.DY23;
+	const s32 DY31 = tri.DY31;
+
+	// Fixed-pos32 deltas
+	const s32 FDX12 = DX12 << 4;
+	const s32 FDX23 = DX23 << 4;
+	const s32 FDX31 = DX31 << 4;
+
+	const s32 FDY12 = DY12 << 4;
+	const s32 FDY23 = DY23 << 4;
+	const s32 FDY31 = DY31 << 4;
+
+	const s32 C1 = tri.C1;
+	const s32 C2 = tri.C2;
+	const s32 C3 = tri.C3;
+
+	// Start in corner of 8x8 block
+	const s32 minx = tri.minx & ~(BLOCK_SIZE - 1);
+	const s32 miny = std::max(tri.miny & ~(BLOCK_SIZE - 1), top);
+	const s32 maxx = tri.maxx;
+	const s32 maxy = std::min(tri.maxy, bottom);
+
+	// Loop through blocks
+	for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+	{
+		for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
+		{
+			// Corners of block
+			s32 x0 = x << 4;
+			s32 x1 = (x + BLOCK_SIZE - 1) << 4;
+			s32 y0 = y << 4;
+			s32 y1 = (y + BLOCK_SIZE - 1) << 4;
+
+			// Evaluate half-space functions
+			bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
+			bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
+			bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
+			bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
+			int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
+
+			bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
+			bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
+			bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
+			bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
+			int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
+
+			bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
+			bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
+			bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
+			bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
+			int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
+
+			// Skip block when outside an edge
+			if (a == 0x0 || b == 0x0 || c == 0x0)
+				continue;
+
+			BuildBlock(tri, ctx, x, y);
+
+			// Accept whole block when totally covered
+			if (a == 0xF && b == 0xF && c == 0xF)
+			{
+				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+				{
+					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+					{
+						Draw(tri, ctx, x + ix, y + iy, ix, iy);
+					}
+				}
+			}
+			else // Partially covered block
+			{
+				s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
+				s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
+				s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
+
+				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+				{
+					s32 CX1 = CY1;
+					s32 CX2 = CY2;
+					s32 CX3 = CY3;
+
+					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+					{
+						if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+						{
+							Draw(tri, ctx, x + ix, y + iy, ix, iy);
+						}
+
+						CX1 -= FDY12;
+						CX2 -= FDY23;
+						CX3 -= FDY31;
+					}
+
+					CY1 += FDX12;
+					CY2 += FDX23;
+					CY3 += FDX31;
+				}
+			}
+		}
+	}
+}
+
+// Draws the pending triangles, every tile of the EFB on its own thread. As
+// the tiles don't share any pixels and each of them draws its triangles in
+// order, the EFB ends up exactly like when drawing them one after the other.
+static void DrawTiles()
+{
+	for (DrawContext& tile : s_tiles)
+		tile.triangles.clear();
+
+	for (u32 i = 0; i < (u32)s_pending.size(); i++)
+	{
+		const Triangle& tri = s_pending[i];
+		s32 first = (tri.miny & ~(BLOCK_SIZE - 1)) / TILE_HEIGHT;
+		s32 last = (tri.maxy - 1) / TILE_HEIGHT;
+		for (s32 t = first; t <= last; t++)
+			s_tiles[t].triangles.push_back(i);
+	}
+
+	for (DrawContext& tile : s_tiles)
+	{
+		if (tile.triangles.empty())
+			continue;
+
+		tile.tev.CopyStateFrom(s_main.tev);
+		tile.rasterBlock = s_main.rasterBlock;
+		tile.counters.Reset();
+		tile.lastBuilt = -1;
+		tile.lastDrawn = -1;
+	}
+
+	s_pool->ParallelFor(NUM_TILES, [](size_t t) {
+		DrawContext& tile = s_tiles[t];
+		for (u32 i : tile.triangles)
+		{
+			tile.current = i;
+			DrawTriangle(s_pending[i], tile, (s32)t * TILE_HEIGHT, (s32)(t + 1) * TILE_HEIGHT);
+		}
+	});
+
+	// Carry on with the state of the tile which drew last. Tiles further down
+	// come later for the same triangle.
+	DrawContext* lastBuilt = nullptr;
+	DrawContext* lastDrawn = nullptr;
+	for (DrawContext& tile : s_tiles)
+	{
+		if (tile.triangles.empty())
+			continue;
+
+		const Tev::Counters& counters = tile.counters;
+		ADDSTAT(swstats.thisFrame.rasterizedPixels, counters.rasterizedPixels);
+		ADDSTAT(swstats.thisFrame.tevPixelsIn, counters.tevPixelsIn);
+		ADDSTAT(swstats.thisFrame.tevPixelsOut, counters.tevPixelsOut);
+		for (int type = 0; type < PQ_NUM_MEMBERS; type++)
+			EfbInterface::IncPerfCounterQuadCount((PerfQueryType)type, counters.perf[type]);
+
+		BoundingBox::coords[BoundingBox::LEFT] = std::min(BoundingBox::coords[BoundingBox::LEFT], counters.bbox[BoundingBox::LEFT]);
+		BoundingBox::coords[BoundingBox::RIGHT] = std::max(BoundingBox::coords[BoundingBox::RIGHT], counters.bbox[BoundingBox::RIGHT]);
+		BoundingBox::coords[BoundingBox::TOP] = std::min(BoundingBox::coords[BoundingBox::TOP], counters.bbox[BoundingBox::TOP]);
+		BoundingBox::coords[BoundingBox::BOTTOM] = std::max(BoundingBox::coords[BoundingBox::BOTTOM], counters.bbox[BoundingBox::BOTTOM]);
+
+		if (tile.lastBuilt >= 0 && (!lastBuilt || tile.lastBuilt >= lastBuilt->lastBuilt))
+			lastBuilt = &tile;
+		if (tile.lastDrawn >= 0 && (!lastDrawn || tile.lastDrawn >= lastDrawn->lastDrawn))
+			lastDrawn = &tile;
+	}
+
+	if (lastBuilt)
+		s_main.rasterBlock = lastBuilt->rasterBlock;
+	if (lastDrawn)
+		s_main.tev.CopyStateFrom(lastDrawn->tev);
+}
+
+void Flush()
+{
+	s_batch_checked = false;
+
+	if (s_pending.empty())
+		return;
+
+	if (s_pending_area >= MIN_PARALLEL_AREA)
+	{
+		DrawTiles();
+	}
+	else
+	{
+		for (const Triangle& tri : s_pending)
+			DrawTriangle(tri, s_main, 0, EFB_HEIGHT);
+	}
+
+	s_pending.clear();
+	s_pending_area = 0;
+}
+
 void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
 {
 	INCSTAT(swstats.thisFrame.numTrianglesDrawn);
@@ -396,7 +688,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
 
 	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
-	InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	InitSlope(&triangle.WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
 	// TODO: The zfreeze emulation is not quite correct, yet!
 	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
@@ -404,17 +696,18 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
 	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
 		InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	triangle.ZSlope = ZSlope;
 
 	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
 	{
 		for (int comp = 0; comp < 4; comp++)
-			InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&triangle.ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
 	{
 		for (int comp = 0; comp < 3; comp++)
-			InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&triangle.TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	// Half-edge constants
@@ -430,87 +723,34 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	// If drawing, rasterize every block
 	if (!BoundingBox::active)
 	{
-		// Start in corner of 8x8 block
-		minx &= ~(BLOCK_SIZE - 1);
-		miny &= ~(BLOCK_SIZE - 1);
-
-		// Loop through blocks
-		for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+		triangle.DX12 = DX12;
+		triangle.DX23 = DX23;
+		triangle.DX31 = DX31;
+		triangle.DY12 = DY12;
+		triangle.DY23 = DY23;
+		triangle.DY31 = DY31;
+		triangle.C1 = C1;
+		triangle.C2 = C2;
+		triangle.C3 = C3;
+		triangle.minx = minx;
+		triangle.maxx = maxx;
+		triangle.miny = miny;
+		triangle.maxy = maxy;
+
+		if (s_pool && !s_batch_checked)
 		{
-			for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
-			{
-				// Corners of block
-				s32 x0 = x << 4;
-				s32 x1 = (x + BLOCK_SIZE - 1) << 4;
-				s32 y0 = y << 4;
-				s32 y1 = (y + BLOCK_SIZE - 1) << 4;
-
-				// Evaluate half-space functions
-				bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
-				bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
-				bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
-				bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
-				int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
-
-				bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
-				bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
-				bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
-				bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
-				int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
-
-				bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
-				bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
-				bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
-				bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
-				int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
-
-				// Skip block when outside an edge
-				if (a == 0x0 || b == 0x0 || c == 0x0)
-					continue;
-
-				BuildBlock(x, y);
-
-				// Accept whole block when totally covered
-				if (a == 0xF && b == 0xF && c == 0xF)
-				{
-					for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-					{
-						for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-						{
-							Draw(x + ix, y + iy, ix, iy);
-						}
-					}
-				}
-				else // Partially covered block
-				{
-					s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
-					s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
-					s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
-
-					for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-					{
-						s32 CX1 = CY1;
-						s32 CX2 = CY2;
-						s32 CX3 = CY3;
-
-						for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-						{
-							if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-							{
-								Draw(x + ix, y + iy, ix, iy);
-							}
-
-							CX1 -= FDY12;
-							CX2 -= FDY23;
-							CX3 -= FDY31;
-						}
+			s_batch_parallel = Tev::PixelsAreIndependent();
+			s_batch_checked = true;
+		}
 
-						CY1 += FDX12;
-						CY2 += FDX23;
-						CY3 += FDX31;
-					}
-				}
-			}
+		if (s_pool && s_batch_parallel)
+		{
+			s_pending.push_back(triangle);
+			s_pending_area += (maxx - minx) * (maxy - miny);
+		}
+		else
+		{
+			DrawTriangle(triangle, s_main, 0, EFB_HEIGHT);
 		}
 	}
 	else
@@ -564,8 +804,8 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 				if (CX1 > 0 && CX2 > 0 && CX3 > 0)
 				{
 					// Build the new raster block every other pixel
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+					PrepareBlock(triangle, s_main, x, y);
+					Draw(triangle, s_main, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
 
 					if (y >= BoundingBox::coords[BoundingBox::TOP])
 						break;
@@ -604,8 +844,8 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 			{
 				if (CY1 > 0 && CY2 > 0 && CY3 > 0)
 				{
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+					PrepareBlock(triangle, s_main, x, y);
+					Draw(triangle, s_main, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
 
 					if (x >= BoundingBox::coords[BoundingBox::LEFT])
 						break;
@@ -644,8 +884,8 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 				if (CX1 > 0 && CX2 > 0 && CX3 > 0)
 				{
 					// Build the new raster block every other pixel
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+					PrepareBlock(triangle, s_main, x, y);
+					Draw(triangle, s_main, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
 
 					if (y <= BoundingBox::coords[BoundingBox::BOTTOM])
 						break;
@@ -685,8 +925,8 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 				if (CY1 > 0 && CY2 > 0 && CY3 > 0)
 				{
 					// Build the new raster block every other pixel
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+					PrepareBlock(triangle, s_main, x, y);
+					Draw(triangle, s_main, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
 
 					if (x <= BoundingBox::coords[BoundingBox::RIGHT])
 						break;
@@ -25,6 +25,8 @@ SWVideoConfig::SWVideoConfig()
 	bZComploc = true;
 	bZFreeze = true;
 
+	iRasterizerThreads = 0;
+
 	bDumpTevStages = false;
 	bDumpTevTextureFetches = false;
 
@@ -46,6 +48,7 @@ void SWVideoConfig::Load(const char* ini_file)
 	rendering->Get("BypassXFB", &bBypassXFB, false);
 	rendering->Get("ZComploc", &bZComploc, true);
 	rendering->Get("ZFreeze", &bZFreeze, true);
+	rendering->Get("RasterizerThreads", &iRasterizerThreads, 0);
 
 	IniFile::Section* info = iniFile.GetOrCreateSection("Info");
 	info->Get("ShowStats", &bShowStats, false);
@@ -75,6 +78,7 @@ void SWVideoConfig::Save(const char* ini_file)
 	rendering->Set("BypassXFB", bBypassXFB);
 	rendering->Set("ZComploc", bZComploc);
 	rendering->Set("ZFreeze", bZFreeze);
+	rendering->Set("RasterizerThreads", iRasterizerThreads);
 
 	IniFile::Section* info = iniFile.GetOrCreateSection("Info");
 	info->Set("ShowStats", bShowStats);
@@ -27,6 +27,9 @@ struct SWVideoConfig : NonCopyable
 	bool bZComploc;
 	bool bZFreeze;
 
+	// Threads drawing triangles, counting the GPU thread. 0 picks one per core.
+	int iRasterizerThreads;
+
 	bool bShowStats;
 
 	bool bDumpTextures;
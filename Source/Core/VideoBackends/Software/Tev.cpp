@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cmath>
+#include <cstring>
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
@@ -21,8 +22,23 @@
 #define ALLOW_TEV_DUMPS 0
 #endif
 
+void Tev::Counters::Reset()
+{
+	rasterizedPixels = 0;
+	tevPixelsIn = 0;
+	tevPixelsOut = 0;
+	for (u32& value : perf)
+		value = 0;
+	bbox[BoundingBox::LEFT] = 0xffff;
+	bbox[BoundingBox::RIGHT] = 0;
+	bbox[BoundingBox::TOP] = 0xffff;
+	bbox[BoundingBox::BOTTOM] = 0;
+}
+
 void Tev::Init()
 {
+	counters = nullptr;
+
 	FixedConstants[0] = 0;
 	FixedConstants[1] = 32;
 	FixedConstants[2] = 64;
@@ -509,7 +525,10 @@ void Tev::Draw()
 	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
 	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
 
-	INCSTAT(swstats.thisFrame.tevPixelsIn);
+	if (counters)
+		counters->tevPixelsIn++;
+	else
+		INCSTAT(swstats.thisFrame.tevPixelsIn);
 
 	for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
 	{
@@ -762,20 +781,21 @@ void Tev::Draw()
 		if (late_ztest && bpmem.zmode.testenable)
 		{
 			// TODO: Check against hw if these values get incremented even if depth testing is disabled
-			EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
+			IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
 
 			if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
 				return;
 
-			EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
+			IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
 		}
 	}
 
 	// branchless bounding box update
-	BoundingBox::coords[BoundingBox::LEFT] = std::min((u16)Position[0], BoundingBox::coords[BoundingBox::LEFT]);
-	BoundingBox::coords[BoundingBox::RIGHT] = std::max((u16)Position[0], BoundingBox::coords[BoundingBox::RIGHT]);
-	BoundingBox::coords[BoundingBox::TOP] = std::min((u16)Position[1], BoundingBox::coords[BoundingBox::TOP]);
-	BoundingBox::coords[BoundingBox::BOTTOM] = std::max((u16)Position[1], BoundingBox::coords[BoundingBox::BOTTOM]);
+	u16* bbox = counters ? counters->bbox : BoundingBox::coords;
+	bbox[BoundingBox::LEFT] = std::min((u16)Position[0], bbox[BoundingBox::LEFT]);
+	bbox[BoundingBox::RIGHT] = std::max((u16)Position[0], bbox[BoundingBox::RIGHT]);
+	bbox[BoundingBox::TOP] = std::min((u16)Position[1], bbox[BoundingBox::TOP]);
+	bbox[BoundingBox::BOTTOM] = std::max((u16)Position[1], bbox[BoundingBox::BOTTOM]);
 
 	// if we are only calculating the bounding box,
 	// there's no need to actually draw anything
@@ -803,8 +823,11 @@ void Tev::Draw()
 	}
 #endif
 
-	INCSTAT(swstats.thisFrame.tevPixelsOut);
-	EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
+	if (counters)
+		counters->tevPixelsOut++;
+	else
+		INCSTAT(swstats.thisFrame.tevPixelsOut);
+	IncPerfCounterQuadCount(PQ_BLEND_INPUT);
 
 	EfbInterface::BlendTev(Position[0], Position[1], output);
 }
@@ -821,6 +844,102 @@ void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 	}
 }
 
+void Tev::CopyStateFrom(const Tev& other)
+{
+	memcpy(Reg, other.Reg, sizeof(Reg));
+	memcpy(KonstantColors, other.KonstantColors, sizeof(KonstantColors));
+	memcpy(TexColor, other.TexColor, sizeof(TexColor));
+	memcpy(RasColor, other.RasColor, sizeof(RasColor));
+	memcpy(StageKonst, other.StageKonst, sizeof(StageKonst));
+	AlphaBump = other.AlphaBump;
+	memcpy(IndirectTex, other.IndirectTex, sizeof(IndirectTex));
+	TexCoord = other.TexCoord;
+
+	memcpy(Position, other.Position, sizeof(Position));
+	memcpy(Color, other.Color, sizeof(Color));
+	memcpy(Uv, other.Uv, sizeof(Uv));
+	memcpy(IndirectLod, other.IndirectLod, sizeof(IndirectLod));
+	memcpy(IndirectLinear, other.IndirectLinear, sizeof(IndirectLinear));
+	memcpy(TextureLod, other.TextureLod, sizeof(TextureLod));
+	memcpy(TextureLinear, other.TextureLinear, sizeof(TextureLinear));
+}
+
+bool Tev::PixelsAreIndependent()
+{
+	if (g_SWVideoConfig.bDumpTevStages || g_SWVideoConfig.bDumpTevTextureFetches)
+		return false;
+
+	// Pieces of state which Draw() keeps between pixels: the rgb and the alpha
+	// parts of the four registers, the texture color and the texture coordinate.
+	enum
+	{
+		REG_RGB = 1 << 0,
+		REG_ALPHA = 1 << 4,
+		TEX_RGB = 1 << 8,
+		TEX_ALPHA = 1 << 9,
+		TEX_COORD = 1 << 10,
+	};
+
+	// Every step a stage takes, in the order Draw() takes them.
+	struct Access
+	{
+		u32 reads;
+		u32 writes;
+	};
+	Access accesses[16 * 3 + 1];
+	int num_accesses = 0;
+
+	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+	{
+		const TevStageIndirect& indirect = bpmem.tevind[stageNum];
+		const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+		const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
+
+		// Indirect() leaves the coordinate alone for this matrix selection.
+		if (!((indirect.mid & 3) && (indirect.mid & 12) == 12))
+			accesses[num_accesses++] = { indirect.fb_addprev ? (u32)TEX_COORD : 0, TEX_COORD };
+
+		if (bpmem.tevorders[stageNum >> 1].getEnable(stageNum & 1))
+			accesses[num_accesses++] = { TEX_COORD, TEX_RGB | TEX_ALPHA };
+
+		u32 reads = 0;
+		for (u32 input : { cc.a, cc.b, cc.c, cc.d })
+		{
+			if (input < 8)
+				reads |= (input & 1 ? REG_ALPHA : REG_RGB) << (input >> 1);
+			else if (input == 8)
+				reads |= TEX_RGB;
+			else if (input == 9)
+				reads |= TEX_ALPHA;
+		}
+		for (u32 input : { ac.a, ac.b, ac.c, ac.d })
+		{
+			if (input < 4)
+				reads |= REG_ALPHA << input;
+			else if (input == 4)
+				reads |= TEX_ALPHA;
+		}
+		accesses[num_accesses++] = { reads, (REG_RGB << cc.dest) | (REG_ALPHA << ac.dest) };
+	}
+
+	if (bpmem.ztex2.op)
+		accesses[num_accesses++] = { TEX_RGB | TEX_ALPHA, 0 };
+
+	// State that no stage writes holds the same value for every pixel.
+	u32 written_by_any = 0;
+	for (int i = 0; i < num_accesses; i++)
+		written_by_any |= accesses[i].writes;
+
+	u32 written = 0;
+	for (int i = 0; i < num_accesses; i++)
+	{
+		if (accesses[i].reads & written_by_any & ~written)
+			return false;
+		written |= accesses[i].writes;
+	}
+	return true;
+}
+
 void Tev::DoState(PointerWrap &p)
 {
 	p.DoArray(Reg, sizeof(Reg));
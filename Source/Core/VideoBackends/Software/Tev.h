@@ -5,6 +5,7 @@
 #pragma once
 
 #include "VideoBackends/Software/BPMemLoader.h"
+#include "VideoBackends/Software/EfbInterface.h"
 
 class PointerWrap;
 
@@ -85,11 +86,46 @@ public:
 		RED_C
 	};
 
+	// What drawing a pixel adds to the statistics, the performance counters
+	// and the bounding box. A Tev which draws alongside other ones collects
+	// them here instead of updating the global ones, see Rasterizer::Flush.
+	struct Counters
+	{
+		u32 rasterizedPixels;
+		u32 tevPixelsIn;
+		u32 tevPixelsOut;
+		u32 perf[PQ_NUM_MEMBERS];
+		u16 bbox[4];
+
+		void Reset();
+	};
+
+	// nullptr to update the global ones directly.
+	Counters* counters;
+
 	void Init();
 
 	void Draw();
 
 	void SetRegColor(int reg, int comp, bool konst, s16 color);
 
+	// Copies the registers and the inputs of the last pixel, leaving the
+	// lookup tables, which point into this Tev, alone.
+	void CopyStateFrom(const Tev& other);
+
+	// Whether the current TEV configuration gives every pixel the same result
+	// no matter which pixels were drawn before it. Some configurations read
+	// a register before the pixel writes it, and see what the previous pixel
+	// left there; these have to be drawn in order.
+	static bool PixelsAreIndependent();
+
+	void IncPerfCounterQuadCount(PerfQueryType type)
+	{
+		if (counters)
+			counters->perf[type]++;
+		else
+			EfbInterface::IncPerfCounterQuadCount(type);
+	}
+
 	void DoState(PointerWrap &p);
 };
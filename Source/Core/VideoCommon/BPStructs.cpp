@@ -19,6 +19,7 @@
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/RenderBase.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VertexShaderManager.h"
@@ -84,6 +85,7 @@ static void BPWritten(const BPCmd& bp)
 	FlushPipeline();
 
 	((u32*)&bpmem)[bp.address] = bp.newvalue;
+	InvalidateShaderUids();
 
 	switch (bp.address)
 	{
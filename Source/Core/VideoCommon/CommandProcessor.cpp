@@ -375,6 +375,7 @@ void UpdateInterrupts(u64 userdata)
 	}
 	CoreTiming::ForceExceptionCheck(0);
 	interruptWaiting = false;
+	WakeGpuThread();
 }
 
 void UpdateInterruptsFromVideoBackend(u64 userdata)
@@ -474,6 +475,7 @@ void ProcessFifoAllDistance()
 {
 	if (IsOnThread())
 	{
+		WakeGpuThread();
 		while (!interruptWaiting && fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint())
 			Common::YieldCPU();
 	}
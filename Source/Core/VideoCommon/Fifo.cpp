@@ -2,12 +2,19 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+
 #include "Common/Atomic.h"
 #include "Common/ChunkFile.h"
 #include "Common/CPUDetect.h"
+#include "Common/Event.h"
 #include "Common/FPURoundMode.h"
 #include "Common/MemoryUtil.h"
 #include "Common/Thread.h"
+#include "Common/Timer.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
@@ -24,12 +31,32 @@
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VideoConfig.h"
 
+// Upper bound on how much RunGpuLoop decodes between checks for async requests.
+static const u32 FIFO_BATCH_SIZE = 64 * 1024;
+
 bool g_bSkipCurrentFrame = false;
 
 static volatile bool GpuRunningState = false;
 static volatile bool EmuRunningState = false;
 static std::mutex m_csHWVidOccupied;
 
+// When the GPU thread runs out of work it polls for a while, then sleeps on
+// s_gpu_work_event until the CPU thread queues enough data or makes a request.
+// The polling budget adapts between 0 and iGPUSpinIterations depending on
+// whether polling found work last time.
+static Common::Event s_gpu_work_event;
+static std::atomic<bool> s_gpu_sleeping;
+static int s_gpu_spin_limit;
+
+struct GpuIdleStats
+{
+	u64 spin_us;
+	u64 sleep_us;
+	u64 spin_wakeups;
+	u64 sleep_wakeups;
+};
+static GpuIdleStats s_gpu_idle_stats;
+
 // Most of this array is unlikely to be faulted in...
 static u8 s_fifo_aux_data[FIFO_SIZE];
 static u8* s_fifo_aux_write_ptr;
@@ -140,17 +167,25 @@ void ExitGpuLoop()
 	// Terminate GPU thread loop
 	GpuRunningState = false;
 	EmuRunningState = true;
+	s_gpu_work_event.Set();
 }
 
 void EmulatorState(bool running)
 {
 	EmuRunningState = running;
+	s_gpu_work_event.Set();
+}
+
+void WakeGpuThread()
+{
+	s_gpu_work_event.Set();
 }
 
 void SyncGPU(SyncGPUReason reason, bool may_move_read_ptr)
 {
 	if (g_use_deterministic_gpu_thread && GpuRunningState)
 	{
+		WakeGpuThread();
 		std::unique_lock<std::mutex> lk(s_video_buffer_lock);
 		u8* write_ptr = s_video_buffer_write_ptr;
 		s_video_buffer_cond.wait(lk, [&]() {
@@ -209,9 +244,8 @@ void* PopFifoAuxBuffer(size_t size)
 }
 
 // Description: RunGpuLoop() sends data through this function.
-static void ReadDataFromFifo(u32 readPtr)
+static void ReadDataFromFifo(u32 readPtr, size_t len = 32)
 {
-	size_t len = 32;
 	if (len > (size_t)(s_video_buffer + FIFO_SIZE - s_video_buffer_write_ptr))
 	{
 		size_t existing_len = s_video_buffer_write_ptr - s_video_buffer_read_ptr;
@@ -258,6 +292,78 @@ static void ReadDataFromFifoOnCPU(u32 readPtr)
 	s_video_buffer_write_ptr = write_ptr + len;
 }
 
+u32 GetFifoBatchSize(const SCPFifoStruct& fifo)
+{
+	u32 readPtr = fifo.CPReadPointer;
+	u32 distance = Common::AtomicLoad(fifo.CPReadWriteDistance);
+	u32 len = std::min<u32>(distance, fifo.CPEnd - readPtr + 32);
+
+	if (fifo.bFF_BPEnable && fifo.CPBreakpoint > readPtr && fifo.CPBreakpoint - readPtr < len)
+		len = fifo.CPBreakpoint - readPtr;
+
+	// SetCPStatusFromGPU only runs between batches, so end them on the block
+	// where reading 32 bytes at a time would have seen the distance drop to
+	// the high watermark or below the low one.
+	if (distance > fifo.CPHiWatermark)
+		len = std::min<u32>(len, (distance - fifo.CPHiWatermark + 31) & ~31);
+	if (distance >= fifo.CPLoWatermark)
+		len = std::min<u32>(len, (distance - fifo.CPLoWatermark + 32) & ~31);
+
+	// Keep batches small enough that async requests from the CPU thread
+	// (EFB access, swaps) don't wait on a huge decode.
+	len = std::min<u32>(len, FIFO_BATCH_SIZE);
+
+	// The CPU only ever writes whole 32 byte blocks.
+	return std::max<u32>(len & ~31, 32);
+}
+
+// Whether RunGpuLoop has anything to do right now, either data to decode or an
+// emulation state change to react to.
+static bool GpuHasWork()
+{
+	if (!GpuRunningState || !EmuRunningState)
+		return true;
+
+	if (g_use_deterministic_gpu_thread)
+		return s_video_buffer_write_ptr.load() > s_video_buffer_seen_ptr.load();
+
+	SCPFifoStruct &fifo = CommandProcessor::fifo;
+	return !CommandProcessor::interruptWaiting && fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint();
+}
+
+static void WaitForGpuWork()
+{
+	const int max_spin = SConfig::GetInstance().m_LocalCoreStartupParameter.iGPUSpinIterations;
+	u64 start = Common::Timer::GetTimeUs();
+
+	for (int i = 0; i < s_gpu_spin_limit; ++i)
+	{
+		Common::YieldCPU();
+		if (GpuHasWork())
+		{
+			s_gpu_idle_stats.spin_us += Common::Timer::GetTimeUs() - start;
+			s_gpu_idle_stats.spin_wakeups++;
+			s_gpu_spin_limit = std::min(max_spin, s_gpu_spin_limit + s_gpu_spin_limit / 2 + 1);
+			return;
+		}
+	}
+
+	u64 sleep_start = Common::Timer::GetTimeUs();
+	s_gpu_idle_stats.spin_us += sleep_start - start;
+
+	// The CPU thread publishes its work before checking s_gpu_sleeping, and
+	// we set s_gpu_sleeping before checking for work, so one of the two
+	// always notices the other. The timeout keeps PeekMessages running.
+	s_gpu_sleeping.store(true);
+	if (!GpuHasWork())
+		s_gpu_work_event.WaitFor(std::chrono::milliseconds(1));
+	s_gpu_sleeping.store(false);
+
+	s_gpu_idle_stats.sleep_us += Common::Timer::GetTimeUs() - sleep_start;
+	s_gpu_idle_stats.sleep_wakeups++;
+	s_gpu_spin_limit /= 2;
+}
+
 void ResetVideoBuffer()
 {
 	s_video_buffer_read_ptr = s_video_buffer;
@@ -278,9 +384,8 @@ void RunGpuLoop()
 	SCPFifoStruct &fifo = CommandProcessor::fifo;
 	u32 cyclesExecuted = 0;
 
-	// If the host CPU has only two cores, idle loop instead of busy loop
-	// This allows a system that we are maxing out in dual core mode to do other things
-	bool yield_cpu = cpu_info.num_cores <= 2;
+	s_gpu_spin_limit = SConfig::GetInstance().m_LocalCoreStartupParameter.iGPUSpinIterations;
+	s_gpu_idle_stats = {};
 
 	while (GpuRunningState)
 	{
@@ -316,18 +421,23 @@ void RunGpuLoop()
 				fifo.isGpuReadingData = true;
 				CommandProcessor::isPossibleWaitingSetDrawDone = fifo.bFF_GPLinkEnable ? true : false;
 
-				if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bSyncGPU || Common::AtomicLoad(CommandProcessor::VITicks) > CommandProcessor::m_cpClockOrigin)
+				bool sync_gpu = SConfig::GetInstance().m_LocalCoreStartupParameter.bSyncGPU;
+				if (!sync_gpu || Common::AtomicLoad(CommandProcessor::VITicks) > CommandProcessor::m_cpClockOrigin)
 				{
+					// With SyncGPU, the cycle budget in VITicks is checked before every
+					// 32 byte block, so don't batch there.
+					u32 len = sync_gpu ? 32 : GetFifoBatchSize(fifo);
 					u32 readPtr = fifo.CPReadPointer;
-					ReadDataFromFifo(readPtr);
+					ReadDataFromFifo(readPtr, len);
 
+					readPtr += len - 32;
 					if (readPtr == fifo.CPEnd)
 						readPtr = fifo.CPBase;
 					else
 						readPtr += 32;
 
-					_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0 ,
-						"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce instability in the game. Please report it.", fifo.CPReadWriteDistance - 32);
+					_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - (s32)len >= 0 ,
+						"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce instability in the game. Please report it.", fifo.CPReadWriteDistance - len);
 
 
 					u8* write_ptr = s_video_buffer_write_ptr;
@@ -338,7 +448,7 @@ void RunGpuLoop()
 						Common::AtomicAdd(CommandProcessor::VITicks, -(s32)cyclesExecuted);
 
 					Common::AtomicStore(fifo.CPReadPointer, readPtr);
-					Common::AtomicAdd(fifo.CPReadWriteDistance, -32);
+					Common::AtomicAdd(fifo.CPReadWriteDistance, -(s32)len);
 					if ((write_ptr - s_video_buffer_read_ptr) == 0)
 						Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
 				}
@@ -357,11 +467,8 @@ void RunGpuLoop()
 
 		if (EmuRunningState)
 		{
-			// NOTE(jsd): Calling SwitchToThread() on Windows 7 x64 is a hot spot, according to profiler.
-			// See https://docs.google.com/spreadsheet/ccc?key=0Ah4nh0yGtjrgdFpDeF9pS3V6RUotRVE3S3J4TGM1NlE#gid=0
-			// for benchmark details.
-			if (yield_cpu)
-				Common::YieldCPU();
+			if (!GpuHasWork())
+				WaitForGpuWork();
 		}
 		else
 		{
@@ -370,13 +477,17 @@ void RunGpuLoop()
 			{
 				g_video_backend->PeekMessages();
 				m_csHWVidOccupied.unlock();
-				Common::SleepCurrentThread(1);
+				s_gpu_work_event.WaitFor(std::chrono::milliseconds(1));
 				m_csHWVidOccupied.lock();
 			}
 		}
 	}
 	// wake up SyncGPU if we were interrupted
 	s_video_buffer_cond.notify_all();
+
+	INFO_LOG(VIDEO, "GPU thread idle: spun %" PRIu64 " us (%" PRIu64 " wakeups), slept %" PRIu64 " us (%" PRIu64 " wakeups)",
+		s_gpu_idle_stats.spin_us, s_gpu_idle_stats.spin_wakeups,
+		s_gpu_idle_stats.sleep_us, s_gpu_idle_stats.sleep_wakeups);
 }
 
 
@@ -388,11 +499,17 @@ bool AtBreakpoint()
 
 void RunGpu()
 {
-	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread &&
-	    !g_use_deterministic_gpu_thread)
-		return;
-
+	const SCoreStartupParameter& param = SConfig::GetInstance().m_LocalCoreStartupParameter;
 	SCPFifoStruct &fifo = CommandProcessor::fifo;
+
+	if (param.bCPUThread && !g_use_deterministic_gpu_thread)
+	{
+		// Pairs with the s_gpu_sleeping store in WaitForGpuWork.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (s_gpu_sleeping.load(std::memory_order_relaxed) && fifo.CPReadWriteDistance >= (u32)param.iGPUWakeupThreshold)
+			s_gpu_work_event.Set();
+		return;
+	}
 	while (fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint() )
 	{
 		if (g_use_deterministic_gpu_thread)
@@ -418,6 +535,13 @@ void RunGpu()
 		fifo.CPReadWriteDistance -= 32;
 	}
 	CommandProcessor::SetCPStatusFromGPU();
+
+	if (g_use_deterministic_gpu_thread)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (s_gpu_sleeping.load(std::memory_order_relaxed))
+			s_gpu_work_event.Set();
+	}
 }
 
 void Fifo_UpdateWantDeterminism(bool want)
@@ -50,7 +50,13 @@ void RunGpu();
 void RunGpuLoop();
 void ExitGpuLoop();
 void EmulatorState(bool running);
+// Wakes the GPU thread if it is idle, e.g. because an async request is pending.
+void WakeGpuThread();
 bool AtBreakpoint();
+// How many bytes RunGpuLoop reads from the CP FIFO in one batch: everything
+// the CPU has written, up to the wraparound point, the breakpoint or the
+// next watermark crossing, whichever comes first.
+u32 GetFifoBatchSize(const SCPFifoStruct& fifo);
 void ResetVideoBuffer();
 void Fifo_SetRendering(bool bEnabled);
 
@@ -1,4 +1,6 @@
 
+#include "Core/HW/Memmap.h"
+
 #include "VideoCommon/FramebufferManagerBase.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/VideoConfig.h"
@@ -114,7 +116,10 @@ const XFBSourceBase* const* FramebufferManagerBase::GetVirtualXFBSource(u32 xfbA
 void FramebufferManagerBase::CopyToXFB(u32 xfbAddr, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc,float Gamma)
 {
 	if (g_ActiveConfig.bUseRealXFB)
+	{
 		g_framebuffer_manager->CopyToRealXFB(xfbAddr, fbWidth, fbHeight, sourceRc,Gamma);
+		Memory::MarkWritten(xfbAddr, fbWidth * fbHeight * 2);
+	}
 	else
 		CopyToVirtualXFB(xfbAddr, fbWidth, fbHeight, sourceRc,Gamma);
 }
@@ -313,6 +313,7 @@ static inline void EndPrimitive(T& out, API_TYPE ApiType)
 void GetGeometryShaderUid(GeometryShaderUid& object, u32 primitive_type, API_TYPE ApiType)
 {
 	GenerateGeometryShader<GeometryShaderUid>(object, primitive_type, ApiType);
+	object.CalculateHash();
 }
 
 void GenerateGeometryShaderCode(ShaderCode& object, u32 primitive_type, API_TYPE ApiType)
@@ -3,8 +3,15 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <SOIL/SOIL.h>
 
@@ -12,17 +19,248 @@
 #include "Common/FileSearch.h"
 #include "Common/FileUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 
 #include "VideoCommon/HiresTextures.h"
+#include "VideoCommon/VideoConfig.h"
 
 namespace HiresTextures
 {
 
+// Custom textures are decoded to RGBA8 once and kept in an LRU cache, so
+// textures which get evicted from the texture cache and come back later
+// don't go through SOIL again. With bCacheHiresTextures, a background thread
+// decodes the whole pack into that cache right after Init.
+//
+// With bHiresTexturesDiskCache, decoded texels are also written to the cache
+// directory, keyed by the size and modification time of the source file, so
+// that later launches can skip reading and decoding the PNG.
+
+struct DecodedTexture
+{
+	std::vector<u8> data;
+	unsigned int width;
+	unsigned int height;
+};
+
+struct CacheEntry
+{
+	std::shared_ptr<DecodedTexture> texture;
+	std::list<std::string>::iterator lru_position;
+};
+
+struct DiskCacheHeader
+{
+	u32 magic;
+	u32 version;
+	u64 source_size;
+	u64 source_mtime;
+	u32 width;
+	u32 height;
+};
+
+enum
+{
+	DISK_CACHE_MAGIC = 0x58544844, // "DHTX"
+	DISK_CACHE_VERSION = 2,
+};
+
 static std::map<std::string, std::string> textureMap;
+static std::string s_disk_cache_dir;
+static bool s_use_disk_cache;
 
-void Init(const std::string& gameCode)
+// Everything below is shared with the loader thread and guarded by s_mutex.
+static std::mutex s_mutex;
+// Signalled when the loader thread finishes a texture or has new work.
+static std::condition_variable s_cond;
+
+// Most recently used first.
+static std::list<std::string> s_lru;
+static std::unordered_map<std::string, CacheEntry> s_cache;
+static size_t s_cache_size;
+static size_t s_cache_budget;
+
+static std::thread s_loader_thread;
+static std::deque<std::string> s_load_queue;
+// The texture the loader thread is decoding right now, if any.
+static std::string s_loading;
+static bool s_loader_quit;
+
+static std::shared_ptr<DecodedTexture> LoadFromDiskCache(const std::string& cache_path, u64 source_size, u64 source_mtime)
+{
+	File::IOFile file(cache_path, "rb");
+	DiskCacheHeader header;
+	if (!file.ReadBytes(&header, sizeof(header)) || header.magic != DISK_CACHE_MAGIC ||
+	    header.version != DISK_CACHE_VERSION || header.source_size != source_size ||
+	    header.source_mtime != source_mtime)
+	{
+		return nullptr;
+	}
+
+	size_t size = (size_t)header.width * header.height * 4;
+	if (file.GetSize() != sizeof(header) + size)
+		return nullptr;
+
+	std::shared_ptr<DecodedTexture> texture = std::make_shared<DecodedTexture>();
+	texture->width = header.width;
+	texture->height = header.height;
+	texture->data.resize(size);
+	if (!file.ReadBytes(texture->data.data(), size))
+		return nullptr;
+
+	return texture;
+}
+
+static void WriteToDiskCache(const std::string& cache_path, u64 source_size, u64 source_mtime, const DecodedTexture& texture)
 {
+	if (!File::CreateFullPath(cache_path))
+		return;
+
+	// Write to a temporary file first so that a crash can't leave a truncated
+	// file around, and another instance never sees a half written one.
+	std::string temp_path = File::GetTempFilenameForAtomicWrite(cache_path);
+	{
+		File::IOFile file(temp_path, "wb");
+		DiskCacheHeader header = { DISK_CACHE_MAGIC, DISK_CACHE_VERSION, source_size, source_mtime, texture.width, texture.height };
+		if (!file.WriteBytes(&header, sizeof(header)) || !file.WriteBytes(texture.data.data(), texture.data.size()))
+		{
+			file.Close();
+			File::Delete(temp_path);
+			return;
+		}
+	}
+	File::RenameSync(temp_path, cache_path);
+}
+
+// Decodes a texture from the pack, or reads it from the disk cache. Doesn't
+// touch any shared state, so it's safe to call from any thread.
+static std::shared_ptr<DecodedTexture> LoadTexture(const std::string& name, const std::string& path)
+{
+	const std::string cache_path = s_disk_cache_dir + name + ".bin";
+	u64 source_size = 0;
+	u64 source_mtime = 0;
+	if (s_use_disk_cache)
+	{
+		source_size = File::GetSize(path);
+		source_mtime = File::GetModificationTime(path);
+		std::shared_ptr<DecodedTexture> texture = LoadFromDiskCache(cache_path, source_size, source_mtime);
+		if (texture)
+			return texture;
+	}
+
+	File::IOFile file(path, "rb");
+	std::vector<u8> buffer(file.GetSize());
+	if (!file.ReadBytes(buffer.data(), buffer.size()))
+	{
+		ERROR_LOG(VIDEO, "Custom texture %s failed to load", path.c_str());
+		return nullptr;
+	}
+
+	int width;
+	int height;
+	int channels;
+	u8* temp = SOIL_load_image_from_memory(buffer.data(), (int)buffer.size(), &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (temp == nullptr)
+	{
+		ERROR_LOG(VIDEO, "Custom texture %s failed to load", path.c_str());
+		return nullptr;
+	}
+
+	std::shared_ptr<DecodedTexture> texture = std::make_shared<DecodedTexture>();
+	texture->width = width;
+	texture->height = height;
+	texture->data.assign(temp, temp + width * height * 4);
+	SOIL_free_image_data(temp);
+
+	if (s_use_disk_cache)
+		WriteToDiskCache(cache_path, source_size, source_mtime, *texture);
+
+	return texture;
+}
+
+// Requires s_mutex. Returns false if the texture doesn't fit into the budget.
+static bool CacheTexture(const std::string& name, std::shared_ptr<DecodedTexture> texture, bool evict)
+{
+	const size_t size = texture->data.size();
+	if (size > s_cache_budget)
+		return false;
+
+	while (s_cache_size + size > s_cache_budget)
+	{
+		if (!evict)
+			return false;
+
+		auto it = s_cache.find(s_lru.back());
+		s_cache_size -= it->second.texture->data.size();
+		s_cache.erase(it);
+		s_lru.pop_back();
+	}
+
+	s_lru.push_front(name);
+	s_cache[name] = CacheEntry{ std::move(texture), s_lru.begin() };
+	s_cache_size += size;
+	return true;
+}
+
+static void LoaderThread()
+{
+	Common::SetCurrentThreadName("Custom texture loader");
+
+	std::unique_lock<std::mutex> lk(s_mutex);
+	while (true)
+	{
+		s_cond.wait(lk, [] { return s_loader_quit || !s_load_queue.empty(); });
+		if (s_loader_quit)
+			return;
+
+		s_loading = s_load_queue.front();
+		s_load_queue.pop_front();
+		if (s_cache.count(s_loading))
+		{
+			s_loading.clear();
+			continue;
+		}
+
+		const std::string name = s_loading;
+		lk.unlock();
+		std::shared_ptr<DecodedTexture> texture = LoadTexture(name, textureMap.find(name)->second);
+		lk.lock();
+
+		// Prefetching never evicts anything: the textures which are already
+		// cached are just as likely to be needed as the ones which aren't.
+		if (texture && !CacheTexture(name, std::move(texture), false))
+		{
+			WARN_LOG(VIDEO, "Custom texture cache is full, not prefetching the remaining %u textures",
+			         (unsigned int)s_load_queue.size() + 1);
+			s_load_queue.clear();
+		}
+		s_loading.clear();
+		s_cond.notify_all();
+	}
+}
+
+void Shutdown()
+{
+	if (s_loader_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lk(s_mutex);
+			s_loader_quit = true;
+		}
+		s_cond.notify_all();
+		s_loader_thread.join();
+	}
+
+	s_load_queue.clear();
+	s_cache.clear();
+	s_lru.clear();
+	s_cache_size = 0;
 	textureMap.clear();
+}
+
+void Init(const std::string& gameCode)
+{
+	Shutdown();
 
 	CFileSearch::XStringVector Directories;
 
@@ -78,6 +316,19 @@ void Init(const std::string& gameCode)
 				textureMap.insert(std::map<std::string, std::string>::value_type(FileName, rFilename));
 		}
 	}
+
+	s_disk_cache_dir = StringFromFormat("%sHiresTextures/%s/", File::GetUserPath(D_CACHE_IDX).c_str(), gameCode.c_str());
+	s_use_disk_cache = g_ActiveConfig.bHiresTexturesDiskCache;
+	s_cache_budget = (size_t)std::max(g_ActiveConfig.iHiresTexturesCacheSize, 0) * 1024 * 1024;
+
+	// Without prefetching, textures are only loaded when they're needed.
+	if (textureMap.empty() || !g_ActiveConfig.bCacheHiresTextures)
+		return;
+
+	s_loader_quit = false;
+	for (const auto& entry : textureMap)
+		s_load_queue.push_back(entry.first);
+	s_loader_thread = std::thread(LoaderThread);
 }
 
 bool HiresTexExists(const std::string& filename)
@@ -85,80 +336,61 @@ bool HiresTexExists(const std::string& filename)
 	return textureMap.find(filename) != textureMap.end();
 }
 
-PC_TexFormat GetHiresTex(const std::string& filename, unsigned int* pWidth, unsigned int* pHeight, unsigned int* required_size, int texformat, unsigned int data_size, u8* data)
+// Returns the texture from the cache, waiting for the loader thread if it's
+// decoding it right now, or loads it on this thread.
+static std::shared_ptr<DecodedTexture> GetTexture(const std::string& filename, const std::string& path)
 {
-	if (textureMap.find(filename) == textureMap.end())
-		return PC_TEX_FMT_NONE;
-
-	int width;
-	int height;
-	int channels;
+	{
+		std::unique_lock<std::mutex> lk(s_mutex);
+		s_cond.wait(lk, [&] { return s_loading != filename; });
 
-	File::IOFile file;
-	file.Open(textureMap[filename], "rb");
-	std::vector<u8> buffer(file.GetSize());
-	file.ReadBytes(buffer.data(), file.GetSize());
+		auto it = s_cache.find(filename);
+		if (it != s_cache.end())
+		{
+			s_lru.splice(s_lru.begin(), s_lru, it->second.lru_position);
+			return it->second.texture;
+		}
 
-	u8* temp = SOIL_load_image_from_memory(buffer.data(), (int)buffer.size(), &width, &height, &channels, SOIL_LOAD_RGBA);
+		// No need for the loader thread to do it a second time.
+		auto queued = std::find(s_load_queue.begin(), s_load_queue.end(), filename);
+		if (queued != s_load_queue.end())
+			s_load_queue.erase(queued);
+	}
 
-	if (temp == nullptr)
+	std::shared_ptr<DecodedTexture> texture = LoadTexture(filename, path);
+	if (texture)
 	{
-		ERROR_LOG(VIDEO, "Custom texture %s failed to load", textureMap[filename].c_str());
-		return PC_TEX_FMT_NONE;
+		std::lock_guard<std::mutex> lk(s_mutex);
+		if (!s_cache.count(filename))
+			CacheTexture(filename, texture, true);
 	}
+	return texture;
+}
 
-	*pWidth = width;
-	*pHeight = height;
+PC_TexFormat GetHiresTex(const std::string& filename, unsigned int* pWidth, unsigned int* pHeight, unsigned int* required_size, int texformat, unsigned int data_size, u8* data)
+{
+	auto path = textureMap.find(filename);
+	if (path == textureMap.end())
+		return PC_TEX_FMT_NONE;
+
+	std::shared_ptr<DecodedTexture> texture = GetTexture(filename, path->second);
+	if (!texture)
+		return PC_TEX_FMT_NONE;
 
-	//int offset = 0;
-	PC_TexFormat returnTex = PC_TEX_FMT_NONE;
+	*pWidth = texture->width;
+	*pHeight = texture->height;
 
 	// TODO(neobrain): This function currently has no way to enforce RGBA32
 	// output, which however is required on some configurations to function
-	// properly. As a lazy workaround, we hence disable the optimized code
-	// path for now.
-#if 0
-	switch (texformat)
-	{
-	case GX_TF_I4:
-	case GX_TF_I8:
-	case GX_TF_IA4:
-	case GX_TF_IA8:
-		*required_size = width * height * 8;
-		if (data_size < *required_size)
-			goto cleanup;
-
-		for (int i = 0; i < width * height * 4; i += 4)
-		{
-			// Rather than use a luminosity function, just use the most intense color for luminance
-			// TODO(neobrain): Isn't this kind of.. stupid?
-			data[offset++] = *std::max_element(temp+i, temp+i+3);
-			data[offset++] = temp[i+3];
-		}
-		returnTex = PC_TEX_FMT_IA8;
-		break;
-	default:
-		*required_size = width * height * 4;
-		if (data_size < *required_size)
-			goto cleanup;
-
-		memcpy(data, temp, width * height * 4);
-		returnTex = PC_TEX_FMT_RGBA32;
-		break;
-	}
-#else
-	*required_size = width * height * 4;
+	// properly. As a lazy workaround, we always return RGBA32.
+	*required_size = (unsigned int)texture->data.size();
 	if (data_size < *required_size)
-		goto cleanup;
+		return PC_TEX_FMT_NONE;
 
-	memcpy(data, temp, width * height * 4);
-	returnTex = PC_TEX_FMT_RGBA32;
-#endif
+	memcpy(data, texture->data.data(), texture->data.size());
 
-	INFO_LOG(VIDEO, "Loading custom texture from %s", textureMap[filename].c_str());
-cleanup:
-	SOIL_free_image_data(temp);
-	return returnTex;
+	INFO_LOG(VIDEO, "Loading custom texture from %s", path->second.c_str());
+	return PC_TEX_FMT_RGBA32;
 }
 
 }
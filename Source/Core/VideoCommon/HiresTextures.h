@@ -12,6 +12,7 @@
 namespace HiresTextures
 {
 void Init(const std::string& gameCode);
+void Shutdown();
 bool HiresTexExists(const std::string& filename);
 PC_TexFormat GetHiresTex(const std::string& fileName, unsigned int* pWidth, unsigned int* pHeight, unsigned int* required_size, int texformat, unsigned int data_size, u8* data);
 
@@ -126,6 +126,7 @@ void VideoBackendHardware::Video_EndField()
 	{
 		SyncGPU(SYNC_GPU_SWAP);
 		s_swapRequested.Set();
+		WakeGpuThread();
 	}
 }
 
@@ -175,6 +176,7 @@ u32 VideoBackendHardware::Video_AccessEFB(EFBAccessType type, u32 x, u32 y, u32
 			if (s_FifoShuttingDown.IsSet())
 				return 0;
 			s_efbAccessRequested.Set();
+			WakeGpuThread();
 			s_efbAccessReadyEvent.Wait();
 		}
 		else
@@ -214,6 +216,7 @@ u32 VideoBackendHardware::Video_GetQueryResult(PerfQueryType type)
 			if (s_FifoShuttingDown.IsSet())
 				return 0;
 			s_perfQueryRequested.Set();
+			WakeGpuThread();
 			s_perfQueryReadyEvent.Wait();
 		}
 		else
@@ -237,6 +240,7 @@ u16 VideoBackendHardware::Video_GetBoundingBox(int index)
 			return 0;
 		s_BBoxIndex = index;
 		s_BBoxRequested.Set();
+		WakeGpuThread();
 		s_BBoxReadyEvent.Wait();
 		return s_BBoxResult;
 	}
@@ -0,0 +1,25 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "VideoCommon/BoundingBox.h"
+#include "VideoCommon/ShaderGenCommon.h"
+
+u32 g_shader_uid_state;
+
+bool ShaderUidInputs::Changed(u32 arg0, u32 arg1, u32 arg2)
+{
+	if (valid && state == g_shader_uid_state && bbox_active == BoundingBox::active &&
+	    args[0] == arg0 && args[1] == arg1 && args[2] == arg2)
+	{
+		return false;
+	}
+
+	valid = true;
+	state = g_shader_uid_state;
+	bbox_active = BoundingBox::active;
+	args[0] = arg0;
+	args[1] = arg1;
+	args[2] = arg2;
+	return true;
+}
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Hash.h"
 #include "Common/StringUtil.h"
 #include "VideoCommon/VideoCommon.h"
 #include "VideoCommon/VideoConfig.h"
@@ -66,12 +67,14 @@ public:
  * uid_data can be any struct of parameters that uniquely identify each shader code output.
  * Unless performance is not an issue, uid_data should be tightly packed to reduce memory footprint.
  * Shader generators will write to specific uid_data fields; ShaderUid methods will only read raw u32 values from a union.
+ * The Get*ShaderUid functions hash the data once the generator is done with it, so that comparisons of different UIDs
+ * usually don't need to look at the data at all, and so that the UIDs can be used as keys of unordered_maps.
  */
 template<class uid_data>
 class ShaderUid : public ShaderGeneratorInterface
 {
 public:
-	ShaderUid()
+	ShaderUid() : hash(0)
 	{
 		// TODO: Move to Shadergen => can be optimized out
 		memset(values, 0, sizeof(values));
@@ -79,12 +82,12 @@ public:
 
 	bool operator == (const ShaderUid& obj) const
 	{
-		return memcmp(this->values, obj.values, data.NumValues() * sizeof(*values)) == 0;
+		return hash == obj.hash && memcmp(this->values, obj.values, data.NumValues() * sizeof(*values)) == 0;
 	}
 
 	bool operator != (const ShaderUid& obj) const
 	{
-		return memcmp(this->values, obj.values, data.NumValues() * sizeof(*values)) != 0;
+		return !(*this == obj);
 	}
 
 	// determines the storage order inside STL containers
@@ -100,12 +103,53 @@ public:
 
 	size_t GetUidDataSize() const { return sizeof(values); }
 
+	void CalculateHash() { hash = GetMurmurHash3(values, data.NumValues() * sizeof(*values), 0); }
+	u64 GetHash() const { return hash; }
+
+	struct Hasher
+	{
+		size_t operator()(const ShaderUid& uid) const { return (size_t)uid.GetHash(); }
+	};
+
 private:
 	union
 	{
 		uid_data data;
 		u8 values[sizeof(uid_data)];
 	};
+	u64 hash;
+};
+
+/**
+ * Incremented whenever the BP, XF or CP registers or the config which the shader generators read might have changed.
+ */
+extern u32 g_shader_uid_state;
+
+inline void InvalidateShaderUids()
+{
+	g_shader_uid_state++;
+}
+
+/**
+ * Remembers what a shader cache last generated its UID from. The generators only read the arguments passed to
+ * them, bounding box state and the state covered by g_shader_uid_state, so while none of that changes the UID
+ * would come out the same and doesn't have to be generated again.
+ */
+class ShaderUidInputs
+{
+public:
+	ShaderUidInputs() : valid(false) {}
+
+	// Returns true if the UID has to be generated again. Arguments which don't apply are left at 0.
+	bool Changed(u32 arg0, u32 arg1 = 0, u32 arg2 = 0);
+
+	void Reset() { valid = false; }
+
+private:
+	bool valid;
+	bool bbox_active;
+	u32 state;
+	u32 args[3];
 };
 
 class ShaderCode : public ShaderGeneratorInterface
@@ -48,6 +48,8 @@ std::string Statistics::ToString()
 	str += StringFromFormat("Vertex streamed: %i kB\n", stats.thisFrame.bytesVertexStreamed/1024);
 	str += StringFromFormat("Index streamed: %i kB\n", stats.thisFrame.bytesIndexStreamed/1024);
 	str += StringFromFormat("Uniform streamed: %i kB\n", stats.thisFrame.bytesUniformStreamed/1024);
+	str += StringFromFormat("Texture hashes skipped: %i\n", stats.thisFrame.numTextureHashSkips);
+	str += StringFromFormat("Texture hashes computed: %i\n", stats.thisFrame.numTextureRehashes);
 	str += StringFromFormat("Vertex Loaders: %i\n", stats.numVertexLoaders);
 
 	std::string vertex_list;
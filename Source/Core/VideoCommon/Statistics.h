@@ -50,6 +50,9 @@ struct Statistics
 
 		int numDListsCalled;
 
+		int numTextureHashSkips;
+		int numTextureRehashes;
+
 		int bytesVertexStreamed;
 		int bytesIndexStreamed;
 		int bytesUniformStreamed;
@@ -3,11 +3,14 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <memory>
 #include <string>
+#include <thread>
 
 #include "Common/FileUtil.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/WorkerPool.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
@@ -23,15 +26,38 @@ enum
 {
 	TEXTURE_KILL_THRESHOLD = 200,
 	RENDER_TARGET_KILL_THRESHOLD = 3,
+	TEXTURE_POOL_KILL_THRESHOLD = 3,
+
+	RANGE_INDEX_SHIFT = 16,
+
+	// Textures that decode to less than this many bytes (all levels together)
+	// aren't worth waking the decode workers for.
+	PARALLEL_DECODE_MIN_SIZE = 256 * 1024,
+	MAX_DECODE_THREADS = 4,
 };
 
 TextureCache *g_texture_cache;
 
-GC_ALIGNED16(u8 *TextureCache::temp) = nullptr;
-unsigned int TextureCache::temp_size;
-
 TextureCache::TexCache TextureCache::textures;
 TextureCache::RenderTargetPool TextureCache::render_target_pool;
+TextureCache::TexturePool TextureCache::texture_pool;
+TextureCache::RangeIndex TextureCache::range_index;
+std::vector<TextureCache::TexCache::iterator> TextureCache::range_entries;
+std::vector<TextureCache::DecodeBuffer> TextureCache::decode_buffers;
+
+static std::unique_ptr<Common::WorkerPool> s_decode_workers;
+
+// A part of a texture for one of the decode workers: either a band of rows of
+// level 0 or a whole mip level.
+struct DecodeJob
+{
+	const u8* src;
+	const u8* src_gb; // only for RGBA8 textures in tmem
+	u8* dst;
+	unsigned int width, height;
+	PC_TexFormat pcfmt;
+};
+static std::vector<DecodeJob> s_decode_jobs;
 
 TextureCache::BackupConfig TextureCache::backup_config;
 
@@ -43,9 +69,8 @@ TextureCache::TCacheEntryBase::~TCacheEntryBase()
 
 TextureCache::TextureCache()
 {
-	temp_size = 2048 * 2048 * 4;
-	if (!temp)
-		temp = (u8*)AllocateAlignedMemory(temp_size, 16);
+	GetDecodeBuffer(0, 1024 * 1024 * 4);
+	s_decode_workers.reset(new Common::WorkerPool(std::min(std::max(std::thread::hardware_concurrency(), 1u), (unsigned int)MAX_DECODE_THREADS)));
 
 	TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
 
@@ -69,19 +94,48 @@ void TextureCache::Invalidate()
 		delete tex.second;
 	}
 	textures.clear();
+	range_index.clear();
 
 	for (auto& rt : render_target_pool)
 	{
 		delete rt;
 	}
 	render_target_pool.clear();
+
+	for (auto& bucket : texture_pool)
+	{
+		for (auto& tex : bucket.second)
+			delete tex;
+	}
+	texture_pool.clear();
 }
 
 TextureCache::~TextureCache()
 {
 	Invalidate();
-	FreeAlignedMemory(temp);
-	temp = nullptr;
+
+	for (DecodeBuffer& buffer : decode_buffers)
+		FreeAlignedMemory(buffer.data);
+	decode_buffers.clear();
+
+	s_decode_workers.reset();
+
+	HiresTextures::Shutdown();
+}
+
+u8* TextureCache::GetDecodeBuffer(unsigned int level, size_t size)
+{
+	if (level >= decode_buffers.size())
+		decode_buffers.resize(level + 1, DecodeBuffer{nullptr, 0});
+
+	DecodeBuffer& buffer = decode_buffers[level];
+	if (buffer.size < size)
+	{
+		FreeAlignedMemory(buffer.data);
+		buffer.data = (u8*)AllocateAlignedMemory(size, 16);
+		buffer.size = size;
+	}
+	return buffer.data;
 }
 
 void TextureCache::OnConfigChanged(VideoConfig& config)
@@ -93,12 +147,15 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 			config.bTexFmtOverlayEnable != backup_config.s_texfmt_overlay ||
 			config.bTexFmtOverlayCenter != backup_config.s_texfmt_overlay_center ||
 			config.bHiresTextures != backup_config.s_hires_textures ||
+			config.bCacheHiresTextures != backup_config.s_cache_hires_textures ||
 			invalidate_texture_cache_requested)
 		{
 			g_texture_cache->Invalidate();
 
 			if (g_ActiveConfig.bHiresTextures)
 				HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID);
+			else
+				HiresTextures::Shutdown();
 
 			SetHash64Function(g_ActiveConfig.bHiresTextures || g_ActiveConfig.bDumpTextures);
 			TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
@@ -132,6 +189,7 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 	backup_config.s_texfmt_overlay = config.bTexFmtOverlayEnable;
 	backup_config.s_texfmt_overlay_center = config.bTexFmtOverlayCenter;
 	backup_config.s_hires_textures = config.bHiresTextures;
+	backup_config.s_cache_hires_textures = config.bCacheHiresTextures;
 	backup_config.s_copy_cache_enable = config.bEFBCopyCacheEnable;
 	backup_config.s_stereo_3d = config.iStereoMode > 0;
 	backup_config.s_efb_mono_depth = config.bStereoEFBMonoDepth;
@@ -147,8 +205,7 @@ void TextureCache::Cleanup()
             // EFB copies living on the host GPU are unrecoverable and thus shouldn't be deleted
 		    !iter->second->IsEfbCopy())
 		{
-			delete iter->second;
-			textures.erase(iter++);
+			iter = FreeEntry(iter);
 		}
 		else
 		{
@@ -171,53 +228,51 @@ void TextureCache::Cleanup()
 			++i;
 		}
 	}
-}
 
-void TextureCache::InvalidateRange(u32 start_address, u32 size)
-{
-	TexCache::iterator
-		iter = textures.begin(),
-		tcend = textures.end();
-	while (iter != tcend)
+	for (auto& bucket : texture_pool)
 	{
-		const int rangePosition = iter->second->IntersectsMemoryRange(start_address, size);
-		if (0 == rangePosition)
+		auto& pool = bucket.second;
+		for (size_t i = 0; i < pool.size();)
 		{
-			delete iter->second;
-			textures.erase(iter++);
-		}
-		else
-		{
-			++iter;
+			if (frameCount > TEXTURE_POOL_KILL_THRESHOLD + pool[i]->frameCount)
+			{
+				delete pool[i];
+				pool[i] = pool.back();
+				pool.pop_back();
+			}
+			else
+			{
+				++i;
+			}
 		}
 	}
 }
 
-void TextureCache::MakeRangeDynamic(u32 start_address, u32 size)
+void TextureCache::InvalidateRange(u32 start_address, u32 size)
 {
-	TexCache::iterator
-		iter = textures.lower_bound(start_address),
-		tcend = textures.upper_bound(start_address + size);
-
-	if (iter != textures.begin())
-		--iter;
+	GetEntriesInRange(start_address, size);
+	for (TexCache::iterator iter : range_entries)
+		FreeEntry(iter);
+}
 
-	for (; iter != tcend; ++iter)
-	{
-		const int rangePosition = iter->second->IntersectsMemoryRange(start_address, size);
-		if (0 == rangePosition)
-		{
-			iter->second->SetHashes(TEXHASH_INVALID);
-		}
-	}
+void TextureCache::MakeRangeDynamic(u32 start_address, u32 size)
+{
+	GetEntriesInRange(start_address, size);
+	for (TexCache::iterator iter : range_entries)
+		iter->second->SetHashes(TEXHASH_INVALID);
 }
 
 bool TextureCache::Find(u32 start_address, u64 hash)
 {
-	TexCache::iterator iter = textures.lower_bound(start_address);
+	auto bucket = range_index.find(start_address >> RANGE_INDEX_SHIFT);
+	if (bucket == range_index.end())
+		return false;
 
-	if (iter->second->hash == hash)
-		return true;
+	for (TexCache::iterator iter : bucket->second)
+	{
+		if (iter->second->addr == start_address && iter->second->hash == hash)
+			return true;
+	}
 
 	return false;
 }
@@ -243,8 +298,7 @@ void TextureCache::ClearRenderTargets()
 	{
 		if (iter->second->type == TCET_EC_VRAM)
 		{
-			delete iter->second;
-			textures.erase(iter++);
+			iter = FreeEntry(iter);
 		}
 		else
 		{
@@ -253,6 +307,66 @@ void TextureCache::ClearRenderTargets()
 	}
 }
 
+// An entry covers addr to addr + size_in_bytes inclusive, like in IntersectsMemoryRange.
+void TextureCache::LinkEntry(TexCache::iterator iter)
+{
+	const TCacheEntryBase* entry = iter->second;
+	const u32 first = entry->addr >> RANGE_INDEX_SHIFT;
+	const u32 last = (entry->addr + entry->size_in_bytes) >> RANGE_INDEX_SHIFT;
+	for (u32 block = first; block <= last; ++block)
+		range_index[block].push_back(iter);
+}
+
+void TextureCache::UnlinkEntry(TexCache::iterator iter)
+{
+	const TCacheEntryBase* entry = iter->second;
+	const u32 first = entry->addr >> RANGE_INDEX_SHIFT;
+	const u32 last = (entry->addr + entry->size_in_bytes) >> RANGE_INDEX_SHIFT;
+	for (u32 block = first; block <= last; ++block)
+	{
+		auto& bucket = range_index[block];
+		auto found = std::find(bucket.begin(), bucket.end(), iter);
+		if (found != bucket.end())
+		{
+			*found = bucket.back();
+			bucket.pop_back();
+		}
+	}
+}
+
+TextureCache::TexCache::iterator TextureCache::FreeEntry(TexCache::iterator iter)
+{
+	UnlinkEntry(iter);
+	FreeTexture(iter->second);
+	return textures.erase(iter);
+}
+
+void TextureCache::GetEntriesInRange(u32 start_address, u32 size)
+{
+	range_entries.clear();
+
+	const u32 first = start_address >> RANGE_INDEX_SHIFT;
+	const u32 last = (start_address + std::max(size, 1u) - 1) >> RANGE_INDEX_SHIFT;
+	for (u32 block = first; block <= last; ++block)
+	{
+		auto bucket = range_index.find(block);
+		if (bucket == range_index.end())
+			continue;
+
+		for (TexCache::iterator iter : bucket->second)
+		{
+			// Entries are listed in every block they cover, only report them
+			// for the first block that is part of the range.
+			const u32 entry_first = iter->second->addr >> RANGE_INDEX_SHIFT;
+			if (std::max(entry_first, first) == block &&
+			    iter->second->IntersectsMemoryRange(start_address, size) == 0)
+			{
+				range_entries.push_back(iter);
+			}
+		}
+	}
+}
+
 bool TextureCache::CheckForCustomTextureLODs(u64 tex_hash, int texformat, unsigned int levels)
 {
 	if (levels == 1)
@@ -289,15 +403,14 @@ PC_TexFormat TextureCache::LoadCustomTexture(u64 tex_hash, int texformat, unsign
 		texPathTemp = StringFromFormat("%s_%08x_%i_mip%u", SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), tex_hash_u32, texformat, level);
 
 	unsigned int required_size = 0;
-	PC_TexFormat ret = HiresTextures::GetHiresTex(texPathTemp, &newWidth, &newHeight, &required_size, texformat, temp_size, temp);
-	if (ret == PC_TEX_FMT_NONE && temp_size < required_size)
+	u8* buffer = GetDecodeBuffer(level, 0);
+	PC_TexFormat ret = HiresTextures::GetHiresTex(texPathTemp, &newWidth, &newHeight, &required_size, texformat, (unsigned int)decode_buffers[level].size, buffer);
+	if (ret == PC_TEX_FMT_NONE && decode_buffers[level].size < required_size)
 	{
 		// Allocate more memory and try again
 		// TODO: Should probably check if newWidth and newHeight are texture dimensions which are actually supported by the current video backend
-		temp_size = required_size;
-		FreeAlignedMemory(temp);
-		temp = (u8*)AllocateAlignedMemory(temp_size, 16);
-		ret = HiresTextures::GetHiresTex(texPathTemp, &newWidth, &newHeight, &required_size, texformat, temp_size, temp);
+		buffer = GetDecodeBuffer(level, required_size);
+		ret = HiresTextures::GetHiresTex(texPathTemp, &newWidth, &newHeight, &required_size, texformat, required_size, buffer);
 	}
 
 	if (ret != PC_TEX_FMT_NONE)
@@ -397,8 +510,6 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	else
 		src_data = Memory::GetPointer(address);
 
-	// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
-	tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
 	if (isPaletteTexture)
 	{
 		const u32 palette_size = TexDecoder_GetPaletteSize(texformat);
@@ -414,15 +525,38 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		//
 		// TODO: Because texID isn't always the same as the address now, CopyRenderTargetToTexture might be broken now
 		texID ^= ((u32)tlut_hash) ^(u32)(tlut_hash >> 32);
-		tex_hash ^= tlut_hash;
 	}
 
+	TexCache::iterator iter = textures.find(texID);
+	TCacheEntryBase *entry = iter != textures.end() ? iter->second : nullptr;
+
+	// If nothing has written to the texture since it was last hashed, that hash is still good.
+	u64 write_stamp = 0;
+	if (!from_tmem && entry && entry->type == TCET_NORMAL && entry->addr == address &&
+	    entry->size_in_bytes == texture_size && !Memory::WrittenSince(address, texture_size, entry->write_stamp))
+	{
+		tex_hash = entry->data_hash;
+		write_stamp = entry->write_stamp;
+		INCSTAT(stats.thisFrame.numTextureHashSkips);
+	}
+	else
+	{
+		if (!from_tmem)
+			write_stamp = Memory::WatchRange(address, texture_size);
+
+		// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
+		tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+		INCSTAT(stats.thisFrame.numTextureRehashes);
+	}
+	const u64 data_hash = tex_hash;
+	if (isPaletteTexture)
+		tex_hash ^= tlut_hash;
+
 	// D3D doesn't like when the specified mipmap count would require more than one 1x1-sized LOD in the mipmap chain
 	// e.g. 64x64 with 7 LODs would have the mipmap chain 64x64,32x32,16x16,8x8,4x4,2x2,1x1,1x1, so we limit the mipmap count to 6 there
 	while (g_ActiveConfig.backend_info.bUseMinimalMipCount && std::max(width, height) >> maxlevel == 0)
 		--maxlevel;
 
-	TCacheEntryBase *entry = textures[texID];
 	if (entry)
 	{
 		// 1. Calculate reference hash:
@@ -463,12 +597,13 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		     entry->native_height == height)) &&
 		     entry->num_layers == 1)
 		{
-			// reuse the texture
+			// reuse the texture, its range is about to change
+			UnlinkEntry(iter);
 		}
 		else
 		{
-			// delete the texture and make a new one
-			delete entry;
+			// pool the texture and make a new one
+			FreeEntry(iter);
 			entry = nullptr;
 		}
 	}
@@ -488,7 +623,8 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				// If we thought we could reuse the texture before, make sure to pool it now!
 				if (entry)
 				{
-					delete entry;
+					FreeTexture(entry);
+					textures.erase(iter);
 					entry = nullptr;
 				}
 			}
@@ -496,30 +632,100 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		}
 	}
 
+	u32 texLevels = use_mipmaps ? (maxlevel + 1) : 1;
+	const bool using_custom_lods = using_custom_texture && CheckForCustomTextureLODs(tex_hash, texformat, texLevels);
+	// Only load native mips if their dimensions fit to our virtual texture dimensions
+	const bool use_native_mips = use_mipmaps && !using_custom_lods && (width == nativeW && height == nativeH);
+	texLevels = (use_native_mips || using_custom_lods) ? texLevels : 1; // TODO: Should be forced to 1 for non-pow2 textures (e.g. efb copies with automatically adjusted IR)
+
+	// Decode level 0 and the native mips up front. Large textures are split
+	// into bands of block rows, and all of it is spread over the decode workers.
+	s_decode_jobs.clear();
+	size_t decoded_size = 0;
 	if (!using_custom_texture)
 	{
-		if (!(texformat == GX_TF_RGBA8 && from_tmem))
+		const size_t level_size = expandedWidth * expandedHeight * 4;
+		u8* dst = GetDecodeBuffer(0, level_size);
+		decoded_size += level_size;
+
+		if (texformat == GX_TF_RGBA8 && from_tmem)
 		{
-			const u8* tlut = &texMem[tlutaddr];
-			pcfmt = TexDecoder_Decode(temp, src_data, expandedWidth, expandedHeight, texformat, tlut, (TlutFormat) tlutfmt);
+			const u8* src_data_gb = &texMem[bpmem.tex[stage/4].texImage2[stage%4].tmem_odd * TMEM_LINE_SIZE];
+			s_decode_jobs.push_back({src_data, src_data_gb, dst, expandedWidth, expandedHeight, PC_TEX_FMT_NONE});
 		}
 		else
 		{
-			u8* src_data_gb = &texMem[bpmem.tex[stage/4].texImage2[stage%4].tmem_odd * TMEM_LINE_SIZE];
-			pcfmt = TexDecoder_DecodeRGBA8FromTmem(temp, src_data, src_data_gb, expandedWidth, expandedHeight);
+			// The format overlay is drawn per decode call, so it needs the whole texture.
+			const unsigned int block_rows = expandedHeight / (bsh + 1);
+			unsigned int bands = 1;
+			if (level_size >= PARALLEL_DECODE_MIN_SIZE && !g_ActiveConfig.bTexFmtOverlayEnable)
+				bands = std::min(s_decode_workers->GetNumThreads(), block_rows);
+
+			for (unsigned int band = 0; band < bands; ++band)
+			{
+				const unsigned int first_row = block_rows * band / bands * (bsh + 1);
+				const unsigned int end_row = block_rows * (band + 1) / bands * (bsh + 1);
+				s_decode_jobs.push_back({src_data + TexDecoder_GetTextureSizeInBytes(expandedWidth, first_row, texformat), nullptr,
+				                         dst + first_row * expandedWidth * 4, expandedWidth, end_row - first_row, PC_TEX_FMT_NONE});
+			}
 		}
 	}
 
-	u32 texLevels = use_mipmaps ? (maxlevel + 1) : 1;
-	const bool using_custom_lods = using_custom_texture && CheckForCustomTextureLODs(tex_hash, texformat, texLevels);
-	// Only load native mips if their dimensions fit to our virtual texture dimensions
-	const bool use_native_mips = use_mipmaps && !using_custom_lods && (width == nativeW && height == nativeH);
-	texLevels = (use_native_mips || using_custom_lods) ? texLevels : 1; // TODO: Should be forced to 1 for non-pow2 textures (e.g. efb copies with automatically adjusted IR)
+	if (use_native_mips)
+	{
+		const u8* mip_src = src_data + texture_size;
+		const u8* ptr_even = nullptr;
+		const u8* ptr_odd = nullptr;
+		if (from_tmem)
+		{
+			ptr_even = &texMem[bpmem.tex[stage/4].texImage1[stage%4].tmem_even * TMEM_LINE_SIZE + texture_size];
+			ptr_odd = &texMem[bpmem.tex[stage/4].texImage2[stage%4].tmem_odd * TMEM_LINE_SIZE];
+		}
+
+		for (u32 level = 1; level != texLevels; ++level)
+		{
+			const u32 mip_width = CalculateLevelSize(width, level);
+			const u32 mip_height = CalculateLevelSize(height, level);
+			const u32 expanded_mip_width = (mip_width + bsw) & (~bsw);
+			const u32 expanded_mip_height = (mip_height + bsh) & (~bsh);
+			const size_t level_size = expanded_mip_width * expanded_mip_height * 4;
+
+			const u8*& mip_src_data = from_tmem
+				? ((level % 2) ? ptr_odd : ptr_even)
+				: mip_src;
+			s_decode_jobs.push_back({mip_src_data, nullptr, GetDecodeBuffer(level, level_size),
+			                         expanded_mip_width, expanded_mip_height, PC_TEX_FMT_NONE});
+			mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
+			decoded_size += level_size;
+		}
+	}
+
+	const u8* tlut = &texMem[tlutaddr];
+	auto decode = [&](size_t i) {
+		DecodeJob& job = s_decode_jobs[i];
+		if (job.src_gb)
+			job.pcfmt = TexDecoder_DecodeRGBA8FromTmem(job.dst, job.src, job.src_gb, job.width, job.height);
+		else
+			job.pcfmt = TexDecoder_Decode(job.dst, job.src, job.width, job.height, texformat, tlut, (TlutFormat) tlutfmt);
+	};
+	if (decoded_size >= PARALLEL_DECODE_MIN_SIZE)
+	{
+		s_decode_workers->ParallelFor(s_decode_jobs.size(), decode);
+	}
+	else
+	{
+		for (size_t i = 0; i < s_decode_jobs.size(); ++i)
+			decode(i);
+	}
+
+	if (!using_custom_texture)
+		pcfmt = s_decode_jobs[0].pcfmt;
 
 	// create the entry/texture
 	if (nullptr == entry)
 	{
-		textures[texID] = entry = g_texture_cache->CreateTexture(width, height, expandedWidth, texLevels, pcfmt);
+		entry = AllocateTexture(decode_buffers[0].data, width, height, expandedWidth, texLevels, pcfmt);
+		iter = textures.emplace(texID, entry).first;
 
 		// Sometimes, we can get around recreating a texture if only the number of mip levels changes
 		// e.g. if our texture cache entry got too many mipmap levels we can limit the number of used levels by setting the appropriate render states
@@ -537,12 +743,15 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	else
 	{
 		// load texture (CreateTexture also loads level 0)
-		entry->Load(width, height, expandedWidth, 0);
+		entry->Load(decode_buffers[0].data, width, height, expandedWidth, 0);
 	}
 
 	entry->SetGeneralParameters(address, texture_size, full_format, entry->num_mipmaps, entry->num_layers);
 	entry->SetDimensions(nativeW, nativeH, width, height);
+	LinkEntry(iter);
 	entry->hash = tex_hash;
+	entry->data_hash = data_hash;
+	entry->write_stamp = write_stamp;
 
 	if (entry->IsEfbCopy() && !g_ActiveConfig.bCopyEFBToTexture)
 		entry->type = TCET_EC_DYNAMIC;
@@ -558,31 +767,13 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	{
 		if (use_native_mips)
 		{
-			src_data += texture_size;
-
-			const u8* ptr_even = nullptr;
-			const u8* ptr_odd = nullptr;
-			if (from_tmem)
-			{
-				ptr_even = &texMem[bpmem.tex[stage/4].texImage1[stage%4].tmem_even * TMEM_LINE_SIZE + texture_size];
-				ptr_odd = &texMem[bpmem.tex[stage/4].texImage2[stage%4].tmem_odd * TMEM_LINE_SIZE];
-			}
-
 			for (; level != texLevels; ++level)
 			{
 				const u32 mip_width = CalculateLevelSize(width, level);
 				const u32 mip_height = CalculateLevelSize(height, level);
 				const u32 expanded_mip_width = (mip_width + bsw) & (~bsw);
-				const u32 expanded_mip_height = (mip_height + bsh) & (~bsh);
 
-				const u8*& mip_src_data = from_tmem
-					? ((level % 2) ? ptr_odd : ptr_even)
-					: src_data;
-				const u8* tlut = &texMem[tlutaddr];
-				TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat, tlut, (TlutFormat) tlutfmt);
-				mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
-
-				entry->Load(mip_width, mip_height, expanded_mip_width, level);
+				entry->Load(decode_buffers[level].data, mip_width, mip_height, expanded_mip_width, level);
 
 				if (g_ActiveConfig.bDumpTextures)
 					DumpTexture(entry, level);
@@ -596,7 +787,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				unsigned int mip_height = CalculateLevelSize(height, level);
 
 				LoadCustomTexture(tex_hash, texformat, level, &mip_width, &mip_height);
-				entry->Load(mip_width, mip_height, mip_width, level);
+				entry->Load(decode_buffers[level].data, mip_width, mip_height, mip_width, level);
 			}
 		}
 	}
@@ -895,7 +1086,8 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 
 	const unsigned int efb_layers = FramebufferManagerBase::GetEFBLayers();
 
-	TCacheEntryBase *entry = textures[dstAddr];
+	TexCache::iterator iter = textures.find(dstAddr);
+	TCacheEntryBase *entry = iter != textures.end() ? iter->second : nullptr;
 	if (entry)
 	{
 		if (entry->type == TCET_EC_DYNAMIC && entry->native_width == tex_w && entry->native_height == tex_h && entry->num_layers == efb_layers)
@@ -908,12 +1100,14 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 			if (entry->type == TCET_EC_VRAM)
 			{
 				// try to re-use this render target later
+				UnlinkEntry(iter);
+				textures.erase(iter);
 				FreeRenderTarget(entry);
 			}
 			else
 			{
 				// remove it and recreate it as a render target
-				delete entry;
+				FreeEntry(iter);
 			}
 
 			entry = nullptr;
@@ -923,18 +1117,25 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	if (nullptr == entry)
 	{
 		// create the texture
-		textures[dstAddr] = entry = AllocateRenderTarget(scaled_tex_w, scaled_tex_h);
+		entry = AllocateRenderTarget(scaled_tex_w, scaled_tex_h);
+		iter = textures.emplace(dstAddr, entry).first;
 
 		// TODO: Using the wrong dstFormat, dumb...
 		entry->SetGeneralParameters(dstAddr, 0, dstFormat, 1, efb_layers);
 		entry->SetDimensions(tex_w, tex_h, scaled_tex_w, scaled_tex_h);
 		entry->SetHashes(TEXHASH_INVALID);
 		entry->type = TCET_EC_VRAM;
+		LinkEntry(iter);
 	}
 
 	entry->frameCount = frameCount;
 
 	entry->FromRenderTarget(dstAddr, dstFormat, srcFormat, srcRect, isIntensity, scaleByHalf, cbufid, colmat);
+
+	// The backend encodes the copy straight into RAM, let write tracking know.
+	// Copies are at least four lines per block row, so this covers the whole copy.
+	if (!g_ActiveConfig.bCopyEFBToTexture)
+		Memory::MarkWritten(dstAddr, bpmem.copyMipMapStrideChannels * 32 * ((tex_h + 3) / 4));
 }
 
 TextureCache::TCacheEntryBase* TextureCache::AllocateRenderTarget(unsigned int width, unsigned int height)
@@ -952,10 +1153,46 @@ TextureCache::TCacheEntryBase* TextureCache::AllocateRenderTarget(unsigned int w
 		return rt;
 	}
 
-	return g_texture_cache->CreateRenderTargetTexture(width, height);
+	TCacheEntryBase* entry = g_texture_cache->CreateRenderTargetTexture(width, height);
+	entry->pool_key = 0;
+	return entry;
 }
 
 void TextureCache::FreeRenderTarget(TCacheEntryBase* entry)
 {
 	render_target_pool.push_back(entry);
 }
+
+TextureCache::TCacheEntryBase* TextureCache::AllocateTexture(const u8* buffer, unsigned int width, unsigned int height,
+	unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt)
+{
+	const u64 pool_key = (u64)width | ((u64)height << 16) | ((u64)tex_levels << 32) | ((u64)pcfmt << 40);
+
+	auto bucket = texture_pool.find(pool_key);
+	if (bucket != texture_pool.end() && !bucket->second.empty())
+	{
+		TCacheEntryBase* entry = bucket->second.back();
+		bucket->second.pop_back();
+
+		// CreateTexture loads level 0, so do the same for pooled textures.
+		entry->Load(buffer, width, height, expanded_width, 0);
+		return entry;
+	}
+
+	TCacheEntryBase* entry = g_texture_cache->CreateTexture(buffer, width, height, expanded_width, tex_levels, pcfmt);
+	entry->pool_key = pool_key;
+	return entry;
+}
+
+void TextureCache::FreeTexture(TCacheEntryBase* entry)
+{
+	// Render targets used as textures don't go back to any pool.
+	if (!entry->pool_key)
+	{
+		delete entry;
+		return;
+	}
+
+	entry->frameCount = frameCount;
+	texture_pool[entry->pool_key].push_back(entry);
+}
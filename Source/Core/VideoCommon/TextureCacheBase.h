@@ -5,6 +5,8 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Thread.h"
@@ -36,6 +38,11 @@ public:
 		//u32 pal_hash;
 		u32 format;
 
+		// Hash of the RAM data alone (without the tlut) and the write tracking
+		// stamp it was taken at, lets Load skip hashing unchanged textures.
+		u64 data_hash;
+		u64 write_stamp;
+
 		enum TexCacheEntryType type;
 
 		unsigned int num_mipmaps;
@@ -46,6 +53,9 @@ public:
 		// used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
 		int frameCount;
 
+		// Size, levels and format the backend texture was created with, 0 for render targets.
+		u64 pool_key;
+
 
 		void SetGeneralParameters(u32 _addr, u32 _size, u32 _format, unsigned int _num_mipmaps, unsigned int _num_layers)
 		{
@@ -68,6 +78,7 @@ public:
 		{
 			hash = _hash;
 			//pal_hash = _pal_hash;
+			write_stamp = 0;
 		}
 
 
@@ -76,7 +87,7 @@ public:
 		virtual void Bind(unsigned int stage) = 0;
 		virtual bool Save(const std::string& filename, unsigned int level) = 0;
 
-		virtual void Load(unsigned int width, unsigned int height,
+		virtual void Load(const u8* buffer, unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int level) = 0;
 		virtual void FromRenderTarget(u32 dstAddr, unsigned int dstFormat,
 			PEControl::PixelFormat srcFormat, const EFBRectangle& srcRect,
@@ -99,7 +110,7 @@ public:
 	static void ClearRenderTargets(); // currently only used by OGL
 	static bool Find(u32 start_address, u64 hash);
 
-	virtual TCacheEntryBase* CreateTexture(unsigned int width, unsigned int height,
+	virtual TCacheEntryBase* CreateTexture(const u8* buffer, unsigned int width, unsigned int height,
 		unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt) = 0;
 	virtual TCacheEntryBase* CreateRenderTargetTexture(unsigned int scaled_tex_w, unsigned int scaled_tex_h) = 0;
 
@@ -116,10 +127,17 @@ public:
 protected:
 	TextureCache();
 
-	static  GC_ALIGNED16(u8 *temp);
-	static unsigned int temp_size;
-
 private:
+	struct DecodeBuffer
+	{
+		u8* data;
+		size_t size;
+	};
+
+	// Returns the buffer that the given mip level is decoded into. Every level
+	// has its own so that they can be decoded at the same time.
+	static u8* GetDecodeBuffer(unsigned int level, size_t size);
+
 	static bool CheckForCustomTextureLODs(u64 tex_hash, int texformat, unsigned int levels);
 	static PC_TexFormat LoadCustomTexture(u64 tex_hash, int texformat, unsigned int level, unsigned int* width, unsigned int* height);
 	static void DumpTexture(TCacheEntryBase* entry, unsigned int level);
@@ -127,11 +145,29 @@ private:
 	static TCacheEntryBase* AllocateRenderTarget(unsigned int width, unsigned int height);
 	static void FreeRenderTarget(TCacheEntryBase* entry);
 
+	static TCacheEntryBase* AllocateTexture(const u8* buffer, unsigned int width, unsigned int height,
+		unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt);
+	static void FreeTexture(TCacheEntryBase* entry);
+
 	typedef std::map<u32, TCacheEntryBase*> TexCache;
 	typedef std::vector<TCacheEntryBase*> RenderTargetPool;
+	// Textures that are no longer used, keyed by TCacheEntryBase::pool_key.
+	typedef std::unordered_map<u64, std::vector<TCacheEntryBase*>> TexturePool;
+	// Cache entries by the RANGE_INDEX_SHIFT sized blocks of memory they cover.
+	typedef std::unordered_map<u32, std::vector<TexCache::iterator>> RangeIndex;
+
+	static void LinkEntry(TexCache::iterator iter);
+	static void UnlinkEntry(TexCache::iterator iter);
+	static TexCache::iterator FreeEntry(TexCache::iterator iter);
+	static void GetEntriesInRange(u32 start_address, u32 size);
 
 	static TexCache textures;
 	static RenderTargetPool render_target_pool;
+	static TexturePool texture_pool;
+	static RangeIndex range_index;
+	// Result of GetEntriesInRange, kept around so range queries don't allocate.
+	static std::vector<TexCache::iterator> range_entries;
+	static std::vector<DecodeBuffer> decode_buffers;
 
 	// Backup configuration values
 	static struct BackupConfig
@@ -144,6 +180,7 @@ private:
 		bool s_texfmt_overlay;
 		bool s_texfmt_overlay_center;
 		bool s_hires_textures;
+		bool s_cache_hires_textures;
 		bool s_copy_cache_enable;
 		bool s_stereo_3d;
 		bool s_efb_mono_depth;
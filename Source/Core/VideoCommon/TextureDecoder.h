@@ -86,5 +86,10 @@ void TexDecoder_DecodeTexelRGBA8FromTmem(u8 *dst, const u8 *src_ar, const u8* sr
 
 void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center);
 
-/* Internal method, implemented by TextureDecoder_Generic and TextureDecoder_x64. */
-PC_TexFormat _TexDecoder_DecodeImpl(u32 * dst, const u8 * src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+/* Internal methods, implemented by TextureDecoder_Generic, TextureDecoder_x64 and TextureDecoder_AVX2.
+ * TexDecoder_Decode uses the fastest one the host CPU supports. */
+PC_TexFormat _TexDecoder_DecodeImpl_Generic(u32 * dst, const u8 * src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+#ifdef _M_X86
+PC_TexFormat _TexDecoder_DecodeImpl_x64(u32 * dst, const u8 * src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+PC_TexFormat _TexDecoder_DecodeImpl_AVX2(u32 * dst, const u8 * src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+#endif
@@ -0,0 +1,428 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <immintrin.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// GameCube/Wii texture decoder, AVX2 version.
+//
+// Every format decodes 8 texels per register: one row of the 8 texel wide
+// block formats, or two rows of the 4 texel wide ones. Paletted formats look
+// up the TLUT with gathers.
+//
+// This file is compiled with AVX2 enabled and is only called when
+// cpu_info.bAVX2 is set. It deliberately doesn't use any of the inline
+// helpers from other headers (LookUpTables.h, Common::swap16, ...): the copy
+// the compiler emits here could contain AVX2 instructions and end up being
+// the one the linker keeps for every other caller.
+
+// Writes the lower four texels of v to row0 and the upper four to row1.
+static inline void StoreRows(u32* row0, u32* row1, __m256i v)
+{
+	_mm_storeu_si128((__m128i*)row0, _mm256_castsi256_si128(v));
+	_mm_storeu_si128((__m128i*)row1, _mm256_extracti128_si256(v, 1));
+}
+
+// The LookUpTables.h conversions, on the low bits of every 32-bit lane.
+static inline __m256i Convert3To8(__m256i v)
+{
+	return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(v, 5), _mm256_slli_epi32(v, 2)), _mm256_srli_epi32(v, 1));
+}
+
+static inline __m256i Convert4To8(__m256i v)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, 4), v);
+}
+
+static inline __m256i Convert5To8(__m256i v)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, 3), _mm256_srli_epi32(v, 2));
+}
+
+static inline __m256i Convert6To8(__m256i v)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, 2), _mm256_srli_epi32(v, 4));
+}
+
+// Extracts a bit field from every 32-bit lane.
+static inline __m256i Field(__m256i v, int shift, int mask)
+{
+	return _mm256_and_si256(_mm256_srli_epi32(v, shift), _mm256_set1_epi32(mask));
+}
+
+static inline __m256i PackRGBA(__m256i r, __m256i g, __m256i b, __m256i a)
+{
+	return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+	                       _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_slli_epi32(a, 24)));
+}
+
+// The DecodePixel functions take the 16-bit texel in the low half of every
+// lane, IA8 as it's stored in memory and the other two already byteswapped.
+static inline __m256i DecodePixel_IA8(__m256i val)
+{
+	__m256i i = _mm256_srli_epi32(val, 8);
+	__m256i rgb = _mm256_or_si256(_mm256_or_si256(i, _mm256_slli_epi32(i, 8)), _mm256_slli_epi32(i, 16));
+	return _mm256_or_si256(rgb, _mm256_slli_epi32(val, 24));
+}
+
+static inline __m256i DecodePixel_RGB565(__m256i val)
+{
+	__m256i r = Convert5To8(Field(val, 11, 0x1f));
+	__m256i g = Convert6To8(Field(val, 5, 0x3f));
+	__m256i b = Convert5To8(Field(val, 0, 0x1f));
+	return PackRGBA(r, g, b, _mm256_set1_epi32(0xFF));
+}
+
+static inline __m256i DecodePixel_RGB5A3(__m256i val)
+{
+	__m256i opaque = PackRGBA(Convert5To8(Field(val, 10, 0x1f)),
+	                          Convert5To8(Field(val, 5, 0x1f)),
+	                          Convert5To8(Field(val, 0, 0x1f)),
+	                          _mm256_set1_epi32(0xFF));
+	__m256i translucent = PackRGBA(Convert4To8(Field(val, 8, 0xf)),
+	                               Convert4To8(Field(val, 4, 0xf)),
+	                               Convert4To8(Field(val, 0, 0xf)),
+	                               Convert3To8(Field(val, 12, 0x7)));
+	// Bit 15 selects between the two.
+	__m256i is_opaque = _mm256_srai_epi32(_mm256_slli_epi32(val, 16), 31);
+	return _mm256_blendv_epi8(translucent, opaque, is_opaque);
+}
+
+// Looks up 8 palette indices in the TLUT and decodes them.
+//
+// The gathers load 32 bits for every 16-bit entry, so they read two bytes past
+// the entry with the highest index. The TLUT always lives in texMem, which is
+// much larger than the highest offset + palette that a texture can address.
+template <TlutFormat tlutfmt>
+static inline __m256i DecodePaletted(__m256i indices, const u8* tlut)
+{
+	__m256i val = _mm256_i32gather_epi32((const int*)tlut, indices, 2);
+	switch (tlutfmt)
+	{
+	case GX_TL_IA8:
+		return DecodePixel_IA8(_mm256_and_si256(val, _mm256_set1_epi32(0xFFFF)));
+	case GX_TL_RGB565:
+	case GX_TL_RGB5A3:
+	default:
+	{
+		const __m256i swap = _mm256_setr_epi8(
+			1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1,
+			1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1);
+		val = _mm256_shuffle_epi8(val, swap);
+		return tlutfmt == GX_TL_RGB565 ? DecodePixel_RGB565(val) : DecodePixel_RGB5A3(val);
+	}
+	}
+}
+
+// Splits 8 bytes into 16 nibbles, the high nibble of each byte first, and
+// returns them as bytes.
+static inline __m128i UnpackNibbles(const u8* src)
+{
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	__m128i v = _mm_loadl_epi64((const __m128i*)src);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+	__m128i lo = _mm_and_si128(v, mask);
+	return _mm_unpacklo_epi8(hi, lo);
+}
+
+// Loads 8 big endian 16-bit texels and zero extends them to 32 bits.
+static inline __m256i LoadU16BE(const u8* src)
+{
+	const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	return _mm256_cvtepu16_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), swap));
+}
+
+// Broadcasts each of 8 bytes of v (starting at byte first) to a whole 32-bit lane.
+static inline __m256i SplatBytes(__m128i v, int first)
+{
+	__m256i bytes = _mm256_broadcastsi128_si256(v);
+	__m256i index = _mm256_setr_epi8(
+		0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+		4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+	return _mm256_shuffle_epi8(bytes, _mm256_add_epi8(index, _mm256_set1_epi8((char)first)));
+}
+
+// 8x8 blocks of 4-bit indices, two rows at a time.
+template <TlutFormat tlutfmt>
+static void DecodeC4(u32* dst, const u8* src, int width, int height, const u8* tlut)
+{
+	for (int y = 0; y < height; y += 8)
+		for (int x = 0; x < width; x += 8)
+			for (int iy = 0; iy < 8; iy += 2, src += 8)
+			{
+				__m128i nibbles = UnpackNibbles(src);
+				u32* row = dst + (y + iy) * width + x;
+				_mm256_storeu_si256((__m256i*)row, DecodePaletted<tlutfmt>(_mm256_cvtepu8_epi32(nibbles), tlut));
+				_mm256_storeu_si256((__m256i*)(row + width),
+				                    DecodePaletted<tlutfmt>(_mm256_cvtepu8_epi32(_mm_srli_si128(nibbles, 8)), tlut));
+			}
+}
+
+// 8x4 blocks of 8-bit indices.
+template <TlutFormat tlutfmt>
+static void DecodeC8(u32* dst, const u8* src, int width, int height, const u8* tlut)
+{
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 8)
+			for (int iy = 0; iy < 4; iy++, src += 8)
+			{
+				__m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), DecodePaletted<tlutfmt>(indices, tlut));
+			}
+}
+
+// 4x4 blocks of 14-bit indices, two rows at a time.
+template <TlutFormat tlutfmt>
+static void DecodeC14X2(u32* dst, const u8* src, int width, int height, const u8* tlut)
+{
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 4)
+			for (int iy = 0; iy < 4; iy += 2, src += 16)
+			{
+				__m256i indices = _mm256_and_si256(LoadU16BE(src), _mm256_set1_epi32(0x3FFF));
+				u32* row = dst + (y + iy) * width + x;
+				StoreRows(row, row + width, DecodePaletted<tlutfmt>(indices, tlut));
+			}
+}
+
+static void DecodeI4(u32* dst, const u8* src, int width, int height)
+{
+	for (int y = 0; y < height; y += 8)
+		for (int x = 0; x < width; x += 8)
+			for (int iy = 0; iy < 8; iy += 2, src += 8)
+			{
+				__m128i nibbles = UnpackNibbles(src);
+				__m128i i8 = _mm_or_si128(_mm_slli_epi16(nibbles, 4), nibbles);
+				u32* row = dst + (y + iy) * width + x;
+				_mm256_storeu_si256((__m256i*)row, SplatBytes(i8, 0));
+				_mm256_storeu_si256((__m256i*)(row + width), SplatBytes(i8, 8));
+			}
+}
+
+static void DecodeI8(u32* dst, const u8* src, int width, int height)
+{
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 8)
+			for (int iy = 0; iy < 4; iy += 2, src += 16)
+			{
+				__m128i i8 = _mm_loadu_si128((const __m128i*)src);
+				u32* row = dst + (y + iy) * width + x;
+				_mm256_storeu_si256((__m256i*)row, SplatBytes(i8, 0));
+				_mm256_storeu_si256((__m256i*)(row + width), SplatBytes(i8, 8));
+			}
+}
+
+static void DecodeIA4(u32* dst, const u8* src, int width, int height)
+{
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	// Intensity in the lower 8 bytes, alpha in the upper ones.
+	const __m256i shuffle = _mm256_setr_epi8(
+		0, 0, 0, 8, 1, 1, 1, 9, 2, 2, 2, 10, 3, 3, 3, 11,
+		4, 4, 4, 12, 5, 5, 5, 13, 6, 6, 6, 14, 7, 7, 7, 15);
+
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 8)
+			for (int iy = 0; iy < 4; iy++, src += 8)
+			{
+				__m128i v = _mm_loadl_epi64((const __m128i*)src);
+				__m128i l = _mm_and_si128(v, mask);
+				__m128i a = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+				__m128i la = _mm_unpacklo_epi64(l, a);
+				la = _mm_or_si128(_mm_slli_epi16(la, 4), la);
+				__m256i rgba = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(la), shuffle);
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), rgba);
+			}
+}
+
+static void DecodeIA8(u32* dst, const u8* src, int width, int height)
+{
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 4)
+			for (int iy = 0; iy < 4; iy += 2, src += 16)
+			{
+				__m256i val = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)src));
+				u32* row = dst + (y + iy) * width + x;
+				StoreRows(row, row + width, DecodePixel_IA8(val));
+			}
+}
+
+static void DecodeRGB565(u32* dst, const u8* src, int width, int height)
+{
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 4)
+			for (int iy = 0; iy < 4; iy += 2, src += 16)
+			{
+				u32* row = dst + (y + iy) * width + x;
+				StoreRows(row, row + width, DecodePixel_RGB565(LoadU16BE(src)));
+			}
+}
+
+static void DecodeRGB5A3(u32* dst, const u8* src, int width, int height)
+{
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 4)
+			for (int iy = 0; iy < 4; iy += 2, src += 16)
+			{
+				u32* row = dst + (y + iy) * width + x;
+				StoreRows(row, row + width, DecodePixel_RGB5A3(LoadU16BE(src)));
+			}
+}
+
+static void DecodeRGBA8(u32* dst, const u8* src, int width, int height)
+{
+	// AR and GB pairs interleave to ARGB, rotate that to RGBA.
+	const __m256i rotate = _mm256_setr_epi8(
+		1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+		1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+
+	for (int y = 0; y < height; y += 4)
+		for (int x = 0; x < width; x += 4, src += 64)
+		{
+			// Rows 0 and 1 in the lower lane, 2 and 3 in the upper one.
+			__m256i ar = _mm256_loadu_si256((const __m256i*)src);
+			__m256i gb = _mm256_loadu_si256((const __m256i*)(src + 32));
+			__m256i rows02 = _mm256_shuffle_epi8(_mm256_unpacklo_epi16(ar, gb), rotate);
+			__m256i rows13 = _mm256_shuffle_epi8(_mm256_unpackhi_epi16(ar, gb), rotate);
+
+			u32* row = dst + y * width + x;
+			StoreRows(row, row + 2 * width, rows02);
+			StoreRows(row + width, row + 3 * width, rows13);
+		}
+}
+
+// Computes the third and fourth palette colors of a DXT block for one
+// channel. Even lanes hold color1 of a block and odd lanes color2, other has
+// them the other way around. Matches TextureDecoder_Generic exactly, which
+// doesn't quite use TexDecoder_DecodeTexel's exact thirds.
+static inline __m256i InterpolateDXT(__m256i self, __m256i other, __m256i c1_greater)
+{
+	const __m256i sign = _mm256_setr_epi32(1, -1, 1, -1, 1, -1, 1, -1);
+	// d is color2 - color1 in both lanes of a block.
+	__m256i d = _mm256_sign_epi32(_mm256_sub_epi32(other, self), sign);
+	__m256i t = _mm256_sub_epi32(_mm256_srai_epi32(d, 1), _mm256_srai_epi32(d, 3));
+	__m256i thirds = _mm256_add_epi32(self, _mm256_sign_epi32(t, sign));
+	__m256i average = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(self, other), _mm256_set1_epi32(1)), 1);
+	// Without interpolation, the fourth color is color2 (but transparent).
+	average = _mm256_blend_epi32(average, self, 0xAA);
+	return _mm256_blendv_epi8(average, thirds, c1_greater);
+}
+
+// Decodes the texels of a 4x4 block from its four palette colors.
+static inline void DecodeDXTBlock(u32* dst, const u8* lines, __m128i palette, int pitch)
+{
+	// Every row is one byte of lines with the leftmost texel in the top bits.
+	const __m256i shift01 = _mm256_setr_epi32(6, 4, 2, 0, 14, 12, 10, 8);
+	const __m256i shift23 = _mm256_setr_epi32(22, 20, 18, 16, 30, 28, 26, 24);
+	const __m256i mask = _mm256_set1_epi32(3);
+	__m256i colors = _mm256_broadcastsi128_si256(palette);
+	u32 sel;
+	memcpy(&sel, lines, sizeof(sel));
+	__m256i sel8 = _mm256_set1_epi32((int)sel);
+
+	__m256i rows01 = _mm256_permutevar8x32_epi32(colors, _mm256_and_si256(_mm256_srlv_epi32(sel8, shift01), mask));
+	__m256i rows23 = _mm256_permutevar8x32_epi32(colors, _mm256_and_si256(_mm256_srlv_epi32(sel8, shift23), mask));
+	StoreRows(dst, dst + pitch, rows01);
+	StoreRows(dst + 2 * pitch, dst + 3 * pitch, rows23);
+}
+
+static void DecodeCMPR(u32* dst, const u8* src, int width, int height)
+{
+	// The two big endian colors of each block, one per lane.
+	const __m256i colors_shuffle = _mm256_setr_epi8(
+		1, 0, -1, -1, 3, 2, -1, -1, 9, 8, -1, -1, 11, 10, -1, -1,
+		1, 0, -1, -1, 3, 2, -1, -1, 9, 8, -1, -1, 11, 10, -1, -1);
+	const __m256i even = _mm256_setr_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+
+	// 8x8 tiles of four 8 byte DXT blocks, their palettes are computed together.
+	for (int y = 0; y < height; y += 8)
+		for (int x = 0; x < width; x += 8, src += 32)
+		{
+			__m256i c = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src), colors_shuffle);
+			__m256i c_other = _mm256_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1));
+			__m256i c1_greater = _mm256_shuffle_epi32(_mm256_cmpgt_epi32(c, c_other), _MM_SHUFFLE(2, 2, 0, 0));
+
+			__m256i r = Convert5To8(Field(c, 11, 0x1f));
+			__m256i g = Convert6To8(Field(c, 5, 0x3f));
+			__m256i b = Convert5To8(Field(c, 0, 0x1f));
+			__m256i r_other = _mm256_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1));
+			__m256i g_other = _mm256_shuffle_epi32(g, _MM_SHUFFLE(2, 3, 0, 1));
+			__m256i b_other = _mm256_shuffle_epi32(b, _MM_SHUFFLE(2, 3, 0, 1));
+
+			__m256i alpha = _mm256_and_si256(_mm256_or_si256(c1_greater, even), _mm256_set1_epi32(0xFF));
+			__m256i colors01 = PackRGBA(r, g, b, _mm256_set1_epi32(0xFF));
+			__m256i colors23 = PackRGBA(InterpolateDXT(r, r_other, c1_greater),
+			                            InterpolateDXT(g, g_other, c1_greater),
+			                            InterpolateDXT(b, b_other, c1_greater), alpha);
+
+			// Blocks 0 and 2 in the lower palette lane, 1 and 3 in the upper one.
+			__m256i palettes02 = _mm256_unpacklo_epi64(colors01, colors23);
+			__m256i palettes13 = _mm256_unpackhi_epi64(colors01, colors23);
+
+			u32* tile = dst + y * width + x;
+			DecodeDXTBlock(tile, src + 4, _mm256_castsi256_si128(palettes02), width);
+			DecodeDXTBlock(tile + 4, src + 12, _mm256_castsi256_si128(palettes13), width);
+			DecodeDXTBlock(tile + 4 * width, src + 20, _mm256_extracti128_si256(palettes02, 1), width);
+			DecodeDXTBlock(tile + 4 * width + 4, src + 28, _mm256_extracti128_si256(palettes13, 1), width);
+		}
+}
+
+PC_TexFormat _TexDecoder_DecodeImpl_AVX2(u32 * dst, const u8 * src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt)
+{
+	switch (texformat)
+	{
+	case GX_TF_C4:
+		if (tlutfmt == GX_TL_IA8)
+			DecodeC4<GX_TL_IA8>(dst, src, width, height, tlut);
+		else if (tlutfmt == GX_TL_RGB565)
+			DecodeC4<GX_TL_RGB565>(dst, src, width, height, tlut);
+		else
+			DecodeC4<GX_TL_RGB5A3>(dst, src, width, height, tlut);
+		break;
+	case GX_TF_I4:
+		DecodeI4(dst, src, width, height);
+		break;
+	case GX_TF_I8:
+		DecodeI8(dst, src, width, height);
+		break;
+	case GX_TF_C8:
+		if (tlutfmt == GX_TL_IA8)
+			DecodeC8<GX_TL_IA8>(dst, src, width, height, tlut);
+		else if (tlutfmt == GX_TL_RGB565)
+			DecodeC8<GX_TL_RGB565>(dst, src, width, height, tlut);
+		else
+			DecodeC8<GX_TL_RGB5A3>(dst, src, width, height, tlut);
+		break;
+	case GX_TF_IA4:
+		DecodeIA4(dst, src, width, height);
+		break;
+	case GX_TF_IA8:
+		DecodeIA8(dst, src, width, height);
+		break;
+	case GX_TF_C14X2:
+		if (tlutfmt == GX_TL_IA8)
+			DecodeC14X2<GX_TL_IA8>(dst, src, width, height, tlut);
+		else if (tlutfmt == GX_TL_RGB565)
+			DecodeC14X2<GX_TL_RGB565>(dst, src, width, height, tlut);
+		else
+			DecodeC14X2<GX_TL_RGB5A3>(dst, src, width, height, tlut);
+		break;
+	case GX_TF_RGB565:
+		DecodeRGB565(dst, src, width, height);
+		break;
+	case GX_TF_RGB5A3:
+		DecodeRGB5A3(dst, src, width, height);
+		break;
+	case GX_TF_RGBA8:
+		DecodeRGBA8(dst, src, width, height);
+		break;
+	case GX_TF_CMPR:
+		DecodeCMPR(dst, src, width, height);
+		break;
+	}
+
+	return PC_TEX_FMT_RGBA32;
+}
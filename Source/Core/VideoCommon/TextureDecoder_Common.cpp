@@ -2,9 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <atomic>
 #include <cmath>
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 
 #include "VideoCommon/LookUpTables.h"
 #include "VideoCommon/sfont.inc"
@@ -246,9 +248,32 @@ static void TexDecoder_DrawOverlay(u8 *dst, int width, int height, int texformat
 	}
 }
 
+typedef PC_TexFormat (*DecodeImplFunc)(u32* dst, const u8* src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+
+static PC_TexFormat SelectDecodeImpl(u32* dst, const u8* src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+
+// Starts out pointing at SelectDecodeImpl, which replaces it on the first
+// call. cpu_info can't be used to initialize it directly since it might not
+// have been constructed yet. Textures are decoded on several threads at once,
+// so the first call can happen on more than one of them; they all store the
+// same decoder.
+static std::atomic<DecodeImplFunc> s_decode_impl(SelectDecodeImpl);
+
+static PC_TexFormat SelectDecodeImpl(u32* dst, const u8* src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt)
+{
+#ifdef _M_X86
+	DecodeImplFunc impl = cpu_info.bAVX2 ? _TexDecoder_DecodeImpl_AVX2 : _TexDecoder_DecodeImpl_x64;
+#else
+	DecodeImplFunc impl = _TexDecoder_DecodeImpl_Generic;
+#endif
+	s_decode_impl.store(impl, std::memory_order_relaxed);
+	return impl(dst, src, width, height, texformat, tlut, tlutfmt);
+}
+
 PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt)
 {
-	PC_TexFormat pc_texformat = _TexDecoder_DecodeImpl((u32*)dst, src, width, height, texformat, tlut, tlutfmt);
+	DecodeImplFunc decode = s_decode_impl.load(std::memory_order_relaxed);
+	PC_TexFormat pc_texformat = decode((u32*)dst, src, width, height, texformat, tlut, tlutfmt);
 
 	if (TexFmt_Overlay_Enable && pc_texformat != PC_TEX_FMT_NONE)
 		TexDecoder_DrawOverlay(dst, width, height, texformat, pc_texformat);
@@ -2,12 +2,20 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
 #include <vector>
 
 #include "Common/StringUtil.h"
 
 #include "VideoCommon/VertexLoader.h"
 #include "VideoCommon/VertexLoaderBase.h"
+#include "VideoCommon/VideoConfig.h"
+
+#ifdef _M_X86
+#include "VideoCommon/VertexLoaderX64.h"
+#endif
 
 VertexLoaderBase::VertexLoaderBase(const TVtxDesc &vtx_desc, const VAT &vtx_attr)
 {
@@ -126,7 +134,7 @@ void VertexLoaderBase::AppendToString(std::string *dest) const
 	dest->append(StringFromFormat(" - %i v\n", m_numLoadedVertices));
 }
 
-// a hacky implementation to compare two vertex loaders
+// Runs two vertex loaders on the same input and complains when their output differs.
 class VertexLoaderTester : public VertexLoaderBase
 {
 public:
@@ -136,8 +144,28 @@ public:
 		a = _a;
 		b = _b;
 		m_initialized = a && b && a->IsInitialized() && b->IsInitialized();
-		m_initialized = m_initialized && (a->m_VertexSize == b->m_VertexSize);
-		m_initialized = m_initialized && (a->m_native_vtx_decl.stride == b->m_native_vtx_decl.stride);
+
+		if (m_initialized)
+		{
+			m_initialized = a->m_VertexSize == b->m_VertexSize &&
+			                a->m_native_components == b->m_native_components &&
+			                !memcmp(&a->m_native_vtx_decl, &b->m_native_vtx_decl, sizeof(PortableVertexDeclaration));
+
+			if (m_initialized)
+			{
+				m_VertexSize = a->m_VertexSize;
+				m_native_vtx_decl = a->m_native_vtx_decl;
+				m_native_components = a->m_native_components;
+			}
+			else
+			{
+				ERROR_LOG(VIDEO, "Can't compare vertex loaders that expect different vertex formats!");
+				ERROR_LOG(VIDEO, "a: m_VertexSize %d, m_native_components 0x%08x, stride %d",
+				          a->m_VertexSize, a->m_native_components, a->m_native_vtx_decl.stride);
+				ERROR_LOG(VIDEO, "b: m_VertexSize %d, m_native_components 0x%08x, stride %d",
+				          b->m_VertexSize, b->m_native_components, b->m_native_vtx_decl.stride);
+			}
+		}
 	}
 	~VertexLoaderTester()
 	{
@@ -147,21 +175,28 @@ public:
 
 	int RunVertices(int primitive, int count, DataReader src, DataReader dst) override
 	{
-		buffer_a.resize(count * a->m_native_vtx_decl.stride);
-		buffer_b.resize(count * b->m_native_vtx_decl.stride);
+		buffer_a.resize(count * a->m_native_vtx_decl.stride + 4);
+		buffer_b.resize(count * b->m_native_vtx_decl.stride + 4);
 
 		int count_a = a->RunVertices(primitive, count, src, DataReader(buffer_a.data(), buffer_a.data()+buffer_a.size()));
 		int count_b = b->RunVertices(primitive, count, src, DataReader(buffer_b.data(), buffer_b.data()+buffer_b.size()));
 
 		if (count_a != count_b)
-			ERROR_LOG(VIDEO, "Both vertexloaders have loaded a different amount of vertices.");
+			ERROR_LOG(VIDEO, "The two vertex loaders have loaded a different amount of vertices (a: %d, b: %d).", count_a, count_b);
 
-		if (memcmp(buffer_a.data(), buffer_b.data(), std::min(count_a, count_b)))
-			ERROR_LOG(VIDEO, "Both vertexloaders have loaded different data.");
+		if (memcmp(buffer_a.data(), buffer_b.data(), std::min(count_a, count_b) * m_native_vtx_decl.stride))
+		{
+			std::string name;
+			AppendToString(&name);
+			ERROR_LOG(VIDEO, "The two vertex loaders have loaded different data "
+			                 "(guru meditation 0x%016" PRIx64 ", 0x%08x, 0x%08x, 0x%08x): %s",
+			          m_VtxDesc.Hex, m_vat.g0.Hex, m_vat.g1.Hex, m_vat.g2.Hex, name.c_str());
+		}
 
 		u8* dstptr;
 		dst.WritePointer(&dstptr);
-		memcpy(dstptr, buffer_a.data(), count_a);
+		memcpy(dstptr, buffer_a.data(), count_a * m_native_vtx_decl.stride);
+		m_numLoadedVertices += count;
 		return count_a;
 	}
 	std::string GetName() const override { return "CompareLoader"; }
@@ -177,15 +212,28 @@ VertexLoaderBase* VertexLoaderBase::CreateVertexLoader(const TVtxDesc& vtx_desc,
 {
 	VertexLoaderBase* loader;
 
-#if 0
-	// first try: Any new VertexLoader vs the old one
-	loader = new VertexLoaderTester(
-			new VertexLoader(vtx_desc, vtx_attr), // the software one
-			new VertexLoader(vtx_desc, vtx_attr), // the new one to compare
-			vtx_desc, vtx_attr);
-	if (loader->IsInitialized())
-		return loader;
-	delete loader;
+#ifdef _M_X86
+	// VertexLoaderX64 doesn't emulate the bounding box on the CPU, leave that to VertexLoader.
+	if (g_ActiveConfig.backend_info.bSupportsBBox)
+	{
+		// first try: VertexLoaderX64 checked against the old one
+		if (g_ActiveConfig.bVertexLoaderLockstep)
+		{
+			loader = new VertexLoaderTester(
+					new VertexLoader(vtx_desc, vtx_attr), // the software one
+					new VertexLoaderX64(vtx_desc, vtx_attr), // the new one to compare
+					vtx_desc, vtx_attr);
+			if (loader->IsInitialized())
+				return loader;
+			delete loader;
+		}
+
+		// second try: the direct-codegen one
+		loader = new VertexLoaderX64(vtx_desc, vtx_attr);
+		if (loader->IsInitialized())
+			return loader;
+		delete loader;
+	}
 #endif
 
 	// last try: The old VertexLoader
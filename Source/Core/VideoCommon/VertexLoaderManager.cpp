@@ -14,6 +14,7 @@
 
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/IndexGenerator.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderBase.h"
 #include "VideoCommon/VertexLoaderManager.h"
@@ -202,12 +203,16 @@ void LoadCPReg(u32 sub_cmd, u32 value, bool is_preprocess)
 		state->vtx_desc.Hex &= ~0x1FFFF;  // keep the Upper bits
 		state->vtx_desc.Hex |= value;
 		state->attr_dirty = BitSet32::AllTrue(8);
+		if (update_global_state)
+			InvalidateShaderUids();
 		break;
 
 	case 0x60:
 		state->vtx_desc.Hex &= 0x1FFFF;  // keep the lower 17Bits
 		state->vtx_desc.Hex |= (u64)value << 17;
 		state->attr_dirty = BitSet32::AllTrue(8);
+		if (update_global_state)
+			InvalidateShaderUids();
 		break;
 
 	case 0x70:
@@ -0,0 +1,657 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstddef>
+#include <cstring>
+
+#include "Common/Common.h"
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/x64ABI.h"
+#include "Common/x64Emitter.h"
+
+#include "VideoCommon/VertexLoaderX64.h"
+#include "VideoCommon/VideoCommon.h"
+
+using namespace Gen;
+
+static const int CODE_SIZE = 8192;
+// The shuffle masks and scales live at the start of the code space so that
+// they can be addressed RIP-relative.
+static const int MAX_CONSTANTS = 32;
+static const int CONSTANT_AREA_SIZE = MAX_CONSTANTS * 16;
+
+static const X64Reg src_reg = ABI_PARAM1;
+static const X64Reg dst_reg = ABI_PARAM2;
+static const X64Reg count_reg = ABI_PARAM3;
+static const X64Reg base_reg = ABI_PARAM4;
+static const X64Reg skipped_reg = ABI_RETURN;
+static const X64Reg scratch1 = R10;
+static const X64Reg scratch2 = R11;
+static const X64Reg scratch3 = RBX;
+
+static int GetFormatSize(int format)
+{
+	switch (format)
+	{
+	case FORMAT_UBYTE:
+	case FORMAT_BYTE:
+		return 1;
+	case FORMAT_USHORT:
+	case FORMAT_SHORT:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+static int GetColorSize(int format)
+{
+	static const int sizes[] = { 2, 3, 4, 2, 3, 4 };
+	return sizes[format];
+}
+
+static int GetIndexSize(u64 attribute)
+{
+	return attribute == INDEX16 ? 2 : 1;
+}
+
+VertexLoaderX64::VertexLoaderX64(const TVtxDesc& vtx_desc, const VAT& vtx_attr)
+: VertexLoaderBase(vtx_desc, vtx_attr)
+{
+	m_initialized = false;
+	m_compiled_code = nullptr;
+	m_constants = nullptr;
+	m_num_constants = 0;
+	memset(&m_arrays, 0, sizeof(m_arrays));
+
+	if (!IsSupported())
+		return;
+
+	ComputeLayout();
+
+	AllocCodeSpace(CODE_SIZE);
+	m_constants = GetWritableCodePtr();
+	SetCodePtr(m_constants + CONSTANT_AREA_SIZE);
+	m_compiled_code = (CompiledFunction)GetCodePtr();
+	GenerateVertexLoader();
+	WriteProtect();
+
+	m_initialized = true;
+}
+
+bool VertexLoaderX64::IsSupported() const
+{
+	if (!cpu_info.bSSSE3)
+		return false;
+
+	// Leave broken formats to VertexLoader, which handles them however it does.
+	if (m_VtxDesc.Position == NOT_PRESENT || m_VtxAttr.PosFormat > FORMAT_FLOAT)
+		return false;
+	if (m_VtxDesc.Normal != NOT_PRESENT && m_VtxAttr.NormalFormat > FORMAT_FLOAT)
+		return false;
+
+	const u64 col[2] = { m_VtxDesc.Color0, m_VtxDesc.Color1 };
+	for (int i = 0; i < 2; i++)
+	{
+		if (col[i] != NOT_PRESENT && m_VtxAttr.color[i].Comp > FORMAT_32B_8888)
+			return false;
+	}
+
+	const u64 tc[8] = {
+		m_VtxDesc.Tex0Coord, m_VtxDesc.Tex1Coord, m_VtxDesc.Tex2Coord, m_VtxDesc.Tex3Coord,
+		m_VtxDesc.Tex4Coord, m_VtxDesc.Tex5Coord, m_VtxDesc.Tex6Coord, m_VtxDesc.Tex7Coord
+	};
+	for (int i = 0; i < 8; i++)
+	{
+		if (tc[i] != NOT_PRESENT && m_VtxAttr.texCoord[i].Format > FORMAT_FLOAT)
+			return false;
+	}
+
+	return true;
+}
+
+// This must produce exactly the same native format as
+// VertexLoader::CompileVertexTranslator.
+void VertexLoaderX64::ComputeLayout()
+{
+	const u64 col[2] = { m_VtxDesc.Color0, m_VtxDesc.Color1 };
+	const u64 tc[8] = {
+		m_VtxDesc.Tex0Coord, m_VtxDesc.Tex1Coord, m_VtxDesc.Tex2Coord, m_VtxDesc.Tex3Coord,
+		m_VtxDesc.Tex4Coord, m_VtxDesc.Tex5Coord, m_VtxDesc.Tex6Coord, m_VtxDesc.Tex7Coord
+	};
+
+	u32 components = 0;
+	int nat_offset = 0;
+	m_VertexSize = 0;
+	memset(&m_native_vtx_decl, 0, sizeof(m_native_vtx_decl));
+
+	if (m_VtxDesc.PosMatIdx)
+	{
+		components |= VB_HAS_POSMTXIDX;
+		m_VertexSize += 1;
+	}
+
+	for (int i = 0; i < 8; i++)
+	{
+		if ((m_VtxDesc.Hex >> (1 + i)) & 1)
+		{
+			components |= VB_HAS_TEXMTXIDX0 << i;
+			m_VertexSize += 1;
+		}
+	}
+
+	if (m_VtxDesc.Position == DIRECT)
+		m_VertexSize += GetFormatSize(m_VtxAttr.PosFormat) * (m_VtxAttr.PosElements ? 3 : 2);
+	else
+		m_VertexSize += GetIndexSize(m_VtxDesc.Position);
+	nat_offset += 12;
+	m_native_vtx_decl.position.components = 3;
+	m_native_vtx_decl.position.enable = true;
+	m_native_vtx_decl.position.offset = 0;
+	m_native_vtx_decl.position.type = VAR_FLOAT;
+	m_native_vtx_decl.position.integer = false;
+
+	if (m_VtxDesc.Normal != NOT_PRESENT)
+	{
+		const int groups = m_VtxAttr.NormalElements ? 3 : 1;
+		if (m_VtxDesc.Normal == DIRECT)
+			m_VertexSize += GetFormatSize(m_VtxAttr.NormalFormat) * 3 * groups;
+		else if (m_VtxAttr.NormalIndex3 && m_VtxAttr.NormalElements)
+			m_VertexSize += GetIndexSize(m_VtxDesc.Normal) * 3;
+		else
+			m_VertexSize += GetIndexSize(m_VtxDesc.Normal);
+
+		for (int i = 0; i < groups; i++)
+		{
+			m_native_vtx_decl.normals[i].components = 3;
+			m_native_vtx_decl.normals[i].enable = true;
+			m_native_vtx_decl.normals[i].offset = nat_offset;
+			m_native_vtx_decl.normals[i].type = VAR_FLOAT;
+			m_native_vtx_decl.normals[i].integer = false;
+			nat_offset += 12;
+		}
+
+		components |= VB_HAS_NRM0;
+		if (m_VtxAttr.NormalElements == 1)
+			components |= VB_HAS_NRM1 | VB_HAS_NRM2;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		m_native_vtx_decl.colors[i].components = 4;
+		m_native_vtx_decl.colors[i].type = VAR_UNSIGNED_BYTE;
+		m_native_vtx_decl.colors[i].integer = false;
+		if (col[i] == NOT_PRESENT)
+			continue;
+
+		if (col[i] == DIRECT)
+			m_VertexSize += GetColorSize(m_VtxAttr.color[i].Comp);
+		else
+			m_VertexSize += GetIndexSize(col[i]);
+
+		components |= VB_HAS_COL0 << i;
+		m_native_vtx_decl.colors[i].offset = nat_offset;
+		m_native_vtx_decl.colors[i].enable = true;
+		nat_offset += 4;
+	}
+
+	for (int i = 0; i < 8; i++)
+	{
+		m_native_vtx_decl.texcoords[i].offset = nat_offset;
+		m_native_vtx_decl.texcoords[i].type = VAR_FLOAT;
+		m_native_vtx_decl.texcoords[i].integer = false;
+
+		const int elements = m_VtxAttr.texCoord[i].Elements ? 2 : 1;
+		if (tc[i] == NOT_PRESENT)
+		{
+			components &= ~(VB_HAS_UV0 << i);
+		}
+		else
+		{
+			components |= VB_HAS_UV0 << i;
+			if (tc[i] == DIRECT)
+				m_VertexSize += GetFormatSize(m_VtxAttr.texCoord[i].Format) * elements;
+			else
+				m_VertexSize += GetIndexSize(tc[i]);
+		}
+
+		if (components & (VB_HAS_TEXMTXIDX0 << i))
+		{
+			m_native_vtx_decl.texcoords[i].enable = true;
+			if (tc[i] != NOT_PRESENT)
+			{
+				// The matrix index goes into z.
+				m_native_vtx_decl.texcoords[i].components = 3;
+				nat_offset += 12;
+			}
+			else
+			{
+				components |= VB_HAS_UV0 << i;
+				m_native_vtx_decl.texcoords[i].components = 4;
+				nat_offset += 16;
+			}
+		}
+		else if (tc[i] != NOT_PRESENT)
+		{
+			m_native_vtx_decl.texcoords[i].enable = true;
+			m_native_vtx_decl.texcoords[i].components = elements;
+			nat_offset += 4 * elements;
+		}
+
+		if (tc[i] == NOT_PRESENT)
+		{
+			int j = i + 1;
+			while (j < 8 && tc[j] == NOT_PRESENT)
+				j++;
+			// Nothing left to load, stop like VertexLoader does.
+			if (j == 8 && !((components & VB_HAS_TEXMTXIDXALL) & (VB_HAS_TEXMTXIDXALL << (i + 1))))
+				break;
+		}
+	}
+
+	if (m_VtxDesc.PosMatIdx)
+	{
+		m_native_vtx_decl.posmtx.components = 4;
+		m_native_vtx_decl.posmtx.enable = true;
+		m_native_vtx_decl.posmtx.offset = nat_offset;
+		m_native_vtx_decl.posmtx.type = VAR_UNSIGNED_BYTE;
+		m_native_vtx_decl.posmtx.integer = true;
+		nat_offset += 4;
+	}
+
+	m_native_components = components;
+	m_native_vtx_decl.stride = nat_offset;
+}
+
+const void* VertexLoaderX64::GetConstant(const void* data)
+{
+	for (int i = 0; i < m_num_constants; i++)
+	{
+		if (!memcmp(m_constants + i * 16, data, 16))
+			return m_constants + i * 16;
+	}
+
+	_assert_msg_(VIDEO, m_num_constants < MAX_CONSTANTS, "Vertex loader constant area is full");
+	u8* constant = m_constants + m_num_constants++ * 16;
+	memcpy(constant, data, 16);
+	return constant;
+}
+
+// Byte swaps each component into the top of its own 32-bit lane, so that a
+// single shift both sign or zero extends it. Unused lanes become zero.
+const void* VertexLoaderX64::GetShuffleMask(int format, int count)
+{
+	const int size = GetFormatSize(format);
+	u8 mask[16];
+	memset(mask, 0x80, sizeof(mask));
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < size; j++)
+			mask[i * 4 + 3 - j] = i * size + j;
+	}
+	return GetConstant(mask);
+}
+
+const void* VertexLoaderX64::GetScale(float scale)
+{
+	const float data[4] = { scale, scale, scale, scale };
+	return GetConstant(data);
+}
+
+// Leaves a pointer to the element selected by the index at src_offset in scratch1.
+void VertexLoaderX64::LoadIndexedAddress(int array, u64 attribute, int src_offset)
+{
+	const int index_size = GetIndexSize(attribute);
+	MOVZX(32, index_size * 8, scratch1, MDisp(src_reg, src_offset));
+	if (index_size == 2)
+		ROL(16, R(scratch1), Imm8(8));
+	IMUL(32, scratch1, MDisp(base_reg, (int)offsetof(ArrayData, strides) + array * sizeof(u32)));
+	ADD(64, R(scratch1), MDisp(base_reg, (int)offsetof(ArrayData, bases) + array * sizeof(u8*)));
+}
+
+// Loads count components into XMM0 as floats, with the unused lanes zeroed.
+// This reads up to a whole 16 bytes, like the SSSE3 paths of VertexLoader.
+void VertexLoaderX64::ReadAttribute(OpArg data, int format, int count, float scale)
+{
+	const int bytes = GetFormatSize(format) * count;
+	if (bytes <= 4)
+		MOVD_xmm(XMM0, data);
+	else if (bytes <= 8)
+		MOVQ_xmm(XMM0, data);
+	else
+		MOVUPS(XMM0, data);
+
+	PSHUFB(XMM0, M(GetShuffleMask(format, count)));
+
+	if (format == FORMAT_FLOAT)
+		return;
+
+	const int shift = 32 - 8 * GetFormatSize(format);
+	if (format == FORMAT_BYTE || format == FORMAT_SHORT)
+		PSRAD(XMM0, shift);
+	else
+		PSRLD(XMM0, shift);
+	CVTDQ2PS(XMM0, R(XMM0));
+	if (scale != 1.0f)
+		MULPS(XMM0, M(GetScale(scale)));
+}
+
+void VertexLoaderX64::WriteFloats(int count, int dst_offset)
+{
+	switch (count)
+	{
+	case 1:
+		MOVSS(MDisp(dst_reg, dst_offset), XMM0);
+		break;
+	case 2:
+		MOVQ_xmm(MDisp(dst_reg, dst_offset), XMM0);
+		break;
+	case 3:
+		// Attributes are written in order, so a zero spilling into the next
+		// one gets overwritten. Only the end of the vertex needs exact stores.
+		if (dst_offset + 16 <= m_native_vtx_decl.stride)
+		{
+			MOVUPS(MDisp(dst_reg, dst_offset), XMM0);
+		}
+		else
+		{
+			MOVQ_xmm(MDisp(dst_reg, dst_offset), XMM0);
+			MOVHLPS(XMM1, XMM0);
+			MOVSS(MDisp(dst_reg, dst_offset + 8), XMM1);
+		}
+		break;
+	}
+}
+
+// Converts a color to RGBA8 using the same bit twiddling as VertexLoader_Color.
+void VertexLoaderX64::ReadColor(OpArg data, int format, bool kill_alpha, int dst_offset)
+{
+	const X64Reg val = scratch2;
+	const X64Reg col = scratch3;
+	const X64Reg tmp = scratch1;
+
+	switch (format)
+	{
+	case FORMAT_24B_888:
+	case FORMAT_32B_888x:
+		MOV(32, R(col), data);
+		OR(32, R(col), Imm32(0xFF000000));
+		break;
+
+	case FORMAT_32B_8888:
+		MOV(32, R(col), data);
+		if (kill_alpha)
+			OR(32, R(col), Imm32(0xFF000000));
+		break;
+
+	case FORMAT_16B_565:
+		// RRRRRGGG GGGBBBBB
+		MOVZX(32, 16, val, data);
+		ROL(16, R(val), Imm8(8));
+		MOV(32, R(col), R(val));
+		SHR(32, R(col), Imm8(8));
+		AND(32, R(col), Imm32(0xF8));
+		MOV(32, R(tmp), R(val));
+		SHL(32, R(tmp), Imm8(5));
+		AND(32, R(tmp), Imm32(0xFC00));
+		OR(32, R(col), R(tmp));
+		SHL(32, R(val), Imm8(19));
+		AND(32, R(val), Imm32(0xF80000));
+		OR(32, R(col), R(val));
+		MOV(32, R(tmp), R(col));
+		SHR(32, R(tmp), Imm8(5));
+		AND(32, R(tmp), Imm32(0x070007));
+		OR(32, R(col), R(tmp));
+		MOV(32, R(tmp), R(col));
+		SHR(32, R(tmp), Imm8(6));
+		AND(32, R(tmp), Imm32(0x000300));
+		OR(32, R(col), R(tmp));
+		OR(32, R(col), Imm32(0xFF000000));
+		break;
+
+	case FORMAT_16B_4444:
+		// Read without swapping: the halves are BA and RG.
+		MOVZX(32, 16, val, data);
+		MOV(32, R(col), R(val));
+		AND(32, R(col), Imm32(0xF0));
+		MOV(32, R(tmp), R(val));
+		AND(32, R(tmp), Imm32(0xF));
+		SHL(32, R(tmp), Imm8(12));
+		OR(32, R(col), R(tmp));
+		MOV(32, R(tmp), R(val));
+		AND(32, R(tmp), Imm32(0xF000));
+		SHL(32, R(tmp), Imm8(8));
+		OR(32, R(col), R(tmp));
+		AND(32, R(val), Imm32(0x0F00));
+		SHL(32, R(val), Imm8(20));
+		OR(32, R(col), R(val));
+		MOV(32, R(tmp), R(col));
+		SHR(32, R(tmp), Imm8(4));
+		OR(32, R(col), R(tmp));
+		break;
+
+	case FORMAT_24B_6666:
+		// RRRRRRGG GGGGBBBB BBAAAAAA
+		MOV(32, R(val), data);
+		BSWAP(32, val);
+		SHR(32, R(val), Imm8(8));
+		MOV(32, R(col), R(val));
+		SHR(32, R(col), Imm8(16));
+		AND(32, R(col), Imm32(0xFC));
+		MOV(32, R(tmp), R(val));
+		SHR(32, R(tmp), Imm8(2));
+		AND(32, R(tmp), Imm32(0xFC00));
+		OR(32, R(col), R(tmp));
+		MOV(32, R(tmp), R(val));
+		SHL(32, R(tmp), Imm8(12));
+		AND(32, R(tmp), Imm32(0xFC0000));
+		OR(32, R(col), R(tmp));
+		SHL(32, R(val), Imm8(26));
+		OR(32, R(col), R(val));
+		MOV(32, R(tmp), R(col));
+		SHR(32, R(tmp), Imm8(6));
+		AND(32, R(tmp), Imm32(0x03030303));
+		OR(32, R(col), R(tmp));
+		break;
+	}
+
+	MOV(32, MDisp(dst_reg, dst_offset), R(col));
+}
+
+void VertexLoaderX64::GenerateVertexLoader()
+{
+	ABI_PushRegistersAndAdjustStack({scratch3}, 8);
+	XOR(32, R(skipped_reg), R(skipped_reg));
+
+	const u8* loop_start = GetCodePtr();
+
+	// The matrix indices come first in the input, but are written out along
+	// with the texture coordinates and at the end of the vertex.
+	int src_offset = 0;
+	if (m_VtxDesc.PosMatIdx)
+		src_offset++;
+	int texmtx_offset[8];
+	for (int i = 0; i < 8; i++)
+		texmtx_offset[i] = ((m_VtxDesc.Hex >> (1 + i)) & 1) ? src_offset++ : -1;
+
+	// Position
+	const int pos_offset = src_offset;
+	const int pos_format = m_VtxAttr.PosFormat;
+	const float pos_scale = pos_format == FORMAT_FLOAT ? 1.0f : 1.0f / (1U << m_VtxAttr.PosFrac);
+	if (m_VtxDesc.Position == DIRECT)
+	{
+		const int elements = m_VtxAttr.PosElements ? 3 : 2;
+		ReadAttribute(MDisp(src_reg, src_offset), pos_format, elements, pos_scale);
+		src_offset += GetFormatSize(pos_format) * elements;
+	}
+	else
+	{
+		LoadIndexedAddress(ARRAY_POSITION, m_VtxDesc.Position, src_offset);
+		ReadAttribute(MatR(scratch1), pos_format, m_VtxAttr.PosElements ? 3 : 2, pos_scale);
+		src_offset += GetIndexSize(m_VtxDesc.Position);
+	}
+	WriteFloats(3, m_native_vtx_decl.position.offset);
+
+	// Normals
+	if (m_VtxDesc.Normal != NOT_PRESENT)
+	{
+		const int format = m_VtxAttr.NormalFormat;
+		const int size = GetFormatSize(format);
+		const bool is_signed = format == FORMAT_BYTE || format == FORMAT_SHORT;
+		const float scale = format == FORMAT_FLOAT ? 1.0f : 1.0f / (1U << (size * 8 - is_signed - 1));
+		const int groups = m_VtxAttr.NormalElements ? 3 : 1;
+		const bool index3 = m_VtxAttr.NormalIndex3 && m_VtxAttr.NormalElements;
+
+		for (int i = 0; i < groups; i++)
+		{
+			if (m_VtxDesc.Normal == DIRECT)
+			{
+				ReadAttribute(MDisp(src_reg, src_offset + i * 3 * size), format, 3, scale);
+			}
+			else
+			{
+				if (i == 0 || index3)
+					LoadIndexedAddress(ARRAY_NORMAL, m_VtxDesc.Normal, src_offset + i * GetIndexSize(m_VtxDesc.Normal));
+				ReadAttribute(MDisp(scratch1, i * 3 * size), format, 3, scale);
+			}
+			WriteFloats(3, m_native_vtx_decl.normals[i].offset);
+		}
+
+		if (m_VtxDesc.Normal == DIRECT)
+			src_offset += size * 3 * groups;
+		else
+			src_offset += GetIndexSize(m_VtxDesc.Normal) * (index3 ? 3 : 1);
+	}
+
+	// Colors. VertexLoader picks the array and the alpha flag by how many colors
+	// came before rather than by the slot, so a lone Color1 uses Color0's; match it.
+	const u64 col[2] = { m_VtxDesc.Color0, m_VtxDesc.Color1 };
+	int col_index = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		if (col[i] == NOT_PRESENT)
+			continue;
+
+		const int format = m_VtxAttr.color[i].Comp;
+		if (col[i] == DIRECT)
+		{
+			const bool kill_alpha = format == FORMAT_32B_8888 && !m_VtxAttr.color[col_index].Elements;
+			ReadColor(MDisp(src_reg, src_offset), format, kill_alpha, m_native_vtx_decl.colors[i].offset);
+			src_offset += GetColorSize(format);
+		}
+		else
+		{
+			LoadIndexedAddress(ARRAY_COLOR + col_index, col[i], src_offset);
+			ReadColor(MatR(scratch1), format, false, m_native_vtx_decl.colors[i].offset);
+			src_offset += GetIndexSize(col[i]);
+		}
+		col_index++;
+	}
+
+	// Texture coordinates and matrix indices
+	const u64 tc[8] = {
+		m_VtxDesc.Tex0Coord, m_VtxDesc.Tex1Coord, m_VtxDesc.Tex2Coord, m_VtxDesc.Tex3Coord,
+		m_VtxDesc.Tex4Coord, m_VtxDesc.Tex5Coord, m_VtxDesc.Tex6Coord, m_VtxDesc.Tex7Coord
+	};
+	for (int i = 0; i < 8; i++)
+	{
+		const int dst_offset = m_native_vtx_decl.texcoords[i].offset;
+
+		if (tc[i] != NOT_PRESENT)
+		{
+			const int format = m_VtxAttr.texCoord[i].Format;
+			const int elements = m_VtxAttr.texCoord[i].Elements ? 2 : 1;
+			const float scale = format == FORMAT_FLOAT ? 1.0f : 1.0f / (1U << m_VtxAttr.texCoord[i].Frac);
+			if (tc[i] == DIRECT)
+			{
+				ReadAttribute(MDisp(src_reg, src_offset), format, elements, scale);
+				src_offset += GetFormatSize(format) * elements;
+			}
+			else
+			{
+				LoadIndexedAddress(ARRAY_TEXCOORD0 + i, tc[i], src_offset);
+				ReadAttribute(MatR(scratch1), format, elements, scale);
+				src_offset += GetIndexSize(tc[i]);
+			}
+
+			if (texmtx_offset[i] >= 0)
+			{
+				// s, t (or 0), matrix index
+				MOVQ_xmm(MDisp(dst_reg, dst_offset), XMM0);
+				MOVZX(32, 8, scratch1, MDisp(src_reg, texmtx_offset[i]));
+				AND(32, R(scratch1), Imm8(0x3F));
+				CVTSI2SS(XMM1, R(scratch1));
+				MOVSS(MDisp(dst_reg, dst_offset + 8), XMM1);
+			}
+			else
+			{
+				WriteFloats(elements, dst_offset);
+			}
+		}
+		else if (texmtx_offset[i] >= 0)
+		{
+			// 0, 0, matrix index, 0
+			MOVZX(32, 8, scratch1, MDisp(src_reg, texmtx_offset[i]));
+			AND(32, R(scratch1), Imm8(0x3F));
+			XORPS(XMM0, R(XMM0));
+			CVTSI2SS(XMM0, R(scratch1));
+			PSHUFD(XMM0, R(XMM0), 0x45);
+			MOVUPS(MDisp(dst_reg, dst_offset), XMM0);
+		}
+	}
+
+	if (m_VtxDesc.PosMatIdx)
+	{
+		MOVZX(32, 8, scratch1, MDisp(src_reg, 0));
+		AND(32, R(scratch1), Imm8(0x3F));
+		MOV(32, MDisp(dst_reg, m_native_vtx_decl.posmtx.offset), R(scratch1));
+	}
+
+	_assert_msg_(VIDEO, src_offset == m_VertexSize, "Vertex loader read %d bytes of a %d byte vertex", src_offset, m_VertexSize);
+
+	// An all-ones position index drops the vertex: don't advance the output.
+	if (m_VtxDesc.Position != DIRECT)
+	{
+		const int index_size = GetIndexSize(m_VtxDesc.Position);
+		MOVZX(32, index_size * 8, scratch1, MDisp(src_reg, pos_offset));
+		CMP(32, R(scratch1), Imm32(index_size == 2 ? 0xFFFF : 0xFF));
+		FixupBranch skip = J_CC(CC_E);
+		ADD(64, R(dst_reg), Imm32(m_native_vtx_decl.stride));
+		FixupBranch next = J();
+		SetJumpTarget(skip);
+		ADD(32, R(skipped_reg), Imm8(1));
+		SetJumpTarget(next);
+	}
+	else
+	{
+		ADD(64, R(dst_reg), Imm32(m_native_vtx_decl.stride));
+	}
+
+	ADD(64, R(src_reg), Imm32(m_VertexSize));
+	SUB(32, R(count_reg), Imm8(1));
+	J_CC(CC_NZ, loop_start);
+
+	ABI_PopRegistersAndAdjustStack({scratch3}, 8);
+	RET();
+}
+
+int VertexLoaderX64::RunVertices(int primitive, int count, DataReader src, DataReader dst)
+{
+	m_numLoadedVertices += count;
+	if (count <= 0)
+		return 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		m_arrays.bases[i] = cached_arraybases[i];
+		m_arrays.strides[i] = g_main_cp_state.array_strides[i];
+	}
+
+	u8* src_ptr;
+	u8* dst_ptr;
+	src.WritePointer(&src_ptr);
+	dst.WritePointer(&dst_ptr);
+	return count - m_compiled_code(src_ptr, dst_ptr, count, &m_arrays);
+}
@@ -0,0 +1,58 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+#include "Common/x64Emitter.h"
+
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/VertexLoaderBase.h"
+
+// Compiles each vertex format into a single straight-line SSE loop. Unlike
+// VertexLoader there are no calls per attribute: every component is loaded,
+// byte swapped, converted and stored directly from registers.
+class VertexLoaderX64 : public Gen::X64CodeBlock, public VertexLoaderBase
+{
+public:
+	VertexLoaderX64(const TVtxDesc& vtx_desc, const VAT& vtx_attr);
+
+	int RunVertices(int primitive, int count, DataReader src, DataReader dst) override;
+	std::string GetName() const override { return "VertexLoaderX64"; }
+	bool IsInitialized() override { return m_initialized; }
+
+private:
+	// The vertex arrays are copied here before every run, and the compiled
+	// code reads them relative to a register.
+	struct ArrayData
+	{
+		u8* bases[16];
+		u32 strides[16];
+	};
+
+	typedef int (*CompiledFunction)(u8* src, u8* dst, int count, const ArrayData* arrays);
+
+	bool IsSupported() const;
+	void ComputeLayout();
+	void GenerateVertexLoader();
+
+	const void* GetConstant(const void* data);
+	const void* GetShuffleMask(int format, int count);
+	const void* GetScale(float scale);
+
+	void LoadIndexedAddress(int array, u64 attribute, int src_offset);
+	void ReadAttribute(Gen::OpArg data, int format, int count, float scale);
+	void WriteFloats(int count, int dst_offset);
+	void ReadColor(Gen::OpArg data, int format, bool kill_alpha, int dst_offset);
+
+	bool m_initialized;
+	ArrayData m_arrays;
+	CompiledFunction m_compiled_code;
+
+	u8* m_constants;
+	int m_num_constants;
+};
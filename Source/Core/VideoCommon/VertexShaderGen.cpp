@@ -415,6 +415,7 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 void GetVertexShaderUid(VertexShaderUid& object, u32 components, API_TYPE api_type)
 {
 	GenerateVertexShader<VertexShaderUid>(object, components, api_type);
+	object.CalculateHash();
 }
 
 void GenerateVertexShaderCode(VertexShaderCode& object, u32 components, API_TYPE api_type)
@@ -12,6 +12,7 @@
 #include "Core/Core.h"
 #include "Core/Movie.h"
 #include "VideoCommon/OnScreenDisplay.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/VideoCommon.h"
 #include "VideoCommon/VideoConfig.h"
 
@@ -23,6 +24,7 @@ void UpdateActiveConfig()
 	if (Movie::IsPlayingInput() && Movie::IsConfigSaved())
 		Movie::SetGraphicsConfig();
 	g_ActiveConfig = g_Config;
+	InvalidateShaderUids();
 }
 
 VideoConfig::VideoConfig()
@@ -68,9 +70,13 @@ void VideoConfig::Load(const std::string& ini_file)
 	settings->Get("ShowEFBCopyRegions", &bShowEFBCopyRegions, false);
 	settings->Get("DumpTextures", &bDumpTextures, 0);
 	settings->Get("HiresTextures", &bHiresTextures, 0);
+	settings->Get("CacheHiresTextures", &bCacheHiresTextures, 0);
+	settings->Get("HiresTexturesDiskCache", &bHiresTexturesDiskCache, false);
+	settings->Get("HiresTexturesCacheSize", &iHiresTexturesCacheSize, 512);
 	settings->Get("DumpEFBTarget", &bDumpEFBTarget, 0);
 	settings->Get("FreeLook", &bFreeLook, 0);
 	settings->Get("UseFFV1", &bUseFFV1, 0);
+	settings->Get("VertexLoaderLockstep", &bVertexLoaderLockstep, false);
 	settings->Get("EnablePixelLighting", &bEnablePixelLighting, 0);
 	settings->Get("FastDepthCalc", &bFastDepthCalc, true);
 	settings->Get("MSAA", &iMultisampleMode, 0);
@@ -81,6 +87,8 @@ void VideoConfig::Load(const std::string& ini_file)
 	settings->Get("WireFrame", &bWireFrame, 0);
 	settings->Get("DisableFog", &bDisableFog, 0);
 	settings->Get("EnableShaderDebugging", &bEnableShaderDebugging, false);
+	settings->Get("BackgroundShaderCompiling", &bBackgroundShaderCompiling, false);
+	settings->Get("SkipDrawsWhileCompiling", &bSkipDrawsWhileCompiling, false);
 	settings->Get("BorderlessFullscreen", &bBorderlessFullscreen, false);
 
 	IniFile::Section* enhancements = iniFile.GetOrCreateSection("Enhancements");
@@ -255,9 +263,13 @@ void VideoConfig::Save(const std::string& ini_file)
 	settings->Set("OverlayProjStats", bOverlayProjStats);
 	settings->Set("DumpTextures", bDumpTextures);
 	settings->Set("HiresTextures", bHiresTextures);
+	settings->Set("CacheHiresTextures", bCacheHiresTextures);
+	settings->Set("HiresTexturesDiskCache", bHiresTexturesDiskCache);
+	settings->Set("HiresTexturesCacheSize", iHiresTexturesCacheSize);
 	settings->Set("DumpEFBTarget", bDumpEFBTarget);
 	settings->Set("FreeLook", bFreeLook);
 	settings->Set("UseFFV1", bUseFFV1);
+	settings->Set("VertexLoaderLockstep", bVertexLoaderLockstep);
 	settings->Set("EnablePixelLighting", bEnablePixelLighting);
 	settings->Set("FastDepthCalc", bFastDepthCalc);
 	settings->Set("ShowEFBCopyRegions", bShowEFBCopyRegions);
@@ -269,6 +281,8 @@ void VideoConfig::Save(const std::string& ini_file)
 	settings->Set("DstAlphaPass", bDstAlphaPass);
 	settings->Set("DisableFog", bDisableFog);
 	settings->Set("EnableShaderDebugging", bEnableShaderDebugging);
+	settings->Set("BackgroundShaderCompiling", bBackgroundShaderCompiling);
+	settings->Set("SkipDrawsWhileCompiling", bSkipDrawsWhileCompiling);
 	settings->Set("BorderlessFullscreen", bBorderlessFullscreen);
 
 	IniFile::Section* enhancements = iniFile.GetOrCreateSection("Enhancements");
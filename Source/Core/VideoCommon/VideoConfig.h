@@ -102,10 +102,14 @@ struct VideoConfig final
 	// Utility
 	bool bDumpTextures;
 	bool bHiresTextures;
+	bool bCacheHiresTextures; // decode the whole custom texture pack in the background at startup
+	bool bHiresTexturesDiskCache; // keep decoded custom textures on disk, uncompressed and not size limited
+	int iHiresTexturesCacheSize; // MB of decoded custom textures to keep in memory
 	bool bDumpEFBTarget;
 	bool bUseFFV1;
 	bool bFreeLook;
 	bool bBorderlessFullscreen;
+	bool bVertexLoaderLockstep; // run the old vertex loader alongside VertexLoaderX64 and compare
 
 	// Hacks
 	bool bEFBAccessEnable;
@@ -122,6 +126,8 @@ struct VideoConfig final
 	float fAspectRatioHackW, fAspectRatioHackH;
 	bool bEnablePixelLighting;
 	bool bFastDepthCalc;
+	bool bBackgroundShaderCompiling; // compile shaders on worker threads and prefetch last run's shaders
+	bool bSkipDrawsWhileCompiling; // skip draws whose shader isn't compiled yet instead of waiting for it
 	int iLog; // CONF_ bits
 	int iSaveTargetId; // TODO: Should be dropped
 
@@ -11,6 +11,7 @@
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
@@ -60,6 +61,8 @@ static void DoState(PointerWrap &p)
 	BoundingBox::DoState(p);
 	p.DoMarker("BoundingBox");
 
+	// The registers above have been replaced wholesale.
+	InvalidateShaderUids();
 
 	// TODO: search for more data that should be saved and add it here
 }
@@ -9,6 +9,7 @@
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
 #include "VideoCommon/VideoCommon.h"
@@ -240,6 +241,7 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, DataReader src)
 	if (transferSize > 0)
 	{
 		XFRegWritten(transferSize, baseAddress, src);
+		InvalidateShaderUids();
 		for (u32 i = 0; i < transferSize; i++)
 		{
 			((u32*)&xfmem)[baseAddress + i] = src.Read<u32>();
@@ -12,6 +12,7 @@
 // Stub out the dsplib host stuff, since this is just a simple cmdline tools.
 u8 DSPHost::ReadHostMemory(u32 addr) { return 0; }
 void DSPHost::WriteHostMemory(u8 value, u32 addr) {}
+void DSPHost::CPUMemoryWritten(u32 addr, u32 size) {}
 void DSPHost::OSD_AddMessage(const std::string& str, u32 ms) {}
 bool DSPHost::OnThread() { return false; }
 bool DSPHost::IsWiiHost() { return false; }
@@ -0,0 +1,95 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <array>
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "Common/CommonTypes.h"
+#include "Common/MPSCQueue.h"
+
+TEST(MPSCQueue, Simple)
+{
+	Common::MPSCQueue<u32, 16> q;
+
+	EXPECT_TRUE(q.Empty());
+
+	EXPECT_TRUE(q.Push(1));
+	EXPECT_FALSE(q.Empty());
+
+	u32 v;
+	EXPECT_TRUE(q.Pop(v));
+	EXPECT_EQ(1u, v);
+	EXPECT_TRUE(q.Empty());
+	EXPECT_FALSE(q.Pop(v));
+
+	// Test the FIFO order, wrapping around the ring several times.
+	for (u32 round = 0; round < 4; ++round)
+	{
+		for (u32 i = 0; i < 10; ++i)
+			EXPECT_TRUE(q.Push(i));
+		for (u32 i = 0; i < 10; ++i)
+		{
+			EXPECT_TRUE(q.Pop(v));
+			EXPECT_EQ(i, v);
+		}
+		EXPECT_TRUE(q.Empty());
+	}
+}
+
+TEST(MPSCQueue, Full)
+{
+	Common::MPSCQueue<u32, 16> q;
+
+	for (u32 i = 0; i < 16; ++i)
+		EXPECT_TRUE(q.Push(i));
+	EXPECT_FALSE(q.Push(16));
+
+	u32 v;
+	EXPECT_TRUE(q.Pop(v));
+	EXPECT_EQ(0u, v);
+	EXPECT_TRUE(q.Push(16));
+
+	for (u32 i = 1; i <= 16; ++i)
+	{
+		EXPECT_TRUE(q.Pop(v));
+		EXPECT_EQ(i, v);
+	}
+	EXPECT_TRUE(q.Empty());
+}
+
+TEST(MPSCQueue, MultiThreaded)
+{
+	const u32 PRODUCERS = 4;
+	const u32 ITERATIONS_COUNT = 50000;
+	Common::MPSCQueue<u32, 64> q;
+
+	auto inserter = [&q](u32 producer) {
+		for (u32 i = 0; i < ITERATIONS_COUNT; ++i)
+		{
+			while (!q.Push((producer << 24) | i))
+				std::this_thread::yield();
+		}
+	};
+
+	std::array<std::thread, PRODUCERS> threads;
+	for (u32 i = 0; i < PRODUCERS; ++i)
+		threads[i] = std::thread(inserter, i);
+
+	// Every producer's values must come out in the order it pushed them.
+	std::array<u32, PRODUCERS> expected = {};
+	for (u32 count = 0; count < PRODUCERS * ITERATIONS_COUNT; ++count)
+	{
+		u32 v;
+		while (!q.Pop(v))
+			std::this_thread::yield();
+		u32 producer = v >> 24;
+		ASSERT_LT(producer, PRODUCERS);
+		EXPECT_EQ(expected[producer]++, v & 0xFFFFFF);
+	}
+	EXPECT_TRUE(q.Empty());
+
+	for (auto& th : threads)
+		th.join();
+}
@@ -0,0 +1,43 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/WorkerPool.h"
+
+TEST(WorkerPool, RunsEveryIterationOnce)
+{
+	for (unsigned int num_threads : {1u, 2u, 4u, 0u})
+	{
+		Common::WorkerPool pool(num_threads);
+
+		for (size_t count : {0, 1, 2, 7, 1000})
+		{
+			std::vector<std::atomic<u32>> runs(count);
+			for (auto& r : runs)
+				r = 0;
+
+			pool.ParallelFor(count, [&](size_t i) { runs[i]++; });
+
+			for (size_t i = 0; i < count; ++i)
+				EXPECT_EQ(1u, runs[i].load()) << "iteration " << i << " with " << num_threads << " threads";
+		}
+	}
+}
+
+TEST(WorkerPool, ManySmallJobs)
+{
+	Common::WorkerPool pool(4);
+	std::atomic<u64> sum(0);
+
+	// Back to back calls catch workers that pick up a job twice or miss one.
+	for (u64 round = 0; round < 2000; ++round)
+		pool.ParallelFor(4, [&](size_t i) { sum += round * 4 + i; });
+
+	const u64 n = 2000 * 4;
+	EXPECT_EQ(n * (n - 1) / 2, sum.load());
+}
@@ -0,0 +1,125 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreParameter.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
+
+static const u32 CODE_ADDRESS = 0x80003000;
+
+// Sums 100..1 into r3, stores and reloads it into r6, then patches the
+// "li r7, 1" at 0x2C to "li r7, 2", invalidates it with icbi and runs it again.
+static const u32 s_program[] = {
+	0x3CA08000, // 00: lis r5, 0x8000
+	0x60A53000, // 04: ori r5, r5, 0x3000
+	0x39000000, // 08: li r8, 0
+	0x38600000, // 0C: li r3, 0
+	0x38800064, // 10: li r4, 100
+	0x7C8903A6, // 14: mtctr r4
+	0x7C632214, // 18: add r3, r3, r4
+	0x3884FFFF, // 1C: addi r4, r4, -1
+	0x4200FFF8, // 20: bdnz 0x18
+	0x90650100, // 24: stw r3, 0x100(r5)
+	0x80C50100, // 28: lwz r6, 0x100(r5)
+	0x38E00001, // 2C: li r7, 1
+	0x2C080000, // 30: cmpwi r8, 0
+	0x40820024, // 34: bne 0x58
+	0x39080001, // 38: addi r8, r8, 1
+	0x3D2038E0, // 3C: lis r9, 0x38E0
+	0x61290002, // 40: ori r9, r9, 2
+	0x9125002C, // 44: stw r9, 0x2C(r5)
+	0x3945002C, // 48: addi r10, r5, 0x2C
+	0x7C0057AC, // 4C: icbi 0, r10
+	0x4BFFFFDC, // 50: b 0x2C
+	0x60000000, // 54: nop
+	0x48000000, // 58: b 0x58
+};
+
+static void StopCallback(u64 userdata, int cyclesLate)
+{
+	PowerPC::Pause();
+}
+
+class CachedInterpreterTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		SConfig::Init();
+		CoreTiming::Init();
+		// Memory::Init also maps MMIO, which needs a video backend. RAM is all
+		// these programs touch.
+		Memory::m_pRAM = new u8[Memory::RAM_SIZE]();
+		Memory::m_pRAMWriteView = Memory::m_pRAM;
+		m_stop_event = CoreTiming::RegisterEvent("stop", &StopCallback);
+	}
+
+	virtual void TearDown() override
+	{
+		JitInterface::Shutdown();
+		delete[] Memory::m_pRAM;
+		Memory::m_pRAM = nullptr;
+		Memory::m_pRAMWriteView = nullptr;
+		CoreTiming::Shutdown();
+		SConfig::Shutdown();
+	}
+
+	// Runs s_program until the stop event fires. PowerPC::Init would also need
+	// the system timers, so this only sets up what the program uses.
+	void RunProgram(int cpu_core)
+	{
+		JitInterface::Shutdown();
+		PPCTables::InitTables(cpu_core);
+		Interpreter::getInstance()->Init();
+		CPUCoreBase* core = Interpreter::getInstance();
+		if (cpu_core != SCoreStartupParameter::CORE_INTERPRETER)
+			core = JitInterface::InitJitCore(cpu_core);
+
+		memset(PowerPC::ppcState.gpr, 0, sizeof(PowerPC::ppcState.gpr));
+		memset(PowerPC::ppcState.spr, 0, sizeof(PowerPC::ppcState.spr));
+		PowerPC::ppcState.Exceptions = 0;
+		PowerPC::ppcState.iCache.Init();
+		HID0.ICE = 1;
+
+		for (u32 i = 0; i < sizeof(s_program) / sizeof(s_program[0]); i++)
+			Memory::Write_U32(s_program[i], CODE_ADDRESS + i * 4);
+		PC = CODE_ADDRESS;
+		PowerPC::ppcState.downcount = CoreTiming::slicelength;
+
+		CoreTiming::ScheduleEvent(100000, m_stop_event);
+		PowerPC::Start();
+		core->Run();
+	}
+
+	int m_stop_event;
+};
+
+TEST_F(CachedInterpreterTest, MatchesInterpreter)
+{
+	RunProgram(SCoreStartupParameter::CORE_CACHEDINTERPRETER);
+
+	EXPECT_EQ(5050u, GPR(3));
+	EXPECT_EQ(5050u, GPR(6));
+	EXPECT_EQ(2u, GPR(7));
+	EXPECT_EQ(1u, GPR(8));
+	EXPECT_EQ(CODE_ADDRESS + 0x58, PC);
+
+	u32 gprs[32];
+	for (int i = 0; i < 32; i++)
+		gprs[i] = GPR(i);
+
+	RunProgram(SCoreStartupParameter::CORE_INTERPRETER);
+	EXPECT_EQ(CODE_ADDRESS + 0x58, PC);
+	for (int i = 0; i < 32; i++)
+		EXPECT_EQ(GPR(i), gprs[i]) << "r" << i;
+}
@@ -0,0 +1,46 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/State.h"
+
+static std::vector<u8> MakeState(size_t size)
+{
+	// Compressible, but not a single repeated byte.
+	std::vector<u8> data(size);
+	for (size_t i = 0; i < size; ++i)
+		data[i] = (u8)((i * 7) ^ (i >> 11));
+	return data;
+}
+
+static void RoundTrip(u8 compression, size_t size)
+{
+	const std::vector<u8> state = MakeState(size);
+
+	std::vector<u8> compressed;
+	ASSERT_TRUE(State::CompressStateData(compression, 6, state.data(), state.size(), compressed));
+
+	std::vector<u8> decompressed;
+	ASSERT_TRUE(State::DecompressStateData(compression, compressed.data(), compressed.size(),
+	                                       state.size(), decompressed));
+	EXPECT_EQ(state, decompressed);
+}
+
+TEST(CompressedState, RoundTripPartialChunk)
+{
+	const size_t size = 3 * State::COMPRESSED_CHUNK_SIZE + 1234;
+	RoundTrip(State::COMPRESSION_LZO, size);
+	RoundTrip(State::COMPRESSION_ZLIB, size);
+}
+
+// The stream then ends with an empty chunk that starts at the end of the state.
+TEST(CompressedState, RoundTripWholeChunks)
+{
+	const size_t size = 4 * State::COMPRESSED_CHUNK_SIZE;
+	RoundTrip(State::COMPRESSION_LZO, size);
+	RoundTrip(State::COMPRESSION_ZLIB, size);
+}
@@ -0,0 +1,308 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Replays a scheduling trace against CoreTiming and reports how many
+// scheduler operations per second it gets through. The trace is either read
+// from a file or recorded from a model of a game keeping a few dozen periodic
+// hardware events pending (VI, DSP, audio DMA, SI, DVD, IPC, ...) with
+// one-shot events and cancellations mixed in. With --verify, the replay is
+// instead checked to fire the same events as the recording did.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Timer.h"
+
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+
+struct TraceOp
+{
+	enum Kind : u8
+	{
+		SCHEDULE,
+		REMOVE,
+		ADVANCE,
+	};
+	Kind kind;
+	u8 type;
+	s32 cycles;
+};
+
+const int NUM_TYPES = 32;
+
+// Cycles between two events of each periodic type, roughly what the
+// hardware emulation schedules at 486MHz.
+const s32 s_periods[NUM_TYPES] = {
+	8100000, 4050000, 2700000, 270000, 97200, 48600, 32400, 16200,
+	10000, 6480, 5000, 4860, 3240, 2430, 1620, 810,
+	600000, 300000, 150000, 75000, 40000, 20000, 12000, 9000,
+	7000, 3000, 2000, 1500, 1000, 750, 500, 400,
+};
+
+int s_types[NUM_TYPES];
+bool s_recording;
+std::vector<TraceOp> s_trace;
+std::vector<u64> s_fired;
+u32 s_seed;
+
+u32 NextRandom(u32 max)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 8) % max;
+}
+
+void Schedule(s32 cycles, int type)
+{
+	CoreTiming::ScheduleEvent(cycles, s_types[type], type);
+	if (s_recording)
+		s_trace.push_back({ TraceOp::SCHEDULE, (u8)type, cycles });
+}
+
+// Periodic events reschedule themselves from their callback, one-shot
+// events (the second half of the types) only sometimes.
+void EventCallback(u64 userdata, int cyclesLate)
+{
+	s_fired[userdata]++;
+	if (!s_recording)
+		return;
+
+	int type = (int)userdata;
+	if (type < NUM_TYPES / 2 || NextRandom(4) == 0)
+	{
+		s32 period = s_periods[type];
+		Schedule(period - NextRandom(period / 8 + 1), type);
+	}
+}
+
+// Advance() consumes (slicelength - downcount) cycles.
+void AdvanceCycles(s32 cycles)
+{
+	PowerPC::ppcState.downcount = CoreTiming::slicelength - cycles;
+	CoreTiming::Advance();
+}
+
+void InitCoreTiming()
+{
+	CoreTiming::Init();
+	for (int i = 0; i < NUM_TYPES; i++)
+		s_types[i] = CoreTiming::RegisterEvent("bench" + std::to_string(i), &EventCallback);
+	s_fired.assign(NUM_TYPES, 0);
+}
+
+// Runs the model for num_ops scheduler operations and records them in s_trace.
+void RecordTrace(size_t num_ops)
+{
+	s_trace.clear();
+	s_seed = 0x12345678;
+	s_recording = true;
+	InitCoreTiming();
+
+	for (int type = 0; type < NUM_TYPES / 2; type++)
+		Schedule(NextRandom(s_periods[type]), type);
+
+	while (s_trace.size() < num_ops)
+	{
+		u32 action = NextRandom(16);
+		if (action < 3)
+		{
+			// The CPU kicks off a DVD read, an IPC request, an SI transfer...
+			int type = NUM_TYPES / 2 + NextRandom(NUM_TYPES / 2);
+			Schedule(NextRandom(s_periods[type]) + 1, type);
+		}
+		else if (action < 4)
+		{
+			int type = NextRandom(NUM_TYPES);
+			CoreTiming::RemoveEvent(s_types[type]);
+			s_trace.push_back({ TraceOp::REMOVE, (u8)type, 0 });
+		}
+		else
+		{
+			// Usually the whole slice runs, sometimes an exception check or
+			// an idle skip cuts it short.
+			s32 cycles = CoreTiming::slicelength;
+			if (NextRandom(4) == 0)
+				cycles = NextRandom(cycles + 1);
+			s_trace.push_back({ TraceOp::ADVANCE, 0, cycles });
+			AdvanceCycles(cycles);
+		}
+	}
+
+	s_recording = false;
+	CoreTiming::Shutdown();
+}
+
+void Replay()
+{
+	for (const TraceOp& op : s_trace)
+	{
+		switch (op.kind)
+		{
+		case TraceOp::SCHEDULE:
+			CoreTiming::ScheduleEvent(op.cycles, s_types[op.type], op.type);
+			break;
+		case TraceOp::REMOVE:
+			CoreTiming::RemoveEvent(s_types[op.type]);
+			break;
+		case TraceOp::ADVANCE:
+			AdvanceCycles(op.cycles);
+			break;
+		}
+	}
+}
+
+bool LoadTrace(const char* filename)
+{
+	FILE* f = fopen(filename, "r");
+	if (!f)
+		return false;
+
+	s_trace.clear();
+	char kind;
+	int type;
+	int cycles;
+	while (fscanf(f, " %c %d %d", &kind, &type, &cycles) == 3)
+	{
+		if (type < 0 || type >= NUM_TYPES || !strchr("sra", kind))
+			break;
+		TraceOp::Kind k = kind == 's' ? TraceOp::SCHEDULE : kind == 'r' ? TraceOp::REMOVE : TraceOp::ADVANCE;
+		s_trace.push_back({ k, (u8)type, cycles });
+	}
+	bool success = feof(f) != 0;
+	fclose(f);
+	return success;
+}
+
+bool SaveTrace(const char* filename)
+{
+	FILE* f = fopen(filename, "w");
+	if (!f)
+		return false;
+
+	for (const TraceOp& op : s_trace)
+		fprintf(f, "%c %d %d\n", "sra"[op.kind], op.type, op.cycles);
+	fclose(f);
+	return true;
+}
+
+void PrintUsage(const char* argv0)
+{
+	printf("Usage: %s [--verify] [--trace <file>] [--save <file>] [--ops <n>] [--time <ms>]\n"
+	       "  --verify        check that replaying the recorded trace fires the same events\n"
+	       "  --trace <file>  replay this trace instead of recording one\n"
+	       "  --save <file>   write the trace which is replayed to a file\n"
+	       "  --ops <n>       number of operations to record (default 1000000)\n"
+	       "  --time <ms>     minimum time to replay the trace for (default 1000)\n"
+	       "Trace files have one operation per line: \"s <type> <cycles>\" schedules an\n"
+	       "event, \"r <type> 0\" removes all events of a type and \"a 0 <cycles>\"\n"
+	       "advances the timer. Types range from 0 to %d.\n",
+	       argv0, NUM_TYPES - 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	bool verify = false;
+	const char* trace_file = nullptr;
+	const char* save_file = nullptr;
+	size_t num_ops = 1000000;
+	u64 min_time_us = 1000000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--verify"))
+		{
+			verify = true;
+		}
+		else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+		{
+			trace_file = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--save") && i + 1 < argc)
+		{
+			save_file = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--ops") && i + 1 < argc)
+		{
+			num_ops = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+		{
+			min_time_us = strtoull(argv[++i], nullptr, 10) * 1000;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (verify)
+	{
+		RecordTrace(num_ops);
+		std::vector<u64> recorded = s_fired;
+
+		InitCoreTiming();
+		Replay();
+		CoreTiming::Shutdown();
+
+		for (int type = 0; type < NUM_TYPES; type++)
+		{
+			if (s_fired[type] != recorded[type])
+			{
+				printf("MISMATCH type %d fired %llu times, %llu while recording\n", type,
+				       (unsigned long long)s_fired[type], (unsigned long long)recorded[type]);
+				return 1;
+			}
+		}
+		printf("Replayed %d operations, all events fired as recorded\n", (int)s_trace.size());
+		return 0;
+	}
+
+	if (trace_file)
+	{
+		if (!LoadTrace(trace_file))
+		{
+			printf("Could not read trace %s\n", trace_file);
+			return 1;
+		}
+	}
+	else
+	{
+		RecordTrace(num_ops);
+	}
+
+	if (save_file && !SaveTrace(save_file))
+	{
+		printf("Could not write trace %s\n", save_file);
+		return 1;
+	}
+
+	u64 replays = 0;
+	u64 fired = 0;
+	u64 start = Common::Timer::GetTimeUs();
+	u64 elapsed;
+	do
+	{
+		InitCoreTiming();
+		Replay();
+		CoreTiming::Shutdown();
+		for (u64 count : s_fired)
+			fired += count;
+		replays++;
+		elapsed = Common::Timer::GetTimeUs() - start;
+	} while (elapsed < min_time_us);
+
+	printf("%d operations, %.2f million operations/s, %.2f million events fired/s\n",
+	       (int)s_trace.size(), replays * s_trace.size() / (double)elapsed, fired / (double)elapsed);
+	return 0;
+}
@@ -0,0 +1,202 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/PowerPC.h"
+
+static std::vector<u64> s_fired;
+
+static void RecordCallback(u64 userdata, int cyclesLate)
+{
+	s_fired.push_back(userdata);
+}
+
+// Advance() consumes (slicelength - downcount) cycles.
+static void AdvanceCycles(int cycles)
+{
+	PowerPC::ppcState.downcount = CoreTiming::slicelength - cycles;
+	CoreTiming::Advance();
+}
+
+class CoreTimingTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		s_fired.clear();
+		CoreTiming::Init();
+		for (int i = 0; i < NUM_TYPES; ++i)
+			m_types[i] = CoreTiming::RegisterEvent("test" + std::to_string(i), &RecordCallback);
+	}
+
+	virtual void TearDown() override
+	{
+		CoreTiming::Shutdown();
+	}
+
+	static const int NUM_TYPES = 8;
+	int m_types[NUM_TYPES];
+};
+
+TEST_F(CoreTimingTest, FiresInTimeOrder)
+{
+	CoreTiming::ScheduleEvent(300, m_types[0], 3);
+	CoreTiming::ScheduleEvent(100, m_types[1], 1);
+	CoreTiming::ScheduleEvent(200, m_types[2], 2);
+
+	AdvanceCycles(1000);
+	EXPECT_EQ((std::vector<u64>{1, 2, 3}), s_fired);
+}
+
+TEST_F(CoreTimingTest, SameTimeKeepsScheduleOrder)
+{
+	for (u64 i = 0; i < 16; ++i)
+		CoreTiming::ScheduleEvent(50, m_types[i % NUM_TYPES], i);
+
+	AdvanceCycles(100);
+	ASSERT_EQ(16u, s_fired.size());
+	for (u64 i = 0; i < 16; ++i)
+		EXPECT_EQ(i, s_fired[i]);
+}
+
+TEST_F(CoreTimingTest, RemoveEvent)
+{
+	CoreTiming::ScheduleEvent(100, m_types[0], 0);
+	CoreTiming::ScheduleEvent(200, m_types[1], 1);
+	CoreTiming::ScheduleEvent(300, m_types[0], 2);
+	EXPECT_TRUE(CoreTiming::IsScheduled(m_types[0]));
+	EXPECT_TRUE(CoreTiming::IsScheduled(m_types[1]));
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_types[2]));
+
+	CoreTiming::RemoveEvent(m_types[0]);
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_types[0]));
+
+	AdvanceCycles(1000);
+	EXPECT_EQ((std::vector<u64>{1}), s_fired);
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_types[1]));
+}
+
+TEST_F(CoreTimingTest, DoStateKeepsOrder)
+{
+	for (u64 i = 0; i < 32; ++i)
+		CoreTiming::ScheduleEvent((int)(1000 - (i % 4) * 100), m_types[i % NUM_TYPES], i);
+
+	u8* ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	CoreTiming::DoState(p);
+	std::vector<u8> buffer(reinterpret_cast<size_t>(ptr));
+
+	ptr = buffer.data();
+	p.SetMode(PointerWrap::MODE_WRITE);
+	CoreTiming::DoState(p);
+
+	CoreTiming::ClearPendingEvents();
+	ptr = buffer.data();
+	p.SetMode(PointerWrap::MODE_READ);
+	CoreTiming::DoState(p);
+
+	AdvanceCycles(2000);
+	std::vector<u64> expected;
+	for (u64 slot = 4; slot-- > 0;)
+		for (u64 i = slot; i < 32; i += 4)
+			expected.push_back(i);
+	EXPECT_EQ(expected, s_fired);
+}
+
+// Far more threadsafe events than the lock-free ring holds, scheduled for the
+// same cycle while the CPU thread keeps moving them, must still fire in the
+// order they were scheduled in.
+TEST_F(CoreTimingTest, ThreadsafeKeepsOrderWhenOverflowing)
+{
+	// ScheduleEvent_Threadsafe asks the config which thread it is on.
+	SConfig::Init();
+
+	const u64 count = 200000;
+	std::atomic<bool> done(false);
+	std::thread producer([&] {
+		for (u64 i = 0; i < count; ++i)
+			CoreTiming::ScheduleEvent_Threadsafe(0, m_types[0], i);
+		done.store(true);
+	});
+	while (!done.load())
+		CoreTiming::MoveEvents();
+	producer.join();
+
+	AdvanceCycles(1);
+	SConfig::Shutdown();
+
+	ASSERT_EQ(count, s_fired.size());
+	for (u64 i = 0; i < count; ++i)
+		ASSERT_EQ(i, s_fired[i]);
+}
+
+// Replays a long pseudo-random scheduling trace and checks the firing order
+// against a trivially correct sorted-list model of the scheduler.
+TEST_F(CoreTimingTest, TraceMatchesReferenceModel)
+{
+	struct RefEvent
+	{
+		s64 time;
+		int type;
+		u64 userdata;
+	};
+	std::vector<RefEvent> reference;
+	std::vector<u64> expected;
+
+	u32 seed = 0x12345678;
+	auto next_random = [&seed](u32 max) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 8) % max;
+	};
+
+	for (u64 op = 0; op < 20000; ++op)
+	{
+		u32 action = next_random(10);
+		if (action < 6)
+		{
+			int type = next_random(NUM_TYPES);
+			int cycles = next_random(5000);
+			u64 userdata = op;
+			CoreTiming::ScheduleEvent(cycles, m_types[type], userdata);
+			RefEvent ev = { (s64)CoreTiming::GetTicks() + cycles, type, userdata };
+			auto it = std::upper_bound(reference.begin(), reference.end(), ev,
+				[](const RefEvent& a, const RefEvent& b) { return a.time < b.time; });
+			reference.insert(it, ev);
+		}
+		else if (action < 7)
+		{
+			int type = next_random(NUM_TYPES);
+			CoreTiming::RemoveEvent(m_types[type]);
+			reference.erase(std::remove_if(reference.begin(), reference.end(),
+				[type](const RefEvent& e) { return e.type == type; }), reference.end());
+		}
+		else
+		{
+			AdvanceCycles(next_random(3000));
+			s64 now = (s64)CoreTiming::GetTicks();
+			auto it = reference.begin();
+			for (; it != reference.end() && it->time <= now; ++it)
+				expected.push_back(it->userdata);
+			reference.erase(reference.begin(), it);
+		}
+
+		for (int type = 0; type < NUM_TYPES; ++type)
+		{
+			bool scheduled = std::any_of(reference.begin(), reference.end(),
+				[type](const RefEvent& e) { return e.type == type; });
+			ASSERT_EQ(scheduled, CoreTiming::IsScheduled(m_types[type]));
+		}
+	}
+
+	EXPECT_EQ(expected, s_fired);
+}
@@ -0,0 +1,437 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Runs guest loops under Jit64 and the interpreter and compares the results,
+// and looks at the code Jit64 emits for them in its cold and hot tiers.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+// gtest's TEST macro conflicts with the TEST method in the x64Emitter, and
+// this file only uses TEST_F.
+#undef TEST
+
+#include "disasm.h"
+
+#include "Common/CommonTypes.h"
+#include "Common/MemArena.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreParameter.h"
+#include "Core/CoreTiming.h"
+#include "Core/MemTools.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+
+static const u32 CODE_ADDRESS = 0x80003000;
+
+// Sums 1000..1 into r3.
+static const u32 s_sum_program[] = {
+	0x38600000, // 00: li r3, 0
+	0x388003E8, // 04: li r4, 1000
+	0x7C8903A6, // 08: mtctr r4
+	0x7C632214, // 0C: add r3, r3, r4
+	0x3884FFFF, // 10: addi r4, r4, -1
+	0x4200FFF8, // 14: bdnz 0x0C
+	0x48000000, // 18: b 0x18
+};
+
+// A loop with more live GPRs than there are loop registers, with a lwarx
+// which falls back to the interpreter and a stw/lwz pair, then a second loop
+// on ctr.
+static const u32 s_busy_program[] = {
+	0x3E808000, // 00: lis r20, 0x8000
+	0x62943000, // 04: ori r20, r20, 0x3000
+	0x3EA00004, // 08: lis r21, 4
+	0x38600000, // 0C: li r3, 0
+	0x38800000, // 10: li r4, 0
+	0x38A00001, // 14: li r5, 1
+	0x38C00003, // 18: li r6, 3
+	0x38E00007, // 1C: li r7, 7
+	0x39000008, // 20: li r8, 8
+	0x39200009, // 24: li r9, 9
+	0x3940000A, // 28: li r10, 10
+	0x3960000B, // 2C: li r11, 11
+	0x3980000C, // 30: li r12, 12
+	0x39A0000D, // 34: li r13, 13
+	0x39C0000E, // 38: li r14, 14
+	0x39E0000F, // 3C: li r15, 15
+	0x3A000010, // 40: li r16, 16
+	0x3A200011, // 44: li r17, 17
+	0x3A400012, // 48: li r18, 18
+	0x3A600013, // 4C: li r19, 19
+	0x7C632A14, // 50: add r3, r3, r5
+	0x38840001, // 54: addi r4, r4, 1
+	0x7CE71A78, // 58: xor r7, r7, r3
+	0x7F20A028, // 5C: lwarx r25, 0, r20
+	0x7D0531D6, // 60: mullw r8, r5, r6
+	0x7D294214, // 64: add r9, r9, r8
+	0x7D474850, // 68: subf r10, r7, r9
+	0x7D6A5A14, // 6C: add r11, r10, r11
+	0x7D8C5A78, // 70: xor r12, r12, r11
+	0x7DAD6214, // 74: add r13, r13, r12
+	0x39CE0003, // 78: addi r14, r14, 3
+	0x7DEF7214, // 7C: add r15, r15, r14
+	0x7E107A78, // 80: xor r16, r16, r15
+	0x7E318214, // 84: add r17, r17, r16
+	0x92340100, // 88: stw r17, 0x100(r20)
+	0x82540100, // 8C: lwz r18, 0x100(r20)
+	0x7E739214, // 90: add r19, r19, r18
+	0x38A50007, // 94: addi r5, r5, 7
+	0x7C04A800, // 98: cmpw r4, r21
+	0x4082FFB4, // 9C: bne 0x50
+	0x3EC00002, // A0: lis r22, 2
+	0x7EC903A6, // A4: mtctr r22
+	0x7EF7B214, // A8: add r23, r23, r22
+	0x3AD6FFFF, // AC: addi r22, r22, -1
+	0x7F18BA78, // B0: xor r24, r24, r23
+	0x4200FFF4, // B4: bdnz 0xA8
+	0x48000000, // B8: b 0xB8
+};
+
+// Sums 100..1 into r3, jumping over two instructions on the way.
+static const u32 s_forward_jump_program[] = {
+	0x38600000, // 00: li r3, 0
+	0x38800064, // 04: li r4, 100
+	0x7C8903A6, // 08: mtctr r4
+	0x7C632214, // 0C: add r3, r3, r4
+	0x4800000C, // 10: b 0x1C
+	0x3860FFFF, // 14: li r3, -1
+	0x3860FFFE, // 18: li r3, -2
+	0x3884FFFF, // 1C: addi r4, r4, -1
+	0x4200FFEC, // 20: bdnz 0x0C
+	0x48000000, // 24: b 0x24
+};
+
+// Each iteration flips the "addi r4, r4, 1" at 0x24 between adding 1 and
+// adding 2, and flushes the instruction cache through HID0, which destroys
+// every block including the running one.
+static const u32 s_self_modifying_program[] = {
+	0x3CA08000, // 00: lis r5, 0x8000
+	0x60A53000, // 04: ori r5, r5, 0x3000
+	0x38800000, // 08: li r4, 0
+	0x38600064, // 0C: li r3, 100
+	0x7C6903A6, // 10: mtctr r3
+	0x3CE03884, // 14: lis r7, 0x3884
+	0x60E70002, // 18: ori r7, r7, 2
+	0x39000003, // 1C: li r8, 3
+	0x60068800, // 20: ori r6, r0, 0x8800
+	0x38840001, // 24: addi r4, r4, 1
+	0x90E50024, // 28: stw r7, 0x24(r5)
+	0x7CE74278, // 2C: xor r7, r7, r8
+	0x7CD0FBA6, // 30: mtspr HID0, r6
+	0x4200FFF0, // 34: bdnz 0x24
+	0x48000000, // 38: b 0x38
+};
+
+// Stores through the physical view, like the guest does with MSR.DR clear.
+// mtctr/mfctr keeps the JIT from folding the address into a constant.
+static const u32 s_physical_store_program[] = {
+	0x38A01000, // 00: li r5, 0x1000
+	0x7CA903A6, // 04: mtctr r5
+	0x7CA902A6, // 08: mfctr r5
+	0x38C01234, // 0C: li r6, 0x1234
+	0x90C50020, // 10: stw r6, 0x20(r5)
+	0x48000000, // 14: b 0x14
+};
+
+static const u32 s_physical_const_store_program[] = {
+	0x38C01234, // 00: li r6, 0x1234
+	0x90C01020, // 04: stw r6, 0x1020(0)
+	0x48000000, // 08: b 0x08
+};
+
+static const u32 s_physical_dcbz_program[] = {
+	0x38A01000, // 00: li r5, 0x1000
+	0x7CA903A6, // 04: mtctr r5
+	0x7CA902A6, // 08: mfctr r5
+	0x7C002FEC, // 0C: dcbz 0, r5
+	0x48000000, // 10: b 0x10
+};
+
+static void StopCallback(u64 userdata, int cyclesLate)
+{
+	PowerPC::Pause();
+}
+
+class Jit64Test : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		SConfig::Init();
+		// Without fastmem, loads and stores still access RAM through
+		// Memory::base, so it has to be mapped like Memory::Init does.
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bFastmem = false;
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bMMU = false;
+		CoreTiming::Init();
+		Memory::base = MemoryMap_Setup(m_views, NUM_VIEWS, 0, &m_arena);
+		Memory::m_pRAMWriteView = Memory::m_pRAM;
+		m_stop_event = CoreTiming::RegisterEvent("stop", &StopCallback);
+	}
+
+	virtual void TearDown() override
+	{
+		JitInterface::Shutdown();
+		MemoryMap_Shutdown(m_views, NUM_VIEWS, 0, &m_arena);
+		m_arena.ReleaseSHMSegment();
+		Memory::base = nullptr;
+		Memory::m_pRAM = nullptr;
+		Memory::m_pRAMWriteView = nullptr;
+		CoreTiming::Shutdown();
+		SConfig::Shutdown();
+	}
+
+	// Runs program until the stop event fires. PowerPC::Init would also need
+	// the system timers, so this only sets up what the programs use.
+	template <size_t N>
+	void RunProgram(int cpu_core, const u32 (&program)[N])
+	{
+		JitInterface::Shutdown();
+		PPCTables::InitTables(cpu_core);
+		Interpreter::getInstance()->Init();
+		CPUCoreBase* core = Interpreter::getInstance();
+		if (cpu_core != SCoreStartupParameter::CORE_INTERPRETER)
+			core = JitInterface::InitJitCore(cpu_core);
+
+		memset(PowerPC::ppcState.gpr, 0, sizeof(PowerPC::ppcState.gpr));
+		memset(PowerPC::ppcState.spr, 0, sizeof(PowerPC::ppcState.spr));
+		PowerPC::ppcState.Exceptions = 0;
+		PowerPC::ppcState.iCache.Init();
+		HID0.ICE = 1;
+
+		for (u32 i = 0; i < N; i++)
+			Memory::Write_U32(program[i], CODE_ADDRESS + i * 4);
+		PC = CODE_ADDRESS;
+		PowerPC::ppcState.downcount = CoreTiming::slicelength;
+
+		CoreTiming::ScheduleEvent(20000000, m_stop_event);
+		PowerPC::Start();
+		core->Run();
+	}
+
+	// Runs program under Jit64, then under the interpreter, and checks that
+	// both end in the final "b ." with the same GPRs.
+	template <size_t N>
+	void ExpectMatchesInterpreter(const u32 (&program)[N])
+	{
+		RunProgram(SCoreStartupParameter::CORE_JIT64, program);
+		ASSERT_EQ(CODE_ADDRESS + (N - 1) * 4, PC);
+		u32 gprs[32];
+		for (int i = 0; i < 32; i++)
+			gprs[i] = GPR(i);
+
+		RunProgram(SCoreStartupParameter::CORE_INTERPRETER, program);
+		ASSERT_EQ(CODE_ADDRESS + (N - 1) * 4, PC);
+		for (int i = 0; i < 32; i++)
+			EXPECT_EQ(GPR(i), gprs[i]) << "r" << i;
+	}
+
+	// Counts the guest GPR loads and stores on one iteration of the self-loop
+	// compiled at address: the straight-line code from where the back edge
+	// jumps to, up to the back edge. Returns -1 if there is no such loop. Call
+	// after running the program under Jit64.
+	int CountGPRAccessesPerIteration(u32 address)
+	{
+		JitBaseBlockCache* cache = jit->GetBlockCache();
+		int block_num = cache->GetBlockNumberFromStartAddress(address);
+		if (block_num < 0)
+			return -1;
+		const JitBlock* b = cache->GetBlock(block_num);
+
+		struct Instruction
+		{
+			const u8* address;
+			const u8* next;
+			std::string text;
+		};
+		std::vector<Instruction> code;
+		disassembler x64disasm;
+		x64disasm.set_syntax_intel();
+		const u8* ptr = b->normalEntry;
+		while (ptr < b->normalEntry + b->codeSize)
+		{
+			char text[256];
+			const u8* next = ptr + x64disasm.disasm64((u64)ptr, (u64)ptr, (u8*)ptr, text);
+			code.push_back({ ptr, next, text });
+			ptr = next;
+		}
+
+		// PPCSTATE() addresses ppcState from RPPCSTATE, which is rbp, biased by 0x80.
+		const long first_gpr = (long)offsetof(PowerPC::PowerPCState, gpr) - 0x80;
+		const long last_gpr = first_gpr + 31 * 4;
+
+		for (const Instruction& jump : code)
+		{
+			// Jumps print as "jmp .-41 (...)", relative to the next instruction.
+			size_t dot = jump.text.find(" .");
+			if (jump.text[0] != 'j' || dot == std::string::npos)
+				continue;
+			const u8* target = jump.next + strtol(jump.text.c_str() + dot + 2, nullptr, 10);
+			if (target >= jump.address || target < b->checkedEntry)
+				continue;
+
+			int count = 0;
+			for (const Instruction& inst : code)
+			{
+				size_t operand = inst.text.find("[rbp");
+				if (inst.address < target || inst.address >= jump.address || operand == std::string::npos)
+					continue;
+				long disp = strtol(inst.text.c_str() + operand + 4, nullptr, 10);
+				if (disp >= first_gpr && disp <= last_gpr)
+					count++;
+			}
+			return count;
+		}
+		return -1;
+	}
+
+	// Counts the accesses per iteration of the loop at offset in program,
+	// compiled cold and compiled hot.
+	template <size_t N>
+	void CountColdAndHot(const u32 (&program)[N], u32 offset, int* cold, int* hot)
+	{
+		SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = 0x7FFFFFFF;
+		RunProgram(SCoreStartupParameter::CORE_JIT64, program);
+		*cold = CountGPRAccessesPerIteration(CODE_ADDRESS + offset);
+
+		SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = 0;
+		RunProgram(SCoreStartupParameter::CORE_JIT64, program);
+		*hot = CountGPRAccessesPerIteration(CODE_ADDRESS + offset);
+
+		printf("Guest GPR loads and stores per iteration of the loop at %08x: %d cold, %d hot\n",
+		       CODE_ADDRESS + offset, *cold, *hot);
+	}
+
+	enum
+	{
+		NUM_VIEWS = 3,
+	};
+	MemoryView m_views[NUM_VIEWS] = {
+		{ &Memory::m_pRAM, 0x00000000, Memory::RAM_SIZE, 0 },
+		{ nullptr,         0x80000000, Memory::RAM_SIZE, MV_MIRROR_PREVIOUS },
+		{ nullptr,         0xC0000000, Memory::RAM_SIZE, MV_MIRROR_PREVIOUS },
+	};
+	MemArena m_arena;
+	int m_stop_event;
+};
+
+TEST_F(Jit64Test, LoopsMatchInterpreter)
+{
+	// Hot blocks get the loop registers, cold ones go through the block entry.
+	for (int threshold : { 0, 0x7FFFFFFF })
+	{
+		SCOPED_TRACE(threshold);
+		SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = threshold;
+		ExpectMatchesInterpreter(s_sum_program);
+		EXPECT_EQ(500500u, GPR(3));
+		ExpectMatchesInterpreter(s_busy_program);
+		ExpectMatchesInterpreter(s_forward_jump_program);
+		EXPECT_EQ(5050u, GPR(3));
+	}
+}
+
+TEST_F(Jit64Test, LoopLeavesDestroyedBlock)
+{
+	SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = 0;
+	ExpectMatchesInterpreter(s_self_modifying_program);
+	EXPECT_EQ(150u, GPR(4));
+}
+
+// Not much of a test, mostly prints how many guest register accesses the loop
+// registers save.
+TEST_F(Jit64Test, LoopKeepsGPRsInHostRegisters)
+{
+	int cold, hot;
+	CountColdAndHot(s_sum_program, 0x0C, &cold, &hot);
+	EXPECT_GT(cold, 0);
+	EXPECT_EQ(0, hot);
+
+	// The lwarx fallback flushes every register in the middle of this one.
+	CountColdAndHot(s_busy_program, 0x50, &cold, &hot);
+	EXPECT_LT(hot, cold);
+
+	CountColdAndHot(s_busy_program, 0xA8, &cold, &hot);
+	EXPECT_GT(cold, 0);
+	EXPECT_EQ(0, hot);
+}
+
+TEST_F(Jit64Test, HotBlocksFollowForwardJumps)
+{
+	JitBaseBlockCache* cache;
+
+	SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = 0x7FFFFFFF;
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_forward_jump_program);
+	cache = jit->GetBlockCache();
+	EXPECT_GE(cache->GetBlockNumberFromStartAddress(CODE_ADDRESS + 0x1C), 0);
+
+	SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = 0;
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_forward_jump_program);
+	cache = jit->GetBlockCache();
+	EXPECT_LT(cache->GetBlockNumberFromStartAddress(CODE_ADDRESS + 0x1C), 0);
+	int block_num = cache->GetBlockNumberFromStartAddress(CODE_ADDRESS + 0x0C);
+	ASSERT_GE(block_num, 0);
+	// Up to the "b ." after the bdnz, including the code jumped over.
+	EXPECT_EQ(7u, cache->GetBlock(block_num)->originalSize);
+	EXPECT_EQ(0, CountGPRAccessesPerIteration(CODE_ADDRESS + 0x0C));
+
+	// Overwriting the code jumped over has to invalidate the block too.
+	cache->InvalidateICache(CODE_ADDRESS + 0x14, 4, false);
+	EXPECT_LT(cache->GetBlockNumberFromStartAddress(CODE_ADDRESS + 0x0C), 0);
+}
+
+TEST_F(Jit64Test, BlocksArePromotedAtThreshold)
+{
+	// The loop at 0x0C runs 100 times, and goes hot after the first few.
+	SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = 3;
+	ExpectMatchesInterpreter(s_forward_jump_program);
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_forward_jump_program);
+	EXPECT_EQ(0, CountGPRAccessesPerIteration(CODE_ADDRESS + 0x0C));
+
+	// A negative threshold from the ini is taken as 0, so everything is hot.
+	SConfig::GetInstance().m_LocalCoreStartupParameter.iJITHotBlockThreshold = -1;
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_forward_jump_program);
+	EXPECT_LT(jit->GetBlockCache()->GetBlockNumberFromStartAddress(CODE_ADDRESS + 0x1C), 0);
+}
+
+TEST_F(Jit64Test, PhysicalStoresAreTracked)
+{
+	// The constant address store goes through a write protected mirror, so
+	// it needs the fault handler.
+	SConfig::GetInstance().m_LocalCoreStartupParameter.bFastmem = true;
+	EMM::InstallExceptionHandler();
+	Memory::EnableWriteTracking();
+
+	const u32 address = 0x80001000;
+	const u32 size = 0x40;
+
+	Memory::Write_U32(0xFFFFFFFF, address + 0x20);
+	u64 stamp = Memory::WatchRange(address, size);
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_physical_store_program);
+	EXPECT_EQ(0x1234u, Memory::Read_U32(address + 0x20));
+	EXPECT_TRUE(Memory::WrittenSince(address, size, stamp));
+
+	Memory::Write_U32(0xFFFFFFFF, address + 0x20);
+	stamp = Memory::WatchRange(address, size);
+	EXPECT_FALSE(Memory::WrittenSince(address, size, stamp));
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_physical_const_store_program);
+	EXPECT_EQ(0x1234u, Memory::Read_U32(address + 0x20));
+	EXPECT_TRUE(Memory::WrittenSince(address, size, stamp));
+
+	stamp = Memory::WatchRange(address, size);
+	RunProgram(SCoreStartupParameter::CORE_JIT64, s_physical_dcbz_program);
+	EXPECT_EQ(0u, Memory::Read_U32(address));
+	EXPECT_TRUE(Memory::WrittenSince(address, size, stamp));
+
+	Memory::DisableWriteTracking();
+	EMM::UninstallExceptionHandler();
+}
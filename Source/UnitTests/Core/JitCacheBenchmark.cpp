@@ -0,0 +1,201 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Drives the JIT block cache through invalidate/recompile storms and reports
+// how many invalidations and block compilations per second it handles. No
+// code is emitted, so this only measures the block cache's own bookkeeping:
+// the page index, linking and unlinking.
+//
+// Each scenario compiles a set of linked blocks, then repeatedly invalidates
+// a range and compiles the destroyed blocks again, the way a game that
+// modifies its code or loads overlays makes the JIT do.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Timer.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+
+#include "StubJit.h"
+
+namespace
+{
+
+struct Scenario
+{
+	const char* name;
+	// Guest code the blocks are spread over.
+	u32 code_size;
+	u32 num_blocks;
+	// Length of each invalidation; 32 is a single icbi.
+	u32 invalidate_length;
+};
+
+const Scenario s_scenarios[] = {
+	// A game patching single instructions in a big executable.
+	{ "icbi", 0x400000, 16384, 32 },
+	// Code copied to the heap a few hundred bytes at a time.
+	{ "small copies", 0x100000, 8192, 0x200 },
+	// Overlays loaded over the same region.
+	{ "overlays", 0x100000, 8192, 0x10000 },
+	// DMA over a large part of the code.
+	{ "big dma", 0x400000, 16384, 0x100000 },
+};
+
+const u32 CODE_BASE = 0x80100000;
+
+u32 s_seed;
+
+u32 NextRandom(u32 max)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 8) % max;
+}
+
+struct GuestBlock
+{
+	u32 address;
+	u32 size;
+	std::vector<u32> exits;
+};
+
+// Block start addresses are spread evenly over the code, each block branches
+// to the next one and to a random other one.
+std::vector<GuestBlock> MakeBlocks(const Scenario& scenario)
+{
+	std::vector<GuestBlock> blocks(scenario.num_blocks);
+	u32 stride = scenario.code_size / scenario.num_blocks & ~3;
+	for (u32 i = 0; i < scenario.num_blocks; i++)
+	{
+		blocks[i].address = CODE_BASE + i * stride;
+		blocks[i].size = 1 + NextRandom(stride / 4);
+	}
+	for (u32 i = 0; i < scenario.num_blocks; i++)
+	{
+		blocks[i].exits.push_back(blocks[(i + 1) % scenario.num_blocks].address);
+		blocks[i].exits.push_back(blocks[NextRandom(scenario.num_blocks)].address);
+	}
+	return blocks;
+}
+
+struct Result
+{
+	double invalidations_per_second;
+	double compiles_per_second;
+};
+
+Result Measure(StubBlockCache* cache, const Scenario& scenario, u64 min_time_us)
+{
+	s_seed = 0x12345678;
+	std::vector<GuestBlock> blocks = MakeBlocks(scenario);
+	u32 stride = scenario.code_size / scenario.num_blocks & ~3;
+
+	cache->Clear();
+	for (const GuestBlock& b : blocks)
+		cache->AddBlock(b.address, b.size, b.exits);
+
+	u64 invalidations = 0;
+	u64 compiles = 0;
+	u64 start = Common::Timer::GetTimeUs();
+	u64 elapsed;
+	do
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			u32 address = CODE_BASE + NextRandom(scenario.code_size - scenario.invalidate_length + 1);
+			if (scenario.invalidate_length == 32)
+				address &= ~31;
+			cache->InvalidateICache(address, scenario.invalidate_length, false);
+			invalidations++;
+
+			// Compile everything the invalidation destroyed again.
+			u32 first = (address - CODE_BASE) / stride;
+			if (first > 0)
+				first--;
+			u32 last = std::min((address - CODE_BASE + scenario.invalidate_length) / stride, scenario.num_blocks - 1);
+			for (u32 j = first; j <= last; j++)
+			{
+				if (cache->GetBlockNumberFromStartAddress(blocks[j].address) >= 0)
+					continue;
+				if (cache->IsFull())
+				{
+					// What the JIT does too.
+					cache->Clear();
+					for (const GuestBlock& b : blocks)
+						cache->AddBlock(b.address, b.size, b.exits);
+					compiles += blocks.size();
+					break;
+				}
+				cache->AddBlock(blocks[j].address, blocks[j].size, blocks[j].exits);
+				compiles++;
+			}
+		}
+		cache->links.clear();
+		cache->destroyed.clear();
+		elapsed = Common::Timer::GetTimeUs() - start;
+	} while (elapsed < min_time_us);
+
+	return { invalidations * 1000000.0 / elapsed, compiles * 1000000.0 / elapsed };
+}
+
+void PrintUsage(const char* argv0)
+{
+	printf("Usage: %s [--filter <text>] [--time <ms>]\n"
+	       "  --filter <text>  only run scenarios with <text> in their name\n"
+	       "  --time <ms>      minimum time to run each scenario (default 1000)\n",
+	       argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+	u64 min_time_us = 1000000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+		{
+			min_time_us = strtoull(argv[++i], nullptr, 10) * 1000;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	SConfig::Init();
+	std::unique_ptr<StubJit> stub_jit(new StubJit());
+	jit = stub_jit.get();
+	stub_jit->block_cache.Init();
+
+	printf("%-14s %16s %16s\n", "scenario", "invalidations/s", "compiles/s");
+	for (const Scenario& scenario : s_scenarios)
+	{
+		if (std::string(scenario.name).find(filter) == std::string::npos)
+			continue;
+
+		Result result = Measure(&stub_jit->block_cache, scenario, min_time_us);
+		printf("%-14s %16.0f %16.0f\n", scenario.name, result.invalidations_per_second, result.compiles_per_second);
+		fflush(stdout);
+	}
+
+	stub_jit->block_cache.Shutdown();
+	jit = nullptr;
+	SConfig::Shutdown();
+	return 0;
+}
@@ -0,0 +1,192 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+// gtest's TEST macro conflicts with the TEST method in the x64Emitter, and
+// this file only uses TEST_F.
+#undef TEST
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+
+#include "StubJit.h"
+
+class JitCacheTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		SConfig::Init();
+		m_jit.reset(new StubJit());
+		jit = m_jit.get();
+		m_cache = &m_jit->block_cache;
+		m_cache->Init();
+	}
+
+	virtual void TearDown() override
+	{
+		m_cache->Shutdown();
+		jit = nullptr;
+		m_jit.reset();
+		SConfig::Shutdown();
+	}
+
+	bool IsCompiled(u32 address)
+	{
+		return m_cache->GetBlockNumberFromStartAddress(address) >= 0;
+	}
+
+	std::unique_ptr<StubJit> m_jit;
+	StubBlockCache* m_cache;
+};
+
+TEST_F(JitCacheTest, InvalidateHitsOverlappingBlocks)
+{
+	m_cache->AddBlock(0x80001000, 8);
+	m_cache->AddBlock(0x80001020, 4);
+	// Crosses into the next page.
+	m_cache->AddBlock(0x80001FF0, 8);
+	m_cache->AddBlock(0x80003000, 1);
+
+	m_cache->InvalidateICache(0x80002000, 0x20, true);
+	EXPECT_EQ(std::vector<u32>{ 0x80001FF0 }, m_cache->destroyed);
+
+	// Ends right where the second block starts.
+	m_cache->InvalidateICache(0x80000F00, 0x120, true);
+	EXPECT_FALSE(IsCompiled(0x80001000));
+	EXPECT_TRUE(IsCompiled(0x80001020));
+
+	// Starts right after the second block ends.
+	m_cache->InvalidateICache(0x80001030, 0x1FD0, true);
+	EXPECT_TRUE(IsCompiled(0x80001020));
+	EXPECT_TRUE(IsCompiled(0x80003000));
+
+	// The last instruction of the second block.
+	m_cache->InvalidateICache(0x8000102C, 4, true);
+	EXPECT_FALSE(IsCompiled(0x80001020));
+	EXPECT_TRUE(IsCompiled(0x80003000));
+
+	EXPECT_EQ((std::vector<u32>{ 0x80001FF0, 0x80001000, 0x80001020 }), m_cache->destroyed);
+}
+
+TEST_F(JitCacheTest, InvalidateThroughMirror)
+{
+	m_cache->AddBlock(0x80004000, 4);
+	m_cache->AddBlock(0x80004100, 4);
+
+	m_cache->InvalidateICache(0xC0004000, 0x20, true);
+	EXPECT_FALSE(IsCompiled(0x80004000));
+
+	m_cache->InvalidateICache(0x00004100, 4, true);
+	EXPECT_FALSE(IsCompiled(0x80004100));
+}
+
+TEST_F(JitCacheTest, InvalidateSpanningPages)
+{
+	for (u32 address = 0x80010000; address < 0x80018000; address += 0x100)
+		m_cache->AddBlock(address, 16);
+
+	m_cache->InvalidateICache(0x80011080, 0x5000, true);
+	for (u32 address = 0x80010000; address < 0x80018000; address += 0x100)
+	{
+		bool overlaps = address + 64 > 0x80011080 && address < 0x80016080;
+		EXPECT_EQ(!overlaps, IsCompiled(address)) << std::hex << address;
+	}
+}
+
+TEST_F(JitCacheTest, LinksFollowDestruction)
+{
+	int a = m_cache->AddBlock(0x80005000, 4, { 0x80006000 });
+	EXPECT_TRUE(m_cache->links.empty());
+
+	int b = m_cache->AddBlock(0x80006000, 4);
+	ASSERT_EQ(1u, m_cache->links.size());
+	EXPECT_EQ(m_cache->GetBlock(a)->checkedEntry, m_cache->links[0].first);
+	EXPECT_EQ(m_cache->GetBlock(b)->checkedEntry, m_cache->links[0].second);
+
+	// A retired block's incoming links are pointed at its replacement.
+	m_cache->links.clear();
+	m_cache->RetireBlock(b);
+	int b2 = m_cache->AddBlock(0x80006000, 4);
+	ASSERT_EQ(1u, m_cache->links.size());
+	EXPECT_EQ(m_cache->GetBlock(a)->checkedEntry, m_cache->links[0].first);
+	EXPECT_EQ(m_cache->GetBlock(b2)->checkedEntry, m_cache->links[0].second);
+
+	// An invalidated block's are dropped, the exit goes through the
+	// dispatcher until its own block is recompiled.
+	m_cache->links.clear();
+	m_cache->InvalidateICache(0x80006000, 0x20, true);
+	EXPECT_TRUE(IsCompiled(0x80005000));
+	m_cache->AddBlock(0x80006000, 4);
+	EXPECT_TRUE(m_cache->links.empty());
+}
+
+// Compiles and invalidates pseudo-random blocks and ranges, and checks that
+// every invalidation destroys exactly the compiled blocks overlapping it.
+TEST_F(JitCacheTest, InvalidateMatchesReferenceModel)
+{
+	struct RefBlock
+	{
+		u32 address;
+		u32 size;
+	};
+	std::vector<RefBlock> compiled;
+
+	u32 seed = 0x12345678;
+	auto next_random = [&seed](u32 max) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 8) % max;
+	};
+
+	for (int round = 0; round < 20000; round++)
+	{
+		if (next_random(3) != 0)
+		{
+			u32 address = 0x80100000 + next_random(0x4000) * 4;
+			if (IsCompiled(address))
+				continue;
+			u32 size = 1 + next_random(next_random(8) == 0 ? 2048 : 32);
+			m_cache->AddBlock(address, size, { 0x80100000 + next_random(0x4000) * 4 });
+			compiled.push_back({ address, size });
+		}
+		else
+		{
+			u32 start = 0x80100000 + next_random(0x10000);
+			u32 length = 1 + next_random(next_random(4) == 0 ? 0x8000 : 0x100);
+			// InvalidateICache takes 32 bytes to mean one cache line, which is
+			// all dcbi and friends ever invalidate.
+			if (length == 32 || next_random(4) == 0)
+			{
+				start &= ~31;
+				length = 32;
+			}
+			m_cache->destroyed.clear();
+			m_cache->InvalidateICache(start, length, true);
+
+			std::vector<u32> expected;
+			auto it = std::remove_if(compiled.begin(), compiled.end(), [&](const RefBlock& b) {
+				if (b.address >= start + length || b.address + b.size * 4 <= start)
+					return false;
+				expected.push_back(b.address);
+				return true;
+			});
+			compiled.erase(it, compiled.end());
+
+			std::sort(expected.begin(), expected.end());
+			std::sort(m_cache->destroyed.begin(), m_cache->destroyed.end());
+			ASSERT_EQ(expected, m_cache->destroyed) << "round " << round;
+		}
+
+		if (m_cache->IsFull())
+			break;
+	}
+
+	for (const RefBlock& b : compiled)
+		EXPECT_TRUE(IsCompiled(b.address));
+}
@@ -0,0 +1,85 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// A JIT which never emits any code, so that the block cache can be driven on
+// its own. The block cache records the links and destructions it would have
+// patched into the code instead.
+
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+class StubBlockCache : public JitBaseBlockCache
+{
+public:
+	// (exit location, destination) of every link written.
+	std::vector<std::pair<u8*, const u8*>> links;
+	// Guest address of every block destroyed.
+	std::vector<u32> destroyed;
+
+	// Allocates and finalizes a block of size instructions at address, with
+	// an exit to each of exits.
+	int AddBlock(u32 address, u32 size, const std::vector<u32>& exits = {})
+	{
+		int block_num = AllocateBlock(address);
+		JitBlock* b = GetBlock(block_num);
+		u8* code = &m_code[(block_num % NUM_CODE_SLOTS) * CODE_SLOT_SIZE];
+		b->checkedEntry = code;
+		b->normalEntry = code;
+		b->codeSize = CODE_SLOT_SIZE;
+		b->originalSize = size;
+		b->runCount = 0;
+		for (u32 i = 0; i < exits.size(); i++)
+		{
+			JitBlock::LinkData data;
+			data.exitPtrs = code + i;
+			data.exitAddress = exits[i];
+			data.linkStatus = false;
+			AddLinkData(b, data);
+		}
+		FinalizeBlock(block_num, true, code);
+		return block_num;
+	}
+
+private:
+	enum
+	{
+		NUM_CODE_SLOTS = 256,
+		CODE_SLOT_SIZE = 16,
+	};
+	u8 m_code[NUM_CODE_SLOTS * CODE_SLOT_SIZE];
+
+	void WriteLinkBlock(u8* location, const u8* address) override
+	{
+		links.emplace_back(location, address);
+	}
+
+	void WriteDestroyBlock(const u8* location, u32 address) override
+	{
+		destroyed.push_back(address);
+	}
+};
+
+class StubJit : public JitBase
+{
+public:
+	StubBlockCache block_cache;
+
+	void Init() override {}
+	void Shutdown() override {}
+	void ClearCache() override {}
+	void Run() override {}
+	void SingleStep() override {}
+	const char* GetName() override { return "Stub"; }
+
+	JitBaseBlockCache* GetBlockCache() override { return &block_cache; }
+	void Jit(u32 em_address) override {}
+	const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+	bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+};
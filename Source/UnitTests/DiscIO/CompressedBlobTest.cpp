@@ -0,0 +1,182 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CompressedBlob.h"
+
+static const int BLOCK_SIZE = 0x4000;
+static const std::string RAW_FILENAME = "CompressedBlobTest.raw";
+static const std::string GCZ_FILENAME = "CompressedBlobTest.gcz";
+static const std::string OTHER_FILENAME = "CompressedBlobTest.out";
+
+static bool ProgressCallback(const std::string& text, float percent, void* arg)
+{
+	return true;
+}
+
+class CompressedBlobTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		// A mix of blocks that compress well and blocks of noise that get
+		// stored as-is, ending in a partial block.
+		m_data.resize(100 * BLOCK_SIZE + 1234);
+		u32 seed = 0x12345678;
+		for (size_t i = 0; i < m_data.size(); i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			if ((i / BLOCK_SIZE) % 3 == 0)
+				m_data[i] = (u8)(seed >> 16);
+			else
+				m_data[i] = (u8)(i / 64);
+		}
+
+		File::IOFile f(RAW_FILENAME, "wb");
+		ASSERT_TRUE(f.WriteBytes(m_data.data(), m_data.size()));
+		f.Close();
+		ASSERT_TRUE(DiscIO::CompressFileToBlob(RAW_FILENAME, GCZ_FILENAME, 0, BLOCK_SIZE, &ProgressCallback, nullptr));
+	}
+
+	virtual void TearDown() override
+	{
+		DiscIO::CompressedBlobReader::SetCacheSize(16, 8);
+		File::Delete(RAW_FILENAME);
+		File::Delete(GCZ_FILENAME);
+		File::Delete(OTHER_FILENAME);
+	}
+
+	void ExpectRead(DiscIO::IBlobReader* reader, u64 offset, u64 size)
+	{
+		std::vector<u8> buffer(size);
+		ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+		EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), m_data.begin() + offset))
+			<< "offset " << offset << " size " << size;
+	}
+
+	std::vector<u8> m_data;
+};
+
+TEST_F(CompressedBlobTest, SequentialReads)
+{
+	std::unique_ptr<DiscIO::IBlobReader> reader(DiscIO::CreateBlobReader(GCZ_FILENAME));
+	ASSERT_TRUE(reader != nullptr);
+	EXPECT_EQ(m_data.size(), reader->GetDataSize());
+
+	// Small reads, so that the reader starts reading ahead.
+	for (u64 offset = 0; offset < m_data.size(); offset += 0x800)
+		ExpectRead(reader.get(), offset, std::min<u64>(0x800, m_data.size() - offset));
+}
+
+TEST_F(CompressedBlobTest, LargeReads)
+{
+	std::unique_ptr<DiscIO::IBlobReader> reader(DiscIO::CreateBlobReader(GCZ_FILENAME));
+	ASSERT_TRUE(reader != nullptr);
+
+	ExpectRead(reader.get(), 0, m_data.size());
+	ExpectRead(reader.get(), 3 * BLOCK_SIZE, 40 * BLOCK_SIZE);
+	ExpectRead(reader.get(), 7 * BLOCK_SIZE + 100, 20 * BLOCK_SIZE + 5);
+	ExpectRead(reader.get(), m_data.size() - 5 * BLOCK_SIZE, 5 * BLOCK_SIZE);
+}
+
+TEST_F(CompressedBlobTest, RandomReadsWithSmallCache)
+{
+	// 64 blocks, so the cache keeps evicting.
+	DiscIO::CompressedBlobReader::SetCacheSize(1, 8);
+	std::unique_ptr<DiscIO::IBlobReader> reader(DiscIO::CreateBlobReader(GCZ_FILENAME));
+	ASSERT_TRUE(reader != nullptr);
+
+	u32 seed = 0x87654321;
+	for (int i = 0; i < 500; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		u64 offset = (seed >> 4) % m_data.size();
+		seed = seed * 1103515245 + 12345;
+		u64 size = std::min<u64>((seed >> 4) % (12 * BLOCK_SIZE) + 1, m_data.size() - offset);
+		ExpectRead(reader.get(), offset, size);
+	}
+}
+
+// The single threaded compressor this format was defined by.
+static std::string ReferenceCompress(const std::vector<u8>& data)
+{
+	DiscIO::CompressedBlobHeader header;
+	header.magic_cookie = DiscIO::kBlobCookie;
+	header.sub_type = 0;
+	header.block_size = BLOCK_SIZE;
+	header.data_size = data.size();
+	header.num_blocks = (u32)((data.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+	std::vector<u64> offsets;
+	std::vector<u32> hashes;
+	std::string body;
+	std::vector<u8> in_buf(BLOCK_SIZE), out_buf(BLOCK_SIZE);
+	z_stream z = {};
+	deflateInit(&z, 9);
+	for (u32 i = 0; i < header.num_blocks; i++)
+	{
+		size_t size = std::min<size_t>(BLOCK_SIZE, data.size() - i * BLOCK_SIZE);
+		std::fill(std::copy_n(data.begin() + i * BLOCK_SIZE, size, in_buf.begin()), in_buf.end(), 0);
+
+		deflateReset(&z);
+		z.next_in = in_buf.data();
+		z.avail_in = BLOCK_SIZE;
+		z.next_out = out_buf.data();
+		z.avail_out = BLOCK_SIZE;
+		int status = deflate(&z, Z_FINISH);
+		int comp_size = BLOCK_SIZE - z.avail_out;
+		if (status != Z_STREAM_END || z.avail_out < 10)
+		{
+			offsets.push_back(body.size() | 0x8000000000000000ULL);
+			hashes.push_back(HashAdler32(in_buf.data(), BLOCK_SIZE));
+			body.append((const char*)in_buf.data(), BLOCK_SIZE);
+		}
+		else
+		{
+			offsets.push_back(body.size());
+			hashes.push_back(HashAdler32(out_buf.data(), comp_size));
+			body.append((const char*)out_buf.data(), comp_size);
+		}
+	}
+	deflateEnd(&z);
+	header.compressed_data_size = body.size();
+
+	std::string result((const char*)&header, sizeof(header));
+	result.append((const char*)offsets.data(), offsets.size() * sizeof(u64));
+	result.append((const char*)hashes.data(), hashes.size() * sizeof(u32));
+	return result + body;
+}
+
+TEST_F(CompressedBlobTest, OutputDoesNotDependOnThreads)
+{
+	std::string expected = ReferenceCompress(m_data);
+	for (int threads : {1, 2, 5})
+	{
+		ASSERT_TRUE(DiscIO::CompressFileToBlob(RAW_FILENAME, OTHER_FILENAME, 0, BLOCK_SIZE, nullptr, nullptr, threads));
+		std::string output;
+		ASSERT_TRUE(File::ReadFileToString(OTHER_FILENAME, output));
+		EXPECT_TRUE(expected == output) << threads << " threads";
+	}
+}
+
+TEST_F(CompressedBlobTest, Decompress)
+{
+	for (int threads : {1, 3})
+	{
+		ASSERT_TRUE(DiscIO::DecompressBlobToFile(GCZ_FILENAME, OTHER_FILENAME, &ProgressCallback, nullptr, threads));
+		std::string output;
+		ASSERT_TRUE(File::ReadFileToString(OTHER_FILENAME, output));
+		ASSERT_EQ(m_data.size(), output.size());
+		EXPECT_TRUE(std::equal(m_data.begin(), m_data.end(), (const u8*)output.data())) << threads << " threads";
+	}
+}
@@ -0,0 +1,164 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+#include <polarssl/aes.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/Crypto/AES.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/VolumeWiiCrypted.h"
+
+static const u64 DATA_OFFSET = 0x20000;
+static const u64 NUM_CLUSTERS = 64;
+
+static const u8 s_key[16] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+};
+
+class MemoryBlobReader : public DiscIO::IBlobReader
+{
+public:
+	explicit MemoryBlobReader(const std::vector<u8>& data) : m_data(data) {}
+
+	u64 GetRawSize() const override { return m_data.size(); }
+	u64 GetDataSize() const override { return m_data.size(); }
+	bool Read(u64 offset, u64 size, u8* out_ptr) override
+	{
+		if (offset + size > m_data.size())
+			return false;
+		memcpy(out_ptr, &m_data[offset], (size_t)size);
+		return true;
+	}
+
+private:
+	const std::vector<u8>& m_data;
+};
+
+static u32 NextRandom(u32& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+// A partition with no ticket or TMD, just encrypted clusters whose hash
+// area is noise (only the IV at 0x3d0 matters for reading).
+class VolumeWiiCryptedTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		u32 seed = 0xC0FFEE;
+		m_plain.resize(NUM_CLUSTERS * 0x7C00);
+		for (u8& b : m_plain)
+			b = (u8)NextRandom(seed);
+
+		aes_context ctx;
+		aes_setkey_enc(&ctx, s_key, 128);
+		m_image.resize(DATA_OFFSET + NUM_CLUSTERS * 0x8000);
+		for (u64 i = 0; i < NUM_CLUSTERS; i++)
+		{
+			u8* cluster = &m_image[DATA_OFFSET + i * 0x8000];
+			for (int j = 0; j < 0x400; j++)
+				cluster[j] = (u8)NextRandom(seed);
+			u8 iv[16];
+			memcpy(iv, cluster + 0x3d0, 16);
+			aes_crypt_cbc(&ctx, AES_ENCRYPT, 0x7C00, iv, &m_plain[i * 0x7C00], cluster + 0x400);
+		}
+
+		m_volume.reset(new DiscIO::CVolumeWiiCrypted(new MemoryBlobReader(m_image), 0, s_key));
+	}
+
+	void ExpectRead(u64 offset, u64 size)
+	{
+		std::vector<u8> buffer(size);
+		ASSERT_TRUE(m_volume->Read(offset, size, buffer.data()));
+		EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), m_plain.begin() + offset))
+			<< "offset " << offset << " size " << size;
+	}
+
+	std::vector<u8> m_plain;
+	std::vector<u8> m_image;
+	std::unique_ptr<DiscIO::CVolumeWiiCrypted> m_volume;
+};
+
+TEST_F(VolumeWiiCryptedTest, SmallReads)
+{
+	u32 seed = 1;
+	for (int i = 0; i < 2000; i++)
+	{
+		u64 offset = NextRandom(seed) % m_plain.size();
+		u64 size = std::min<u64>(NextRandom(seed) % 0x1000 + 1, m_plain.size() - offset);
+		ExpectRead(offset, size);
+	}
+}
+
+TEST_F(VolumeWiiCryptedTest, LargeReads)
+{
+	ExpectRead(0, m_plain.size());
+	ExpectRead(0x7C00 * 3, 0x7C00 * 20);
+	ExpectRead(0x7C00 * 5 + 17, 0x7C00 * 30 + 1000);
+	ExpectRead(0x7C00 * 2 - 1, 0x7C00 * 2 + 2);
+}
+
+TEST_F(VolumeWiiCryptedTest, ReadFailsPastEnd)
+{
+	std::vector<u8> buffer(0x100);
+	EXPECT_FALSE(m_volume->Read(m_plain.size(), buffer.size(), buffer.data()));
+}
+
+// Not a real benchmark harness, but gives a number to compare.
+TEST_F(VolumeWiiCryptedTest, Throughput)
+{
+	const int ITERATIONS = 8;
+	std::vector<u8> buffer(m_plain.size());
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++)
+		ASSERT_TRUE(m_volume->Read(0, buffer.size(), buffer.data()));
+	double large = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++)
+		for (u64 offset = 0; offset < buffer.size(); offset += 0x800)
+			ASSERT_TRUE(m_volume->Read(offset, 0x800, &buffer[offset]));
+	double small = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	double megabytes = ITERATIONS * buffer.size() / (1024.0 * 1024.0);
+	printf("AES-NI: %s\n", cpu_info.bAES ? "yes" : "no");
+	printf("Whole image reads: %.1f MB/s\n", megabytes / large);
+	printf("Sequential 2 KiB reads: %.1f MB/s\n", megabytes / small);
+}
+
+TEST(AES, MatchesPolarSSL)
+{
+	if (!cpu_info.bAES)
+		return;
+
+	u32 seed = 42;
+	std::vector<u8> in(0x7C00 + 48);
+	for (u8& b : in)
+		b = (u8)NextRandom(seed);
+	u8 iv[16] = {1, 2, 3};
+	u8 iv2[16];
+	memcpy(iv2, iv, sizeof(iv));
+
+	aes_context ctx;
+	aes_setkey_dec(&ctx, s_key, 128);
+	std::vector<u8> expected(in.size());
+	aes_crypt_cbc(&ctx, AES_DECRYPT, in.size(), iv, in.data(), expected.data());
+
+	u8 round_keys[AES::NUM_ROUND_KEYS * AES::BLOCK_SIZE];
+	AES::ExpandDecryptionKey(s_key, round_keys);
+	std::vector<u8> actual(in.size());
+	AES::DecryptCBC(round_keys, iv2, in.data(), actual.data(), in.size());
+
+	EXPECT_EQ(expected, actual);
+	EXPECT_EQ(0, memcmp(iv, iv2, sizeof(iv)));
+}
@@ -0,0 +1,141 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <set>
+#include <tuple>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/Fifo.h"
+
+static const u32 FIFO_BASE = 0x00200000;
+static const u32 FIFO_LENGTH = 0x00100000;
+
+class FifoBatchTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		memset(&m_fifo, 0, sizeof(m_fifo));
+		m_fifo.CPBase = FIFO_BASE;
+		m_fifo.CPEnd = FIFO_BASE + FIFO_LENGTH - 32;
+		m_fifo.CPReadPointer = FIFO_BASE;
+		m_fifo.CPHiWatermark = FIFO_LENGTH - 0x4000;
+		m_fifo.CPLoWatermark = 0;
+		m_fifo.bFF_GPReadEnable = 1;
+	}
+
+	// What SetCPStatusFromGPU looks at.
+	std::tuple<bool, bool, bool> Status() const
+	{
+		return std::make_tuple(m_fifo.bFF_BPEnable && m_fifo.CPReadPointer == m_fifo.CPBreakpoint,
+		                       m_fifo.CPReadWriteDistance > m_fifo.CPHiWatermark,
+		                       m_fifo.CPReadWriteDistance < m_fifo.CPLoWatermark);
+	}
+
+	void Consume(u32 len)
+	{
+		m_fifo.CPReadPointer += len - 32;
+		if (m_fifo.CPReadPointer == m_fifo.CPEnd)
+			m_fifo.CPReadPointer = m_fifo.CPBase;
+		else
+			m_fifo.CPReadPointer += 32;
+		m_fifo.CPReadWriteDistance -= len;
+	}
+
+	// Reads the whole FIFO the way RunGpuLoop does, and checks that every
+	// read pointer where reading 32 bytes at a time would have seen the
+	// status change is also the end of a batch.
+	void CheckStatusChangesEndBatches()
+	{
+		SCPFifoStruct start = m_fifo;
+		std::set<u32> changes;
+		while (m_fifo.CPReadWriteDistance && !std::get<0>(Status()))
+		{
+			auto before = Status();
+			Consume(32);
+			if (Status() != before)
+				changes.insert((u32)m_fifo.CPReadPointer);
+		}
+
+		m_fifo = start;
+		std::set<u32> batch_ends;
+		while (m_fifo.CPReadWriteDistance && !std::get<0>(Status()))
+		{
+			u32 len = GetFifoBatchSize(m_fifo);
+			ASSERT_EQ(0u, len % 32);
+			ASSERT_LE(len, m_fifo.CPReadWriteDistance);
+			Consume(len);
+			batch_ends.insert((u32)m_fifo.CPReadPointer);
+		}
+
+		for (u32 change : changes)
+			EXPECT_EQ(1u, batch_ends.count(change)) << "status changes at " << std::hex << change;
+	}
+
+	SCPFifoStruct m_fifo;
+};
+
+TEST_F(FifoBatchTest, StopsAtBreakpointInsideBatch)
+{
+	m_fifo.CPReadWriteDistance = 0x8000;
+	m_fifo.CPBreakpoint = FIFO_BASE + 0x1240;
+	m_fifo.bFF_BPEnable = 1;
+	EXPECT_EQ(0x1240u, GetFifoBatchSize(m_fifo));
+
+	// Not enabled, or behind the read pointer.
+	m_fifo.bFF_BPEnable = 0;
+	EXPECT_EQ(0x8000u, GetFifoBatchSize(m_fifo));
+	m_fifo.bFF_BPEnable = 1;
+	m_fifo.CPReadPointer = FIFO_BASE + 0x2000;
+	EXPECT_EQ(0x8000u, GetFifoBatchSize(m_fifo));
+
+	m_fifo.CPReadPointer = FIFO_BASE;
+	CheckStatusChangesEndBatches();
+	EXPECT_EQ(m_fifo.CPBreakpoint, m_fifo.CPReadPointer);
+}
+
+TEST_F(FifoBatchTest, StopsAtWraparound)
+{
+	m_fifo.CPReadPointer = m_fifo.CPEnd - 0x100;
+	m_fifo.CPReadWriteDistance = 0x1000;
+	EXPECT_EQ(0x120u, GetFifoBatchSize(m_fifo));
+	Consume(0x120);
+	EXPECT_EQ(FIFO_BASE, m_fifo.CPReadPointer);
+}
+
+TEST_F(FifoBatchTest, IsCapped)
+{
+	m_fifo.CPReadWriteDistance = 0x40000;
+	u32 len = GetFifoBatchSize(m_fifo);
+	EXPECT_GE(len, 0x1000u);
+	EXPECT_LT(len, 0x40000u);
+}
+
+TEST_F(FifoBatchTest, StopsAtWatermarks)
+{
+	m_fifo.CPReadWriteDistance = 0x30000;
+	m_fifo.CPHiWatermark = 0x2F010;
+	m_fifo.CPLoWatermark = 0x2E000;
+	EXPECT_EQ(0x1000u, GetFifoBatchSize(m_fifo));
+	Consume(0x1000);
+	EXPECT_EQ(0x1020u, GetFifoBatchSize(m_fifo));
+
+	m_fifo.CPReadPointer = FIFO_BASE;
+	m_fifo.CPReadWriteDistance = 0x30000;
+	CheckStatusChangesEndBatches();
+}
+
+TEST_F(FifoBatchTest, StopsAtEverything)
+{
+	m_fifo.CPReadPointer = FIFO_BASE + FIFO_LENGTH - 0x8000;
+	m_fifo.CPReadWriteDistance = 0x60000;
+	m_fifo.CPHiWatermark = 0x4A345;
+	m_fifo.CPLoWatermark = 0x1234;
+	m_fifo.CPBreakpoint = FIFO_BASE + 0x30000;
+	m_fifo.bFF_BPEnable = 1;
+	CheckStatusChangesEndBatches();
+	EXPECT_EQ(m_fifo.CPBreakpoint, m_fifo.CPReadPointer);
+}
@@ -0,0 +1,387 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Draws batches of random triangles with the software rasterizer, on the
+// GPU thread alone and with several threads, and reports how many million
+// pixels per second each one gets through. With --verify, the EFB, the
+// performance counters, the bounding box and the statistics after drawing
+// with several threads are instead compared against drawing with one.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Timer.h"
+
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoCommon/BoundingBox.h"
+#include "VideoCommon/BPMemory.h"
+
+namespace
+{
+
+struct Scene
+{
+	const char* name;
+	// Sets up everything but the scissor and the konst color.
+	void (*setup)();
+};
+
+void SetupCommon()
+{
+	memset(&bpmem, 0, sizeof(bpmem));
+
+	bpmem.genMode.numcolchans = 1;
+	bpmem.genMode.numtevstages = 1;
+
+	// Identity swap table
+	bpmem.tevksel[0].swap1 = 0;
+	bpmem.tevksel[0].swap2 = 1;
+	bpmem.tevksel[1].swap1 = 2;
+	bpmem.tevksel[1].swap2 = 3;
+
+	// Stage 0: prev = ras
+	TevStageCombiner::ColorCombiner& cc0 = bpmem.combiners[0].colorC;
+	TevStageCombiner::AlphaCombiner& ac0 = bpmem.combiners[0].alphaC;
+	cc0.a = cc0.b = cc0.c = TEVCOLORARG_ZERO;
+	cc0.d = TEVCOLORARG_RASC;
+	cc0.clamp = 1;
+	ac0.a = ac0.b = ac0.c = TEVALPHAARG_ZERO;
+	ac0.d = TEVALPHAARG_RASA;
+	ac0.clamp = 1;
+
+	// Stage 1: prev = lerp(prev, konst, ras.a)
+	bpmem.tevksel[0].kcsel1 = 12; // K0
+	TevStageCombiner::ColorCombiner& cc1 = bpmem.combiners[1].colorC;
+	TevStageCombiner::AlphaCombiner& ac1 = bpmem.combiners[1].alphaC;
+	cc1.a = TEVCOLORARG_CPREV;
+	cc1.b = TEVCOLORARG_KONST;
+	cc1.c = TEVCOLORARG_RASA;
+	cc1.d = TEVCOLORARG_ZERO;
+	cc1.clamp = 1;
+	ac1.a = ac1.b = ac1.c = TEVALPHAARG_ZERO;
+	ac1.d = TEVALPHAARG_APREV;
+	ac1.clamp = 1;
+
+	bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+	bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+
+	bpmem.zmode.testenable = 1;
+	bpmem.zmode.func = ZMode::LEQUAL;
+	bpmem.zmode.updateenable = 1;
+
+	bpmem.blendmode.blendenable = 1;
+	bpmem.blendmode.colorupdate = 1;
+	bpmem.blendmode.alphaupdate = 1;
+	bpmem.blendmode.srcfactor = BlendMode::SRCALPHA;
+	bpmem.blendmode.dstfactor = BlendMode::INVSRCALPHA;
+	bpmem.zcontrol.pixel_format = PEControl::RGBA6_Z24;
+}
+
+void SetupEarlyZ()
+{
+	SetupCommon();
+	bpmem.zcontrol.early_ztest = 1;
+}
+
+// Stage 0 reads c0 before stage 1 writes it, so every pixel sees what the
+// previous one left there.
+void SetupOrderDependent()
+{
+	SetupCommon();
+	bpmem.combiners[0].colorC.b = TEVCOLORARG_C0;
+	bpmem.combiners[0].colorC.c = TEVCOLORARG_RASA;
+	bpmem.combiners[1].colorC.dest = GX_TEVREG0;
+	bpmem.combiners[1].alphaC.dest = GX_TEVREG0;
+	bpmem.combiners[2] = bpmem.combiners[0];
+	bpmem.genMode.numtevstages = 2;
+}
+
+const Scene s_scenes[] = {
+	{ "late z", SetupCommon },
+	{ "early z", SetupEarlyZ },
+	{ "order dependent", SetupOrderDependent },
+};
+
+struct Vertex
+{
+	float x, y, z;
+	u8 color[4];
+};
+
+// Fills a batch with the same pseudo-random triangles for a given seed, in
+// the winding the rasterizer draws.
+std::vector<Vertex> RandomTriangles(u32 seed, int count, float max_size)
+{
+	auto next = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 8) & 0xffff;
+	};
+
+	std::vector<Vertex> vertices;
+	for (int i = 0; i < count; i++)
+	{
+		float cx = next() * EFB_WIDTH / 65536.f;
+		float cy = next() * EFB_HEIGHT / 65536.f;
+		Vertex tri[3];
+		for (Vertex& v : tri)
+		{
+			v.x = cx + (next() / 65536.f - 0.5f) * max_size;
+			v.y = cy + (next() / 65536.f - 0.5f) * max_size;
+			v.z = (float)(next() << 8);
+			for (u8& c : v.color)
+				c = (u8)next();
+		}
+
+		float cross = (tri[1].x - tri[0].x) * (tri[2].y - tri[0].y) - (tri[1].y - tri[0].y) * (tri[2].x - tri[0].x);
+		if (cross > 0)
+			std::swap(tri[1], tri[2]);
+
+		vertices.insert(vertices.end(), tri, tri + 3);
+	}
+	return vertices;
+}
+
+struct Result
+{
+	std::vector<u8> colors;
+	std::vector<u32> depths;
+	u32 perf[PQ_NUM_MEMBERS];
+	u16 bbox[4];
+	u32 rasterizedPixels;
+	u32 tevPixelsIn;
+	u32 tevPixelsOut;
+};
+
+// Draws the triangles in primitives of 64, flushing the rasterizer after
+// each like the opcode decoder does.
+void Draw(const Scene& scene, const std::vector<Vertex>& vertices)
+{
+	for (size_t i = 0; i < vertices.size(); i += 3)
+	{
+		OutputVertexData v[3];
+		memset(v, 0, sizeof(v));
+		for (int j = 0; j < 3; j++)
+		{
+			const Vertex& in = vertices[i + j];
+			v[j].screenPosition.x = in.x;
+			v[j].screenPosition.y = in.y;
+			v[j].screenPosition.z = in.z;
+			v[j].projectedPosition.w = 1.0f;
+			memcpy(v[j].color[0], in.color, 4);
+		}
+		Rasterizer::DrawTriangleFrontFace(&v[0], &v[1], &v[2]);
+
+		if ((i / 3) % 64 == 63)
+			Rasterizer::Flush();
+	}
+	Rasterizer::Flush();
+}
+
+void Start(const Scene& scene, int threads)
+{
+	g_SWVideoConfig.iRasterizerThreads = threads;
+	Rasterizer::Init();
+
+	scene.setup();
+	bpmem.scissorOffset.x = 342 / 2;
+	bpmem.scissorOffset.y = 342 / 2;
+	bpmem.scissorTL.x = 342;
+	bpmem.scissorTL.y = 342;
+	bpmem.scissorBR.x = 341 + EFB_WIDTH;
+	bpmem.scissorBR.y = 341 + EFB_HEIGHT;
+	Rasterizer::SetScissor();
+
+	// The registers keep whatever the last pixel of the previous run left.
+	const s16 konst[4] = { 0xff, 0x40, 0x80, 0xc0 };
+	for (int comp = 0; comp < 4; comp++)
+	{
+		Rasterizer::SetTevReg(0, comp, true, konst[comp]);
+		for (int reg = 0; reg < 4; reg++)
+			Rasterizer::SetTevReg(reg, comp, false, 0);
+	}
+
+	u8 clear[4] = { 0x10, 0x20, 0x30, 0x40 };
+	for (u16 y = 0; y < EFB_HEIGHT; y++)
+	{
+		for (u16 x = 0; x < EFB_WIDTH; x++)
+		{
+			EfbInterface::SetColor(x, y, clear);
+			EfbInterface::SetDepth(x, y, 0xffffff);
+		}
+	}
+
+	memset(EfbInterface::perf_values, 0, sizeof(EfbInterface::perf_values));
+	memset(EfbInterface::perf_quad_pixels, 0, sizeof(EfbInterface::perf_quad_pixels));
+	BoundingBox::coords[BoundingBox::LEFT] = 0x3ff;
+	BoundingBox::coords[BoundingBox::RIGHT] = 0;
+	BoundingBox::coords[BoundingBox::TOP] = 0x3ff;
+	BoundingBox::coords[BoundingBox::BOTTOM] = 0;
+	swstats.ResetFrame();
+}
+
+Result Render(const Scene& scene, int threads, const std::vector<Vertex>& vertices)
+{
+	Start(scene, threads);
+	Draw(scene, vertices);
+
+	Result result;
+	result.colors.resize(EFB_WIDTH * EFB_HEIGHT * 4);
+	result.depths.resize(EFB_WIDTH * EFB_HEIGHT);
+	for (u16 y = 0; y < EFB_HEIGHT; y++)
+	{
+		for (u16 x = 0; x < EFB_WIDTH; x++)
+		{
+			EfbInterface::GetColor(x, y, &result.colors[(y * EFB_WIDTH + x) * 4]);
+			result.depths[y * EFB_WIDTH + x] = EfbInterface::GetDepth(x, y);
+		}
+	}
+	memcpy(result.perf, EfbInterface::perf_values, sizeof(result.perf));
+	memcpy(result.bbox, BoundingBox::coords, sizeof(result.bbox));
+	result.rasterizedPixels = swstats.thisFrame.rasterizedPixels;
+	result.tevPixelsIn = swstats.thisFrame.tevPixelsIn;
+	result.tevPixelsOut = swstats.thisFrame.tevPixelsOut;
+
+	Rasterizer::Shutdown();
+	return result;
+}
+
+// Returns false if drawing with several threads gives a different result.
+bool Verify(const Scene& scene, int threads)
+{
+	bool success = true;
+	const float sizes[] = { 8.f, 64.f, 400.f };
+	for (float size : sizes)
+	{
+		std::vector<Vertex> vertices = RandomTriangles((u32)size, size < 100.f ? 2000 : 100, size);
+		Result expected = Render(scene, 1, vertices);
+		Result actual = Render(scene, threads, vertices);
+
+		if (expected.tevPixelsOut == 0)
+		{
+			printf("MISMATCH %s size %.0f: nothing was drawn\n", scene.name, size);
+			success = false;
+		}
+		for (int i = 0; i < EFB_WIDTH * EFB_HEIGHT; i++)
+		{
+			if (memcmp(&actual.colors[i * 4], &expected.colors[i * 4], 4) || actual.depths[i] != expected.depths[i])
+			{
+				printf("MISMATCH %s size %.0f: pixel (%d, %d) differs\n", scene.name, size, i % EFB_WIDTH, i / EFB_WIDTH);
+				success = false;
+				break;
+			}
+		}
+		if (memcmp(actual.perf, expected.perf, sizeof(actual.perf)) || memcmp(actual.bbox, expected.bbox, sizeof(actual.bbox)))
+		{
+			printf("MISMATCH %s size %.0f: performance counters or bounding box differ\n", scene.name, size);
+			success = false;
+		}
+		if (actual.rasterizedPixels != expected.rasterizedPixels || actual.tevPixelsIn != expected.tevPixelsIn ||
+		    actual.tevPixelsOut != expected.tevPixelsOut)
+		{
+			printf("MISMATCH %s size %.0f: statistics differ\n", scene.name, size);
+			success = false;
+		}
+	}
+	return success;
+}
+
+// Returns million rasterized pixels per second.
+double Measure(const Scene& scene, int threads, const std::vector<Vertex>& vertices, u64 min_time_us)
+{
+	Start(scene, threads);
+	Draw(scene, vertices);
+
+	u64 pixels = 0;
+	u64 start = Common::Timer::GetTimeUs();
+	u64 elapsed;
+	do
+	{
+		swstats.ResetFrame();
+		Draw(scene, vertices);
+		pixels += swstats.thisFrame.rasterizedPixels;
+		elapsed = Common::Timer::GetTimeUs() - start;
+	} while (elapsed < min_time_us);
+
+	Rasterizer::Shutdown();
+	return pixels / (double)elapsed;
+}
+
+void PrintUsage(const char* argv0)
+{
+	printf("Usage: %s [--verify] [--threads <n>] [--time <ms>]\n"
+	       "  --verify       compare drawing with several threads against drawing with one instead of measuring\n"
+	       "  --threads <n>  number of threads to compare against one (default 0, one per core)\n"
+	       "  --time <ms>    minimum time to measure each scene (default 500)\n",
+	       argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	bool verify = false;
+	int threads = 0;
+	u64 min_time_us = 500000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--verify"))
+		{
+			verify = true;
+		}
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+		{
+			min_time_us = strtoull(argv[++i], nullptr, 10) * 1000;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (verify)
+	{
+		// Make sure there's more than one thread even on single core machines.
+		if (threads == 0)
+			threads = 4;
+
+		int failures = 0;
+		for (const Scene& scene : s_scenes)
+		{
+			if (!Verify(scene, threads))
+				failures++;
+		}
+		printf("%d of %d scenes verified, %d mismatches\n",
+		       (int)(sizeof(s_scenes) / sizeof(s_scenes[0])) - failures, (int)(sizeof(s_scenes) / sizeof(s_scenes[0])), failures);
+		return failures ? 1 : 0;
+	}
+
+	printf("%-24s %12s %12s\n", "scene (Mpixels/s)", "1 thread", "threads");
+	for (const Scene& scene : s_scenes)
+	{
+		for (float size : { 16.f, 128.f })
+		{
+			std::vector<Vertex> vertices = RandomTriangles(1, 2000, size);
+			std::string name = std::string(scene.name) + (size < 100.f ? ", small" : ", large");
+			printf("%-24s %12.1f", name.c_str(), Measure(scene, 1, vertices, min_time_us));
+			printf(" %12.1f\n", Measure(scene, threads, vertices, min_time_us));
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,276 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Decodes every texture format with every texture decoder and reports how
+// many MB of RGBA8 output each one produces per second. With --verify, the
+// output of every decoder is instead compared against TexDecoder_DecodeTexel.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+
+typedef PC_TexFormat (*DecodeFunc)(u32* dst, const u8* src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt);
+
+struct DecoderType
+{
+	const char* name;
+	DecodeFunc decode;
+	// Whether the host CPU can run it.
+	bool (*supported)();
+};
+
+bool AlwaysSupported()
+{
+	return true;
+}
+
+#ifdef _M_X86
+bool AVX2Supported()
+{
+	return cpu_info.bAVX2;
+}
+#endif
+
+const DecoderType s_decoder_types[] = {
+	{ "Generic", _TexDecoder_DecodeImpl_Generic, AlwaysSupported },
+#ifdef _M_X86
+	{ "x64", _TexDecoder_DecodeImpl_x64, AlwaysSupported },
+	{ "AVX2", _TexDecoder_DecodeImpl_AVX2, AVX2Supported },
+#endif
+};
+
+struct DecodeFormat
+{
+	std::string name;
+	int texformat;
+	TlutFormat tlutfmt;
+};
+
+const char* const s_tlut_names[] = { "IA8", "RGB565", "RGB5A3" };
+
+// C14X2 indexes up to 16384 TLUT entries, and the AVX2 decoder reads two
+// bytes past the one it looks up.
+const int TLUT_SIZE = 16384 * 2 + 4;
+const int MAX_WIDTH = 512;
+const int MAX_HEIGHT = 512;
+
+std::vector<u8> s_src;
+std::vector<u8> s_tlut;
+std::vector<u32> s_output;
+
+std::vector<DecodeFormat> AllFormats()
+{
+	std::vector<DecodeFormat> formats;
+	const struct
+	{
+		const char* name;
+		int texformat;
+	} direct[] = {
+		{ "I4", GX_TF_I4 },
+		{ "I8", GX_TF_I8 },
+		{ "IA4", GX_TF_IA4 },
+		{ "IA8", GX_TF_IA8 },
+		{ "RGB565", GX_TF_RGB565 },
+		{ "RGB5A3", GX_TF_RGB5A3 },
+		{ "RGBA8", GX_TF_RGBA8 },
+		{ "CMPR", GX_TF_CMPR },
+	};
+	for (const auto& f : direct)
+		formats.push_back({ f.name, f.texformat, GX_TL_IA8 });
+
+	const struct
+	{
+		const char* name;
+		int texformat;
+	} paletted[] = {
+		{ "C4", GX_TF_C4 },
+		{ "C8", GX_TF_C8 },
+		{ "C14X2", GX_TF_C14X2 },
+	};
+	for (const auto& f : paletted)
+		for (int tlutfmt = GX_TL_IA8; tlutfmt <= GX_TL_RGB5A3; tlutfmt++)
+			formats.push_back({ StringFromFormat("%s %s", f.name, s_tlut_names[tlutfmt]), f.texformat, (TlutFormat)tlutfmt });
+
+	return formats;
+}
+
+// Fills the texture and the TLUT with pseudo-random data, the same data for a
+// given seed.
+void FillRandom(u32 seed)
+{
+	s_src.resize(TexDecoder_GetTextureSizeInBytes(MAX_WIDTH, MAX_HEIGHT, GX_TF_RGBA8));
+	s_tlut.resize(TLUT_SIZE);
+	for (u8& b : s_src)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+	for (u8& b : s_tlut)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+}
+
+// Returns false if any decoder disagrees with TexDecoder_DecodeTexel.
+bool Verify(const DecodeFormat& format)
+{
+	// Several blocks in each direction, and not a power of two.
+	const int width = 72;
+	const int height = 40;
+	FillRandom(format.texformat * 3 + format.tlutfmt);
+
+	std::vector<u32> expected(width * height);
+	if (format.texformat == GX_TF_CMPR)
+	{
+		// TexDecoder_DecodeTexel interpolates CMPR colors in exact thirds, the
+		// block decoders use a cheaper approximation. Check them against the
+		// Generic one instead.
+		s_decoder_types[0].decode(expected.data(), s_src.data(), width, height, format.texformat,
+		                          s_tlut.data(), format.tlutfmt);
+	}
+	else
+	{
+		for (int t = 0; t < height; t++)
+			for (int s = 0; s < width; s++)
+				TexDecoder_DecodeTexel((u8*)&expected[t * width + s], s_src.data(), s, t, width - 1,
+				                       format.texformat, s_tlut.data(), format.tlutfmt);
+	}
+
+	bool success = true;
+	for (const DecoderType& type : s_decoder_types)
+	{
+		if (!type.supported())
+			continue;
+
+		s_output.assign(width * height, 0xCDCDCDCD);
+		type.decode(s_output.data(), s_src.data(), width, height, format.texformat, s_tlut.data(), format.tlutfmt);
+
+		for (int i = 0; i < width * height; i++)
+		{
+			if (s_output[i] != expected[i])
+			{
+				printf("MISMATCH %s %s: texel (%d, %d) is %08x, expected %08x\n", format.name.c_str(), type.name,
+				       i % width, i / width, s_output[i], expected[i]);
+				success = false;
+				break;
+			}
+		}
+	}
+	return success;
+}
+
+// Returns MB of decoded output per second.
+double Measure(const DecoderType& type, const DecodeFormat& format, u64 min_time_us)
+{
+	const int width = MAX_WIDTH;
+	const int height = MAX_HEIGHT;
+	s_output.resize(width * height);
+	type.decode(s_output.data(), s_src.data(), width, height, format.texformat, s_tlut.data(), format.tlutfmt);
+
+	u64 textures = 0;
+	u64 start = Common::Timer::GetTimeUs();
+	u64 elapsed;
+	do
+	{
+		for (int i = 0; i < 4; i++)
+			type.decode(s_output.data(), s_src.data(), width, height, format.texformat, s_tlut.data(), format.tlutfmt);
+		textures += 4;
+		elapsed = Common::Timer::GetTimeUs() - start;
+	} while (elapsed < min_time_us);
+
+	return textures * width * height * 4 / (double)elapsed;
+}
+
+void PrintUsage(const char* argv0)
+{
+	printf("Usage: %s [--verify] [--filter <text>] [--time <ms>]\n"
+	       "  --verify         compare every decoder against TexDecoder_DecodeTexel instead of measuring\n"
+	       "  --filter <text>  only use formats with <text> in their name\n"
+	       "  --time <ms>      minimum time to measure each decoder and format (default 100)\n",
+	       argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	bool verify = false;
+	std::string filter;
+	u64 min_time_us = 100000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--verify"))
+		{
+			verify = true;
+		}
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+		{
+			min_time_us = strtoull(argv[++i], nullptr, 10) * 1000;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<DecodeFormat> formats;
+	for (const DecodeFormat& format : AllFormats())
+	{
+		if (format.name.find(filter) != std::string::npos)
+			formats.push_back(format);
+	}
+
+	if (verify)
+	{
+		int failures = 0;
+		for (const DecodeFormat& format : formats)
+		{
+			if (!Verify(format))
+				failures++;
+		}
+		printf("%d of %d formats verified, %d mismatches\n",
+		       (int)formats.size() - failures, (int)formats.size(), failures);
+		return failures ? 1 : 0;
+	}
+
+	printf("%-16s", "format (MB/s)");
+	for (const DecoderType& type : s_decoder_types)
+		printf(" %12s", type.name);
+	printf("\n");
+
+	for (const DecodeFormat& format : formats)
+	{
+		FillRandom(format.texformat);
+		printf("%-16s", format.name.c_str());
+		for (const DecoderType& type : s_decoder_types)
+		{
+			if (type.supported())
+				printf(" %12.1f", Measure(type, format, min_time_us));
+			else
+				printf(" %12s", "unsupported");
+		}
+		printf("\n");
+		fflush(stdout);
+	}
+	return 0;
+}
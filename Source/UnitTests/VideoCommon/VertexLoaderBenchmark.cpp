@@ -0,0 +1,463 @@
+// Copyright 2015 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Sweeps vertex formats through every vertex loader and reports how many
+// vertices per second each one manages. With --verify, the output of every
+// loader is instead compared byte for byte against VertexLoader.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/VertexLoader.h"
+#include "VideoCommon/VertexLoaderBase.h"
+
+#ifdef _M_X86
+#include "VideoCommon/VertexLoaderX64.h"
+#endif
+
+namespace
+{
+
+struct LoaderType
+{
+	const char* name;
+	VertexLoaderBase* (*create)(const TVtxDesc& vtx_desc, const VAT& vtx_attr);
+};
+
+template <typename T>
+VertexLoaderBase* CreateLoader(const TVtxDesc& vtx_desc, const VAT& vtx_attr)
+{
+	return new T(vtx_desc, vtx_attr);
+}
+
+// The first one is the reference the others are checked against.
+const LoaderType s_loader_types[] = {
+	{ "VertexLoader", CreateLoader<VertexLoader> },
+#ifdef _M_X86
+	{ "VertexLoaderX64", CreateLoader<VertexLoaderX64> },
+#endif
+};
+const int NUM_LOADER_TYPES = sizeof(s_loader_types) / sizeof(s_loader_types[0]);
+
+struct VertexFormat
+{
+	std::string name;
+	TVtxDesc desc;
+	VAT vat;
+};
+
+const char* const s_mode_names[] = { "-", "Dir", "I8", "I16" };
+const char* const s_format_names[] = { "u8", "s8", "u16", "s16", "flt" };
+const char* const s_color_names[] = { "565", "888", "888x", "4444", "6666", "8888" };
+
+// Array entries are 40 bytes apart, which fits the largest attribute (a float NBT normal).
+const u32 ARRAY_STRIDE = 40;
+const int MAX_VERTICES = 4096;
+
+u8 s_input[MAX_VERTICES * 256 + 64];
+u8 s_arrays[65536 * ARRAY_STRIDE + 64];
+std::vector<u8> s_output_reference;
+std::vector<u8> s_output;
+
+VertexFormat EmptyFormat()
+{
+	VertexFormat format;
+	memset(&format.desc, 0, sizeof(format.desc));
+	memset(&format.vat, 0, sizeof(format.vat));
+	format.vat.g0.ByteDequant = 1;
+	return format;
+}
+
+void AddPositionFormats(std::vector<VertexFormat>* formats)
+{
+	for (int mode = DIRECT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_UBYTE; format <= FORMAT_FLOAT; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	for (int frac : { 0, 6, 14 })
+	{
+		if (format == FORMAT_FLOAT && frac)
+			continue;
+
+		VertexFormat f = EmptyFormat();
+		f.desc.Position = mode;
+		f.vat.g0.PosFormat = format;
+		f.vat.g0.PosElements = elements;
+		f.vat.g0.PosFrac = frac;
+		f.name = StringFromFormat("P %s %s %s frac %d", s_mode_names[mode], s_format_names[format],
+		                          elements ? "XYZ" : "XY", frac);
+		formats->push_back(f);
+	}
+}
+
+void AddNormalFormats(std::vector<VertexFormat>* formats)
+{
+	for (int mode = DIRECT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_UBYTE; format <= FORMAT_FLOAT; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	for (int index3 = 0; index3 <= 1; index3++)
+	{
+		// NormalIndex3 only matters for indexed NBT normals.
+		if (index3 && (mode == DIRECT || !elements))
+			continue;
+
+		VertexFormat f = EmptyFormat();
+		f.desc.Position = DIRECT;
+		f.vat.g0.PosFormat = FORMAT_FLOAT;
+		f.vat.g0.PosElements = 1;
+		f.desc.Normal = mode;
+		f.vat.g0.NormalFormat = format;
+		f.vat.g0.NormalElements = elements;
+		f.vat.g0.NormalIndex3 = index3;
+		f.name = StringFromFormat("P Dir flt XYZ, N %s %s %s%s", s_mode_names[mode], s_format_names[format],
+		                          elements ? "NBT" : "N", index3 ? " index3" : "");
+		formats->push_back(f);
+	}
+}
+
+void AddColorFormats(std::vector<VertexFormat>* formats)
+{
+	for (int mode = DIRECT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_16B_565; format <= FORMAT_32B_8888; format++)
+	for (int both = 0; both <= 1; both++)
+	{
+		VertexFormat f = EmptyFormat();
+		f.desc.Position = DIRECT;
+		f.vat.g0.PosFormat = FORMAT_FLOAT;
+		f.vat.g0.PosElements = 1;
+		f.desc.Color0 = mode;
+		f.vat.g0.Color0Comp = format;
+		f.vat.g0.Color0Elements = 1;
+		if (both)
+		{
+			f.desc.Color1 = mode;
+			f.vat.g0.Color1Comp = format;
+			f.vat.g0.Color1Elements = 1;
+		}
+		f.name = StringFromFormat("P Dir flt XYZ, C0%s %s %s", both ? "+C1" : "",
+		                          s_mode_names[mode], s_color_names[format]);
+		formats->push_back(f);
+	}
+}
+
+void AddTexCoordFormats(std::vector<VertexFormat>* formats)
+{
+	for (int mode = DIRECT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_UBYTE; format <= FORMAT_FLOAT; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	for (int frac : { 0, 7, 15 })
+	{
+		if (format == FORMAT_FLOAT && frac)
+			continue;
+
+		VertexFormat f = EmptyFormat();
+		f.desc.Position = DIRECT;
+		f.vat.g0.PosFormat = FORMAT_FLOAT;
+		f.vat.g0.PosElements = 1;
+		f.desc.Tex0Coord = mode;
+		f.vat.g0.Tex0CoordFormat = format;
+		f.vat.g0.Tex0CoordElements = elements;
+		f.vat.g0.Tex0Frac = frac;
+		f.name = StringFromFormat("P Dir flt XYZ, T0 %s %s %s frac %d", s_mode_names[mode], s_format_names[format],
+		                          elements ? "ST" : "S", frac);
+		formats->push_back(f);
+	}
+}
+
+// A few combinations which games actually use a lot.
+void AddMixedFormats(std::vector<VertexFormat>* formats)
+{
+	VertexFormat f = EmptyFormat();
+	f.desc.PosMatIdx = 1;
+	f.desc.Position = INDEX16;
+	f.vat.g0.PosFormat = FORMAT_FLOAT;
+	f.vat.g0.PosElements = 1;
+	f.desc.Normal = INDEX16;
+	f.vat.g0.NormalFormat = FORMAT_FLOAT;
+	f.desc.Color0 = INDEX16;
+	f.vat.g0.Color0Comp = FORMAT_32B_8888;
+	f.vat.g0.Color0Elements = 1;
+	f.desc.Tex0Coord = INDEX16;
+	f.vat.g0.Tex0CoordFormat = FORMAT_FLOAT;
+	f.vat.g0.Tex0CoordElements = 1;
+	f.name = "skinned: PMtx, P I16 flt, N I16 flt, C0 I16 8888, T0 I16 flt";
+	formats->push_back(f);
+
+	f = EmptyFormat();
+	f.desc.Position = INDEX16;
+	f.vat.g0.PosFormat = FORMAT_SHORT;
+	f.vat.g0.PosElements = 1;
+	f.vat.g0.PosFrac = 8;
+	f.desc.Normal = INDEX8;
+	f.vat.g0.NormalFormat = FORMAT_BYTE;
+	f.desc.Tex0Coord = INDEX16;
+	f.vat.g0.Tex0CoordFormat = FORMAT_SHORT;
+	f.vat.g0.Tex0CoordElements = 1;
+	f.vat.g0.Tex0Frac = 10;
+	f.desc.Tex1Coord = INDEX16;
+	f.vat.g1.Tex1CoordFormat = FORMAT_USHORT;
+	f.vat.g1.Tex1CoordElements = 1;
+	f.vat.g1.Tex1Frac = 15;
+	f.name = "static: P I16 s16, N I8 s8, T0 I16 s16, T1 I16 u16";
+	formats->push_back(f);
+
+	f = EmptyFormat();
+	f.desc.Position = DIRECT;
+	f.vat.g0.PosFormat = FORMAT_SHORT;
+	f.vat.g0.PosElements = 0;
+	f.desc.Color0 = DIRECT;
+	f.vat.g0.Color0Comp = FORMAT_32B_8888;
+	f.vat.g0.Color0Elements = 1;
+	f.desc.Tex0Coord = DIRECT;
+	f.vat.g0.Tex0CoordFormat = FORMAT_FLOAT;
+	f.vat.g0.Tex0CoordElements = 1;
+	f.name = "2D: P Dir s16 XY, C0 Dir 8888, T0 Dir flt";
+	formats->push_back(f);
+
+	f = EmptyFormat();
+	f.desc.Hex = 0x1FF; // all matrix indices
+	f.desc.Position = DIRECT;
+	f.vat.g0.PosFormat = FORMAT_FLOAT;
+	f.vat.g0.PosElements = 1;
+	f.desc.Normal = DIRECT;
+	f.vat.g0.NormalFormat = FORMAT_FLOAT;
+	f.vat.g0.NormalElements = 1;
+	f.desc.Color0 = DIRECT;
+	f.vat.g0.Color0Comp = FORMAT_32B_8888;
+	f.vat.g0.Color0Elements = 1;
+	f.desc.Color1 = DIRECT;
+	f.vat.g0.Color1Comp = FORMAT_32B_8888;
+	f.vat.g0.Color1Elements = 1;
+	f.desc.Tex0Coord = f.desc.Tex1Coord = f.desc.Tex2Coord = f.desc.Tex3Coord = DIRECT;
+	f.desc.Tex4Coord = f.desc.Tex5Coord = f.desc.Tex6Coord = f.desc.Tex7Coord = DIRECT;
+	f.vat.g0.Tex0CoordFormat = f.vat.g1.Tex1CoordFormat = f.vat.g1.Tex2CoordFormat = FORMAT_FLOAT;
+	f.vat.g1.Tex3CoordFormat = f.vat.g1.Tex4CoordFormat = f.vat.g2.Tex5CoordFormat = FORMAT_FLOAT;
+	f.vat.g2.Tex6CoordFormat = f.vat.g2.Tex7CoordFormat = FORMAT_FLOAT;
+	f.vat.g0.Tex0CoordElements = f.vat.g1.Tex1CoordElements = f.vat.g1.Tex2CoordElements = 1;
+	f.vat.g1.Tex3CoordElements = f.vat.g1.Tex4CoordElements = f.vat.g2.Tex5CoordElements = 1;
+	f.vat.g2.Tex6CoordElements = f.vat.g2.Tex7CoordElements = 1;
+	f.name = "everything: all matrices, P/N/C0/C1/T0-7 Dir flt 8888";
+	formats->push_back(f);
+}
+
+// Fills the input stream and the vertex arrays with pseudo-random data, the
+// same data for a given seed.
+void FillRandom(u32 seed)
+{
+	for (u8& b : s_input)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+	for (u8& b : s_arrays)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		// Leave room in front, VertexLoader reads 6666 colors from one byte early.
+		cached_arraybases[i] = s_arrays + 16;
+		g_main_cp_state.array_strides[i] = ARRAY_STRIDE;
+	}
+}
+
+int Run(VertexLoaderBase* loader, int count, std::vector<u8>* output)
+{
+	output->resize(count * loader->m_native_vtx_decl.stride + 4);
+	DataReader src(s_input + 16, s_input + sizeof(s_input));
+	DataReader dst(output->data(), output->data() + output->size());
+	return loader->RunVertices(GX_DRAW_TRIANGLES, count, src, dst);
+}
+
+// Returns false if any loader disagrees with the reference.
+bool Verify(const VertexFormat& format)
+{
+	const int count = 1000;
+	FillRandom((u32)(format.desc.Hex ^ format.vat.g0.Hex ^ (format.vat.g1.Hex << 7)));
+
+	std::unique_ptr<VertexLoaderBase> reference(s_loader_types[0].create(format.desc, format.vat));
+	const int stride = reference->m_native_vtx_decl.stride;
+	const int count_reference = Run(reference.get(), count, &s_output_reference);
+
+	bool success = true;
+	for (int i = 1; i < NUM_LOADER_TYPES; i++)
+	{
+		std::unique_ptr<VertexLoaderBase> loader(s_loader_types[i].create(format.desc, format.vat));
+		if (!loader->IsInitialized())
+			continue;
+
+		std::string error;
+		if (loader->m_VertexSize != reference->m_VertexSize)
+			error = StringFromFormat("vertex size %d, expected %d", loader->m_VertexSize, reference->m_VertexSize);
+		else if (loader->m_native_components != reference->m_native_components ||
+		         memcmp(&loader->m_native_vtx_decl, &reference->m_native_vtx_decl, sizeof(PortableVertexDeclaration)))
+			error = "different native vertex format";
+
+		if (error.empty())
+		{
+			int loaded = Run(loader.get(), count, &s_output);
+			if (loaded != count_reference)
+				error = StringFromFormat("loaded %d vertices, expected %d", loaded, count_reference);
+
+			for (int v = 0; v < count_reference && error.empty(); v++)
+			{
+				const u8* expected = s_output_reference.data() + v * stride;
+				const u8* actual = s_output.data() + v * stride;
+				for (int b = 0; b < stride; b++)
+				{
+					if (expected[b] != actual[b])
+					{
+						error = StringFromFormat("vertex %d differs at byte %d: 0x%02x, expected 0x%02x",
+						                         v, b, actual[b], expected[b]);
+						break;
+					}
+				}
+			}
+		}
+
+		if (!error.empty())
+		{
+			printf("MISMATCH %s (%08x%08x %08x %08x %08x) %s: %s\n", format.name.c_str(),
+			       (u32)(format.desc.Hex >> 32), (u32)format.desc.Hex,
+			       format.vat.g0.Hex, format.vat.g1.Hex, format.vat.g2.Hex,
+			       s_loader_types[i].name, error.c_str());
+			success = false;
+		}
+	}
+	return success;
+}
+
+// Returns the vertices per second, or 0 if the loader doesn't support the format.
+double Measure(const LoaderType& type, const VertexFormat& format, u64 min_time_us)
+{
+	std::unique_ptr<VertexLoaderBase> loader(type.create(format.desc, format.vat));
+	if (!loader->IsInitialized())
+		return 0;
+
+	const int count = MAX_VERTICES;
+	Run(loader.get(), count, &s_output);
+
+	u64 vertices = 0;
+	u64 start = Common::Timer::GetTimeUs();
+	u64 elapsed;
+	do
+	{
+		for (int i = 0; i < 16; i++)
+			Run(loader.get(), count, &s_output);
+		vertices += 16 * count;
+		elapsed = Common::Timer::GetTimeUs() - start;
+	} while (elapsed < min_time_us);
+
+	return vertices * 1000000.0 / elapsed;
+}
+
+void PrintUsage(const char* argv0)
+{
+	printf("Usage: %s [--verify] [--filter <text>] [--time <ms>]\n"
+	       "  --verify         compare every loader against %s instead of measuring\n"
+	       "  --filter <text>  only use formats with <text> in their name\n"
+	       "  --time <ms>      minimum time to measure each loader and format (default 50)\n",
+	       argv0, s_loader_types[0].name);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	bool verify = false;
+	std::string filter;
+	u64 min_time_us = 50000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--verify"))
+		{
+			verify = true;
+		}
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+		{
+			min_time_us = strtoull(argv[++i], nullptr, 10) * 1000;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<VertexFormat> all_formats;
+	AddPositionFormats(&all_formats);
+	AddNormalFormats(&all_formats);
+	AddColorFormats(&all_formats);
+	AddTexCoordFormats(&all_formats);
+	AddMixedFormats(&all_formats);
+
+	std::vector<VertexFormat> formats;
+	for (const VertexFormat& format : all_formats)
+	{
+		if (format.name.find(filter) != std::string::npos)
+			formats.push_back(format);
+	}
+
+	if (verify)
+	{
+		int failures = 0;
+		for (const VertexFormat& format : formats)
+		{
+			if (!Verify(format))
+				failures++;
+		}
+		printf("%d of %d formats verified, %d mismatches\n",
+		       (int)formats.size() - failures, (int)formats.size(), failures);
+		return failures ? 1 : 0;
+	}
+
+	printf("%-64s", "format (Mvertices/s)");
+	for (const LoaderType& type : s_loader_types)
+		printf(" %16s", type.name);
+	printf("\n");
+
+	std::vector<double> totals(NUM_LOADER_TYPES, 0.0);
+	std::vector<int> supported(NUM_LOADER_TYPES, 0);
+	for (const VertexFormat& format : formats)
+	{
+		FillRandom((u32)format.desc.Hex);
+		printf("%-64s", format.name.c_str());
+		for (int i = 0; i < NUM_LOADER_TYPES; i++)
+		{
+			double rate = Measure(s_loader_types[i], format, min_time_us);
+			if (rate)
+			{
+				totals[i] += rate;
+				supported[i]++;
+				printf(" %16.1f", rate / 1000000.0);
+			}
+			else
+				printf(" %16s", "unsupported");
+		}
+		printf("\n");
+		fflush(stdout);
+	}
+
+	printf("%-64s", "mean of supported formats");
+	for (int i = 0; i < NUM_LOADER_TYPES; i++)
+		printf(" %16.1f", supported[i] ? totals[i] / supported[i] / 1000000.0 : 0.0);
+	printf("\n");
+	return 0;
+}
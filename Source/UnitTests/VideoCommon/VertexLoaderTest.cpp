@@ -1,8 +1,14 @@
+#include <memory>
 #include <unordered_set>
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "VideoCommon/DataReader.h"
+#include "VideoCommon/VertexLoader.h"
 #include "VideoCommon/VertexLoaderBase.h"
+#ifdef _M_X86
+#include "VideoCommon/VertexLoaderX64.h"
+#endif
 
 // Needs to be included later because it defines a TEST macro that conflicts
 // with a TEST method definition in x64Emitter.h.
@@ -272,3 +278,142 @@ TEST_F(VertexLoaderTest, LargeFloatVertexSpeed)
 	}
 	delete loader;
 }
+
+#ifdef _M_X86
+static u8 array_memory[65536 * 40 + 64];
+
+// Feeds the same random vertices and arrays to VertexLoader and
+// VertexLoaderX64 and checks that they produce the same output.
+static void ExpectSameOutput(const TVtxDesc& vtx_desc, const VAT& vtx_attr)
+{
+	std::unique_ptr<VertexLoaderBase> reference(new VertexLoader(vtx_desc, vtx_attr));
+	std::unique_ptr<VertexLoaderBase> loader(new VertexLoaderX64(vtx_desc, vtx_attr));
+	ASSERT_TRUE(loader->IsInitialized());
+	ASSERT_EQ(reference->m_VertexSize, loader->m_VertexSize);
+	ASSERT_EQ(reference->m_native_components, loader->m_native_components);
+	ASSERT_EQ(0, memcmp(&reference->m_native_vtx_decl, &loader->m_native_vtx_decl, sizeof(PortableVertexDeclaration)));
+
+	u32 seed = (u32)(vtx_desc.Hex ^ vtx_attr.g0.Hex ^ (vtx_attr.g1.Hex << 7));
+	auto next_byte = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return (u8)(seed >> 16);
+	};
+
+	const int count = 1000;
+	const int stride = reference->m_native_vtx_decl.stride;
+	// Leave room before the data, VertexLoader reads 6666 colors from one byte early.
+	for (int i = 0; i < count * reference->m_VertexSize + 32; i++)
+		input_memory[i] = next_byte();
+	for (u8& b : array_memory)
+		b = next_byte();
+	for (int i = 0; i < 16; i++)
+	{
+		cached_arraybases[i] = array_memory + 16;
+		g_main_cp_state.array_strides[i] = 40;
+	}
+
+	u8* const output_a = output_memory;
+	u8* const output_b = output_memory + sizeof(output_memory) / 2;
+	memset(output_a, 0, count * stride);
+	memset(output_b, 0, count * stride);
+
+	DataReader src(input_memory + 16, input_memory + sizeof(input_memory));
+	int count_a = reference->RunVertices(7, count, src, DataReader(output_a, output_b));
+	int count_b = loader->RunVertices(7, count, src, DataReader(output_b, output_memory + sizeof(output_memory)));
+
+	std::string name;
+	reference->AppendToString(&name);
+	ASSERT_EQ(count_a, count_b) << name;
+	for (int i = 0; i < count_a; i++)
+		ASSERT_EQ(0, memcmp(output_a + i * stride, output_b + i * stride, stride)) << "vertex " << i << " of " << name;
+}
+
+TEST_F(VertexLoaderTest, X64Positions)
+{
+	if (!cpu_info.bSSSE3)
+		return;
+
+	for (int mode = DIRECT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_UBYTE; format <= FORMAT_FLOAT; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	{
+		m_vtx_desc.Position = mode;
+		m_vtx_desc.PosMatIdx = elements;
+		m_vtx_attr.g0.PosFormat = format;
+		m_vtx_attr.g0.PosElements = elements;
+		m_vtx_attr.g0.PosFrac = format * 3;
+		ExpectSameOutput(m_vtx_desc, m_vtx_attr);
+	}
+}
+
+TEST_F(VertexLoaderTest, X64Normals)
+{
+	if (!cpu_info.bSSSE3)
+		return;
+
+	m_vtx_desc.Position = INDEX16;
+	m_vtx_attr.g0.PosFormat = FORMAT_FLOAT;
+	for (int mode = DIRECT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_UBYTE; format <= FORMAT_FLOAT; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	for (int index3 = 0; index3 <= 1; index3++)
+	{
+		m_vtx_desc.Normal = mode;
+		m_vtx_attr.g0.NormalFormat = format;
+		m_vtx_attr.g0.NormalElements = elements;
+		m_vtx_attr.g0.NormalIndex3 = index3;
+		ExpectSameOutput(m_vtx_desc, m_vtx_attr);
+	}
+}
+
+TEST_F(VertexLoaderTest, X64Colors)
+{
+	if (!cpu_info.bSSSE3)
+		return;
+
+	m_vtx_desc.Position = DIRECT;
+	for (int mode0 = NOT_PRESENT; mode0 <= INDEX16; mode0++)
+	for (int mode1 = NOT_PRESENT; mode1 <= INDEX16; mode1++)
+	for (int format = FORMAT_16B_565; format <= FORMAT_32B_8888; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	{
+		m_vtx_desc.Color0 = mode0;
+		m_vtx_desc.Color1 = mode1;
+		m_vtx_attr.g0.Color0Comp = format;
+		m_vtx_attr.g0.Color1Comp = FORMAT_32B_8888 - format;
+		m_vtx_attr.g0.Color0Elements = elements;
+		m_vtx_attr.g0.Color1Elements = !elements;
+		ExpectSameOutput(m_vtx_desc, m_vtx_attr);
+	}
+}
+
+TEST_F(VertexLoaderTest, X64TexCoordsAndMatrices)
+{
+	if (!cpu_info.bSSSE3)
+		return;
+
+	m_vtx_desc.Position = DIRECT;
+	for (int mode = NOT_PRESENT; mode <= INDEX16; mode++)
+	for (int format = FORMAT_UBYTE; format <= FORMAT_FLOAT; format++)
+	for (int elements = 0; elements <= 1; elements++)
+	for (int matrices = 0; matrices < 4; matrices++)
+	{
+		// Matrix indices with and without coordinates, and gaps in between.
+		m_vtx_desc.Hex &= ~0x1FEull;
+		m_vtx_desc.Hex |= (u64)(matrices * 0x55) << 1;
+		m_vtx_desc.Tex0Coord = mode;
+		m_vtx_desc.Tex3Coord = mode;
+		m_vtx_desc.Tex6Coord = (mode + 1) % 4;
+		m_vtx_attr.g0.Tex0CoordFormat = format;
+		m_vtx_attr.g0.Tex0CoordElements = elements;
+		m_vtx_attr.g0.Tex0Frac = 7;
+		m_vtx_attr.g1.Tex3CoordFormat = format;
+		m_vtx_attr.g1.Tex3CoordElements = !elements;
+		m_vtx_attr.g1.Tex3Frac = 2;
+		m_vtx_attr.g2.Tex6CoordFormat = FORMAT_FLOAT - format;
+		m_vtx_attr.g2.Tex6CoordElements = elements;
+		m_vtx_attr.g2.Tex6Frac = 31;
+		ExpectSameOutput(m_vtx_desc, m_vtx_attr);
+	}
+}
+#endif